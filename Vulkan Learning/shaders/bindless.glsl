@@ -0,0 +1,6 @@
+// Global descriptor heap, see Descriptors/BindlessHeap.h. Storage buffers are
+// declared per shader since every buffer type aliases binding 1.
+#extension GL_EXT_nonuniform_qualifier : require
+
+layout(set = 0, binding = 0) uniform sampler2D textures[];
+layout(set = 0, binding = 2, r32f) uniform writeonly image2D images_r32f[];
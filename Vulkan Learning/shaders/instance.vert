@@ -0,0 +1,21 @@
+#version 460
+#extension GL_GOOGLE_include_directive : require
+#include "bindless.glsl"
+#include "scene.glsl"
+
+layout(location = 0) in vec3 in_position;
+layout(location = 0) out vec3 out_color;
+
+layout(set = 0, binding = 1, std430) readonly buffer Views { CullView view; } view_buffers[];
+layout(set = 0, binding = 1, std430) readonly buffer Instances { Instance items[]; } instance_buffers[];
+layout(set = 0, binding = 1, std430) readonly buffer Visible { uint items[]; } visible_buffers[];
+
+void main() {
+  // indirect draws index the compacted visible list, direct draws pass the instance itself
+  uint id = (push.flags & DRAW_DIRECT) != 0 ? gl_InstanceIndex : visible_buffers[push.visible_buffer].items[gl_InstanceIndex];
+  Instance instance = instance_buffers[push.instance_buffer].items[id];
+
+  vec3 world = in_position * instance.position_scale.w + instance.position_scale.xyz;
+  gl_Position = view_buffers[push.view_buffer].view.view_proj * vec4(world, 1.0);
+  out_color = unpackUnorm4x8(instance.color).rgb;
+}
@@ -0,0 +1,61 @@
+// GPU-driven scene layout, mirrors Culling/IndirectCuller.h
+
+struct Instance {
+  vec4 position_scale;
+  uint mesh;
+  uint color;
+  uint pad0;
+  uint pad1;
+};
+
+struct Mesh {
+  uint index_count;
+  uint first_index;
+  int vertex_offset;
+  uint instance_base;
+  // bounding sphere in mesh space
+  vec4 bounds;
+};
+
+// VkDrawIndexedIndirectCommand
+struct DrawCommand {
+  uint index_count;
+  uint instance_count;
+  uint first_index;
+  int vertex_offset;
+  uint first_instance;
+};
+
+struct CullView {
+  mat4 view;
+  mat4 view_proj;
+  // world space, inside when dot(plane.xyz, p) + plane.w >= 0
+  vec4 frustum[6];
+  float p00;
+  float p11;
+  float znear;
+  float zfar;
+};
+
+const uint CULL_OCCLUSION = 1;
+const uint DRAW_DIRECT = 2;
+
+// heap slots and counts, see CullPush
+layout(push_constant) uniform Push {
+  uint view_buffer;
+  uint instance_buffer;
+  uint mesh_buffer;
+  uint command_buffer;
+  uint visible_buffer;
+  uint draw_buffer;
+  uint count_buffer;
+  uint pyramid;
+  uint instance_count;
+  uint mesh_count;
+  uint flags;
+  uint source_texture;
+  uint source_level;
+  uint target_image;
+  uint target_width;
+  uint target_height;
+} push;
@@ -1,37 +1,487 @@
 #include "Application.h"
+#include "Assets/AssetBenchmark.h"
+#include "Commands.h"
+#include "Culling/CullingBenchmark.h"
+#include "Scheduling/AsyncComputeBenchmark.h"
+#include "Scheduling/SplitDeviceBenchmark.h"
 #include "Device.h"
 #include "Init.h"
+#include "Offscreen.h"
 #include "Swapchain.h"
+#include "Sync.h"
+
+Application::Application(const AppConfig& config) {
+  config_ = config;
+
+  // disk work that needs no device, it runs under everything up to the pipeline services
+  std::future<std::vector<uint8_t>> pipeline_cache_data = std::async(std::launch::async, [this]() {
+    auto stage = startup_timer_.stage("pipeline cache file");
+    shader_compiler_ = new ShaderCompiler(config_.ShaderCacheDir, debug_);
+    return PipelineCache::read_file(config_.PipelineCachePath);
+  });
+
+  // GLFW stays on the main thread, only its surface extensions are needed before the instance exists
+  std::vector<const char*> window_extensions;
+  if (!config_.Headless) {
+    auto stage = startup_timer_.stage("glfw init");
+    window_extensions = Window::required_instance_extensions(debug_);
+  }
+
+  // loading the drivers dominates cold starts, so the instance and device queries overlap the window
+  std::future<std::vector<VkUtils::DeviceCapabilities>> device_candidates = std::async(std::launch::async, [this, window_extensions]() {
+    {
+      auto stage = startup_timer_.stage("instance");
+      create_instance(window_extensions);
+    }
+    if (debug_) {
+      auto stage = startup_timer_.stage("debug messenger");
+      create_debug_messenger();
+    }
+    auto stage = startup_timer_.stage("device queries");
+    return VkInit::query_physical_devices(instance_, debug_);
+  });
+
+  if (!config_.Headless) {
+    auto stage = startup_timer_.stage("window");
+    window_ = Window::create(debug_);
+  }
+  std::vector<VkUtils::DeviceCapabilities> candidates = device_candidates.get();
+  if (!config_.Headless) {
+    auto stage = startup_timer_.stage("surface");
+    window_->create_surface(instance_, surface_, debug_);
+  }
+  {
+    auto stage = startup_timer_.stage("physical device");
+    create_physical_device(std::move(candidates));
+  }
+  {
+    auto stage = startup_timer_.stage("logical device");
+    create_logical_device();
+  }
+  {
+    auto stage = startup_timer_.stage("pipeline services");
+    create_pipeline_services(pipeline_cache_data.get());
+  }
+  {
+    auto stage = startup_timer_.stage(config_.Headless ? "offscreen targets" : "swapchain");
+    if (config_.Headless) {
+      create_offscreen_targets();
+    }
+    else {
+      create_swapchain();
+      if (!config_.CapturePath.empty()) {
+        LOG_WARN("Capture needs --headless, swapchain images cannot be read back");
+      }
+    }
+  }
+  {
+    auto stage = startup_timer_.stage("frame resources");
+    create_frame_resources();
+  }
 
-Application::Application() {
-  window_ = new WindowsWindow(debug_);
-  create_instance();
   if (debug_) {
-    create_debug_messenger();
+    // reports go straight to the console, let queued log lines land first
+    Log::flush();
+    startup_timer_.report();
   }
-  window_->create_surface(instance_, surface_, debug_);
-  create_physical_device();
-  create_logical_device();
-  create_swapchain();
 }
 
 Application::~Application() {
-  instance_.destroyDebugUtilsMessengerEXT(debug_messenger_, nullptr, dispatch_loader_);
-  instance_.destroySurfaceKHR(surface_, nullptr);
-  device_.destroySwapchainKHR(swapchain_);
-  device_.destroy();
+  device_->waitIdle();
+  destroy_frame_resources();
+  if (config_.Headless) {
+    for (size_t i = 0; i < swapchain_images_.size(); ++i) {
+      device_->destroyImage(swapchain_images_[i]);
+      allocator_->free(offscreen_memory_[i]);
+      residency_->untrack(offscreen_residency_[i]);
+    }
+  }
+  else {
+    swapchain_.reset();
+  }
+  // compiles still in flight would land in the cache after it was saved
+  pipeline_service_->wait_idle();
+  pipeline_cache_->save();
+  Log::flush();
+  if (profiler_) {
+    profiler_->report();
+    if (!config_.TracePath.empty()) {
+      profiler_->export_chrome_trace(config_.TracePath);
+    }
+  }
+  if (debug_) {
+    if (present_latency_) {
+      present_latency_->report();
+    }
+    pipeline_service_->report();
+    shaders_->report();
+    if (bindless_) {
+      bindless_->report();
+    }
+    frame_graph_->report();
+    pipeline_cache_->report();
+    scheduler_->report();
+    deletion_queue_->report();
+    upload_engine_->report();
+    residency_->report();
+    allocator_->report();
+  }
+  // the device is idle, so whatever is still queued goes now
+  delete readback_;
+  delete deletion_queue_;
+  delete present_latency_;
+  delete profiler_;
+  delete frame_graph_;
+  delete bindless_;
+  // the service waits for queued compiles, which still read the library's modules
+  delete pipeline_service_;
+  delete shaders_;
+  delete shader_compiler_;
+  delete pipeline_cache_;
+  delete scheduler_;
+  delete upload_engine_;
+  delete residency_;
+  delete allocator_;
+  delete capabilities_;
+  device_.reset();
+  destroy_secondary_devices();
+  if (debug_) {
+    instance_.destroyDebugUtilsMessengerEXT(debug_messenger_, nullptr, dispatch_loader_);
+  }
+  if (surface_) {
+    instance_.destroySurfaceKHR(surface_, nullptr);
+  }
   instance_.destroy();
   delete window_;
 }
 
 void Application::run() {
   while (running_) {
-    window_->on_update();
+    if (window_) {
+      // sleeping in the event wait keeps an idle window from pinning a core, polling is opt-in through --idle-fps 0
+      if (config_.IdleFps > 0) {
+        window_->wait_events_timeout(1.0 / config_.IdleFps);
+      }
+      else {
+        window_->on_update();
+      }
+      if (window_->should_close()) {
+        break;
+      }
+      present_latency_->mark_input();
+      // a zero sized surface can't back a swapchain, sleep until the window is restored
+      if (window_->is_minimized()) {
+        window_->wait_events();
+        continue;
+      }
+      if (window_->consume_resize() || swapchain_dirty_) {
+        recreate_swapchain();
+      }
+    }
+
+    render();
+
+    if (debug_ && frame_number_ % 1000 == 0) {
+      Log::flush();
+      frame_stats_.report();
+      residency_->report();
+    }
+    if (config_.FrameCount != 0 && frame_number_ >= config_.FrameCount) {
+      running_ = false;
+    }
+  }
+
+  device_->waitIdle();
+  if (readback_) {
+    readback_->flush();
+  }
+  Log::flush();
+  frame_stats_.report();
+  if (present_latency_) {
+    present_latency_->report();
+  }
+  if (readback_) {
+    readback_->report();
   }
 }
 
-void Application::create_instance() {
-  instance_ = VkInit::make_instance(name_, debug_);
+void Application::render() {
+  VkUtils::FrameData& frame = frames_[current_frame_];
+  frame_stats_.begin_frame();
+
+  // blocks only when the GPU is more than FramesInFlight frames behind
+  frame_stats_.begin_gpu_wait();
+  (void)device_->waitForFences(frame.InFlight, VK_TRUE, UINT64_MAX);
+  frame_stats_.end_gpu_wait();
+  if (profiler_) {
+    profiler_->begin_frame(current_frame_);
+  }
+  recorder_->begin_frame(current_frame_);
+  frame_ring_->begin_frame(current_frame_);
+  if (bindless_) {
+    bindless_->begin_frame(frame_number_);
+  }
+  deletion_queue_->collect();
+  residency_->begin_frame(frame_number_);
+  residency_->publish(profiler_);
+  shaders_->poll();
+  if (readback_) {
+    readback_->begin_frame();
+  }
+
+  uint32_t image_index = current_frame_;
+  if (!config_.Headless) {
+    GpuProfiler::CpuScope scope(profiler_, "acquire");
+    try {
+      vk::ResultValue<uint32_t> acquired = device_->acquireNextImageKHR(*swapchain_, UINT64_MAX, frame.ImageAvailable, nullptr);
+      image_index = acquired.value;
+      // a suboptimal image is still presentable, finish the frame and recreate afterwards
+      if (acquired.result == vk::Result::eSuboptimalKHR) {
+        swapchain_dirty_ = true;
+      }
+    }
+    catch (const vk::OutOfDateKHRError&) {
+      // nothing was signaled and the fence is untouched, so the frame slot can simply be retried
+      recreate_swapchain();
+      return;
+    }
+  }
+
+  // with fewer swapchain images than frames in flight an older frame may still own this image
+  if (images_in_flight_[image_index] && images_in_flight_[image_index] != frame.InFlight) {
+    frame_stats_.begin_gpu_wait();
+    (void)device_->waitForFences(images_in_flight_[image_index], VK_TRUE, UINT64_MAX);
+    frame_stats_.end_gpu_wait();
+  }
+  images_in_flight_[image_index] = frame.InFlight;
+
+  device_->resetFences(frame.InFlight);
+  device_->resetCommandPool(frame.CommandPool);
+  // kick off uploads queued since the last frame so the transfer queue works alongside this one
+  upload_engine_->flush();
+  // descriptors added since begin_frame(), e.g. by upload completions, must land before the submit
+  if (bindless_) {
+    bindless_->flush();
+  }
+  {
+    GpuProfiler::CpuScope scope(profiler_, "record");
+    record_commands(frame.CommandBuffer, image_index);
+  }
+
+  QueueSubmit submit;
+  if (!config_.Headless) {
+    submit.wait(frame.ImageAvailable, vk::PipelineStageFlagBits::eTransfer);
+    submit.signal(render_finished_[image_index]);
+  }
+  if (upload_wait_ != 0) {
+    submit.wait(upload_engine_->timeline(), vk::PipelineStageFlagBits::eAllCommands, upload_wait_);
+  }
+  QueuePoint frame_point = scheduler_->submit_graphics(submit, frame.CommandBuffer, {}, vk::PipelineStageFlagBits::eAllCommands,
+    frame.InFlight);
+  if (readback_) {
+    readback_->submitted(frame_point);
+  }
+  if (profiler_) {
+    profiler_->mark_submit();
+  }
+
+  if (!config_.Headless) {
+    GpuProfiler::CpuScope scope(profiler_, "present");
+    vk::PresentInfoKHR present_info{};
+    present_info.waitSemaphoreCount = 1;
+    present_info.pWaitSemaphores = &render_finished_[image_index];
+    present_info.swapchainCount = 1;
+    vk::SwapchainKHR swapchain = *swapchain_;
+    present_info.pSwapchains = &swapchain;
+    present_info.pImageIndices = &image_index;
+
+    vk::PresentIdKHR present_id_info{};
+    uint64_t present_id = present_latency_->on_present(*swapchain_);
+    if (present_id != 0) {
+      present_id_info.swapchainCount = 1;
+      present_id_info.pPresentIds = &present_id;
+      present_info.pNext = &present_id_info;
+    }
+    try {
+      if (present_queue_.presentKHR(present_info) == vk::Result::eSuboptimalKHR) {
+        swapchain_dirty_ = true;
+      }
+    }
+    catch (const vk::OutOfDateKHRError&) {
+      swapchain_dirty_ = true;
+    }
+    present_latency_->poll();
+  }
+
+  current_frame_ = (current_frame_ + 1) % static_cast<uint32_t>(frames_.size());
+  ++frame_number_;
+  frame_stats_.end_frame();
+}
+
+void Application::record_commands(vk::CommandBuffer command_buffer, uint32_t image_index) {
+  vk::CommandBufferBeginInfo begin_info{};
+  begin_info.flags = vk::CommandBufferUsageFlagBits::eOneTimeSubmit;
+  command_buffer.begin(begin_info);
+  if (profiler_) {
+    profiler_->reset_queries(command_buffer);
+  }
+
+  {
+    GpuProfiler::GpuScope frame_scope(profiler_, command_buffer, "frame");
+    record_frame(command_buffer, image_index);
+  }
+
+  command_buffer.end();
+}
+
+void Application::record_frame(vk::CommandBuffer command_buffer, uint32_t image_index) {
+  {
+    GpuProfiler::GpuScope scope(profiler_, command_buffer, "upload acquires");
+    upload_wait_ = upload_engine_->record_acquires(command_buffer);
+  }
+  // bound once per frame, pipelines built on its layout pick resources by push constant index
+  if (bindless_) {
+    bindless_->bind(command_buffer, vk::PipelineBindPoint::eGraphics);
+    bindless_->bind(command_buffer, vk::PipelineBindPoint::eCompute);
+  }
+
+  vk::Image image = swapchain_images_[image_index];
+  vk::ImageSubresourceRange range{ vk::ImageAspectFlagBits::eColor, 0, 1, 0, 1 };
+
+  // the acquire semaphore is waited on at the transfer stage, headless images are read back after the frame
+  frame_graph_->reset();
+  GraphResource backbuffer = frame_graph_->import_texture("backbuffer", image, { swapchain_format_, swapchain_extent_ },
+    vk::ImageLayout::eUndefined, vk::PipelineStageFlagBits2::eTransfer,
+    config_.Headless ? vk::ImageLayout::eTransferSrcOptimal : vk::ImageLayout::ePresentSrcKHR);
+
+  float pulse = static_cast<float>(frame_number_ % 240) / 240.0f;
+  vk::ClearColorValue clear_color{ std::array<float, 4>{ 0.1f, pulse, 0.3f, 1.0f } };
+  frame_graph_->add_pass("clear", [&](GraphPassBuilder& pass) {
+    pass.write(backbuffer, GraphUse::TransferDst);
+  }, [&](vk::CommandBuffer command_buffer) {
+    GpuProfiler::GpuScope scope(profiler_, command_buffer, "clear");
+    command_buffer.clearColorImage(image, vk::ImageLayout::eTransferDstOptimal, clear_color, range);
+  });
+
+  frame_graph_->add_pass("record items", [](GraphPassBuilder& pass) {
+    pass.side_effect();
+  }, [this](vk::CommandBuffer command_buffer) {
+    GpuProfiler::GpuScope scope(profiler_, command_buffer, "record items");
+    vk::CommandBufferInheritanceInfo inheritance{};
+    recorder_->record(command_buffer, config_.RecordItems, record_items, inheritance);
+  });
+
+  if (readback_) {
+    frame_graph_->add_pass("readback", [&](GraphPassBuilder& pass) {
+      pass.read(backbuffer, GraphUse::TransferSrc);
+      pass.side_effect();
+    }, [&](vk::CommandBuffer command_buffer) {
+      GpuProfiler::GpuScope scope(profiler_, command_buffer, "readback");
+      readback_->record_copy(command_buffer, image);
+    });
+  }
+
+  frame_graph_->compile();
+  frame_graph_->execute(command_buffer, capabilities_->Synchronization2 ? &dispatch_loader_ : nullptr);
+}
+
+void Application::record_items(vk::CommandBuffer command_buffer, uint32_t begin, uint32_t end) {
+  for (uint32_t i = begin; i < end; ++i) {
+    float offset = static_cast<float>(i % 64);
+    vk::Viewport viewport{ offset, offset, 64.0f, 64.0f, 0.0f, 1.0f };
+    vk::Rect2D scissor{ vk::Offset2D{ 0, 0 }, vk::Extent2D{ 64, 64 } };
+    command_buffer.setViewport(0, viewport);
+    command_buffer.setScissor(0, scissor);
+  }
+}
+
+void Application::run_recording_benchmark() {
+  const uint32_t item_count = 200000;
+  const uint32_t repetitions = 5;
+
+  std::cout << "Recording " << item_count << " items, best of " << repetitions << " runs:" << std::endl;
+
+  device_->waitIdle();
+  VkUtils::FrameData& frame = frames_[0];
+  vk::CommandBufferInheritanceInfo inheritance{};
+  double single_thread_ms = 0.0;
+
+  for (uint32_t threads = 1; threads <= recorder_->thread_count(); ++threads) {
+    double best_ms = 1e30;
+    for (uint32_t run = 0; run < repetitions; ++run) {
+      device_->resetCommandPool(frame.CommandPool);
+      recorder_->begin_frame(0);
+
+      vk::CommandBufferBeginInfo begin_info{};
+      begin_info.flags = vk::CommandBufferUsageFlagBits::eOneTimeSubmit;
+      frame.CommandBuffer.begin(begin_info);
+
+      auto start = std::chrono::steady_clock::now();
+      recorder_->record(frame.CommandBuffer, item_count, record_items, inheritance, threads);
+      auto stop = std::chrono::steady_clock::now();
+
+      frame.CommandBuffer.end();
+      best_ms = (std::min)(best_ms, std::chrono::duration<double, std::milli>(stop - start).count());
+    }
+
+    if (threads == 1) {
+      single_thread_ms = best_ms;
+    }
+    std::cout << threads << " threads: " << best_ms << "ms, "
+      << item_count / best_ms / 1000.0 << "M items/s, speedup " << single_thread_ms / best_ms << "x" << std::endl;
+  }
+}
+
+void Application::run_culling_benchmark() {
+  if (!bindless_ || !capabilities_->supports_gpu_culling()) {
+    LOG_ERROR("GPU culling needs descriptor indexing, drawIndirectCount and multiDrawIndirect");
+    return;
+  }
+
+  device_->waitIdle();
+  CullingBenchmark benchmark(*device_, *allocator_, *upload_engine_, *bindless_, *pipeline_service_, *shaders_,
+    graphics_queue_, capabilities_->Indices.GraphicsFamily.value(), config_.CullInstances, debug_);
+  benchmark.run(config_.FrameCount != 0 ? config_.FrameCount : 100);
+}
+
+void Application::run_async_compute_benchmark() {
+  if (!bindless_) {
+    LOG_ERROR("The async compute benchmark needs descriptor indexing");
+    return;
+  }
+
+  device_->waitIdle();
+  const VkUtils::QueueFamilyIndices& indices = capabilities_->Indices;
+  AsyncComputeBenchmark benchmark(*device_, *allocator_, *bindless_, *pipeline_service_, *scheduler_, *shaders_,
+    indices.GraphicsFamily.value(), indices.ComputeFamily.value(), debug_);
+  benchmark.run(config_.FrameCount != 0 ? config_.FrameCount : 200);
+}
+
+void Application::run_asset_benchmark() {
+  device_->waitIdle();
+  AssetBenchmark benchmark(*device_, *allocator_, *upload_engine_, graphics_queue_, capabilities_->Indices.GraphicsFamily.value(),
+    capabilities_->Features.textureCompressionBC, config_.AssetDir, config_.AssetPackPath, debug_);
+  benchmark.run();
+}
+
+void Application::run_split_device_benchmark() {
+  device_->waitIdle();
+  std::vector<SplitDevice> devices;
+  devices.push_back({ capabilities_->Properties.deviceName.data(), *device_, allocator_, graphics_queue_,
+    capabilities_->Indices.GraphicsFamily.value() });
+  for (const SecondaryDevice& secondary : secondary_devices_) {
+    devices.push_back({ secondary.Name, *secondary.Device, secondary.Allocator, secondary.Queue, secondary.Family });
+  }
+
+  SplitDeviceBenchmark benchmark(std::move(devices), debug_);
+  benchmark.run(config_.FrameCount != 0 ? config_.FrameCount : 5);
+}
+
+void Application::create_instance(const std::vector<const char*>& window_extensions) {
+  instance_ = VkInit::make_instance(name_, window_extensions, debug_);
+  if (!instance_) {
+    throw std::runtime_error("Failed to create instance!");
+  }
 }
 
 void Application::create_debug_messenger() {
@@ -39,21 +489,235 @@ void Application::create_debug_messenger() {
   debug_messenger_ = VkInit::create_debug_messenger(instance_, dispatch_loader_);
 }
 
-void Application::create_physical_device() {
-  physical_device_ = VkInit::choose_physical_device(instance_, surface_, debug_);
+void Application::create_physical_device(std::vector<VkUtils::DeviceCapabilities> candidates) {
+  // surface_ stays null when headless, which drops the present requirements
+  capabilities_ = new VkUtils::DeviceCapabilities(VkInit::choose_physical_device(std::move(candidates), surface_, config_.DeviceOverride, debug_));
+  physical_device_ = capabilities_->PhysicalDevice;
 }
 
 void Application::create_logical_device() {
-  device_ = VkInit::create_logical_device(physical_device_, surface_, debug_);
-  std::array<vk::Queue, 2> queues = VkInit::get_queue(physical_device_, device_, surface_, debug_);
+  const VkUtils::QueueFamilyIndices& indices = capabilities_->Indices;
+  VkUtils::QueueRequest request;
+  request.ComputeQueues = config_.ComputeQueues;
+  request.ComputePriority = config_.ComputePriority;
+  request.TransferPriority = config_.TransferPriority;
+  VkUtils::QueuePlan plan = VkUtils::plan_queues(indices, capabilities_->QueueFamilies, request);
+
+  device_ = vk::UniqueDevice(VkInit::create_logical_device(*capabilities_, plan, debug_));
+  if (!device_) {
+    throw std::runtime_error("Failed to create logical device!");
+  }
+  std::array<vk::Queue, 3> queues = VkInit::get_queue(plan, *device_, debug_);
   graphics_queue_ = queues[0];
   present_queue_ = queues[1];
+  transfer_queue_ = queues[2];
+  scheduler_ = new QueueScheduler(*device_, graphics_queue_, VkInit::get_compute_queues(plan, *device_, debug_),
+    indices.ComputeFamily.value(), indices.has_async_compute(), debug_);
+
+  allocator_ = new MemoryAllocator(physical_device_, *device_, debug_);
+  residency_ = new ResidencyManager(physical_device_, capabilities_->MemoryBudget, config_.FramesInFlight, debug_);
+  deletion_queue_ = new DeletionQueue(*device_, *allocator_, *scheduler_, debug_);
+
+  upload_engine_ = new UploadEngine(*device_, *allocator_, transfer_queue_, indices.TransferFamily.value(),
+    indices.GraphicsFamily.value(), 32 * 1024 * 1024, debug_);
+
+  if (config_.DeviceCount > 1) {
+    create_secondary_devices();
+  }
+  if (capabilities_->supports_bindless()) {
+    bindless_ = new BindlessHeap(*device_, capabilities_->Vulkan12Properties, BindlessCapacity{}, config_.FramesInFlight, debug_);
+  }
+  else {
+    LOG_WARN("Descriptor indexing is not supported, the bindless heap is disabled");
+  }
+  frame_graph_ = new RenderGraph();
+  if (!capabilities_->Synchronization2) {
+    LOG_WARN("Synchronization2 is not supported, the render graph records legacy barriers");
+  }
+
+  // present wait and calibrated timestamps are extensions, so their entry points come through the dynamic loader
+  dispatch_loader_ = vk::DispatchLoaderDynamic(instance_, vkGetInstanceProcAddr, *device_, vkGetDeviceProcAddr);
+  if (!config_.Headless) {
+    present_latency_ = new PresentLatency(*device_, capabilities_->PresentWait ? &dispatch_loader_ : nullptr);
+  }
+
+  if (config_.Profile) {
+    uint32_t valid_bits = capabilities_->QueueFamilies[indices.GraphicsFamily.value()].timestampValidBits;
+    if (valid_bits == 0) {
+      LOG_WARN("The graphics queue does not support timestamps, profiling is disabled");
+    }
+    else {
+      bool calibrated = capabilities_->has_extension(VK_EXT_CALIBRATED_TIMESTAMPS_EXTENSION_NAME);
+      profiler_ = new GpuProfiler(physical_device_, *device_, capabilities_->Properties.limits.timestampPeriod, valid_bits,
+        config_.FramesInFlight, calibrated ? &dispatch_loader_ : nullptr, debug_);
+    }
+  }
+}
+
+void Application::create_pipeline_services(std::vector<uint8_t> pipeline_cache_data) {
+  pipeline_cache_ = new PipelineCache(physical_device_, *device_, config_.PipelineCachePath, std::move(pipeline_cache_data), debug_);
+  pipeline_service_ = new PipelineService(*device_, *pipeline_cache_, config_.CompileThreads, debug_);
+  // shader_compiler_ was made next to the cache file read
+  shaders_ = new ShaderLibrary(*device_, *shader_compiler_, config_.ShaderDir, config_.HotReload, debug_);
+}
+
+void Application::create_secondary_devices() {
+  // ranked without a surface, secondaries only need graphics/compute
+  std::vector<VkUtils::DeviceCapabilities> ranked = VkInit::rank_physical_devices(instance_, nullptr, "", debug_);
+
+  for (const VkUtils::DeviceCapabilities& candidate : ranked) {
+    if (secondary_devices_.size() + 1 >= config_.DeviceCount) {
+      break;
+    }
+    if (candidate.PhysicalDevice == physical_device_) {
+      continue;
+    }
+
+    SecondaryDevice secondary;
+    secondary.PhysicalDevice = candidate.PhysicalDevice;
+    VkUtils::QueuePlan plan = VkUtils::plan_queues(candidate.Indices, candidate.QueueFamilies, VkUtils::QueueRequest{});
+    secondary.Device = vk::UniqueDevice(VkInit::create_logical_device(candidate, plan, debug_));
+    if (!secondary.Device) {
+      continue;
+    }
+    secondary.Name = candidate.Properties.deviceName.data();
+    secondary.Allocator = new MemoryAllocator(candidate.PhysicalDevice, *secondary.Device, debug_);
+    secondary.Queue = VkInit::get_queue(plan, *secondary.Device, debug_)[0];
+    secondary.Family = plan.Graphics.Family;
+    secondary_devices_.push_back(std::move(secondary));
+  }
+
+  if (secondary_devices_.size() + 1 < config_.DeviceCount) {
+    LOG_WARN("Requested " << config_.DeviceCount << " devices, only " << secondary_devices_.size() + 1
+      << " are usable");
+  }
+}
+
+void Application::destroy_secondary_devices() {
+  for (SecondaryDevice& secondary : secondary_devices_) {
+    secondary.Device->waitIdle();
+    delete secondary.Allocator;
+    secondary.Device.reset();
+  }
+  secondary_devices_.clear();
 }
 
 void Application::create_swapchain() {
-  VkUtils::SwapChainBundle bundle = VkInit::create_swapchain(physical_device_, device_, surface_, window_->get_glfw_window(), debug_);
-  swapchain_ = bundle.Swapchain;
-  swapchain_images_ = device_.getSwapchainImagesKHR(swapchain_);
+  VkUtils::SwapChainBundle bundle = VkInit::create_swapchain(*capabilities_, *device_, surface_, window_->get_glfw_window(),
+    config_.Present, config_.SwapchainImages, nullptr, debug_);
+  swapchain_ = vk::UniqueSwapchainKHR(bundle.Swapchain, *device_);
+  swapchain_images_ = device_->getSwapchainImagesKHR(*swapchain_);
+  swapchain_format_ = bundle.Format;
+  swapchain_extent_ = bundle.Extent;
+}
+
+void Application::recreate_swapchain() {
+  if (window_->is_minimized()) {
+    swapchain_dirty_ = true;
+    return;
+  }
+  swapchain_dirty_ = false;
+
+  // the old swapchain is handed to the new one, then destroyed once every frame that may still
+  // present from it has retired, so resizing never drains the device. Presentation signals
+  // nothing on the timeline, so that is FramesInFlight frames after the last submitted one
+  VkUtils::SwapChainBundle bundle = VkInit::create_swapchain(*capabilities_, *device_, surface_, window_->get_glfw_window(),
+    config_.Present, config_.SwapchainImages, *swapchain_, debug_);
+
+  QueuePoint retire_point = scheduler_->last_point(QueueScheduler::GraphicsQueue);
+  retire_point.Value += config_.FramesInFlight;
+  for (vk::Semaphore semaphore : render_finished_) {
+    deletion_queue_->retire(semaphore, retire_point);
+  }
+  render_finished_.clear();
+  vk::SwapchainKHR retired = *swapchain_;
+  deletion_queue_->retire([this, retired]() { present_latency_->forget(retired); }, retire_point);
+  deletion_queue_->retire(std::move(swapchain_), retire_point);
+
+  swapchain_ = vk::UniqueSwapchainKHR(bundle.Swapchain, *device_);
+  swapchain_images_ = device_->getSwapchainImagesKHR(*swapchain_);
+  swapchain_format_ = bundle.Format;
+  swapchain_extent_ = bundle.Extent;
+
+  render_finished_.resize(swapchain_images_.size());
+  for (vk::Semaphore& semaphore : render_finished_) {
+    semaphore = VkInit::make_semaphore(*device_, debug_);
+  }
+  // fences stay valid, but the image indices they were recorded against don't
+  images_in_flight_.assign(swapchain_images_.size(), nullptr);
+
+  if (debug_) {
+    LOG_DEBUG("Recreated swapchain at " << swapchain_extent_.width << "x" << swapchain_extent_.height);
+  }
+}
+
+void Application::create_offscreen_targets() {
+  vk::Extent2D extent{ config_.Width, config_.Height };
+  VkUtils::OffscreenBundle bundle = VkInit::create_offscreen_targets(*device_, *allocator_, extent, config_.FramesInFlight, debug_);
+  swapchain_images_ = bundle.Images;
+  offscreen_memory_ = bundle.Memory;
+  for (const MemoryAllocation& memory : offscreen_memory_) {
+    offscreen_residency_.push_back(residency_->track(ResidencyCategory::RenderTarget, memory));
+  }
   swapchain_format_ = bundle.Format;
   swapchain_extent_ = bundle.Extent;
+
+  // the offscreen targets are RGBA8 with transfer source usage and never change size, unlike swapchain images
+  if (!config_.CapturePath.empty()) {
+    uint32_t slots = config_.CaptureSlots != 0 ? config_.CaptureSlots : config_.FramesInFlight + 2;
+    readback_ = new FrameReadback(*device_, *allocator_, *scheduler_, bundle.Format, bundle.Extent, slots,
+      config_.CapturePath, config_.Capture, config_.CaptureFps, debug_);
+  }
+}
+
+void Application::create_frame_resources() {
+  if (debug_) {
+    LOG_DEBUG("Creating " << config_.FramesInFlight << " Frames In Flight...");
+  }
+
+  uint32_t graphics_family = capabilities_->Indices.GraphicsFamily.value();
+
+  frames_.resize(config_.FramesInFlight);
+  for (VkUtils::FrameData& frame : frames_) {
+    frame.CommandPool = VkInit::make_command_pool(*device_, graphics_family, vk::CommandPoolCreateFlagBits::eTransient, debug_);
+    frame.CommandBuffer = VkInit::make_command_buffer(*device_, frame.CommandPool, vk::CommandBufferLevel::ePrimary, debug_);
+    frame.ImageAvailable = VkInit::make_semaphore(*device_, debug_);
+    frame.InFlight = VkInit::make_fence(*device_, debug_);
+  }
+
+  render_finished_.resize(swapchain_images_.size());
+  for (vk::Semaphore& semaphore : render_finished_) {
+    semaphore = VkInit::make_semaphore(*device_, debug_);
+  }
+  images_in_flight_.assign(swapchain_images_.size(), nullptr);
+
+  frame_ring_ = new RingBuffer(*device_, *allocator_, 4 * 1024 * 1024,
+    vk::BufferUsageFlagBits::eUniformBuffer | vk::BufferUsageFlagBits::eVertexBuffer |
+    vk::BufferUsageFlagBits::eIndexBuffer | vk::BufferUsageFlagBits::eTransferSrc,
+    config_.FramesInFlight);
+
+  jobs_ = new JobSystem(config_.WorkerThreads);
+  recorder_ = new ParallelRecorder(*device_, graphics_family, config_.FramesInFlight, *jobs_, debug_);
+}
+
+void Application::destroy_frame_resources() {
+  delete recorder_;
+  recorder_ = nullptr;
+  delete jobs_;
+  jobs_ = nullptr;
+  delete frame_ring_;
+  frame_ring_ = nullptr;
+
+  for (VkUtils::FrameData& frame : frames_) {
+    device_->destroyFence(frame.InFlight);
+    device_->destroySemaphore(frame.ImageAvailable);
+    device_->destroyCommandPool(frame.CommandPool);
+  }
+  frames_.clear();
+
+  for (vk::Semaphore semaphore : render_finished_) {
+    device_->destroySemaphore(semaphore);
+  }
+  render_finished_.clear();
+  images_in_flight_.clear();
 }
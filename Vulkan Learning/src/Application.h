@@ -1,37 +1,149 @@
 #pragma once
-#include "WindowsWindow.h"
+#include "Capture/FrameReadback.h"
+#include "Config.h"
+#include "Descriptors/BindlessHeap.h"
+#include "FrameStats.h"
+#include "JobSystem.h"
+#include "Memory/DeletionQueue.h"
+#include "Memory/MemoryAllocator.h"
+#include "Memory/ResidencyManager.h"
+#include "Memory/RingBuffer.h"
+#include "ParallelRecorder.h"
+#include "Pipelines/PipelineCache.h"
+#include "Pipelines/PipelineService.h"
+#include "Presentation/PresentLatency.h"
+#include "Profiling/GpuProfiler.h"
+#include "RenderGraph/RenderGraph.h"
+#include "Scheduling/QueueScheduler.h"
+#include "Shaders/ShaderLibrary.h"
+#include "StartupTimer.h"
+#include "Transfer/UploadEngine.h"
+#include "Window.h"
+#include "VkUtils/Frame.h"
+
+#include <future>
+
+namespace VkUtils {
+  struct DeviceCapabilities;
+}
 
 class Application {
 public:
-  Application();
+  Application(const AppConfig& config);
   ~Application();
   
   void run();
+  void run_recording_benchmark();
+  void run_culling_benchmark();
+  void run_async_compute_benchmark();
+  void run_asset_benchmark();
+  void run_split_device_benchmark();
 
 private:
-  void create_instance();
+  // called off the main thread while the window is created
+  void create_instance(const std::vector<const char*>& window_extensions);
   void create_debug_messenger();
 
-  void create_physical_device();
+  // candidates come from VkInit::query_physical_devices, the surface half is queried here
+  void create_physical_device(std::vector<VkUtils::DeviceCapabilities> candidates);
   void create_logical_device();
+  // takes the pipeline cache file read while the device was being created
+  void create_pipeline_services(std::vector<uint8_t> pipeline_cache_data);
+  void create_secondary_devices();
+  void destroy_secondary_devices();
   void create_swapchain();
+  // rebuilds the swapchain for the current surface extent without stalling the device
+  void recreate_swapchain();
+  void create_offscreen_targets();
+  void create_frame_resources();
+  void destroy_frame_resources();
+
+  void render();
+  void record_commands(vk::CommandBuffer command_buffer, uint32_t image_index);
+  // the frame's commands between begin and end, profiled as one scope
+  void record_frame(vk::CommandBuffer command_buffer, uint32_t image_index);
+  // stand-in for scene draws until there is a scene to record
+  static void record_items(vk::CommandBuffer command_buffer, uint32_t begin, uint32_t end);
 
   vk::Instance instance_;
   vk::DebugUtilsMessengerEXT debug_messenger_;
   vk::DispatchLoaderDynamic dispatch_loader_;
   vk::SurfaceKHR surface_;
 
-  vk::SwapchainKHR swapchain_;
+  vk::UniqueSwapchainKHR swapchain_;
   std::vector<vk::Image> swapchain_images_;
   vk::Format swapchain_format_;
   vk::Extent2D swapchain_extent_;
+  // backing memory for swapchain_images_ when headless
+  std::vector<MemoryAllocation> offscreen_memory_;
+  std::vector<uint64_t> offscreen_residency_;
+  // streams headless frames to --capture, null otherwise
+  FrameReadback* readback_ = nullptr;
+  // set on out-of-date/suboptimal results, or when recreation had to wait for a non-zero extent
+  bool swapchain_dirty_ = false;
 
   vk::PhysicalDevice physical_device_;
-  vk::Device device_;
+  // queried once for the chosen device, shared by every init stage
+  VkUtils::DeviceCapabilities* capabilities_ = nullptr;
+  // released by hand in ~Application, after everything created from it
+  vk::UniqueDevice device_;
+
+  // additional devices opened for split workloads, they never present. Each
+  // has its own allocator, freed before its device in destroy_secondary_devices
+  struct SecondaryDevice {
+    std::string Name;
+    vk::PhysicalDevice PhysicalDevice;
+    vk::UniqueDevice Device;
+    MemoryAllocator* Allocator = nullptr;
+    vk::Queue Queue;
+    uint32_t Family = 0;
+  };
+  std::vector<SecondaryDevice> secondary_devices_;
+  MemoryAllocator* allocator_ = nullptr;
+  // per heap budgets from VK_EXT_memory_budget, releases streamable resources under pressure
+  ResidencyManager* residency_ = nullptr;
+  // transient per-frame uniform/vertex data
+  RingBuffer* frame_ring_ = nullptr;
+  PipelineCache* pipeline_cache_ = nullptr;
+  // asynchronous, deduplicated pipeline creation through pipeline_cache_
+  PipelineService* pipeline_service_ = nullptr;
+  ShaderCompiler* shader_compiler_ = nullptr;
+  // every shader module, recompiled from source on change with --hot-reload
+  ShaderLibrary* shaders_ = nullptr;
+  // global descriptor set every pipeline indexes into, null without descriptor indexing
+  BindlessHeap* bindless_ = nullptr;
+  // rebuilt every frame, places the barriers between the frame's passes
+  RenderGraph* frame_graph_ = nullptr;
   vk::Queue graphics_queue_;
   vk::Queue present_queue_;
+  vk::Queue transfer_queue_;
+  // submits to the graphics and compute queues, ordered by timeline semaphores
+  QueueScheduler* scheduler_ = nullptr;
+  // destroys retired objects once the graphics timeline passes their point
+  DeletionQueue* deletion_queue_ = nullptr;
+  UploadEngine* upload_engine_ = nullptr;
+  // upload timeline value the frame being recorded has to wait on
+  uint64_t upload_wait_ = 0;
+
+  std::vector<VkUtils::FrameData> frames_;
+  // one per swapchain image, since presentation of an image may outlive its frame slot
+  std::vector<vk::Semaphore> render_finished_;
+  // fence of the frame that last rendered each swapchain image
+  std::vector<vk::Fence> images_in_flight_;
+  uint32_t current_frame_ = 0;
+  uint64_t frame_number_ = 0;
+  FrameStats frame_stats_;
+  // null when headless
+  PresentLatency* present_latency_ = nullptr;
+  // null unless profiling was requested, scopes accept the null pointer
+  GpuProfiler* profiler_ = nullptr;
+
+  JobSystem* jobs_ = nullptr;
+  ParallelRecorder* recorder_ = nullptr;
 
-  WindowsWindow* window_;
+  StartupTimer startup_timer_;
+  Window* window_ = nullptr;
+  AppConfig config_;
 
   bool running_ = true;
   bool debug_ = true;
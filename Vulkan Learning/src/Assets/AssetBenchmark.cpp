@@ -0,0 +1,259 @@
+#include "Assets/AssetBenchmark.h"
+#include "Assets/AssetPacker.h"
+#include "Assets/AssetSources.h"
+
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+
+namespace {
+  const uint32_t MeshCount = 48;
+  const uint32_t TextureCount = 24;
+  const uint32_t TextureSize = 1024;
+
+  double elapsed_ms(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+  }
+
+  bool ends_with(const std::string& text, const char* suffix) {
+    size_t length = strlen(suffix);
+    return text.size() >= length && text.compare(text.size() - length, length, suffix) == 0;
+  }
+
+  // a UV sphere as an exporter would write it, one quad per face
+  void write_sphere_obj(const std::string& path, uint32_t rings, uint32_t segments) {
+    std::ofstream file(path);
+    const float pi = 3.14159265f;
+    for (uint32_t ring = 0; ring <= rings; ++ring) {
+      float theta = pi * ring / rings;
+      for (uint32_t segment = 0; segment <= segments; ++segment) {
+        float phi = 2.0f * pi * segment / segments;
+        float x = std::sin(theta) * std::cos(phi);
+        float y = std::cos(theta);
+        float z = std::sin(theta) * std::sin(phi);
+        file << "v " << x << " " << y << " " << z << "\n";
+        file << "vt " << static_cast<float>(segment) / segments << " " << static_cast<float>(ring) / rings << "\n";
+        file << "vn " << x << " " << y << " " << z << "\n";
+      }
+    }
+    for (uint32_t ring = 0; ring < rings; ++ring) {
+      for (uint32_t segment = 0; segment < segments; ++segment) {
+        uint32_t a = ring * (segments + 1) + segment + 1;
+        uint32_t b = a + segments + 1;
+        file << "f " << a << "/" << a << "/" << a << " " << b << "/" << b << "/" << b << " "
+          << b + 1 << "/" << b + 1 << "/" << b + 1 << " " << a + 1 << "/" << a + 1 << "/" << a + 1 << "\n";
+      }
+    }
+  }
+
+  // legacy header, DXT1 or 32-bit RGBA masks, with a full mip chain of noise
+  void write_dds(const std::string& path, vk::Format format, uint32_t size, uint32_t seed) {
+    uint32_t levels = 1;
+    while ((size >> levels) > 0) {
+      ++levels;
+    }
+    bool compressed = format == vk::Format::eBc1RgbaUnormBlock;
+
+    uint32_t header[32] = {};
+    header[0] = 0x20534444; // "DDS "
+    header[1] = 124;
+    header[2] = 0x1 | 0x2 | 0x4 | 0x1000 | 0x20000; // caps, height, width, pixel format, mip count
+    header[3] = size;
+    header[4] = size;
+    header[7] = levels;
+    header[19] = 32;
+    if (compressed) {
+      header[20] = 0x4;
+      header[21] = 0x31545844; // "DXT1"
+    }
+    else {
+      header[20] = 0x41;
+      header[22] = 32;
+      header[23] = 0x000000ff;
+      header[24] = 0x0000ff00;
+      header[25] = 0x00ff0000;
+      header[26] = 0xff000000;
+    }
+    header[27] = 0x1000 | 0x400000 | 0x8; // texture, mipmap, complex
+
+    std::ofstream file(path, std::ios::binary);
+    file.write(reinterpret_cast<const char*>(header), sizeof(header));
+    uint32_t state = seed * 2654435761u + 1;
+    std::vector<uint32_t> words;
+    for (uint32_t level = 0; level < levels; ++level) {
+      uint32_t extent = (std::max)(size >> level, 1u);
+      words.resize(static_cast<size_t>(texture_level_size(format, extent, extent) / 4));
+      for (uint32_t& word : words) {
+        state = state * 1664525u + 1013904223u;
+        word = state;
+      }
+      file.write(reinterpret_cast<const char*>(words.data()), words.size() * sizeof(uint32_t));
+    }
+  }
+}
+
+AssetBenchmark::AssetBenchmark(const vk::Device& device, MemoryAllocator& allocator, UploadEngine& uploads, vk::Queue queue,
+  uint32_t queue_family, bool block_compression, const std::string& directory, const std::string& pack_path, const bool debug)
+  : device_(device), allocator_(allocator), uploads_(uploads), queue_(queue), block_compression_(block_compression),
+  directory_(directory), pack_path_(pack_path), debug_(debug) {
+  vk::CommandPoolCreateInfo pool_info{};
+  pool_info.flags = vk::CommandPoolCreateFlagBits::eResetCommandBuffer;
+  pool_info.queueFamilyIndex = queue_family;
+  command_pool_ = device_.createCommandPool(pool_info);
+  vk::CommandBufferAllocateInfo allocate_info{ command_pool_, vk::CommandBufferLevel::ePrimary, 1 };
+  command_buffer_ = device_.allocateCommandBuffers(allocate_info)[0];
+  fence_ = device_.createFence(vk::FenceCreateInfo{});
+}
+
+AssetBenchmark::~AssetBenchmark() {
+  device_.destroyFence(fence_);
+  device_.destroyCommandPool(command_pool_);
+}
+
+void AssetBenchmark::run() {
+  std::vector<std::string> sources = source_files();
+  if (sources.empty()) {
+    generate_assets();
+    sources = source_files();
+  }
+  if (pack_asset_directory(directory_, pack_path_) != 0) {
+    LOG_ERROR("Some assets failed to pack, the two paths load different sets");
+  }
+
+  std::vector<std::string> pack_files = { pack_path_ };
+  uint64_t source_bytes = 0;
+  for (const std::string& source : sources) {
+    source_bytes += std::filesystem::file_size(source);
+  }
+  std::cout << "Loading " << sources.size() << " assets, " << source_bytes / (1024.0 * 1024.0) << "MB of sources, "
+    << std::filesystem::file_size(pack_path_) / (1024.0 * 1024.0) << "MB packed:" << std::endl;
+
+  for (bool packed : { false, true }) {
+    for (bool cold : { true, false }) {
+      bool evicted = true;
+      if (cold) {
+        for (const std::string& file : packed ? pack_files : sources) {
+          evicted = evict_file_cache(file) && evicted;
+        }
+      }
+
+      LoadTimes times = packed ? load_packed() : load_parsed(sources);
+      std::cout << "  " << (packed ? "mapped pack" : "parse at load") << ", " << (cold ? "cold" : "warm") << ": "
+        << times.ReadyMs << "ms until ready, " << times.CpuMs << "ms on the CPU, " << times.Bytes / (1024.0 * 1024.0)
+        << "MB uploaded" << (cold && !evicted ? " (the page cache could not be dropped, this is a warm load)" : "") << std::endl;
+    }
+  }
+}
+
+void AssetBenchmark::generate_assets() {
+  LOG_INFO("Generating " << MeshCount << " meshes and " << TextureCount << " textures in " << directory_);
+  std::filesystem::create_directories(directory_);
+  for (uint32_t i = 0; i < MeshCount; ++i) {
+    write_sphere_obj(directory_ + "/mesh_" + std::to_string(i) + ".obj", 48 + i, 96 + 2 * i);
+  }
+  // without BC support the textures are what an uncompressed pipeline would ship
+  vk::Format format = block_compression_ ? vk::Format::eBc1RgbaUnormBlock : vk::Format::eR8G8B8A8Unorm;
+  for (uint32_t i = 0; i < TextureCount; ++i) {
+    write_dds(directory_ + "/texture_" + std::to_string(i) + ".dds", format, TextureSize, i);
+  }
+}
+
+std::vector<std::string> AssetBenchmark::source_files() const {
+  std::vector<std::string> sources;
+  std::error_code error;
+  for (const auto& entry : std::filesystem::recursive_directory_iterator(directory_, error)) {
+    std::string path = entry.path().generic_string();
+    if (entry.is_regular_file() && (ends_with(path, ".obj") || ends_with(path, ".dds"))) {
+      sources.push_back(path);
+    }
+  }
+  std::sort(sources.begin(), sources.end());
+  return sources;
+}
+
+AssetBenchmark::LoadTimes AssetBenchmark::load_parsed(const std::vector<std::string>& sources) {
+  LoadTimes times;
+  uint64_t ready = 0;
+  auto start = std::chrono::steady_clock::now();
+  for (const std::string& source : sources) {
+    // parsed data only has to live until the upload engine copied it into staging
+    if (ends_with(source, ".obj")) {
+      ParsedMesh mesh = parse_obj(source);
+      meshes_.push_back(upload_mesh(device_, allocator_, uploads_, mesh.view()));
+      ready = (std::max)(ready, meshes_.back().Ready);
+      times.Bytes += (mesh.Vertices.size() * sizeof(PackVertex)) + mesh.Indices.size() * sizeof(uint32_t);
+    }
+    else {
+      ParsedTexture texture = parse_dds(source);
+      if (!block_compression_ && texture.Format != vk::Format::eR8G8B8A8Unorm) {
+        continue;
+      }
+      textures_.push_back(upload_texture(device_, allocator_, uploads_, texture.view()));
+      ready = (std::max)(ready, textures_.back().Ready);
+      times.Bytes += texture.Data.size();
+    }
+  }
+  uploads_.flush();
+  times.CpuMs = elapsed_ms(start);
+  finish(ready);
+  times.ReadyMs = elapsed_ms(start);
+  return times;
+}
+
+AssetBenchmark::LoadTimes AssetBenchmark::load_packed() {
+  LoadTimes times;
+  uint64_t ready = 0;
+  auto start = std::chrono::steady_clock::now();
+  {
+    AssetPack pack(pack_path_);
+    for (const PackEntry& entry : pack.entries()) {
+      if (entry.Kind == AssetKind::Mesh) {
+        meshes_.push_back(upload_mesh(device_, allocator_, uploads_, pack.mesh(entry)));
+        ready = (std::max)(ready, meshes_.back().Ready);
+      }
+      else {
+        if (!block_compression_ && static_cast<vk::Format>(entry.Format) != vk::Format::eR8G8B8A8Unorm) {
+          continue;
+        }
+        textures_.push_back(upload_texture(device_, allocator_, uploads_, pack.texture(entry)));
+        ready = (std::max)(ready, textures_.back().Ready);
+      }
+      times.Bytes += entry.Size;
+    }
+    // every view has been copied into staging, the mapping can go
+    uploads_.flush();
+  }
+  times.CpuMs = elapsed_ms(start);
+  finish(ready);
+  times.ReadyMs = elapsed_ms(start);
+  return times;
+}
+
+void AssetBenchmark::finish(uint64_t ready) {
+  uploads_.wait(ready);
+
+  // with a dedicated transfer family the graphics queue has to acquire everything before using it
+  device_.resetFences(fence_);
+  command_buffer_.reset();
+  vk::CommandBufferBeginInfo begin_info{};
+  begin_info.flags = vk::CommandBufferUsageFlagBits::eOneTimeSubmit;
+  command_buffer_.begin(begin_info);
+  uploads_.record_acquires(command_buffer_);
+  command_buffer_.end();
+  vk::SubmitInfo submit_info{};
+  submit_info.commandBufferCount = 1;
+  submit_info.pCommandBuffers = &command_buffer_;
+  queue_.submit(submit_info, fence_);
+  (void)device_.waitForFences(fence_, VK_TRUE, UINT64_MAX);
+
+  for (GpuMeshAsset& mesh : meshes_) {
+    destroy_mesh(device_, allocator_, mesh);
+  }
+  for (GpuTextureAsset& texture : textures_) {
+    destroy_texture(device_, allocator_, texture);
+  }
+  meshes_.clear();
+  textures_.clear();
+}
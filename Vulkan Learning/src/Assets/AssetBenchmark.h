@@ -0,0 +1,49 @@
+#pragma once
+#include "Headers.h"
+#include "Assets/AssetLoader.h"
+
+#include <string>
+
+// Loads the same meshes and textures twice: parsed from OBJ and DDS at load
+// time, and straight out of a memory-mapped pack baked from them. Each path
+// runs cold, with the files dropped from the OS page cache where possible,
+// and warm. Times cover reading, parsing, staging and the GPU copies up to
+// the graphics queue owning the resources. When the directory holds no
+// assets a synthetic set is generated into it first.
+class AssetBenchmark {
+public:
+  AssetBenchmark(const vk::Device& device, MemoryAllocator& allocator, UploadEngine& uploads, vk::Queue queue,
+    uint32_t queue_family, bool block_compression, const std::string& directory, const std::string& pack_path, const bool debug);
+  ~AssetBenchmark();
+
+  void run();
+
+private:
+  struct LoadTimes {
+    double CpuMs = 0.0;
+    double ReadyMs = 0.0;
+    uint64_t Bytes = 0;
+  };
+
+  void generate_assets();
+  std::vector<std::string> source_files() const;
+  LoadTimes load_parsed(const std::vector<std::string>& sources);
+  LoadTimes load_packed();
+  // waits for the uploads, hands the resources to the graphics queue and frees them
+  void finish(uint64_t ready);
+
+  vk::Device device_;
+  MemoryAllocator& allocator_;
+  UploadEngine& uploads_;
+  vk::Queue queue_;
+  bool block_compression_;
+  std::string directory_;
+  std::string pack_path_;
+  bool debug_;
+
+  vk::CommandPool command_pool_;
+  vk::CommandBuffer command_buffer_;
+  vk::Fence fence_;
+  std::vector<GpuMeshAsset> meshes_;
+  std::vector<GpuTextureAsset> textures_;
+};
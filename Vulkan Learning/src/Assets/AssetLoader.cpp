@@ -0,0 +1,90 @@
+#include "Assets/AssetLoader.h"
+
+namespace {
+  vk::Buffer create_buffer(const vk::Device& device, vk::DeviceSize size, vk::BufferUsageFlags usage) {
+    vk::BufferCreateInfo buffer_info{};
+    buffer_info.size = size;
+    buffer_info.usage = usage | vk::BufferUsageFlagBits::eTransferDst;
+    buffer_info.sharingMode = vk::SharingMode::eExclusive;
+    try {
+      return device.createBuffer(buffer_info);
+    }
+    catch (vk::SystemError e) {
+      throw std::runtime_error("Failed to create mesh buffer!");
+    }
+  }
+}
+
+GpuMeshAsset upload_mesh(const vk::Device& device, MemoryAllocator& allocator, UploadEngine& uploads, const MeshView& mesh) {
+  GpuMeshAsset asset;
+  vk::DeviceSize vertex_size = static_cast<vk::DeviceSize>(mesh.VertexCount) * sizeof(PackVertex);
+  vk::DeviceSize index_size = static_cast<vk::DeviceSize>(mesh.IndexCount) * sizeof(uint32_t);
+  if (vertex_size == 0 || index_size == 0) {
+    throw std::runtime_error("Failed to upload mesh, it has no triangles!");
+  }
+
+  // storage usage lets the culling and bindless paths read them too
+  asset.VertexBuffer = create_buffer(device, vertex_size, vk::BufferUsageFlagBits::eVertexBuffer | vk::BufferUsageFlagBits::eStorageBuffer);
+  asset.VertexMemory = allocator.allocate_for_buffer(asset.VertexBuffer, vk::MemoryPropertyFlagBits::eDeviceLocal);
+  asset.IndexBuffer = create_buffer(device, index_size, vk::BufferUsageFlagBits::eIndexBuffer | vk::BufferUsageFlagBits::eStorageBuffer);
+  asset.IndexMemory = allocator.allocate_for_buffer(asset.IndexBuffer, vk::MemoryPropertyFlagBits::eDeviceLocal);
+  asset.IndexCount = mesh.IndexCount;
+
+  uploads.upload_buffer(asset.VertexBuffer, 0, mesh.Vertices, vertex_size);
+  asset.Ready = uploads.upload_buffer(asset.IndexBuffer, 0, mesh.Indices, index_size);
+  return asset;
+}
+
+GpuTextureAsset upload_texture(const vk::Device& device, MemoryAllocator& allocator, UploadEngine& uploads, const TextureView& texture) {
+  GpuTextureAsset asset;
+  asset.Format = texture.Format;
+  asset.Extent = vk::Extent2D{ texture.Width, texture.Height };
+  asset.MipLevels = texture.MipLevels;
+
+  vk::ImageCreateInfo image_info{};
+  image_info.imageType = vk::ImageType::e2D;
+  image_info.format = texture.Format;
+  image_info.extent = vk::Extent3D{ texture.Width, texture.Height, 1 };
+  image_info.mipLevels = texture.MipLevels;
+  image_info.arrayLayers = 1;
+  image_info.samples = vk::SampleCountFlagBits::e1;
+  image_info.tiling = vk::ImageTiling::eOptimal;
+  image_info.usage = vk::ImageUsageFlagBits::eSampled | vk::ImageUsageFlagBits::eTransferDst;
+  image_info.sharingMode = vk::SharingMode::eExclusive;
+  image_info.initialLayout = vk::ImageLayout::eUndefined;
+  try {
+    asset.Image = device.createImage(image_info);
+  }
+  catch (vk::SystemError e) {
+    throw std::runtime_error("Failed to create texture image!");
+  }
+  asset.Memory = allocator.allocate_for_image(asset.Image, vk::MemoryPropertyFlagBits::eDeviceLocal);
+
+  uint64_t offset = 0;
+  for (uint32_t level = 0; level < texture.MipLevels; ++level) {
+    uint32_t width = (std::max)(texture.Width >> level, 1u);
+    uint32_t height = (std::max)(texture.Height >> level, 1u);
+    uint64_t size = texture_level_size(texture.Format, width, height);
+    if (offset + size > texture.Size) {
+      throw std::runtime_error("Failed to upload texture, the mip chain is truncated!");
+    }
+    asset.Ready = uploads.upload_image(asset.Image, vk::Extent3D{ width, height, 1 }, level, 0, texture.Data + offset, size,
+      vk::ImageLayout::eShaderReadOnlyOptimal);
+    offset += size;
+  }
+  return asset;
+}
+
+void destroy_mesh(const vk::Device& device, MemoryAllocator& allocator, GpuMeshAsset& mesh) {
+  device.destroyBuffer(mesh.VertexBuffer);
+  allocator.free(mesh.VertexMemory);
+  device.destroyBuffer(mesh.IndexBuffer);
+  allocator.free(mesh.IndexMemory);
+  mesh = GpuMeshAsset{};
+}
+
+void destroy_texture(const vk::Device& device, MemoryAllocator& allocator, GpuTextureAsset& texture) {
+  device.destroyImage(texture.Image);
+  allocator.free(texture.Memory);
+  texture = GpuTextureAsset{};
+}
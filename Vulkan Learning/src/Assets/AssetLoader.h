@@ -0,0 +1,36 @@
+#pragma once
+#include "Headers.h"
+#include "Assets/AssetPack.h"
+#include "Memory/MemoryAllocator.h"
+#include "Transfer/UploadEngine.h"
+
+struct GpuMeshAsset {
+  vk::Buffer VertexBuffer;
+  MemoryAllocation VertexMemory;
+  vk::Buffer IndexBuffer;
+  MemoryAllocation IndexMemory;
+  uint32_t IndexCount = 0;
+  // upload timeline value after which both buffers are ready
+  uint64_t Ready = 0;
+};
+
+struct GpuTextureAsset {
+  vk::Image Image;
+  MemoryAllocation Memory;
+  vk::Format Format = vk::Format::eUndefined;
+  vk::Extent2D Extent;
+  uint32_t MipLevels = 1;
+  // every level is in ShaderReadOnlyOptimal after this upload timeline value
+  uint64_t Ready = 0;
+};
+
+// Creates device local resources and queues their contents on the upload
+// engine. The views are memcpy'd once into staging, so pointing them into a
+// mapped AssetPack means no other copy or parse on the way to the GPU.
+// Uploads are only queued; flush the engine and wait on Ready before use.
+GpuMeshAsset upload_mesh(const vk::Device& device, MemoryAllocator& allocator, UploadEngine& uploads, const MeshView& mesh);
+GpuTextureAsset upload_texture(const vk::Device& device, MemoryAllocator& allocator, UploadEngine& uploads, const TextureView& texture);
+
+// the GPU must be done with them
+void destroy_mesh(const vk::Device& device, MemoryAllocator& allocator, GpuMeshAsset& mesh);
+void destroy_texture(const vk::Device& device, MemoryAllocator& allocator, GpuTextureAsset& texture);
@@ -0,0 +1,96 @@
+#include "Assets/AssetPack.h"
+
+#include <cstring>
+
+uint64_t texture_level_size(vk::Format format, uint32_t width, uint32_t height) {
+  uint64_t blocks = static_cast<uint64_t>((width + 3) / 4) * ((height + 3) / 4);
+  switch (format) {
+  case vk::Format::eBc1RgbUnormBlock:
+  case vk::Format::eBc1RgbSrgbBlock:
+  case vk::Format::eBc1RgbaUnormBlock:
+  case vk::Format::eBc1RgbaSrgbBlock:
+  case vk::Format::eBc4UnormBlock:
+  case vk::Format::eBc4SnormBlock:
+    return blocks * 8;
+  case vk::Format::eBc2UnormBlock:
+  case vk::Format::eBc2SrgbBlock:
+  case vk::Format::eBc3UnormBlock:
+  case vk::Format::eBc3SrgbBlock:
+  case vk::Format::eBc5UnormBlock:
+  case vk::Format::eBc5SnormBlock:
+  case vk::Format::eBc6HUfloatBlock:
+  case vk::Format::eBc6HSfloatBlock:
+  case vk::Format::eBc7UnormBlock:
+  case vk::Format::eBc7SrgbBlock:
+    return blocks * 16;
+  case vk::Format::eR8G8B8A8Unorm:
+  case vk::Format::eR8G8B8A8Srgb:
+  case vk::Format::eB8G8R8A8Unorm:
+  case vk::Format::eB8G8R8A8Srgb:
+    return static_cast<uint64_t>(width) * height * 4;
+  default:
+    throw std::runtime_error("Unsupported texture format " + vk::to_string(format) + "!");
+  }
+}
+
+AssetPack::AssetPack(const std::string& path)
+  : file_(std::make_unique<MappedFile>(path)) {
+  if (file_->size() < sizeof(PackHeader)) {
+    throw std::runtime_error("Failed to open asset pack " + path + ", the file is truncated!");
+  }
+  PackHeader header;
+  memcpy(&header, file_->data(), sizeof(PackHeader));
+  if (header.Magic != PackMagic || header.Version != PackVersion) {
+    throw std::runtime_error("Failed to open asset pack " + path + ", wrong magic or version!");
+  }
+  uint64_t toc_size = static_cast<uint64_t>(header.EntryCount) * sizeof(PackEntry);
+  if (header.FileSize != file_->size() || header.TocOffset + toc_size > file_->size()) {
+    throw std::runtime_error("Failed to open asset pack " + path + ", the file is truncated!");
+  }
+
+  entries_.resize(header.EntryCount);
+  memcpy(entries_.data(), file_->data() + header.TocOffset, toc_size);
+  for (const PackEntry& entry : entries_) {
+    if (entry.Offset + entry.Size > header.TocOffset || entry.Name[sizeof(entry.Name) - 1] != '\0') {
+      throw std::runtime_error("Failed to open asset pack " + path + ", corrupt table of contents!");
+    }
+  }
+}
+
+const std::vector<PackEntry>& AssetPack::entries() const {
+  return entries_;
+}
+
+const PackEntry* AssetPack::find(const std::string& name) const {
+  auto it = std::lower_bound(entries_.begin(), entries_.end(), name, [](const PackEntry& entry, const std::string& key) {
+    return strcmp(entry.Name, key.c_str()) < 0;
+  });
+  return it != entries_.end() && name == it->Name ? &*it : nullptr;
+}
+
+MeshView AssetPack::mesh(const PackEntry& entry) const {
+  const uint8_t* blob = file_->data() + entry.Offset;
+  MeshView view;
+  view.Vertices = reinterpret_cast<const PackVertex*>(blob);
+  view.VertexCount = entry.VertexCount;
+  view.Indices = reinterpret_cast<const uint32_t*>(blob + entry.IndexOffset);
+  view.IndexCount = entry.IndexCount;
+  return view;
+}
+
+TextureView AssetPack::texture(const PackEntry& entry) const {
+  TextureView view;
+  view.Format = static_cast<vk::Format>(entry.Format);
+  view.Width = entry.Width;
+  view.Height = entry.Height;
+  view.MipLevels = entry.MipLevels;
+  view.Data = file_->data() + entry.Offset;
+  view.Size = entry.Size;
+  // start reading ahead now, the upload touches the pages in order
+  file_->prefetch(entry.Offset, entry.Size);
+  return view;
+}
+
+uint64_t AssetPack::size() const {
+  return file_->size();
+}
@@ -0,0 +1,98 @@
+#pragma once
+#include "Headers.h"
+#include "Assets/MappedFile.h"
+
+#include <memory>
+
+// On-disk layout of a pack, little endian. A header, the asset blobs each
+// starting on a PackAlignment boundary, then the table of contents sorted by
+// name. Bump PackVersion whenever any of these structs change.
+constexpr uint32_t PackMagic = 0x50414b56; // "VKAP"
+constexpr uint32_t PackVersion = 1;
+// page sized, so a blob can be mapped or read unbuffered on its own
+constexpr uint64_t PackAlignment = 4096;
+
+enum class AssetKind : uint32_t {
+  Mesh = 1,
+  Texture = 2
+};
+
+struct PackHeader {
+  uint32_t Magic = PackMagic;
+  uint32_t Version = PackVersion;
+  uint32_t EntryCount = 0;
+  uint32_t Alignment = static_cast<uint32_t>(PackAlignment);
+  uint64_t TocOffset = 0;
+  uint64_t FileSize = 0;
+};
+
+// interleaved mesh vertex, what the packer bakes every mesh to
+struct PackVertex {
+  float Position[3];
+  float Normal[3];
+  float Uv[2];
+};
+
+struct PackEntry {
+  // relative to the packed directory, NUL terminated
+  char Name[64] = {};
+  AssetKind Kind = AssetKind::Mesh;
+  // VkFormat of textures, unused for meshes
+  uint32_t Format = 0;
+  uint64_t Offset = 0;
+  uint64_t Size = 0;
+  // meshes: PackVertex array, then 32-bit indices at IndexOffset from the blob start
+  uint32_t VertexCount = 0;
+  uint32_t IndexCount = 0;
+  uint64_t IndexOffset = 0;
+  // textures: every mip level tightly packed, largest first
+  uint32_t Width = 0;
+  uint32_t Height = 0;
+  uint32_t MipLevels = 0;
+  uint32_t Reserved[5] = {};
+};
+
+static_assert(sizeof(PackHeader) == 32, "PackHeader is part of the file format");
+static_assert(sizeof(PackVertex) == 32, "PackVertex is part of the file format");
+static_assert(sizeof(PackEntry) == 136, "PackEntry is part of the file format");
+
+// mesh data as the uploader wants it, pointing into a pack or into parsed vectors
+struct MeshView {
+  const PackVertex* Vertices = nullptr;
+  uint32_t VertexCount = 0;
+  const uint32_t* Indices = nullptr;
+  uint32_t IndexCount = 0;
+};
+
+struct TextureView {
+  vk::Format Format = vk::Format::eUndefined;
+  uint32_t Width = 0;
+  uint32_t Height = 0;
+  uint32_t MipLevels = 1;
+  // all levels tightly packed, largest first
+  const uint8_t* Data = nullptr;
+  uint64_t Size = 0;
+};
+
+// bytes of one mip level, block compressed formats round up to whole 4x4 blocks
+uint64_t texture_level_size(vk::Format format, uint32_t width, uint32_t height);
+
+// Read side of a pack: maps the file and hands out views straight into the
+// mapping, there is no parsing beyond checking the header and the table of
+// contents. Views stay valid as long as the pack.
+class AssetPack {
+public:
+  // throws on a missing, truncated or foreign file
+  explicit AssetPack(const std::string& path);
+
+  const std::vector<PackEntry>& entries() const;
+  // null when there is no such asset
+  const PackEntry* find(const std::string& name) const;
+  MeshView mesh(const PackEntry& entry) const;
+  TextureView texture(const PackEntry& entry) const;
+  uint64_t size() const;
+
+private:
+  std::unique_ptr<MappedFile> file_;
+  std::vector<PackEntry> entries_;
+};
@@ -0,0 +1,108 @@
+#include "Assets/AssetPacker.h"
+#include "Assets/AssetSources.h"
+
+#include <chrono>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+
+namespace {
+  bool ends_with(const std::string& text, const char* suffix) {
+    size_t length = strlen(suffix);
+    return text.size() >= length && text.compare(text.size() - length, length, suffix) == 0;
+  }
+
+  void pad_to(std::ofstream& file, uint64_t alignment) {
+    static const char zeros[PackAlignment] = {};
+    uint64_t position = static_cast<uint64_t>(file.tellp());
+    uint64_t padding = (alignment - position % alignment) % alignment;
+    file.write(zeros, static_cast<std::streamsize>(padding));
+  }
+}
+
+uint32_t pack_asset_directory(const std::string& directory, const std::string& output) {
+  auto start = std::chrono::steady_clock::now();
+
+  std::vector<std::string> sources;
+  std::error_code error;
+  for (const auto& entry : std::filesystem::recursive_directory_iterator(directory, error)) {
+    std::string path = entry.path().generic_string();
+    if (entry.is_regular_file() && (ends_with(path, ".obj") || ends_with(path, ".dds"))) {
+      sources.push_back(path);
+    }
+  }
+  if (error) {
+    LOG_ERROR("Cannot read asset directory " << directory);
+    return 1;
+  }
+  // the table of contents is searched by name
+  std::sort(sources.begin(), sources.end());
+
+  std::ofstream file(output, std::ios::binary | std::ios::trunc);
+  if (!file) {
+    LOG_ERROR("Cannot create asset pack " << output);
+    return 1;
+  }
+  PackHeader header;
+  file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+
+  std::vector<PackEntry> entries;
+  uint32_t failed = 0;
+  for (const std::string& path : sources) {
+    std::string name = std::filesystem::relative(path, directory).generic_string();
+    if (name.size() >= sizeof(PackEntry::Name)) {
+      ++failed;
+      LOG_ERROR("Asset name " << name << " is longer than " << sizeof(PackEntry::Name) - 1 << " characters");
+      continue;
+    }
+
+    PackEntry entry;
+    memcpy(entry.Name, name.c_str(), name.size());
+    try {
+      pad_to(file, PackAlignment);
+      entry.Offset = static_cast<uint64_t>(file.tellp());
+      if (ends_with(path, ".obj")) {
+        ParsedMesh mesh = parse_obj(path);
+        entry.Kind = AssetKind::Mesh;
+        entry.VertexCount = static_cast<uint32_t>(mesh.Vertices.size());
+        entry.IndexCount = static_cast<uint32_t>(mesh.Indices.size());
+        entry.IndexOffset = mesh.Vertices.size() * sizeof(PackVertex);
+        file.write(reinterpret_cast<const char*>(mesh.Vertices.data()), entry.IndexOffset);
+        file.write(reinterpret_cast<const char*>(mesh.Indices.data()), mesh.Indices.size() * sizeof(uint32_t));
+      }
+      else {
+        ParsedTexture texture = parse_dds(path);
+        entry.Kind = AssetKind::Texture;
+        entry.Format = static_cast<uint32_t>(texture.Format);
+        entry.Width = texture.Width;
+        entry.Height = texture.Height;
+        entry.MipLevels = texture.MipLevels;
+        file.write(reinterpret_cast<const char*>(texture.Data.data()), texture.Data.size());
+      }
+      entry.Size = static_cast<uint64_t>(file.tellp()) - entry.Offset;
+      entries.push_back(entry);
+    }
+    catch (const std::runtime_error& e) {
+      ++failed;
+      LOG_ERROR(e.what());
+    }
+  }
+
+  pad_to(file, PackAlignment);
+  header.EntryCount = static_cast<uint32_t>(entries.size());
+  header.TocOffset = static_cast<uint64_t>(file.tellp());
+  file.write(reinterpret_cast<const char*>(entries.data()), entries.size() * sizeof(PackEntry));
+  header.FileSize = static_cast<uint64_t>(file.tellp());
+  file.seekp(0);
+  file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+  file.close();
+  if (!file) {
+    LOG_ERROR("Failed to write asset pack " << output);
+    return failed + 1;
+  }
+
+  double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+  std::cout << "Packed " << entries.size() << " of " << sources.size() << " assets from " << directory << " into " << output
+    << " (" << header.FileSize / (1024.0 * 1024.0) << "MB) in " << ms << "ms" << std::endl;
+  return failed;
+}
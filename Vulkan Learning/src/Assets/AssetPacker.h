@@ -0,0 +1,8 @@
+#pragma once
+#include <string>
+
+// Offline step: bakes every .obj and .dds below directory into one pack,
+// meshes as interleaved PackVertex data with 32-bit indices and textures
+// as the mip chain exactly as the GPU takes it. Returns the number of assets
+// that failed to bake.
+uint32_t pack_asset_directory(const std::string& directory, const std::string& output);
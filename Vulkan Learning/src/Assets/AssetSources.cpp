@@ -0,0 +1,235 @@
+#include "Assets/AssetSources.h"
+
+#include <array>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <unordered_map>
+
+namespace {
+  std::vector<uint8_t> read_file(const std::string& path) {
+    std::ifstream file(path, std::ios::binary | std::ios::ate);
+    if (!file) {
+      throw std::runtime_error("Failed to open " + path + "!");
+    }
+    std::vector<uint8_t> bytes(static_cast<size_t>(file.tellg()));
+    file.seekg(0);
+    file.read(reinterpret_cast<char*>(bytes.data()), bytes.size());
+    return bytes;
+  }
+
+  uint32_t read_u32(const std::vector<uint8_t>& bytes, size_t offset) {
+    uint32_t value = 0;
+    memcpy(&value, bytes.data() + offset, sizeof(value));
+    return value;
+  }
+
+  uint32_t four_cc(const char* code) {
+    return static_cast<uint32_t>(code[0]) | (static_cast<uint32_t>(code[1]) << 8) |
+      (static_cast<uint32_t>(code[2]) << 16) | (static_cast<uint32_t>(code[3]) << 24);
+  }
+
+  vk::Format dxgi_format(uint32_t dxgi) {
+    switch (dxgi) {
+    case 28: return vk::Format::eR8G8B8A8Unorm;
+    case 29: return vk::Format::eR8G8B8A8Srgb;
+    case 71: return vk::Format::eBc1RgbaUnormBlock;
+    case 72: return vk::Format::eBc1RgbaSrgbBlock;
+    case 74: return vk::Format::eBc2UnormBlock;
+    case 75: return vk::Format::eBc2SrgbBlock;
+    case 77: return vk::Format::eBc3UnormBlock;
+    case 78: return vk::Format::eBc3SrgbBlock;
+    case 80: return vk::Format::eBc4UnormBlock;
+    case 81: return vk::Format::eBc4SnormBlock;
+    case 83: return vk::Format::eBc5UnormBlock;
+    case 84: return vk::Format::eBc5SnormBlock;
+    case 87: return vk::Format::eB8G8R8A8Unorm;
+    case 91: return vk::Format::eB8G8R8A8Srgb;
+    case 95: return vk::Format::eBc6HUfloatBlock;
+    case 96: return vk::Format::eBc6HSfloatBlock;
+    case 98: return vk::Format::eBc7UnormBlock;
+    case 99: return vk::Format::eBc7SrgbBlock;
+    default: return vk::Format::eUndefined;
+    }
+  }
+
+  // 1-based, negative counts back from the end of what was read so far
+  uint32_t resolve_index(long index, size_t count, const std::string& path) {
+    long resolved = index > 0 ? index - 1 : static_cast<long>(count) + index;
+    if (index == 0 || resolved < 0 || resolved >= static_cast<long>(count)) {
+      throw std::runtime_error("Failed to parse " + path + ", face index out of range!");
+    }
+    return static_cast<uint32_t>(resolved);
+  }
+
+  struct CornerHash {
+    size_t operator()(const std::array<uint32_t, 3>& corner) const {
+      uint64_t hash = 14695981039346656037ull;
+      for (uint32_t value : corner) {
+        hash = (hash ^ value) * 1099511628211ull;
+      }
+      return static_cast<size_t>(hash);
+    }
+  };
+}
+
+MeshView ParsedMesh::view() const {
+  return MeshView{ Vertices.data(), static_cast<uint32_t>(Vertices.size()), Indices.data(), static_cast<uint32_t>(Indices.size()) };
+}
+
+TextureView ParsedTexture::view() const {
+  return TextureView{ Format, Width, Height, MipLevels, Data.data(), Data.size() };
+}
+
+ParsedMesh parse_obj(const std::string& path) {
+  std::vector<uint8_t> bytes = read_file(path);
+  bytes.push_back('\0');
+  const char* cursor = reinterpret_cast<const char*>(bytes.data());
+
+  std::vector<std::array<float, 3>> positions;
+  std::vector<std::array<float, 3>> normals;
+  std::vector<std::array<float, 2>> uvs;
+  std::unordered_map<std::array<uint32_t, 3>, uint32_t, CornerHash> corners;
+  ParsedMesh mesh;
+  std::vector<uint32_t> polygon;
+
+  while (*cursor) {
+    const char* line = cursor;
+    while (*cursor && *cursor != '\n') {
+      ++cursor;
+    }
+    if (*cursor) {
+      ++cursor;
+    }
+
+    char* next = nullptr;
+    if (line[0] == 'v' && line[1] == ' ') {
+      std::array<float, 3> position{};
+      position[0] = std::strtof(line + 2, &next);
+      position[1] = std::strtof(next, &next);
+      position[2] = std::strtof(next, &next);
+      positions.push_back(position);
+    }
+    else if (line[0] == 'v' && line[1] == 'n') {
+      std::array<float, 3> normal{};
+      normal[0] = std::strtof(line + 3, &next);
+      normal[1] = std::strtof(next, &next);
+      normal[2] = std::strtof(next, &next);
+      normals.push_back(normal);
+    }
+    else if (line[0] == 'v' && line[1] == 't') {
+      std::array<float, 2> uv{};
+      uv[0] = std::strtof(line + 3, &next);
+      uv[1] = std::strtof(next, &next);
+      uvs.push_back(uv);
+    }
+    else if (line[0] == 'f' && line[1] == ' ') {
+      // v, v/vt, v//vn or v/vt/vn, with 0 standing for a missing attribute below
+      polygon.clear();
+      const char* token = line + 2;
+      while (true) {
+        while (*token == ' ' || *token == '\t') {
+          ++token;
+        }
+        if (*token == '\0' || *token == '\n' || *token == '\r') {
+          break;
+        }
+        std::array<uint32_t, 3> corner{};
+        corner[0] = resolve_index(std::strtol(token, &next, 10), positions.size(), path) + 1;
+        token = next;
+        if (*token == '/') {
+          ++token;
+          if (*token != '/') {
+            corner[1] = resolve_index(std::strtol(token, &next, 10), uvs.size(), path) + 1;
+            token = next;
+          }
+          if (*token == '/') {
+            corner[2] = resolve_index(std::strtol(token + 1, &next, 10), normals.size(), path) + 1;
+            token = next;
+          }
+        }
+
+        auto found = corners.find(corner);
+        if (found == corners.end()) {
+          PackVertex vertex{};
+          memcpy(vertex.Position, positions[corner[0] - 1].data(), sizeof(vertex.Position));
+          if (corner[1] != 0) {
+            memcpy(vertex.Uv, uvs[corner[1] - 1].data(), sizeof(vertex.Uv));
+          }
+          if (corner[2] != 0) {
+            memcpy(vertex.Normal, normals[corner[2] - 1].data(), sizeof(vertex.Normal));
+          }
+          found = corners.emplace(corner, static_cast<uint32_t>(mesh.Vertices.size())).first;
+          mesh.Vertices.push_back(vertex);
+        }
+        polygon.push_back(found->second);
+      }
+
+      for (size_t i = 2; i < polygon.size(); ++i) {
+        mesh.Indices.push_back(polygon[0]);
+        mesh.Indices.push_back(polygon[i - 1]);
+        mesh.Indices.push_back(polygon[i]);
+      }
+    }
+  }
+  return mesh;
+}
+
+ParsedTexture parse_dds(const std::string& path) {
+  std::vector<uint8_t> bytes = read_file(path);
+  const size_t header_size = 128;
+  if (bytes.size() < header_size || read_u32(bytes, 0) != four_cc("DDS ")) {
+    throw std::runtime_error("Failed to parse " + path + ", not a DDS file!");
+  }
+
+  ParsedTexture texture;
+  texture.Height = read_u32(bytes, 12);
+  texture.Width = read_u32(bytes, 16);
+  texture.MipLevels = (std::max)(read_u32(bytes, 28), 1u);
+  uint32_t caps2 = read_u32(bytes, 112);
+  uint32_t pixel_flags = read_u32(bytes, 80);
+  uint32_t code = read_u32(bytes, 84);
+  size_t data_offset = header_size;
+
+  const uint32_t cubemap = 0x200;
+  const uint32_t volume = 0x200000;
+  const uint32_t four_cc_flag = 0x4;
+  if (caps2 & (cubemap | volume)) {
+    throw std::runtime_error("Failed to parse " + path + ", only 2D textures are supported!");
+  }
+
+  if ((pixel_flags & four_cc_flag) && code == four_cc("DX10")) {
+    const size_t dx10_size = 20;
+    if (bytes.size() < header_size + dx10_size || read_u32(bytes, header_size + 12) != 1) {
+      throw std::runtime_error("Failed to parse " + path + ", texture arrays are not supported!");
+    }
+    texture.Format = dxgi_format(read_u32(bytes, header_size));
+    data_offset += dx10_size;
+  }
+  else if (pixel_flags & four_cc_flag) {
+    texture.Format = code == four_cc("DXT1") ? vk::Format::eBc1RgbaUnormBlock :
+      code == four_cc("DXT3") ? vk::Format::eBc2UnormBlock :
+      code == four_cc("DXT5") ? vk::Format::eBc3UnormBlock :
+      code == four_cc("ATI1") || code == four_cc("BC4U") ? vk::Format::eBc4UnormBlock :
+      code == four_cc("ATI2") || code == four_cc("BC5U") ? vk::Format::eBc5UnormBlock : vk::Format::eUndefined;
+  }
+  else if (read_u32(bytes, 88) == 32 && read_u32(bytes, 92) == 0x000000ff) {
+    texture.Format = vk::Format::eR8G8B8A8Unorm;
+  }
+  else if (read_u32(bytes, 88) == 32 && read_u32(bytes, 92) == 0x00ff0000) {
+    texture.Format = vk::Format::eB8G8R8A8Unorm;
+  }
+  if (texture.Format == vk::Format::eUndefined) {
+    throw std::runtime_error("Failed to parse " + path + ", unsupported pixel format!");
+  }
+
+  uint64_t size = 0;
+  for (uint32_t level = 0; level < texture.MipLevels; ++level) {
+    size += texture_level_size(texture.Format, (std::max)(texture.Width >> level, 1u), (std::max)(texture.Height >> level, 1u));
+  }
+  if (data_offset + size > bytes.size()) {
+    throw std::runtime_error("Failed to parse " + path + ", the mip chain is truncated!");
+  }
+  texture.Data.assign(bytes.begin() + data_offset, bytes.begin() + data_offset + size);
+  return texture;
+}
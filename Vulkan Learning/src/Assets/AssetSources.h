@@ -0,0 +1,34 @@
+#pragma once
+#include "Headers.h"
+#include "Assets/AssetPack.h"
+
+#include <string>
+#include <vector>
+
+// Parsers for the source formats the packer bakes. The parse-at-load path of
+// the asset benchmark uses the same code, so it measures what skipping them
+// at runtime saves.
+
+struct ParsedMesh {
+  std::vector<PackVertex> Vertices;
+  std::vector<uint32_t> Indices;
+
+  MeshView view() const;
+};
+
+struct ParsedTexture {
+  vk::Format Format = vk::Format::eUndefined;
+  uint32_t Width = 0;
+  uint32_t Height = 0;
+  uint32_t MipLevels = 1;
+  std::vector<uint8_t> Data;
+
+  TextureView view() const;
+};
+
+// positions, normals and texture coordinates of a Wavefront OBJ, polygons are
+// fanned into triangles and identical corners share a vertex; throws on
+// unreadable files and out of range indices
+ParsedMesh parse_obj(const std::string& path);
+// 2D DDS textures with their mips, BC1-7 or RGBA8, legacy or DX10 headers; throws on anything else
+ParsedTexture parse_dds(const std::string& path);
@@ -0,0 +1,127 @@
+#include "Assets/MappedFile.h"
+
+#include <stdexcept>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#ifdef _WIN32
+
+MappedFile::MappedFile(const std::string& path) {
+  file_ = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+  if (file_ == INVALID_HANDLE_VALUE) {
+    file_ = nullptr;
+    throw std::runtime_error("Failed to open " + path + "!");
+  }
+  LARGE_INTEGER size{};
+  GetFileSizeEx(file_, &size);
+  size_ = static_cast<uint64_t>(size.QuadPart);
+  if (size_ == 0) {
+    return;
+  }
+
+  mapping_ = CreateFileMappingA(file_, nullptr, PAGE_READONLY, 0, 0, nullptr);
+  data_ = mapping_ ? static_cast<const uint8_t*>(MapViewOfFile(mapping_, FILE_MAP_READ, 0, 0, 0)) : nullptr;
+  if (!data_) {
+    if (mapping_) {
+      CloseHandle(mapping_);
+    }
+    CloseHandle(file_);
+    throw std::runtime_error("Failed to map " + path + "!");
+  }
+}
+
+MappedFile::~MappedFile() {
+  if (data_) {
+    UnmapViewOfFile(data_);
+  }
+  if (mapping_) {
+    CloseHandle(mapping_);
+  }
+  if (file_) {
+    CloseHandle(file_);
+  }
+}
+
+void MappedFile::prefetch(uint64_t offset, uint64_t size) const {
+  if (!data_) {
+    return;
+  }
+  WIN32_MEMORY_RANGE_ENTRY range{ const_cast<uint8_t*>(data_ + offset), static_cast<SIZE_T>(size) };
+  PrefetchVirtualMemory(GetCurrentProcess(), 1, &range, 0);
+}
+
+bool evict_file_cache(const std::string&) {
+  // unbuffered handles bypass the cache but there is no per-file purge without admin rights
+  return false;
+}
+
+#else
+
+MappedFile::MappedFile(const std::string& path) {
+  fd_ = open(path.c_str(), O_RDONLY);
+  if (fd_ < 0) {
+    throw std::runtime_error("Failed to open " + path + "!");
+  }
+  struct stat info {};
+  fstat(fd_, &info);
+  size_ = static_cast<uint64_t>(info.st_size);
+  if (size_ == 0) {
+    return;
+  }
+
+  void* mapped = mmap(nullptr, size_, PROT_READ, MAP_PRIVATE, fd_, 0);
+  if (mapped == MAP_FAILED) {
+    close(fd_);
+    throw std::runtime_error("Failed to map " + path + "!");
+  }
+  data_ = static_cast<const uint8_t*>(mapped);
+}
+
+MappedFile::~MappedFile() {
+  if (data_) {
+    munmap(const_cast<uint8_t*>(data_), size_);
+  }
+  if (fd_ >= 0) {
+    close(fd_);
+  }
+}
+
+void MappedFile::prefetch(uint64_t offset, uint64_t size) const {
+  if (!data_) {
+    return;
+  }
+  // madvise wants a page aligned start
+  uint64_t page = static_cast<uint64_t>(sysconf(_SC_PAGESIZE));
+  uint64_t start = offset & ~(page - 1);
+  madvise(const_cast<uint8_t*>(data_ + start), size + (offset - start), MADV_WILLNEED);
+}
+
+bool evict_file_cache(const std::string& path) {
+  int fd = open(path.c_str(), O_RDONLY);
+  if (fd < 0) {
+    return false;
+  }
+  // only clean pages can be dropped
+  fdatasync(fd);
+  bool evicted = posix_fadvise(fd, 0, 0, POSIX_FADV_DONTNEED) == 0;
+  close(fd);
+  return evicted;
+}
+
+#endif
+
+const uint8_t* MappedFile::data() const {
+  return data_;
+}
+
+uint64_t MappedFile::size() const {
+  return size_;
+}
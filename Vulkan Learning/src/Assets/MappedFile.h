@@ -0,0 +1,34 @@
+#pragma once
+#include <cstdint>
+#include <string>
+
+// A read-only memory mapping of a whole file. Pages are faulted in from the
+// OS file cache on first touch, so mapping costs nothing up front and reading
+// an asset is one copy out of the page cache.
+class MappedFile {
+public:
+  // throws when the file cannot be opened or mapped
+  explicit MappedFile(const std::string& path);
+  ~MappedFile();
+
+  MappedFile(const MappedFile&) = delete;
+  MappedFile& operator=(const MappedFile&) = delete;
+
+  const uint8_t* data() const;
+  uint64_t size() const;
+  // tells the OS the range is read front to back soon, so it can read ahead
+  void prefetch(uint64_t offset, uint64_t size) const;
+
+private:
+  const uint8_t* data_ = nullptr;
+  uint64_t size_ = 0;
+#ifdef _WIN32
+  void* file_ = nullptr;
+  void* mapping_ = nullptr;
+#else
+  int fd_ = -1;
+#endif
+};
+
+// drops the file from the OS page cache where the platform allows it, so the next read is a cold one
+bool evict_file_cache(const std::string& path);
@@ -0,0 +1,210 @@
+#include "Capture/FrameReadback.h"
+
+namespace {
+  double elapsed_ms(std::chrono::steady_clock::time_point start, std::chrono::steady_clock::time_point stop) {
+    return std::chrono::duration<double, std::milli>(stop - start).count();
+  }
+}
+
+FrameReadback::FrameReadback(const vk::Device& device, MemoryAllocator& allocator, QueueScheduler& scheduler, vk::Format format,
+  vk::Extent2D extent, uint32_t slots, const std::string& path, CaptureFormat capture, uint32_t fps, const bool debug)
+  : device_(device), allocator_(allocator), scheduler_(scheduler), extent_(extent), debug_(debug),
+  writer_(path, capture, extent, fps) {
+  if (format != vk::Format::eR8G8B8A8Unorm && format != vk::Format::eR8G8B8A8Srgb) {
+    throw std::runtime_error("Failed to create frame readback, only RGBA8 targets are supported!");
+  }
+
+  vk::DeviceSize size = static_cast<vk::DeviceSize>(extent_.width) * extent_.height * 4;
+  // the CPU reads every byte, uncached memory would make the writer crawl
+  vk::MemoryPropertyFlags cached = vk::MemoryPropertyFlagBits::eHostVisible | vk::MemoryPropertyFlagBits::eHostCoherent |
+    vk::MemoryPropertyFlagBits::eHostCached;
+  vk::MemoryPropertyFlags coherent = vk::MemoryPropertyFlagBits::eHostVisible | vk::MemoryPropertyFlagBits::eHostCoherent;
+
+  slots_.resize(slots);
+  for (Slot& slot : slots_) {
+    vk::BufferCreateInfo buffer_info{};
+    buffer_info.size = size;
+    buffer_info.usage = vk::BufferUsageFlagBits::eTransferDst;
+    buffer_info.sharingMode = vk::SharingMode::eExclusive;
+    try {
+      slot.Buffer = device_.createBuffer(buffer_info);
+    }
+    catch (const vk::SystemError&) {
+      throw std::runtime_error("Failed to create readback buffer!");
+    }
+    try {
+      slot.Memory = allocator_.allocate_for_buffer(slot.Buffer, cached);
+    }
+    catch (const std::runtime_error&) {
+      slot.Memory = allocator_.allocate_for_buffer(slot.Buffer, coherent);
+    }
+  }
+
+  thread_ = std::thread(&FrameReadback::write_frames, this);
+  if (debug_) {
+    LOG_DEBUG("Capturing " << extent_.width << "x" << extent_.height << " frames to " << path << " through " << slots << " readback slots");
+  }
+}
+
+FrameReadback::~FrameReadback() {
+  flush();
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    stop_ = true;
+  }
+  work_.notify_all();
+  thread_.join();
+
+  for (Slot& slot : slots_) {
+    device_.destroyBuffer(slot.Buffer);
+    allocator_.free(slot.Memory);
+  }
+}
+
+void FrameReadback::begin_frame() {
+  while (!pending_.empty() && scheduler_.is_complete(slots_[pending_.front()].Point)) {
+    hand_off(pending_.front());
+    pending_.pop_front();
+  }
+}
+
+void FrameReadback::record_copy(vk::CommandBuffer command_buffer, vk::Image image) {
+  uint32_t index = next_slot_;
+  next_slot_ = (next_slot_ + 1) % static_cast<uint32_t>(slots_.size());
+
+  // the ring wrapped onto a frame the GPU or the writer still owns
+  bool pending = false;
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    pending = slots_[index].State == SlotState::Pending;
+  }
+  if (pending) {
+    while (!pending_.empty()) {
+      uint32_t oldest = pending_.front();
+      scheduler_.wait(slots_[oldest].Point);
+      hand_off(oldest);
+      pending_.pop_front();
+      if (oldest == index) {
+        break;
+      }
+    }
+  }
+  {
+    std::unique_lock<std::mutex> lock(mutex_);
+    if (slots_[index].State != SlotState::Free) {
+      auto start = std::chrono::steady_clock::now();
+      slot_free_.wait(lock, [&] { return slots_[index].State == SlotState::Free; });
+      ++stats_.Stalls;
+      stats_.StallMs += elapsed_ms(start, std::chrono::steady_clock::now());
+    }
+    slots_[index].State = SlotState::Recorded;
+  }
+
+  Slot& slot = slots_[index];
+  slot.Frame = frame_++;
+  recorded_slot_ = static_cast<int32_t>(index);
+
+  vk::BufferImageCopy region{};
+  region.imageSubresource = vk::ImageSubresourceLayers{ vk::ImageAspectFlagBits::eColor, 0, 0, 1 };
+  region.imageExtent = vk::Extent3D{ extent_.width, extent_.height, 1 };
+  command_buffer.copyImageToBuffer(image, vk::ImageLayout::eTransferSrcOptimal, slot.Buffer, region);
+
+  // make the copy visible to the host once the submit's signal is waited on
+  vk::MemoryBarrier to_host{ vk::AccessFlagBits::eTransferWrite, vk::AccessFlagBits::eHostRead };
+  command_buffer.pipelineBarrier(vk::PipelineStageFlagBits::eTransfer, vk::PipelineStageFlagBits::eHost,
+    vk::DependencyFlags{}, to_host, nullptr, nullptr);
+}
+
+void FrameReadback::submitted(const QueuePoint& point) {
+  if (recorded_slot_ < 0) {
+    return;
+  }
+  uint32_t index = static_cast<uint32_t>(recorded_slot_);
+  recorded_slot_ = -1;
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    slots_[index].State = SlotState::Pending;
+  }
+  slots_[index].Point = point;
+  pending_.push_back(index);
+}
+
+void FrameReadback::flush() {
+  while (!pending_.empty()) {
+    scheduler_.wait(slots_[pending_.front()].Point);
+    hand_off(pending_.front());
+    pending_.pop_front();
+  }
+
+  std::unique_lock<std::mutex> lock(mutex_);
+  slot_free_.wait(lock, [this] {
+    for (const Slot& slot : slots_) {
+      if (slot.State == SlotState::Writing) {
+        return false;
+      }
+    }
+    return true;
+  });
+}
+
+ReadbackStats FrameReadback::stats() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  ReadbackStats stats = stats_;
+  stats.ElapsedMs = stats.Written > 0 ? elapsed_ms(first_write_, last_write_) : 0.0;
+  return stats;
+}
+
+void FrameReadback::report() const {
+  ReadbackStats stats = this->stats();
+  double seconds = stats.ElapsedMs / 1000.0;
+  double fps = seconds > 0.0 ? stats.Written / seconds : 0.0;
+  double megabytes = stats.Bytes / (1024.0 * 1024.0);
+  std::cout << "Capture: " << stats.Written << " of " << stats.Captured << " frames written (" << stats.WriteErrors
+    << " failed), " << megabytes << "MB, sustained " << fps << " fps / " << (seconds > 0.0 ? megabytes / seconds : 0.0)
+    << "MB/s to disk, encode " << (stats.Written > 0 ? stats.WriteMs / stats.Written : 0.0) << "ms per frame, "
+    << stats.Stalls << " render stalls (" << stats.StallMs << "ms)" << std::endl;
+}
+
+void FrameReadback::hand_off(uint32_t slot) {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    slots_[slot].State = SlotState::Writing;
+    queue_.push_back(slot);
+    ++stats_.Captured;
+  }
+  work_.notify_one();
+}
+
+void FrameReadback::write_frames() {
+  std::unique_lock<std::mutex> lock(mutex_);
+  while (true) {
+    work_.wait(lock, [this] { return stop_ || !queue_.empty(); });
+    if (queue_.empty()) {
+      break;
+    }
+    uint32_t index = queue_.front();
+    queue_.pop_front();
+    const Slot& slot = slots_[index];
+    lock.unlock();
+
+    auto start = std::chrono::steady_clock::now();
+    uint64_t bytes_before = writer_.bytes_written();
+    bool written = writer_.write(static_cast<const uint8_t*>(slot.Memory.Mapped), slot.Frame);
+    auto stop = std::chrono::steady_clock::now();
+
+    lock.lock();
+    if (stats_.Written + stats_.WriteErrors == 0) {
+      first_write_ = start;
+    }
+    last_write_ = stop;
+    stats_.Written += written ? 1 : 0;
+    stats_.WriteErrors += written ? 0 : 1;
+    stats_.Bytes += writer_.bytes_written() - bytes_before;
+    stats_.WriteMs += elapsed_ms(start, stop);
+    if (!written && stats_.WriteErrors == 1) {
+      LOG_ERROR("Failed to write captured frame " << slot.Frame);
+    }
+    slots_[index].State = SlotState::Free;
+    slot_free_.notify_all();
+  }
+}
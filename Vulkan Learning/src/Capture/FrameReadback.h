@@ -0,0 +1,101 @@
+#pragma once
+#include "Headers.h"
+#include "Capture/FrameWriter.h"
+#include "Memory/MemoryAllocator.h"
+#include "Scheduling/QueueScheduler.h"
+
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <thread>
+
+struct ReadbackStats {
+  uint64_t Captured = 0;
+  uint64_t Written = 0;
+  uint64_t WriteErrors = 0;
+  uint64_t Bytes = 0;
+  // times recording waited for the writer to free a slot
+  uint64_t Stalls = 0;
+  double StallMs = 0.0;
+  double WriteMs = 0.0;
+  // first write started to last write finished
+  double ElapsedMs = 0.0;
+};
+
+// Copies finished frames into a ring of persistently mapped, host cached
+// buffers and streams them to a FrameWriter on a background thread. The
+// writer encodes straight from the mapped memory, so a frame is never copied
+// on the CPU side.
+//
+// A copy is handed to the writer once begin_frame() sees its graphics
+// timeline point pass, which the frame fence wait has usually guaranteed, so
+// readback overlaps the frames that follow. Recording only blocks when every
+// slot is still waiting on the writer, i.e. when the disk is the bottleneck.
+class FrameReadback {
+public:
+  // only RGBA8 targets, which is what the offscreen targets use
+  FrameReadback(const vk::Device& device, MemoryAllocator& allocator, QueueScheduler& scheduler, vk::Format format,
+    vk::Extent2D extent, uint32_t slots, const std::string& path, CaptureFormat capture, uint32_t fps, const bool debug);
+  // writes every frame still in flight, the scheduler must outlive it
+  ~FrameReadback();
+
+  // after the frame fence wait, hands completed copies to the writer
+  void begin_frame();
+  // the image must be in TransferSrcOptimal with its writes visible to transfers
+  void record_copy(vk::CommandBuffer command_buffer, vk::Image image);
+  // with the point the frame's submit returned
+  void submitted(const QueuePoint& point);
+  // blocks until every submitted frame is on disk
+  void flush();
+
+  ReadbackStats stats() const;
+  void report() const;
+
+private:
+  enum class SlotState : uint8_t {
+    Free,
+    // copy recorded, not yet submitted
+    Recorded,
+    // submitted, the copy may still be running
+    Pending,
+    // owned by the writer thread
+    Writing
+  };
+
+  struct Slot {
+    vk::Buffer Buffer;
+    MemoryAllocation Memory;
+    SlotState State = SlotState::Free;
+    QueuePoint Point;
+    uint64_t Frame = 0;
+  };
+
+  void hand_off(uint32_t slot);
+  void write_frames();
+
+  vk::Device device_;
+  MemoryAllocator& allocator_;
+  QueueScheduler& scheduler_;
+  vk::Extent2D extent_;
+  bool debug_;
+
+  FrameWriter writer_;
+  std::vector<Slot> slots_;
+  uint32_t next_slot_ = 0;
+  int32_t recorded_slot_ = -1;
+  uint64_t frame_ = 0;
+  // submitted slots in frame order
+  std::deque<uint32_t> pending_;
+
+  // slots queued for the writer, in frame order
+  std::deque<uint32_t> queue_;
+  bool stop_ = false;
+  std::chrono::steady_clock::time_point first_write_;
+  std::chrono::steady_clock::time_point last_write_;
+  ReadbackStats stats_;
+  mutable std::mutex mutex_;
+  std::condition_variable work_;
+  std::condition_variable slot_free_;
+  std::thread thread_;
+};
@@ -0,0 +1,251 @@
+#include "Capture/FrameWriter.h"
+
+#include <cstring>
+#include <filesystem>
+
+namespace {
+  // the largest stored deflate block
+  const size_t StoredBlockSize = 65535;
+
+  struct Crc32 {
+    uint32_t Table[256];
+
+    Crc32() {
+      for (uint32_t n = 0; n < 256; ++n) {
+        uint32_t c = n;
+        for (int k = 0; k < 8; ++k) {
+          c = (c & 1) ? 0xedb88320u ^ (c >> 1) : c >> 1;
+        }
+        Table[n] = c;
+      }
+    }
+
+    uint32_t update(uint32_t crc, const uint8_t* data, size_t size) const {
+      for (size_t i = 0; i < size; ++i) {
+        crc = Table[(crc ^ data[i]) & 0xff] ^ (crc >> 8);
+      }
+      return crc;
+    }
+  };
+
+  const Crc32& crc_table() {
+    static Crc32 table;
+    return table;
+  }
+
+  void put_be32(uint8_t* out, uint32_t value) {
+    out[0] = static_cast<uint8_t>(value >> 24);
+    out[1] = static_cast<uint8_t>(value >> 16);
+    out[2] = static_cast<uint8_t>(value >> 8);
+    out[3] = static_cast<uint8_t>(value);
+  }
+
+  // Streams one IDAT chunk of stored deflate blocks, tracking the chunk CRC
+  // and the zlib Adler-32 as the bytes go by.
+  class PngStream {
+  public:
+    PngStream(std::FILE* file, size_t raw_size)
+      : file_(file), remaining_(raw_size) {
+    }
+
+    bool begin(uint32_t chunk_size) {
+      uint8_t header[8];
+      put_be32(header, chunk_size);
+      memcpy(header + 4, "IDAT", 4);
+      crc_ = crc_table().update(0xffffffffu, header + 4, 4);
+      if (std::fwrite(header, 1, 8, file_) != 8) {
+        return false;
+      }
+      // deflate, 32K window, no preset dictionary, check bits for the fastest level
+      const uint8_t zlib_header[2] = { 0x78, 0x01 };
+      return emit(zlib_header, 2);
+    }
+
+    bool add(const uint8_t* data, size_t size) {
+      while (size > 0) {
+        if (block_left_ == 0 && !start_block()) {
+          return false;
+        }
+        size_t take = (std::min)(size, block_left_);
+        adler(data, take);
+        if (!emit(data, take)) {
+          return false;
+        }
+        block_left_ -= take;
+        data += take;
+        size -= take;
+      }
+      return true;
+    }
+
+    bool end() {
+      uint8_t trailer[8];
+      put_be32(trailer, (adler_b_ << 16) | adler_a_);
+      if (!emit(trailer, 4)) {
+        return false;
+      }
+      put_be32(trailer + 4, crc_ ^ 0xffffffffu);
+      return std::fwrite(trailer + 4, 1, 4, file_) == 4;
+    }
+
+  private:
+    bool start_block() {
+      block_left_ = (std::min)(remaining_, StoredBlockSize);
+      remaining_ -= block_left_;
+      uint16_t length = static_cast<uint16_t>(block_left_);
+      uint16_t inverse = static_cast<uint16_t>(~length);
+      const uint8_t header[5] = { static_cast<uint8_t>(remaining_ == 0 ? 1 : 0),
+        static_cast<uint8_t>(length), static_cast<uint8_t>(length >> 8),
+        static_cast<uint8_t>(inverse), static_cast<uint8_t>(inverse >> 8) };
+      return emit(header, 5);
+    }
+
+    bool emit(const uint8_t* data, size_t size) {
+      crc_ = crc_table().update(crc_, data, size);
+      return std::fwrite(data, 1, size, file_) == size;
+    }
+
+    void adler(const uint8_t* data, size_t size) {
+      // 5552 bytes is the most that can be summed before the 32-bit sums overflow
+      while (size > 0) {
+        size_t run = (std::min)(size, static_cast<size_t>(5552));
+        for (size_t i = 0; i < run; ++i) {
+          adler_a_ += data[i];
+          adler_b_ += adler_a_;
+        }
+        adler_a_ %= 65521;
+        adler_b_ %= 65521;
+        data += run;
+        size -= run;
+      }
+    }
+
+    std::FILE* file_;
+    size_t remaining_;
+    size_t block_left_ = 0;
+    uint32_t crc_ = 0;
+    uint32_t adler_a_ = 1;
+    uint32_t adler_b_ = 0;
+  };
+
+  bool write_png_chunk(std::FILE* file, const char* type, const uint8_t* data, uint32_t size) {
+    uint8_t header[8];
+    put_be32(header, size);
+    memcpy(header + 4, type, 4);
+    uint32_t crc = crc_table().update(0xffffffffu, header + 4, 4);
+    crc = crc_table().update(crc, data, size) ^ 0xffffffffu;
+    uint8_t trailer[4];
+    put_be32(trailer, crc);
+    return std::fwrite(header, 1, 8, file) == 8 && std::fwrite(data, 1, size, file) == size &&
+      std::fwrite(trailer, 1, 4, file) == 4;
+  }
+}
+
+FrameWriter::FrameWriter(const std::string& path, CaptureFormat format, vk::Extent2D extent, uint32_t fps)
+  : path_(path), format_(format), extent_(extent) {
+  if (format_ == CaptureFormat::Png) {
+    std::error_code error;
+    std::filesystem::create_directories(path_, error);
+    if (error) {
+      throw std::runtime_error("Failed to create capture directory " + path_ + "!");
+    }
+    return;
+  }
+
+  stream_ = std::fopen(path_.c_str(), "wb");
+  if (!stream_) {
+    throw std::runtime_error("Failed to open capture output " + path_ + "!");
+  }
+
+  if (format_ == CaptureFormat::Y4M) {
+    std::string header = "YUV4MPEG2 W" + std::to_string(extent_.width) + " H" + std::to_string(extent_.height) +
+      " F" + std::to_string(fps) + ":1 Ip A1:1 C444\n";
+    write_bytes(stream_, header.data(), header.size());
+    planes_.resize(static_cast<size_t>(extent_.width) * extent_.height * 3);
+  }
+}
+
+FrameWriter::~FrameWriter() {
+  if (stream_) {
+    std::fclose(stream_);
+  }
+}
+
+bool FrameWriter::write(const uint8_t* pixels, uint64_t frame) {
+  switch (format_) {
+  case CaptureFormat::Raw:
+    return write_bytes(stream_, pixels, static_cast<size_t>(extent_.width) * extent_.height * 4);
+  case CaptureFormat::Y4M:
+    return write_y4m(pixels);
+  case CaptureFormat::Png:
+  default:
+    return write_png(pixels, frame);
+  }
+}
+
+uint64_t FrameWriter::bytes_written() const {
+  return bytes_;
+}
+
+bool FrameWriter::write_bytes(std::FILE* file, const void* data, size_t size) {
+  bool ok = std::fwrite(data, 1, size, file) == size;
+  bytes_ += ok ? size : 0;
+  return ok;
+}
+
+bool FrameWriter::write_y4m(const uint8_t* pixels) {
+  size_t plane = static_cast<size_t>(extent_.width) * extent_.height;
+  uint8_t* y = planes_.data();
+  uint8_t* cb = y + plane;
+  uint8_t* cr = cb + plane;
+  // BT.601 limited range, which is what players assume for Y4M without a colour tag
+  for (size_t i = 0; i < plane; ++i) {
+    int r = pixels[i * 4 + 0];
+    int g = pixels[i * 4 + 1];
+    int b = pixels[i * 4 + 2];
+    y[i] = static_cast<uint8_t>(((66 * r + 129 * g + 25 * b + 128) >> 8) + 16);
+    cb[i] = static_cast<uint8_t>(((-38 * r - 74 * g + 112 * b + 128) >> 8) + 128);
+    cr[i] = static_cast<uint8_t>(((112 * r - 94 * g - 18 * b + 128) >> 8) + 128);
+  }
+  return write_bytes(stream_, "FRAME\n", 6) && write_bytes(stream_, planes_.data(), planes_.size());
+}
+
+bool FrameWriter::write_png(const uint8_t* pixels, uint64_t frame) {
+  char name[32];
+  std::snprintf(name, sizeof(name), "/frame_%06llu.png", static_cast<unsigned long long>(frame));
+  std::string file_path = path_ + name;
+  std::FILE* file = std::fopen(file_path.c_str(), "wb");
+  if (!file) {
+    return false;
+  }
+  // rows go out in pieces behind their filter bytes, batch them into large writes
+  std::setvbuf(file, nullptr, _IOFBF, 1 << 20);
+
+  const uint8_t signature[8] = { 0x89, 'P', 'N', 'G', '\r', '\n', 0x1a, '\n' };
+  uint8_t header[13];
+  put_be32(header, extent_.width);
+  put_be32(header + 4, extent_.height);
+  // 8 bits per channel, RGBA, deflate, adaptive filtering, not interlaced
+  header[8] = 8;
+  header[9] = 6;
+  header[10] = 0;
+  header[11] = 0;
+  header[12] = 0;
+
+  size_t row_size = static_cast<size_t>(extent_.width) * 4;
+  size_t raw_size = (row_size + 1) * extent_.height;
+  size_t blocks = (raw_size + StoredBlockSize - 1) / StoredBlockSize;
+  size_t idat_size = 2 + blocks * 5 + raw_size + 4;
+
+  bool ok = std::fwrite(signature, 1, 8, file) == 8 && write_png_chunk(file, "IHDR", header, 13);
+  PngStream stream(file, raw_size);
+  ok = ok && stream.begin(static_cast<uint32_t>(idat_size));
+  const uint8_t no_filter = 0;
+  for (uint32_t row = 0; ok && row < extent_.height; ++row) {
+    ok = stream.add(&no_filter, 1) && stream.add(pixels + row * row_size, row_size);
+  }
+  ok = ok && stream.end() && write_png_chunk(file, "IEND", nullptr, 0);
+  ok = std::fclose(file) == 0 && ok;
+  bytes_ += ok ? 8 + 25 + 12 + idat_size + 12 : 0;
+  return ok;
+}
@@ -0,0 +1,38 @@
+#pragma once
+#include "Headers.h"
+#include "Config.h"
+
+#include <cstdio>
+#include <string>
+#include <vector>
+
+// Encodes tightly packed RGBA8 frames straight from the caller's memory.
+// Raw and Y4M append to one stream, a file or a named pipe (stdout carries
+// the log); PNG writes one file per frame into the path as a directory.
+//
+// Raw and PNG never copy the frame: raw is written as is and PNG stores
+// uncompressed deflate blocks, so each row goes to the file behind its filter
+// byte. Y4M converts to 4:4:4 YCbCr through one reused plane buffer.
+// Not thread-safe, FrameReadback calls it from its writer thread only.
+class FrameWriter {
+public:
+  // throws when the output cannot be opened
+  FrameWriter(const std::string& path, CaptureFormat format, vk::Extent2D extent, uint32_t fps);
+  ~FrameWriter();
+
+  // false on an I/O error, later frames are still attempted
+  bool write(const uint8_t* pixels, uint64_t frame);
+  uint64_t bytes_written() const;
+
+private:
+  bool write_bytes(std::FILE* file, const void* data, size_t size);
+  bool write_y4m(const uint8_t* pixels);
+  bool write_png(const uint8_t* pixels, uint64_t frame);
+
+  std::string path_;
+  CaptureFormat format_;
+  vk::Extent2D extent_;
+  std::FILE* stream_ = nullptr;
+  std::vector<uint8_t> planes_;
+  uint64_t bytes_ = 0;
+};
@@ -0,0 +1,186 @@
+#include "Config.h"
+
+#include <cstring>
+#include <string>
+
+AppConfig parse_config(int argc, char** argv) {
+  AppConfig config;
+
+  for (int i = 1; i < argc; ++i) {
+    const char* arg = argv[i];
+
+    if (strcmp(arg, "--headless") == 0) {
+      config.Headless = true;
+    }
+    else if (strcmp(arg, "--frames") == 0 && i + 1 < argc) {
+      config.FrameCount = static_cast<uint32_t>(std::stoul(argv[++i]));
+    }
+    else if (strcmp(arg, "--frames-in-flight") == 0 && i + 1 < argc) {
+      config.FramesInFlight = (std::max)(1u, static_cast<uint32_t>(std::stoul(argv[++i])));
+    }
+    else if (strcmp(arg, "--record-items") == 0 && i + 1 < argc) {
+      config.RecordItems = static_cast<uint32_t>(std::stoul(argv[++i]));
+    }
+    else if (strcmp(arg, "--threads") == 0 && i + 1 < argc) {
+      config.WorkerThreads = static_cast<uint32_t>(std::stoul(argv[++i]));
+    }
+    else if (strcmp(arg, "--bench-recording") == 0) {
+      config.BenchRecording = true;
+    }
+    else if (strcmp(arg, "--bench-allocator") == 0) {
+      config.BenchAllocator = true;
+    }
+    else if (strcmp(arg, "--bench-render-graph") == 0) {
+      config.BenchRenderGraph = true;
+    }
+    else if (strcmp(arg, "--bench-culling") == 0) {
+      config.BenchCulling = true;
+    }
+    else if (strcmp(arg, "--bench-async-compute") == 0) {
+      config.BenchAsyncCompute = true;
+    }
+    else if (strcmp(arg, "--bench-assets") == 0) {
+      config.BenchAssets = true;
+    }
+    else if (strcmp(arg, "--pack-assets") == 0) {
+      config.PackAssets = true;
+    }
+    else if (strcmp(arg, "--asset-dir") == 0 && i + 1 < argc) {
+      config.AssetDir = argv[++i];
+    }
+    else if (strcmp(arg, "--asset-pack") == 0 && i + 1 < argc) {
+      config.AssetPackPath = argv[++i];
+    }
+    else if (strcmp(arg, "--bench-scene") == 0) {
+      config.BenchScene = true;
+    }
+    else if (strcmp(arg, "--scene-objects") == 0 && i + 1 < argc) {
+      config.SceneObjects = (std::max)(1u, static_cast<uint32_t>(std::stoul(argv[++i])));
+    }
+    else if (strcmp(arg, "--cull-instances") == 0 && i + 1 < argc) {
+      config.CullInstances = (std::max)(1u, static_cast<uint32_t>(std::stoul(argv[++i])));
+    }
+    else if (strcmp(arg, "--shader-dir") == 0 && i + 1 < argc) {
+      config.ShaderDir = argv[++i];
+    }
+    else if (strcmp(arg, "--shader-cache") == 0 && i + 1 < argc) {
+      config.ShaderCacheDir = argv[++i];
+    }
+    else if (strcmp(arg, "--no-shader-cache") == 0) {
+      config.ShaderCacheDir.clear();
+    }
+    else if (strcmp(arg, "--hot-reload") == 0) {
+      config.HotReload = true;
+    }
+    else if (strcmp(arg, "--compile-shaders") == 0) {
+      config.CompileShaders = true;
+    }
+    else if (strcmp(arg, "--device") == 0 && i + 1 < argc) {
+      config.DeviceOverride = argv[++i];
+    }
+    else if (strcmp(arg, "--device-count") == 0 && i + 1 < argc) {
+      config.DeviceCount = (std::max)(1u, static_cast<uint32_t>(std::stoul(argv[++i])));
+    }
+    else if (strcmp(arg, "--bench-devices") == 0) {
+      config.BenchDevices = true;
+    }
+    else if (strcmp(arg, "--compute-queues") == 0 && i + 1 < argc) {
+      config.ComputeQueues = (std::max)(1u, static_cast<uint32_t>(std::stoul(argv[++i])));
+    }
+    else if (strcmp(arg, "--compute-priority") == 0 && i + 1 < argc) {
+      config.ComputePriority = std::clamp(std::stof(argv[++i]), 0.0f, 1.0f);
+    }
+    else if (strcmp(arg, "--transfer-priority") == 0 && i + 1 < argc) {
+      config.TransferPriority = std::clamp(std::stof(argv[++i]), 0.0f, 1.0f);
+    }
+    else if (strcmp(arg, "--pipeline-cache") == 0 && i + 1 < argc) {
+      config.PipelineCachePath = argv[++i];
+    }
+    else if (strcmp(arg, "--compile-threads") == 0 && i + 1 < argc) {
+      config.CompileThreads = static_cast<uint32_t>(std::stoul(argv[++i]));
+    }
+    else if (strcmp(arg, "--no-pipeline-cache") == 0) {
+      config.PipelineCachePath.clear();
+    }
+    else if (strcmp(arg, "--profile") == 0) {
+      config.Profile = true;
+    }
+    else if (strcmp(arg, "--trace") == 0 && i + 1 < argc) {
+      config.TracePath = argv[++i];
+      config.Profile = true;
+    }
+    else if (strcmp(arg, "--log-level") == 0 && i + 1 < argc) {
+      const char* level = argv[++i];
+      const char* names[] = { "trace", "debug", "info", "warn", "error" };
+      bool known = false;
+      for (int n = 0; n < 5; ++n) {
+        if (strcmp(level, names[n]) == 0) {
+          config.LogLevel = static_cast<Log::Level>(n);
+          known = true;
+        }
+      }
+      if (!known) {
+        std::cout << "Ignoring unknown log level: " << level << std::endl;
+      }
+    }
+    else if (strcmp(arg, "--log-json") == 0 && i + 1 < argc) {
+      config.LogJsonPath = argv[++i];
+    }
+    else if (strcmp(arg, "--idle-fps") == 0 && i + 1 < argc) {
+      config.IdleFps = static_cast<uint32_t>(std::stoul(argv[++i]));
+    }
+    else if (strcmp(arg, "--present") == 0 && i + 1 < argc) {
+      const char* profile = argv[++i];
+      if (strcmp(profile, "low-latency") == 0) {
+        config.Present = PresentProfile::LowLatency;
+      }
+      else if (strcmp(profile, "throughput") == 0) {
+        config.Present = PresentProfile::Throughput;
+      }
+      else if (strcmp(profile, "power-saving") == 0) {
+        config.Present = PresentProfile::PowerSaving;
+      }
+      else {
+        std::cout << "Ignoring unknown present profile: " << profile << std::endl;
+      }
+    }
+    else if (strcmp(arg, "--swapchain-images") == 0 && i + 1 < argc) {
+      config.SwapchainImages = static_cast<uint32_t>(std::stoul(argv[++i]));
+    }
+    else if (strcmp(arg, "--capture") == 0 && i + 1 < argc) {
+      config.CapturePath = argv[++i];
+    }
+    else if (strcmp(arg, "--capture-format") == 0 && i + 1 < argc) {
+      const char* format = argv[++i];
+      if (strcmp(format, "raw") == 0) {
+        config.Capture = CaptureFormat::Raw;
+      }
+      else if (strcmp(format, "y4m") == 0) {
+        config.Capture = CaptureFormat::Y4M;
+      }
+      else if (strcmp(format, "png") == 0) {
+        config.Capture = CaptureFormat::Png;
+      }
+      else {
+        std::cout << "Ignoring unknown capture format: " << format << std::endl;
+      }
+    }
+    else if (strcmp(arg, "--capture-slots") == 0 && i + 1 < argc) {
+      config.CaptureSlots = static_cast<uint32_t>(std::stoul(argv[++i]));
+    }
+    else if (strcmp(arg, "--capture-fps") == 0 && i + 1 < argc) {
+      config.CaptureFps = static_cast<uint32_t>(std::stoul(argv[++i]));
+    }
+    else if (strcmp(arg, "--width") == 0 && i + 1 < argc) {
+      config.Width = static_cast<uint32_t>(std::stoul(argv[++i]));
+    }
+    else if (strcmp(arg, "--height") == 0 && i + 1 < argc) {
+      config.Height = static_cast<uint32_t>(std::stoul(argv[++i]));
+    }
+    else {
+      std::cout << "Ignoring unknown argument: " << arg << std::endl;
+    }
+  }
+
+  return config;
+}
@@ -0,0 +1,108 @@
+#pragma once
+#include "Headers.h"
+
+#include <string>
+
+// how the swapchain trades latency, frame rate and power
+enum class PresentProfile {
+  // mailbox or immediate with the fewest images that keep acquire from blocking
+  LowLatency,
+  // never throttles the CPU, deeper image queue
+  Throughput,
+  // vsync with the minimum image count
+  PowerSaving
+};
+
+// how headless frames are written out by --capture
+enum class CaptureFormat {
+  // tightly packed RGBA8, e.g. for ffmpeg -f rawvideo -pix_fmt rgba
+  Raw,
+  // YUV4MPEG2 4:4:4, readable by most encoders and players
+  Y4M,
+  // one file per frame in the capture directory
+  Png
+};
+
+struct AppConfig {
+  // render into offscreen images instead of a window + swapchain
+  bool Headless = false;
+  // number of frames to render before exiting, 0 runs until the window closes
+  uint32_t FrameCount = 0;
+  // frames the CPU may record ahead of the GPU
+  uint32_t FramesInFlight = 2;
+  // synthetic per-frame work items recorded across the worker threads
+  uint32_t RecordItems = 0;
+  // 0 uses one worker per hardware thread
+  uint32_t WorkerThreads = 0;
+  // measure secondary command buffer recording at 1..N threads and exit
+  bool BenchRecording = false;
+  // measure CPU-side sub-allocator throughput and exit, no device is created
+  bool BenchAllocator = false;
+  // compile a representative render graph, report barriers and aliasing and exit, no device is created
+  bool BenchRenderGraph = false;
+  // compare GPU-driven culling against per-object draws and exit
+  bool BenchCulling = false;
+  // compare compute on the graphics queue against the async compute queue and exit
+  bool BenchAsyncCompute = false;
+  // compare loading parsed OBJ/DDS sources against the mapped asset pack and exit
+  bool BenchAssets = false;
+  // bake AssetDir into AssetPackPath and exit, no device is created
+  bool PackAssets = false;
+  // OBJ and DDS sources, the benchmark generates a synthetic set when it is empty
+  std::string AssetDir = "assets";
+  std::string AssetPackPath = "assets.pack";
+  // time scene transform updates and CPU frustum culling on one thread and on all workers and exit, no device is created
+  bool BenchScene = false;
+  // nodes in the scene benchmark
+  uint32_t SceneObjects = 1000000;
+  // instances in the culling benchmark scene
+  uint32_t CullInstances = 250000;
+  // shader sources and their prebuilt SPIR-V, relative to the working directory
+  std::string ShaderDir = "shaders";
+  // compiled SPIR-V keyed by source hash, empty compiles every run
+  std::string ShaderCacheDir = "shader_cache";
+  // recompile shaders when their sources change and rebuild the pipelines using them
+  bool HotReload = false;
+  // compile every shader in ShaderDir to SPIR-V next to its source and exit, no device is created
+  bool CompileShaders = false;
+  // device name substring or device UUID that beats the scoring
+  std::string DeviceOverride;
+  // logical devices to open, the best ranked device renders and the rest take split workloads
+  uint32_t DeviceCount = 1;
+  // split a batch of buffer copies across the DeviceCount devices, compare it with one device and exit
+  bool BenchDevices = false;
+  // queues opened on the compute family, fewer when the family has fewer
+  uint32_t ComputeQueues = 1;
+  // relative to the graphics queue's 1.0, only ranks queues of the same family
+  float ComputePriority = 0.5f;
+  float TransferPriority = 0.5f;
+  // pipeline compile threads, 0 uses half the hardware threads
+  uint32_t CompileThreads = 0;
+  // where the pipeline cache is persisted, empty disables the cache
+  std::string PipelineCachePath = "pipeline_cache.bin";
+  // time frames with GPU timestamp queries and CPU scopes
+  bool Profile = false;
+  // Chrome trace written at exit, implies Profile
+  std::string TracePath;
+  // runtime log threshold, levels below LOG_MIN_LEVEL are compiled out regardless
+  Log::Level LogLevel = Log::Level::Debug;
+  // structured copy of the log, one JSON record per line
+  std::string LogJsonPath;
+  // the window redraws on input, or this many times a second while idle. 0 polls and redraws
+  // as fast as presentation allows, which keeps a core busy
+  uint32_t IdleFps = 60;
+  PresentProfile Present = PresentProfile::LowLatency;
+  // swapchain images to request, 0 lets the present profile decide
+  uint32_t SwapchainImages = 0;
+  // headless only, a file or named pipe for raw and y4m, a directory for png; empty disables capture
+  std::string CapturePath;
+  CaptureFormat Capture = CaptureFormat::Raw;
+  // readback buffers in the ring, 0 uses FramesInFlight + 2 so the writer can fall behind briefly
+  uint32_t CaptureSlots = 0;
+  // frame rate written to the y4m header, the frames themselves are not paced
+  uint32_t CaptureFps = 60;
+  uint32_t Width = 640;
+  uint32_t Height = 480;
+};
+
+AppConfig parse_config(int argc, char** argv);
@@ -0,0 +1,473 @@
+#include "Culling/CullingBenchmark.h"
+
+#include <chrono>
+#include <cmath>
+#include <random>
+
+namespace {
+  struct Vec3 {
+    float X, Y, Z;
+  };
+
+  Vec3 subtract(Vec3 a, Vec3 b) {
+    return Vec3{ a.X - b.X, a.Y - b.Y, a.Z - b.Z };
+  }
+
+  Vec3 cross(Vec3 a, Vec3 b) {
+    return Vec3{ a.Y * b.Z - a.Z * b.Y, a.Z * b.X - a.X * b.Z, a.X * b.Y - a.Y * b.X };
+  }
+
+  float dot(Vec3 a, Vec3 b) {
+    return a.X * b.X + a.Y * b.Y + a.Z * b.Z;
+  }
+
+  Vec3 normalize(Vec3 v) {
+    float length = std::sqrt(dot(v, v));
+    return Vec3{ v.X / length, v.Y / length, v.Z / length };
+  }
+
+  // view space looks down +z with y down, as CullView expects
+  void look_at(Vec3 eye, Vec3 target, float out[16]) {
+    Vec3 forward = normalize(subtract(target, eye));
+    Vec3 right = normalize(cross(Vec3{ 0.0f, 1.0f, 0.0f }, forward));
+    Vec3 down = cross(right, forward);
+
+    const Vec3 axes[3] = { right, down, forward };
+    for (int row = 0; row < 3; ++row) {
+      out[0 * 4 + row] = axes[row].X;
+      out[1 * 4 + row] = axes[row].Y;
+      out[2 * 4 + row] = axes[row].Z;
+      out[3 * 4 + row] = -dot(axes[row], eye);
+    }
+    out[3] = 0.0f;
+    out[7] = 0.0f;
+    out[11] = 0.0f;
+    out[15] = 1.0f;
+  }
+
+  void perspective(float fov_y, float aspect, float znear, float zfar, float out[16]) {
+    std::fill(out, out + 16, 0.0f);
+    float p11 = 1.0f / std::tan(fov_y * 0.5f);
+    out[0] = p11 / aspect;
+    out[5] = p11;
+    out[10] = zfar / (zfar - znear);
+    out[11] = 1.0f;
+    out[14] = -zfar * znear / (zfar - znear);
+  }
+
+  void add_cube(std::vector<float>& vertices, std::vector<uint32_t>& indices) {
+    for (int i = 0; i < 8; ++i) {
+      vertices.push_back(i & 1 ? 0.5f : -0.5f);
+      vertices.push_back(i & 2 ? 0.5f : -0.5f);
+      vertices.push_back(i & 4 ? 0.5f : -0.5f);
+    }
+    const uint32_t faces[6][4] = { { 0, 2, 3, 1 }, { 4, 5, 7, 6 }, { 0, 1, 5, 4 }, { 2, 6, 7, 3 }, { 0, 4, 6, 2 }, { 1, 3, 7, 5 } };
+    for (const uint32_t* face : faces) {
+      indices.insert(indices.end(), { face[0], face[1], face[2], face[0], face[2], face[3] });
+    }
+  }
+
+  void add_sphere(std::vector<float>& vertices, std::vector<uint32_t>& indices, uint32_t segments, uint32_t rings) {
+    const float pi = 3.14159265f;
+    for (uint32_t ring = 0; ring <= rings; ++ring) {
+      float theta = pi * ring / rings;
+      for (uint32_t segment = 0; segment <= segments; ++segment) {
+        float phi = 2.0f * pi * segment / segments;
+        vertices.push_back(0.5f * std::sin(theta) * std::cos(phi));
+        vertices.push_back(0.5f * std::cos(theta));
+        vertices.push_back(0.5f * std::sin(theta) * std::sin(phi));
+      }
+    }
+    for (uint32_t ring = 0; ring < rings; ++ring) {
+      for (uint32_t segment = 0; segment < segments; ++segment) {
+        uint32_t a = ring * (segments + 1) + segment;
+        uint32_t b = a + segments + 1;
+        indices.insert(indices.end(), { a, b, a + 1, a + 1, b, b + 1 });
+      }
+    }
+  }
+
+  double elapsed_ms(std::chrono::steady_clock::time_point start, std::chrono::steady_clock::time_point stop) {
+    return std::chrono::duration<double, std::milli>(stop - start).count();
+  }
+}
+
+CullingBenchmark::CullingBenchmark(const vk::Device& device, MemoryAllocator& allocator, UploadEngine& uploads, BindlessHeap& heap,
+  PipelineService& pipelines, ShaderLibrary& shaders, vk::Queue queue, uint32_t queue_family,
+  uint32_t instance_count, const bool debug)
+  : device_(device), allocator_(allocator), uploads_(uploads), heap_(heap), pipelines_(pipelines), shaders_(shaders),
+  queue_(queue), debug_(debug) {
+  culler_ = new IndirectCuller(device_, allocator_, uploads_, heap_, pipelines_, shaders_, 1, debug_);
+
+  vk::CommandPoolCreateInfo pool_info{};
+  pool_info.flags = vk::CommandPoolCreateFlagBits::eTransient;
+  pool_info.queueFamilyIndex = queue_family;
+  command_pool_ = device_.createCommandPool(pool_info);
+  vk::CommandBufferAllocateInfo allocate_info{ command_pool_, vk::CommandBufferLevel::ePrimary, 1 };
+  command_buffer_ = device_.allocateCommandBuffers(allocate_info)[0];
+  fence_ = device_.createFence(vk::FenceCreateInfo{});
+
+  create_scene(instance_count);
+  create_targets();
+
+  ShaderSource vertex{ "instance.vert" };
+  ShaderSource fragment{ "instance.frag" };
+  vertex_shader_ = shaders_.load(vertex);
+  fragment_shader_ = shaders_.load(fragment);
+  pipeline_ = create_pipeline();
+  listeners_.push_back(shaders_.on_reload(vertex, [this](vk::ShaderModule module) {
+    vertex_shader_ = module;
+    reloaded_ = create_pipeline();
+  }));
+  listeners_.push_back(shaders_.on_reload(fragment, [this](vk::ShaderModule module) {
+    fragment_shader_ = module;
+    reloaded_ = create_pipeline();
+  }));
+}
+
+CullingBenchmark::~CullingBenchmark() {
+  device_.waitIdle();
+  delete culler_;
+
+  for (uint32_t listener : listeners_) {
+    shaders_.remove_listener(listener);
+  }
+  device_.destroyFramebuffer(framebuffer_);
+  device_.destroyRenderPass(render_pass_);
+  device_.destroyImageView(depth_view_);
+  device_.destroyImage(depth_);
+  allocator_.free(depth_memory_);
+  device_.destroyImageView(color_view_);
+  device_.destroyImage(color_);
+  allocator_.free(color_memory_);
+  device_.destroyBuffer(index_buffer_);
+  allocator_.free(index_memory_);
+  device_.destroyBuffer(vertex_buffer_);
+  allocator_.free(vertex_memory_);
+  device_.destroyFence(fence_);
+  device_.destroyCommandPool(command_pool_);
+}
+
+void CullingBenchmark::run(uint32_t frames) {
+  // every compile and upload has to be done before anything is timed
+  pipelines_.wait_idle();
+  uploads_.wait(upload_value_);
+  if (!pipeline_.ready() || !culler_->ready()) {
+    LOG_ERROR("Culling benchmark pipelines failed to compile");
+    return;
+  }
+
+  std::cout << "Culling " << instances_.size() << " instances of " << meshes_.size() << " meshes at "
+    << extent_.width << "x" << extent_.height << ", average of " << frames << " frames:" << std::endl;
+
+  const char* names[] = { "naive per-object loop", "GPU frustum culling", "GPU frustum + Hi-Z occlusion" };
+  bool first = true;
+  for (Mode mode : { Mode::Naive, Mode::GpuFrustum, Mode::GpuOcclusion }) {
+    // warm up, which also gives occlusion a pyramid from the previous frame
+    for (uint32_t i = 0; i < 3; ++i) {
+      render_frame(mode, first);
+      first = false;
+    }
+
+    FrameTimes total;
+    for (uint32_t i = 0; i < frames; ++i) {
+      FrameTimes times = render_frame(mode, false);
+      total.RecordMs += times.RecordMs;
+      total.SubmitMs += times.SubmitMs;
+      total.GpuMs += times.GpuMs;
+      total.ApiDraws = times.ApiDraws;
+    }
+
+    std::cout << "  " << names[static_cast<int>(mode)] << ": " << total.ApiDraws << " API draw calls";
+    if (mode != Mode::Naive) {
+      // the fence was waited on, so the slot's counts are those of the last frame
+      culler_->begin_frame(0, view_);
+      CullStats stats = culler_->stats();
+      std::cout << " (" << stats.Draws << " GPU draws, " << stats.VisibleInstances << " visible)";
+    }
+    std::cout << ", record " << total.RecordMs / frames << "ms, submit " << total.SubmitMs / frames
+      << "ms, GPU " << total.GpuMs / frames << "ms" << std::endl;
+  }
+}
+
+void CullingBenchmark::create_scene(uint32_t instance_count) {
+  std::vector<float> vertices;
+  std::vector<uint32_t> indices;
+
+  // one cube and spheres of rising detail in one vertex and index buffer, indices
+  // restart at 0 for every mesh and VertexOffset rebases them
+  auto add_mesh = [&](auto&& build, float radius) {
+    GpuMesh mesh{};
+    mesh.FirstIndex = static_cast<uint32_t>(indices.size());
+    mesh.VertexOffset = static_cast<int32_t>(vertices.size() / 3);
+    build();
+    mesh.IndexCount = static_cast<uint32_t>(indices.size()) - mesh.FirstIndex;
+    mesh.Bounds[0] = 0.0f;
+    mesh.Bounds[1] = 0.0f;
+    mesh.Bounds[2] = 0.0f;
+    mesh.Bounds[3] = radius;
+    meshes_.push_back(mesh);
+  };
+  add_mesh([&] { add_cube(vertices, indices); }, 0.8660254f);
+  uint32_t detail[][2] = { { 8, 6 }, { 16, 12 }, { 32, 16 } };
+  for (const uint32_t* sphere : detail) {
+    add_mesh([&] { add_sphere(vertices, indices, sphere[0], sphere[1]); }, 0.5f);
+  }
+
+  // a grid of layers the camera looks straight into, near rows hide most of the far ones
+  const uint32_t layers = 16;
+  const uint32_t side = static_cast<uint32_t>(std::ceil(std::sqrt(static_cast<double>(instance_count) / layers)));
+  const float spacing = 4.0f;
+  std::mt19937 rng(1234);
+  std::uniform_real_distribution<float> scale(0.6f, 1.4f);
+  std::uniform_int_distribution<uint32_t> mesh(0, static_cast<uint32_t>(meshes_.size()) - 1);
+
+  instances_.reserve(instance_count);
+  for (uint32_t i = 0; i < instance_count; ++i) {
+    GpuInstance instance{};
+    instance.PositionScale[0] = (i % side) * spacing;
+    instance.PositionScale[1] = ((i / side) % layers) * spacing;
+    instance.PositionScale[2] = (i / (side * layers)) * spacing;
+    instance.PositionScale[3] = scale(rng) * spacing * 0.6f;
+    instance.Mesh = mesh(rng);
+    instance.Color = rng() | 0xff000000;
+    instances_.push_back(instance);
+  }
+
+  float width = side * spacing;
+  float height = layers * spacing;
+  float view[16];
+  float projection[16];
+  const float znear = 0.1f;
+  const float zfar = 2000.0f;
+  look_at(Vec3{ width * 0.5f, height * 0.5f, -20.0f }, Vec3{ width * 0.5f, height * 0.5f, width }, view);
+  perspective(1.0471976f, static_cast<float>(extent_.width) / extent_.height, znear, zfar, projection);
+  view_ = make_cull_view(view, projection, znear, zfar);
+
+  vk::BufferCreateInfo buffer_info{};
+  buffer_info.sharingMode = vk::SharingMode::eExclusive;
+  buffer_info.size = vertices.size() * sizeof(float);
+  buffer_info.usage = vk::BufferUsageFlagBits::eVertexBuffer | vk::BufferUsageFlagBits::eTransferDst;
+  vertex_buffer_ = device_.createBuffer(buffer_info);
+  vertex_memory_ = allocator_.allocate_for_buffer(vertex_buffer_, vk::MemoryPropertyFlagBits::eDeviceLocal);
+  buffer_info.size = indices.size() * sizeof(uint32_t);
+  buffer_info.usage = vk::BufferUsageFlagBits::eIndexBuffer | vk::BufferUsageFlagBits::eTransferDst;
+  index_buffer_ = device_.createBuffer(buffer_info);
+  index_memory_ = allocator_.allocate_for_buffer(index_buffer_, vk::MemoryPropertyFlagBits::eDeviceLocal);
+
+  upload_value_ = culler_->set_scene(meshes_, instances_);
+  upload_value_ = (std::max)(upload_value_, uploads_.upload_buffer(vertex_buffer_, 0, vertices.data(), vertices.size() * sizeof(float)));
+  upload_value_ = (std::max)(upload_value_, uploads_.upload_buffer(index_buffer_, 0, indices.data(), indices.size() * sizeof(uint32_t)));
+  uploads_.flush();
+}
+
+void CullingBenchmark::create_targets() {
+  vk::ImageCreateInfo image_info{};
+  image_info.imageType = vk::ImageType::e2D;
+  image_info.extent = vk::Extent3D{ extent_.width, extent_.height, 1 };
+  image_info.mipLevels = 1;
+  image_info.arrayLayers = 1;
+  image_info.samples = vk::SampleCountFlagBits::e1;
+  image_info.tiling = vk::ImageTiling::eOptimal;
+  image_info.sharingMode = vk::SharingMode::eExclusive;
+  image_info.initialLayout = vk::ImageLayout::eUndefined;
+
+  image_info.format = vk::Format::eR8G8B8A8Unorm;
+  image_info.usage = vk::ImageUsageFlagBits::eColorAttachment;
+  color_ = device_.createImage(image_info);
+  color_memory_ = allocator_.allocate_for_image(color_, vk::MemoryPropertyFlagBits::eDeviceLocal);
+
+  // sampled as the source of the depth pyramid
+  image_info.format = vk::Format::eD32Sfloat;
+  image_info.usage = vk::ImageUsageFlagBits::eDepthStencilAttachment | vk::ImageUsageFlagBits::eSampled;
+  depth_ = device_.createImage(image_info);
+  depth_memory_ = allocator_.allocate_for_image(depth_, vk::MemoryPropertyFlagBits::eDeviceLocal);
+
+  vk::ImageViewCreateInfo view_info{};
+  view_info.viewType = vk::ImageViewType::e2D;
+  view_info.image = color_;
+  view_info.format = vk::Format::eR8G8B8A8Unorm;
+  view_info.subresourceRange = vk::ImageSubresourceRange{ vk::ImageAspectFlagBits::eColor, 0, 1, 0, 1 };
+  color_view_ = device_.createImageView(view_info);
+  view_info.image = depth_;
+  view_info.format = vk::Format::eD32Sfloat;
+  view_info.subresourceRange = vk::ImageSubresourceRange{ vk::ImageAspectFlagBits::eDepth, 0, 1, 0, 1 };
+  depth_view_ = device_.createImageView(view_info);
+
+  std::array<vk::AttachmentDescription, 2> attachments{};
+  attachments[0].format = vk::Format::eR8G8B8A8Unorm;
+  attachments[0].samples = vk::SampleCountFlagBits::e1;
+  attachments[0].loadOp = vk::AttachmentLoadOp::eClear;
+  attachments[0].storeOp = vk::AttachmentStoreOp::eStore;
+  attachments[0].stencilLoadOp = vk::AttachmentLoadOp::eDontCare;
+  attachments[0].stencilStoreOp = vk::AttachmentStoreOp::eDontCare;
+  attachments[0].initialLayout = vk::ImageLayout::eUndefined;
+  attachments[0].finalLayout = vk::ImageLayout::eColorAttachmentOptimal;
+  attachments[1] = attachments[0];
+  attachments[1].format = vk::Format::eD32Sfloat;
+  attachments[1].finalLayout = vk::ImageLayout::eDepthStencilReadOnlyOptimal;
+
+  vk::AttachmentReference color_ref{ 0, vk::ImageLayout::eColorAttachmentOptimal };
+  vk::AttachmentReference depth_ref{ 1, vk::ImageLayout::eDepthStencilAttachmentOptimal };
+  vk::SubpassDescription subpass{};
+  subpass.pipelineBindPoint = vk::PipelineBindPoint::eGraphics;
+  subpass.colorAttachmentCount = 1;
+  subpass.pColorAttachments = &color_ref;
+  subpass.pDepthStencilAttachment = &depth_ref;
+
+  // last frame's pyramid build reads depth before it is cleared again, and builds from it afterwards
+  std::array<vk::SubpassDependency, 2> dependencies{};
+  dependencies[0].srcSubpass = VK_SUBPASS_EXTERNAL;
+  dependencies[0].dstSubpass = 0;
+  dependencies[0].srcStageMask = vk::PipelineStageFlagBits::eComputeShader | vk::PipelineStageFlagBits::eColorAttachmentOutput;
+  dependencies[0].dstStageMask = vk::PipelineStageFlagBits::eEarlyFragmentTests | vk::PipelineStageFlagBits::eColorAttachmentOutput;
+  dependencies[0].srcAccessMask = vk::AccessFlags{};
+  dependencies[0].dstAccessMask = vk::AccessFlagBits::eDepthStencilAttachmentWrite | vk::AccessFlagBits::eColorAttachmentWrite;
+  dependencies[1].srcSubpass = 0;
+  dependencies[1].dstSubpass = VK_SUBPASS_EXTERNAL;
+  dependencies[1].srcStageMask = vk::PipelineStageFlagBits::eLateFragmentTests;
+  dependencies[1].dstStageMask = vk::PipelineStageFlagBits::eComputeShader;
+  dependencies[1].srcAccessMask = vk::AccessFlagBits::eDepthStencilAttachmentWrite;
+  dependencies[1].dstAccessMask = vk::AccessFlagBits::eShaderRead;
+
+  vk::RenderPassCreateInfo render_pass_info{};
+  render_pass_info.attachmentCount = static_cast<uint32_t>(attachments.size());
+  render_pass_info.pAttachments = attachments.data();
+  render_pass_info.subpassCount = 1;
+  render_pass_info.pSubpasses = &subpass;
+  render_pass_info.dependencyCount = static_cast<uint32_t>(dependencies.size());
+  render_pass_info.pDependencies = dependencies.data();
+  render_pass_ = device_.createRenderPass(render_pass_info);
+
+  std::array<vk::ImageView, 2> views = { color_view_, depth_view_ };
+  vk::FramebufferCreateInfo framebuffer_info{};
+  framebuffer_info.renderPass = render_pass_;
+  framebuffer_info.attachmentCount = static_cast<uint32_t>(views.size());
+  framebuffer_info.pAttachments = views.data();
+  framebuffer_info.width = extent_.width;
+  framebuffer_info.height = extent_.height;
+  framebuffer_info.layers = 1;
+  framebuffer_ = device_.createFramebuffer(framebuffer_info);
+
+  culler_->set_depth_source(depth_view_, extent_, vk::ImageLayout::eDepthStencilReadOnlyOptimal);
+}
+
+PipelineHandle CullingBenchmark::create_pipeline() {
+  GraphicsPipelineDesc desc{};
+  desc.Stages = { ShaderStageDesc{ vk::ShaderStageFlagBits::eVertex, vertex_shader_ },
+    ShaderStageDesc{ vk::ShaderStageFlagBits::eFragment, fragment_shader_ } };
+  desc.VertexBindings = { vk::VertexInputBindingDescription{ 0, 3 * sizeof(float), vk::VertexInputRate::eVertex } };
+  desc.VertexAttributes = { vk::VertexInputAttributeDescription{ 0, 0, vk::Format::eR32G32B32Sfloat, 0 } };
+  // the view flips handedness, and the benchmark is about submission rather than shading
+  desc.CullMode = vk::CullModeFlagBits::eNone;
+  desc.DepthTest = true;
+  desc.DepthWrite = true;
+  desc.DepthCompare = vk::CompareOp::eLess;
+  vk::PipelineColorBlendAttachmentState blend{};
+  blend.colorWriteMask = vk::ColorComponentFlagBits::eR | vk::ColorComponentFlagBits::eG |
+    vk::ColorComponentFlagBits::eB | vk::ColorComponentFlagBits::eA;
+  desc.Blend = { blend };
+  desc.Layout = heap_.pipeline_layout();
+  desc.RenderPass = render_pass_;
+  return pipelines_.request_graphics(desc);
+}
+
+CullingBenchmark::FrameTimes CullingBenchmark::render_frame(Mode mode, bool first) {
+  FrameTimes times;
+  auto record_start = std::chrono::steady_clock::now();
+
+  // the previous frame's fence was waited on, a reload can swap modules and pipelines here
+  shaders_.poll();
+  if (reloaded_.ready()) {
+    pipeline_ = reloaded_;
+    reloaded_ = PipelineHandle();
+  }
+  culler_->begin_frame(0, view_);
+  device_.resetCommandPool(command_pool_);
+  vk::CommandBufferBeginInfo begin_info{};
+  begin_info.flags = vk::CommandBufferUsageFlagBits::eOneTimeSubmit;
+  command_buffer_.begin(begin_info);
+  if (first) {
+    uploads_.record_acquires(command_buffer_);
+  }
+
+  if (mode != Mode::Naive) {
+    culler_->record_cull(command_buffer_, mode == Mode::GpuOcclusion);
+  }
+
+  std::array<vk::ClearValue, 2> clear_values{};
+  clear_values[0].color = vk::ClearColorValue{ std::array<float, 4>{ 0.1f, 0.1f, 0.1f, 1.0f } };
+  clear_values[1].depthStencil = vk::ClearDepthStencilValue{ 1.0f, 0 };
+  vk::RenderPassBeginInfo pass_info{};
+  pass_info.renderPass = render_pass_;
+  pass_info.framebuffer = framebuffer_;
+  pass_info.renderArea = vk::Rect2D{ vk::Offset2D{ 0, 0 }, extent_ };
+  pass_info.clearValueCount = static_cast<uint32_t>(clear_values.size());
+  pass_info.pClearValues = clear_values.data();
+  command_buffer_.beginRenderPass(pass_info, vk::SubpassContents::eInline);
+
+  command_buffer_.bindPipeline(vk::PipelineBindPoint::eGraphics, pipeline_.get_or(nullptr));
+  heap_.bind(command_buffer_, vk::PipelineBindPoint::eGraphics);
+  vk::Viewport viewport{ 0.0f, 0.0f, static_cast<float>(extent_.width), static_cast<float>(extent_.height), 0.0f, 1.0f };
+  command_buffer_.setViewport(0, viewport);
+  command_buffer_.setScissor(0, pass_info.renderArea);
+  vk::DeviceSize offset = 0;
+  command_buffer_.bindVertexBuffers(0, vertex_buffer_, offset);
+  command_buffer_.bindIndexBuffer(index_buffer_, 0, vk::IndexType::eUint32);
+
+  if (mode == Mode::Naive) {
+    times.ApiDraws = record_naive(command_buffer_);
+  }
+  else {
+    culler_->record_draws(command_buffer_);
+    times.ApiDraws = 1;
+  }
+
+  command_buffer_.endRenderPass();
+  // every mode builds the pyramid so the GPU timings stay comparable
+  culler_->record_depth_pyramid(command_buffer_);
+  command_buffer_.end();
+
+  auto submit_start = std::chrono::steady_clock::now();
+  vk::SubmitInfo submit_info{};
+  submit_info.commandBufferCount = 1;
+  submit_info.pCommandBuffers = &command_buffer_;
+  queue_.submit(submit_info, fence_);
+  auto submit_stop = std::chrono::steady_clock::now();
+
+  (void)device_.waitForFences(fence_, VK_TRUE, UINT64_MAX);
+  auto gpu_stop = std::chrono::steady_clock::now();
+  device_.resetFences(fence_);
+
+  times.RecordMs = elapsed_ms(record_start, submit_start);
+  times.SubmitMs = elapsed_ms(submit_start, submit_stop);
+  times.GpuMs = elapsed_ms(submit_stop, gpu_stop);
+  return times;
+}
+
+uint32_t CullingBenchmark::record_naive(vk::CommandBuffer command_buffer) {
+  // the vertex shader takes the instance straight from firstInstance
+  CullPush push = culler_->push_constants(IndirectCuller::DrawDirect);
+  heap_.push(command_buffer, &push, sizeof(push));
+
+  uint32_t draws = 0;
+  for (uint32_t i = 0; i < instances_.size(); ++i) {
+    const GpuInstance& instance = instances_[i];
+    const GpuMesh& mesh = meshes_[instance.Mesh];
+
+    float scale = instance.PositionScale[3];
+    float center[3] = { instance.PositionScale[0] + mesh.Bounds[0] * scale, instance.PositionScale[1] + mesh.Bounds[1] * scale,
+      instance.PositionScale[2] + mesh.Bounds[2] * scale };
+    float radius = mesh.Bounds[3] * scale;
+
+    bool visible = true;
+    for (const float* plane : view_.Frustum) {
+      visible = visible && plane[0] * center[0] + plane[1] * center[1] + plane[2] * center[2] + plane[3] > -radius;
+    }
+    if (visible) {
+      command_buffer.drawIndexed(mesh.IndexCount, 1, mesh.FirstIndex, mesh.VertexOffset, i);
+      ++draws;
+    }
+  }
+  return draws;
+}
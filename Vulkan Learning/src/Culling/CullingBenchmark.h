@@ -0,0 +1,83 @@
+#pragma once
+#include "Headers.h"
+#include "Culling/IndirectCuller.h"
+
+#include <string>
+
+// Draws a dense instanced scene offscreen twice: once the naive way, with a CPU
+// frustum test and one vkCmdDrawIndexed per object, and once through
+// IndirectCuller with and without occlusion. Reports API draw calls, the draws
+// that actually reached the GPU and the CPU record and submit time of each.
+// Shader reloads are applied between frames, so shaders can be tuned while
+// the numbers run.
+class CullingBenchmark {
+public:
+  CullingBenchmark(const vk::Device& device, MemoryAllocator& allocator, UploadEngine& uploads, BindlessHeap& heap,
+    PipelineService& pipelines, ShaderLibrary& shaders, vk::Queue queue, uint32_t queue_family,
+    uint32_t instance_count, const bool debug);
+  ~CullingBenchmark();
+
+  void run(uint32_t frames);
+
+private:
+  enum class Mode {
+    Naive,
+    GpuFrustum,
+    GpuOcclusion
+  };
+
+  struct FrameTimes {
+    double RecordMs = 0.0;
+    double SubmitMs = 0.0;
+    double GpuMs = 0.0;
+    uint32_t ApiDraws = 0;
+  };
+
+  void create_scene(uint32_t instance_count);
+  void create_targets();
+  PipelineHandle create_pipeline();
+  FrameTimes render_frame(Mode mode, bool first);
+  uint32_t record_naive(vk::CommandBuffer command_buffer);
+
+  vk::Device device_;
+  MemoryAllocator& allocator_;
+  UploadEngine& uploads_;
+  BindlessHeap& heap_;
+  PipelineService& pipelines_;
+  ShaderLibrary& shaders_;
+  vk::Queue queue_;
+  bool debug_;
+
+  IndirectCuller* culler_ = nullptr;
+  std::vector<GpuMesh> meshes_;
+  std::vector<GpuInstance> instances_;
+  CullView view_;
+  uint64_t upload_value_ = 0;
+
+  vk::Buffer vertex_buffer_;
+  MemoryAllocation vertex_memory_;
+  vk::Buffer index_buffer_;
+  MemoryAllocation index_memory_;
+
+  vk::Extent2D extent_{ 1280, 720 };
+  vk::Image color_;
+  MemoryAllocation color_memory_;
+  vk::ImageView color_view_;
+  vk::Image depth_;
+  MemoryAllocation depth_memory_;
+  vk::ImageView depth_view_;
+  vk::RenderPass render_pass_;
+  vk::Framebuffer framebuffer_;
+
+  // owned by the library
+  vk::ShaderModule vertex_shader_;
+  vk::ShaderModule fragment_shader_;
+  std::vector<uint32_t> listeners_;
+  PipelineHandle pipeline_;
+  // recompile after a reload, swapped in once ready
+  PipelineHandle reloaded_;
+
+  vk::CommandPool command_pool_;
+  vk::CommandBuffer command_buffer_;
+  vk::Fence fence_;
+};
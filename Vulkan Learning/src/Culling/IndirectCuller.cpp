@@ -0,0 +1,428 @@
+#include "Culling/IndirectCuller.h"
+
+#include <cmath>
+#include <cstring>
+
+namespace {
+  uint32_t previous_power_of_two(uint32_t value) {
+    uint32_t result = 1;
+    while (result * 2 <= value) {
+      result *= 2;
+    }
+    return result;
+  }
+
+  void multiply(const float a[16], const float b[16], float out[16]) {
+    for (int column = 0; column < 4; ++column) {
+      for (int row = 0; row < 4; ++row) {
+        float sum = 0.0f;
+        for (int k = 0; k < 4; ++k) {
+          sum += a[k * 4 + row] * b[column * 4 + k];
+        }
+        out[column * 4 + row] = sum;
+      }
+    }
+  }
+}
+
+CullView make_cull_view(const float view[16], const float projection[16], float znear, float zfar) {
+  CullView cull{};
+  memcpy(cull.View, view, sizeof(cull.View));
+  multiply(projection, view, cull.ViewProj);
+
+  // planes straight from the rows of the view projection (Gribb and Hartmann), clip z is [0, w]
+  const float* m = cull.ViewProj;
+  auto row = [m](int r, int c) { return m[c * 4 + r]; };
+  for (int c = 0; c < 4; ++c) {
+    cull.Frustum[0][c] = row(3, c) + row(0, c);
+    cull.Frustum[1][c] = row(3, c) - row(0, c);
+    cull.Frustum[2][c] = row(3, c) + row(1, c);
+    cull.Frustum[3][c] = row(3, c) - row(1, c);
+    cull.Frustum[4][c] = row(2, c);
+    cull.Frustum[5][c] = row(3, c) - row(2, c);
+  }
+  for (float* plane : cull.Frustum) {
+    float length = std::sqrt(plane[0] * plane[0] + plane[1] * plane[1] + plane[2] * plane[2]);
+    for (int c = 0; c < 4; ++c) {
+      plane[c] /= length;
+    }
+  }
+
+  cull.P00 = projection[0];
+  cull.P11 = projection[5];
+  cull.ZNear = znear;
+  cull.ZFar = zfar;
+  return cull;
+}
+
+IndirectCuller::IndirectCuller(const vk::Device& device, MemoryAllocator& allocator, UploadEngine& uploads, BindlessHeap& heap,
+  PipelineService& pipelines, ShaderLibrary& shaders, uint32_t frames_in_flight, const bool debug)
+  : device_(device), allocator_(allocator), uploads_(uploads), heap_(heap), pipelines_(pipelines), shaders_(shaders), debug_(debug) {
+  const char* sources[] = { "cull.comp", "compact_draws.comp", "depth_pyramid.comp" };
+  for (uint32_t i = 0; i < 3; ++i) {
+    ShaderSource source{ sources[i] };
+    request_pipeline(i, shaders_.load(source));
+    listeners_.push_back(shaders_.on_reload(source, [this, i](vk::ShaderModule module) {
+      request_pipeline(i, module);
+    }));
+  }
+  cull_pipeline_ = reloaded_[0];
+  compact_pipeline_ = reloaded_[1];
+  pyramid_pipeline_ = reloaded_[2];
+  reloaded_ = {};
+
+  vk::MemoryPropertyFlags host = vk::MemoryPropertyFlagBits::eHostVisible | vk::MemoryPropertyFlagBits::eHostCoherent;
+  for (uint32_t i = 0; i < frames_in_flight; ++i) {
+    views_.push_back(create_buffer(sizeof(CullView), vk::BufferUsageFlagBits::eStorageBuffer, host, true));
+    readbacks_.push_back(create_buffer(2 * sizeof(uint32_t), vk::BufferUsageFlagBits::eTransferDst, host, false));
+    memset(readbacks_.back().Memory.Mapped, 0, 2 * sizeof(uint32_t));
+  }
+
+  // texelFetch only, the sampler is never filtered
+  vk::SamplerCreateInfo sampler_info{};
+  sampler_info.magFilter = vk::Filter::eNearest;
+  sampler_info.minFilter = vk::Filter::eNearest;
+  sampler_info.mipmapMode = vk::SamplerMipmapMode::eNearest;
+  sampler_info.addressModeU = vk::SamplerAddressMode::eClampToEdge;
+  sampler_info.addressModeV = vk::SamplerAddressMode::eClampToEdge;
+  sampler_info.addressModeW = vk::SamplerAddressMode::eClampToEdge;
+  sampler_info.maxLod = VK_LOD_CLAMP_NONE;
+  pyramid_sampler_ = device_.createSampler(sampler_info);
+}
+
+IndirectCuller::~IndirectCuller() {
+  destroy_pyramid();
+  destroy_scene();
+  for (Buffer& buffer : views_) {
+    destroy_buffer(buffer);
+  }
+  for (Buffer& buffer : readbacks_) {
+    destroy_buffer(buffer);
+  }
+  device_.destroySampler(pyramid_sampler_);
+
+  // the pipelines and modules belong to the service and the library
+  for (uint32_t listener : listeners_) {
+    shaders_.remove_listener(listener);
+  }
+}
+
+uint64_t IndirectCuller::set_scene(std::vector<GpuMesh> meshes, const std::vector<GpuInstance>& instances) {
+  // zero sized buffers are invalid, and an empty scene has nothing to cull
+  if (meshes.empty() || instances.empty()) {
+    throw std::runtime_error("Failed to set culling scene, it has no meshes or no instances!");
+  }
+  for (const GpuInstance& instance : instances) {
+    if (instance.Mesh >= meshes.size()) {
+      throw std::runtime_error("Failed to set culling scene, an instance refers to a missing mesh!");
+    }
+  }
+
+  destroy_scene();
+  instance_count_ = static_cast<uint32_t>(instances.size());
+  mesh_count_ = static_cast<uint32_t>(meshes.size());
+
+  // each mesh gets a contiguous range of the visible list, sized for all of its instances
+  std::vector<uint32_t> per_mesh(meshes.size(), 0);
+  for (const GpuInstance& instance : instances) {
+    ++per_mesh[instance.Mesh];
+  }
+  std::vector<vk::DrawIndexedIndirectCommand> commands(meshes.size());
+  uint32_t base = 0;
+  for (size_t i = 0; i < meshes.size(); ++i) {
+    meshes[i].InstanceBase = base;
+    commands[i] = vk::DrawIndexedIndirectCommand{ meshes[i].IndexCount, 0, meshes[i].FirstIndex, meshes[i].VertexOffset, base };
+    base += per_mesh[i];
+  }
+
+  vk::MemoryPropertyFlags local = vk::MemoryPropertyFlagBits::eDeviceLocal;
+  vk::BufferUsageFlags storage = vk::BufferUsageFlagBits::eStorageBuffer | vk::BufferUsageFlagBits::eTransferDst;
+  vk::DeviceSize command_bytes = commands.size() * sizeof(vk::DrawIndexedIndirectCommand);
+
+  instances_ = create_buffer(instances.size() * sizeof(GpuInstance), storage, local, true);
+  meshes_ = create_buffer(meshes.size() * sizeof(GpuMesh), storage, local, true);
+  command_template_ = create_buffer(command_bytes, vk::BufferUsageFlagBits::eTransferSrc | vk::BufferUsageFlagBits::eTransferDst, local, false);
+  commands_ = create_buffer(command_bytes, storage, local, true);
+  visible_ = create_buffer(instance_count_ * sizeof(uint32_t), storage, local, true);
+  draws_ = create_buffer(command_bytes, storage | vk::BufferUsageFlagBits::eIndirectBuffer, local, true);
+  counts_ = create_buffer(2 * sizeof(uint32_t), storage | vk::BufferUsageFlagBits::eIndirectBuffer | vk::BufferUsageFlagBits::eTransferSrc,
+    local, true);
+
+  uint64_t value = 0;
+  value = (std::max)(value, uploads_.upload_buffer(instances_.Buffer, 0, instances.data(), instances.size() * sizeof(GpuInstance)));
+  value = (std::max)(value, uploads_.upload_buffer(meshes_.Buffer, 0, meshes.data(), meshes.size() * sizeof(GpuMesh)));
+  value = (std::max)(value, uploads_.upload_buffer(command_template_.Buffer, 0, commands.data(), command_bytes));
+  uploads_.flush();
+  heap_.flush();
+
+  stats_.Instances = instance_count_;
+  stats_.Meshes = mesh_count_;
+  if (debug_) {
+    LOG_DEBUG("Indirect culler scene: " << instance_count_ << " instances of " << mesh_count_ << " meshes");
+  }
+  return value;
+}
+
+void IndirectCuller::set_depth_source(vk::ImageView depth_view, vk::Extent2D extent, vk::ImageLayout layout) {
+  destroy_pyramid();
+
+  // a power of two base keeps every level an exact 2:1 reduction of the one above
+  pyramid_extent_ = vk::Extent2D{ previous_power_of_two(extent.width), previous_power_of_two(extent.height) };
+  uint32_t levels = 1;
+  while ((std::max)(pyramid_extent_.width, pyramid_extent_.height) >> levels) {
+    ++levels;
+  }
+
+  vk::ImageCreateInfo image_info{};
+  image_info.imageType = vk::ImageType::e2D;
+  image_info.format = vk::Format::eR32Sfloat;
+  image_info.extent = vk::Extent3D{ pyramid_extent_.width, pyramid_extent_.height, 1 };
+  image_info.mipLevels = levels;
+  image_info.arrayLayers = 1;
+  image_info.samples = vk::SampleCountFlagBits::e1;
+  image_info.tiling = vk::ImageTiling::eOptimal;
+  image_info.usage = vk::ImageUsageFlagBits::eSampled | vk::ImageUsageFlagBits::eStorage;
+  image_info.sharingMode = vk::SharingMode::eExclusive;
+  image_info.initialLayout = vk::ImageLayout::eUndefined;
+  pyramid_ = device_.createImage(image_info);
+  pyramid_memory_ = allocator_.allocate_for_image(pyramid_, vk::MemoryPropertyFlagBits::eDeviceLocal);
+
+  vk::ImageViewCreateInfo view_info{};
+  view_info.image = pyramid_;
+  view_info.viewType = vk::ImageViewType::e2D;
+  view_info.format = vk::Format::eR32Sfloat;
+  view_info.subresourceRange = vk::ImageSubresourceRange{ vk::ImageAspectFlagBits::eColor, 0, levels, 0, 1 };
+  pyramid_view_ = device_.createImageView(view_info);
+  // sampled and written in the same dispatch sequence, so it stays in general layout
+  pyramid_slot_ = heap_.add_texture(pyramid_view_, pyramid_sampler_, vk::ImageLayout::eGeneral);
+
+  for (uint32_t level = 0; level < levels; ++level) {
+    view_info.subresourceRange = vk::ImageSubresourceRange{ vk::ImageAspectFlagBits::eColor, level, 1, 0, 1 };
+    pyramid_mip_views_.push_back(device_.createImageView(view_info));
+    pyramid_mip_slots_.push_back(heap_.add_storage_image(pyramid_mip_views_.back(), vk::ImageLayout::eGeneral));
+  }
+
+  depth_slot_ = heap_.add_texture(depth_view, pyramid_sampler_, layout);
+  heap_.flush();
+
+  if (debug_) {
+    LOG_DEBUG("Depth pyramid " << pyramid_extent_.width << "x" << pyramid_extent_.height << " with " << levels << " levels");
+  }
+}
+
+bool IndirectCuller::ready() const {
+  return instance_count_ != 0 && cull_pipeline_.ready() && compact_pipeline_.ready() && pyramid_pipeline_.ready();
+}
+
+void IndirectCuller::begin_frame(uint32_t frame_slot, const CullView& view) {
+  frame_slot_ = frame_slot;
+  PipelineHandle* current[] = { &cull_pipeline_, &compact_pipeline_, &pyramid_pipeline_ };
+  for (uint32_t i = 0; i < 3; ++i) {
+    if (reloaded_[i].ready()) {
+      *current[i] = reloaded_[i];
+      reloaded_[i] = PipelineHandle();
+    }
+  }
+  memcpy(views_[frame_slot_].Memory.Mapped, &view, sizeof(CullView));
+
+  // the slot's fence has been waited on, so the counts its last frame copied are final
+  const uint32_t* counts = static_cast<const uint32_t*>(readbacks_[frame_slot_].Memory.Mapped);
+  stats_.Draws = counts[0];
+  stats_.VisibleInstances = counts[1];
+}
+
+void IndirectCuller::record_cull(vk::CommandBuffer command_buffer, bool occlusion) {
+  if (!ready()) {
+    return;
+  }
+
+  // the previous frame's draws and culling still read what is reset here
+  vk::MemoryBarrier reuse{ vk::AccessFlags{}, vk::AccessFlags{} };
+  command_buffer.pipelineBarrier(vk::PipelineStageFlagBits::eDrawIndirect | vk::PipelineStageFlagBits::eVertexShader |
+    vk::PipelineStageFlagBits::eComputeShader | vk::PipelineStageFlagBits::eTransfer, vk::PipelineStageFlagBits::eTransfer,
+    vk::DependencyFlags{}, reuse, nullptr, nullptr);
+
+  vk::BufferCopy reset{ 0, 0, mesh_count_ * sizeof(vk::DrawIndexedIndirectCommand) };
+  command_buffer.copyBuffer(command_template_.Buffer, commands_.Buffer, reset);
+  command_buffer.fillBuffer(counts_.Buffer, 0, 2 * sizeof(uint32_t), 0);
+
+  vk::MemoryBarrier to_cull{ vk::AccessFlagBits::eTransferWrite, vk::AccessFlagBits::eShaderRead | vk::AccessFlagBits::eShaderWrite };
+  command_buffer.pipelineBarrier(vk::PipelineStageFlagBits::eTransfer, vk::PipelineStageFlagBits::eComputeShader,
+    vk::DependencyFlags{}, to_cull, nullptr, nullptr);
+
+  CullPush push = push_constants(occlusion && pyramid_valid_ ? Occlusion : 0);
+  heap_.bind(command_buffer, vk::PipelineBindPoint::eCompute);
+  heap_.push(command_buffer, &push, sizeof(push));
+
+  command_buffer.bindPipeline(vk::PipelineBindPoint::eCompute, cull_pipeline_.get_or(nullptr));
+  command_buffer.dispatch((instance_count_ + 63) / 64, 1, 1);
+
+  vk::MemoryBarrier to_compact{ vk::AccessFlagBits::eShaderWrite, vk::AccessFlagBits::eShaderRead | vk::AccessFlagBits::eShaderWrite };
+  command_buffer.pipelineBarrier(vk::PipelineStageFlagBits::eComputeShader, vk::PipelineStageFlagBits::eComputeShader,
+    vk::DependencyFlags{}, to_compact, nullptr, nullptr);
+
+  command_buffer.bindPipeline(vk::PipelineBindPoint::eCompute, compact_pipeline_.get_or(nullptr));
+  command_buffer.dispatch((mesh_count_ + 63) / 64, 1, 1);
+
+  vk::MemoryBarrier to_draw{ vk::AccessFlagBits::eShaderWrite,
+    vk::AccessFlagBits::eIndirectCommandRead | vk::AccessFlagBits::eShaderRead | vk::AccessFlagBits::eTransferRead };
+  command_buffer.pipelineBarrier(vk::PipelineStageFlagBits::eComputeShader,
+    vk::PipelineStageFlagBits::eDrawIndirect | vk::PipelineStageFlagBits::eVertexShader | vk::PipelineStageFlagBits::eTransfer,
+    vk::DependencyFlags{}, to_draw, nullptr, nullptr);
+
+  // counts for stats(), read back once this slot comes around again
+  vk::BufferCopy count_copy{ 0, 0, 2 * sizeof(uint32_t) };
+  command_buffer.copyBuffer(counts_.Buffer, readbacks_[frame_slot_].Buffer, count_copy);
+  vk::MemoryBarrier to_host{ vk::AccessFlagBits::eTransferWrite, vk::AccessFlagBits::eHostRead };
+  command_buffer.pipelineBarrier(vk::PipelineStageFlagBits::eTransfer, vk::PipelineStageFlagBits::eHost,
+    vk::DependencyFlags{}, to_host, nullptr, nullptr);
+}
+
+void IndirectCuller::record_draws(vk::CommandBuffer command_buffer) const {
+  if (!ready()) {
+    return;
+  }
+
+  CullPush push = push_constants(0);
+  heap_.push(command_buffer, &push, sizeof(push));
+  command_buffer.drawIndexedIndirectCount(draws_.Buffer, 0, counts_.Buffer, 0, mesh_count_, sizeof(vk::DrawIndexedIndirectCommand));
+}
+
+void IndirectCuller::record_depth_pyramid(vk::CommandBuffer command_buffer) {
+  if (!pyramid_ || !pyramid_pipeline_.ready()) {
+    return;
+  }
+
+  std::vector<vk::ImageMemoryBarrier> barriers;
+  if (!pyramid_initialized_) {
+    vk::ImageMemoryBarrier to_general{};
+    to_general.srcAccessMask = vk::AccessFlags{};
+    to_general.dstAccessMask = vk::AccessFlagBits::eShaderRead | vk::AccessFlagBits::eShaderWrite;
+    to_general.oldLayout = vk::ImageLayout::eUndefined;
+    to_general.newLayout = vk::ImageLayout::eGeneral;
+    to_general.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    to_general.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    to_general.image = pyramid_;
+    to_general.subresourceRange = vk::ImageSubresourceRange{ vk::ImageAspectFlagBits::eColor, 0, VK_REMAINING_MIP_LEVELS, 0, 1 };
+    barriers.push_back(to_general);
+    pyramid_initialized_ = true;
+  }
+
+  // depth written by the pass just recorded, and this frame's culling still reading the old pyramid
+  vk::MemoryBarrier to_build{ vk::AccessFlagBits::eDepthStencilAttachmentWrite, vk::AccessFlagBits::eShaderRead | vk::AccessFlagBits::eShaderWrite };
+  command_buffer.pipelineBarrier(vk::PipelineStageFlagBits::eEarlyFragmentTests | vk::PipelineStageFlagBits::eLateFragmentTests |
+    vk::PipelineStageFlagBits::eComputeShader, vk::PipelineStageFlagBits::eComputeShader,
+    vk::DependencyFlags{}, to_build, nullptr, barriers);
+
+  heap_.bind(command_buffer, vk::PipelineBindPoint::eCompute);
+  command_buffer.bindPipeline(vk::PipelineBindPoint::eCompute, pyramid_pipeline_.get_or(nullptr));
+
+  vk::MemoryBarrier between_levels{ vk::AccessFlagBits::eShaderWrite, vk::AccessFlagBits::eShaderRead };
+  for (uint32_t level = 0; level < pyramid_mip_slots_.size(); ++level) {
+    CullPush push{};
+    push.SourceTexture = level == 0 ? depth_slot_ : pyramid_slot_;
+    push.SourceLevel = level == 0 ? 0 : level - 1;
+    push.TargetImage = pyramid_mip_slots_[level];
+    push.TargetWidth = (std::max)(pyramid_extent_.width >> level, 1u);
+    push.TargetHeight = (std::max)(pyramid_extent_.height >> level, 1u);
+    heap_.push(command_buffer, &push, sizeof(push));
+    command_buffer.dispatch((push.TargetWidth + 7) / 8, (push.TargetHeight + 7) / 8, 1);
+
+    command_buffer.pipelineBarrier(vk::PipelineStageFlagBits::eComputeShader, vk::PipelineStageFlagBits::eComputeShader,
+      vk::DependencyFlags{}, between_levels, nullptr, nullptr);
+  }
+  pyramid_valid_ = true;
+}
+
+CullPush IndirectCuller::push_constants(uint32_t flags) const {
+  CullPush push{};
+  push.ViewBuffer = views_[frame_slot_].Slot;
+  push.InstanceBuffer = instances_.Slot;
+  push.MeshBuffer = meshes_.Slot;
+  push.CommandBuffer = commands_.Slot;
+  push.VisibleBuffer = visible_.Slot;
+  push.DrawBuffer = draws_.Slot;
+  push.CountBuffer = counts_.Slot;
+  push.Pyramid = pyramid_slot_;
+  push.InstanceCount = instance_count_;
+  push.MeshCount = mesh_count_;
+  push.Flags = flags;
+  return push;
+}
+
+IndirectCuller::Buffer IndirectCuller::create_buffer(vk::DeviceSize size, vk::BufferUsageFlags usage, vk::MemoryPropertyFlags properties,
+  bool bindless) {
+  Buffer buffer;
+  vk::BufferCreateInfo buffer_info{};
+  buffer_info.size = size;
+  buffer_info.usage = usage;
+  buffer_info.sharingMode = vk::SharingMode::eExclusive;
+  buffer.Buffer = device_.createBuffer(buffer_info);
+  buffer.Memory = allocator_.allocate_for_buffer(buffer.Buffer, properties);
+  if (bindless) {
+    buffer.Slot = heap_.add_storage_buffer(buffer.Buffer);
+  }
+  return buffer;
+}
+
+void IndirectCuller::destroy_buffer(Buffer& buffer) {
+  if (!buffer.Buffer) {
+    return;
+  }
+  heap_.release(BindlessType::StorageBuffer, buffer.Slot);
+  device_.destroyBuffer(buffer.Buffer);
+  allocator_.free(buffer.Memory);
+  buffer = Buffer{};
+}
+
+void IndirectCuller::destroy_scene() {
+  destroy_buffer(instances_);
+  destroy_buffer(meshes_);
+  destroy_buffer(command_template_);
+  destroy_buffer(commands_);
+  destroy_buffer(visible_);
+  destroy_buffer(draws_);
+  destroy_buffer(counts_);
+  instance_count_ = 0;
+  mesh_count_ = 0;
+}
+
+void IndirectCuller::request_pipeline(uint32_t index, vk::ShaderModule module) {
+  ComputePipelineDesc desc{};
+  desc.Layout = heap_.pipeline_layout();
+  desc.Stage.Module = module;
+  reloaded_[index] = pipelines_.request_compute(desc);
+}
+
+void IndirectCuller::destroy_pyramid() {
+  if (!pyramid_) {
+    return;
+  }
+
+  heap_.release(BindlessType::Texture, pyramid_slot_);
+  heap_.release(BindlessType::Texture, depth_slot_);
+  for (size_t level = 0; level < pyramid_mip_views_.size(); ++level) {
+    heap_.release(BindlessType::StorageImage, pyramid_mip_slots_[level]);
+    device_.destroyImageView(pyramid_mip_views_[level]);
+  }
+  pyramid_mip_views_.clear();
+  pyramid_mip_slots_.clear();
+  device_.destroyImageView(pyramid_view_);
+  device_.destroyImage(pyramid_);
+  allocator_.free(pyramid_memory_);
+
+  pyramid_ = nullptr;
+  pyramid_slot_ = BindlessHeap::InvalidSlot;
+  depth_slot_ = BindlessHeap::InvalidSlot;
+  pyramid_initialized_ = false;
+  pyramid_valid_ = false;
+}
+
+CullStats IndirectCuller::stats() const {
+  return stats_;
+}
+
+void IndirectCuller::report() const {
+  std::cout << "Indirect culler: " << stats_.Instances << " instances of " << stats_.Meshes << " meshes, last frame "
+    << stats_.VisibleInstances << " visible in " << stats_.Draws << " indirect draws" << std::endl;
+}
@@ -0,0 +1,183 @@
+#pragma once
+#include "Headers.h"
+#include "Descriptors/BindlessHeap.h"
+#include "Memory/MemoryAllocator.h"
+#include "Pipelines/PipelineService.h"
+#include "Shaders/ShaderLibrary.h"
+#include "Transfer/UploadEngine.h"
+
+#include <array>
+
+// GPU-side scene layout, mirrors shaders/scene.glsl
+struct GpuInstance {
+  // world position, uniform scale in w
+  float PositionScale[4];
+  uint32_t Mesh = 0;
+  // RGBA8
+  uint32_t Color = 0xffffffff;
+  uint32_t Pad[2] = {};
+};
+
+struct GpuMesh {
+  uint32_t IndexCount = 0;
+  uint32_t FirstIndex = 0;
+  int32_t VertexOffset = 0;
+  // start of the mesh's range in the visible list, filled in by IndirectCuller::set_scene()
+  uint32_t InstanceBase = 0;
+  // mesh space bounding sphere, radius in w
+  float Bounds[4];
+};
+
+// View space looks down +z with y pointing down the screen, depth is [0, 1]
+struct CullView {
+  float View[16];
+  float ViewProj[16];
+  // world space planes, a point is inside when dot(xyz, p) + w >= 0
+  float Frustum[6][4];
+  float P00;
+  float P11;
+  float ZNear;
+  float ZFar;
+};
+
+// heap slots and counts shared by the culling, pyramid and draw shaders
+struct CullPush {
+  uint32_t ViewBuffer = BindlessHeap::InvalidSlot;
+  uint32_t InstanceBuffer = BindlessHeap::InvalidSlot;
+  uint32_t MeshBuffer = BindlessHeap::InvalidSlot;
+  uint32_t CommandBuffer = BindlessHeap::InvalidSlot;
+  uint32_t VisibleBuffer = BindlessHeap::InvalidSlot;
+  uint32_t DrawBuffer = BindlessHeap::InvalidSlot;
+  uint32_t CountBuffer = BindlessHeap::InvalidSlot;
+  uint32_t Pyramid = BindlessHeap::InvalidSlot;
+  uint32_t InstanceCount = 0;
+  uint32_t MeshCount = 0;
+  uint32_t Flags = 0;
+  uint32_t SourceTexture = BindlessHeap::InvalidSlot;
+  uint32_t SourceLevel = 0;
+  uint32_t TargetImage = BindlessHeap::InvalidSlot;
+  uint32_t TargetWidth = 0;
+  uint32_t TargetHeight = 0;
+};
+
+static_assert(sizeof(GpuInstance) == 32, "GpuInstance must match scene.glsl");
+static_assert(sizeof(GpuMesh) == 32, "GpuMesh must match scene.glsl");
+static_assert(sizeof(CullView) == 240, "CullView must match scene.glsl");
+static_assert(sizeof(CullPush) <= BindlessHeap::PushConstantSize, "CullPush must fit the heap's push constants");
+
+// view and projection are column major, projection as in the CullView comment
+CullView make_cull_view(const float view[16], const float projection[16], float znear, float zfar);
+
+struct CullStats {
+  uint32_t Instances = 0;
+  uint32_t Meshes = 0;
+  // read back from the last completed use of the frame slot
+  uint32_t Draws = 0;
+  uint32_t VisibleInstances = 0;
+};
+
+// GPU-driven culling. One compute pass tests every instance against the view
+// frustum and last frame's depth pyramid and appends survivors to their
+// mesh's indirect command, a second pass compacts the non-empty commands, and
+// a single vkCmdDrawIndexedIndirectCount then draws the scene. The CPU cost is
+// the same for ten instances or a million.
+//
+// All buffers and the pyramid are reached through the bindless heap, the
+// caller's graphics pipeline has to use the heap's pipeline layout and the
+// instance vertex shader.
+class IndirectCuller {
+public:
+  static constexpr uint32_t Occlusion = 1;
+  // instance index comes from gl_InstanceIndex instead of the visible list
+  static constexpr uint32_t DrawDirect = 2;
+
+  IndirectCuller(const vk::Device& device, MemoryAllocator& allocator, UploadEngine& uploads, BindlessHeap& heap,
+    PipelineService& pipelines, ShaderLibrary& shaders, uint32_t frames_in_flight, const bool debug);
+  // the GPU must be done with every frame that used the culler
+  ~IndirectCuller();
+
+  // Mesh indices in instances refer to meshes, neither list may be empty.
+  // Returns the upload value the first frame has to wait on, with the
+  // ownership acquires recorded through UploadEngine::record_acquires().
+  // Frees the previous scene's buffers, so only call it while the GPU is idle.
+  uint64_t set_scene(std::vector<GpuMesh> meshes, const std::vector<GpuInstance>& instances);
+  // depth target the pyramid is built from, sampled in layout. Recreates the
+  // pyramid, so only call it while the GPU is idle.
+  void set_depth_source(vk::ImageView depth_view, vk::Extent2D extent, vk::ImageLayout layout);
+  // pipelines compiled and a scene set
+  bool ready() const;
+
+  // call after the slot's fence wait, before recording, also swaps in pipelines recompiled by a shader reload
+  void begin_frame(uint32_t frame_slot, const CullView& view);
+  // outside a render pass, before the draws
+  void record_cull(vk::CommandBuffer command_buffer, bool occlusion);
+  // inside the render pass, with a pipeline on the heap's layout bound
+  void record_draws(vk::CommandBuffer command_buffer) const;
+  // after the pass that wrote the depth source, the next frame culls against it
+  void record_depth_pyramid(vk::CommandBuffer command_buffer);
+
+  // slots for draws that bypass culling, e.g. a per-object reference path
+  CullPush push_constants(uint32_t flags) const;
+  CullStats stats() const;
+  void report() const;
+
+private:
+  struct Buffer {
+    vk::Buffer Buffer;
+    MemoryAllocation Memory;
+    uint32_t Slot = BindlessHeap::InvalidSlot;
+  };
+
+  Buffer create_buffer(vk::DeviceSize size, vk::BufferUsageFlags usage, vk::MemoryPropertyFlags properties, bool bindless);
+  void destroy_buffer(Buffer& buffer);
+  void destroy_scene();
+  void destroy_pyramid();
+  void request_pipeline(uint32_t index, vk::ShaderModule module);
+
+  vk::Device device_;
+  MemoryAllocator& allocator_;
+  UploadEngine& uploads_;
+  BindlessHeap& heap_;
+  PipelineService& pipelines_;
+  bool debug_;
+
+  ShaderLibrary& shaders_;
+  std::vector<uint32_t> listeners_;
+  PipelineHandle cull_pipeline_;
+  PipelineHandle compact_pipeline_;
+  PipelineHandle pyramid_pipeline_;
+  // recompiles after a reload, the old pipeline keeps drawing until these are ready
+  std::array<PipelineHandle, 3> reloaded_;
+
+  Buffer instances_;
+  Buffer meshes_;
+  // per-mesh commands with no instances, copied over commands_ every frame
+  Buffer command_template_;
+  Buffer commands_;
+  Buffer visible_;
+  Buffer draws_;
+  // draw count, then visible instance count
+  Buffer counts_;
+  uint32_t instance_count_ = 0;
+  uint32_t mesh_count_ = 0;
+
+  // host visible, one per frame slot
+  std::vector<Buffer> views_;
+  std::vector<Buffer> readbacks_;
+  uint32_t frame_slot_ = 0;
+
+  vk::Sampler pyramid_sampler_;
+  vk::Image pyramid_;
+  MemoryAllocation pyramid_memory_;
+  vk::ImageView pyramid_view_;
+  std::vector<vk::ImageView> pyramid_mip_views_;
+  std::vector<uint32_t> pyramid_mip_slots_;
+  vk::Extent2D pyramid_extent_;
+  uint32_t pyramid_slot_ = BindlessHeap::InvalidSlot;
+  uint32_t depth_slot_ = BindlessHeap::InvalidSlot;
+  bool pyramid_initialized_ = false;
+  // set once a pyramid was built, occlusion is skipped before that
+  bool pyramid_valid_ = false;
+
+  CullStats stats_;
+};
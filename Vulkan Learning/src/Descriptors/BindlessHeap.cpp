@@ -0,0 +1,226 @@
+#include "Descriptors/BindlessHeap.h"
+
+BindlessHeap::BindlessHeap(const vk::Device& device, const vk::PhysicalDeviceVulkan12Properties& limits, BindlessCapacity capacity,
+  uint32_t frames_in_flight, const bool debug)
+  : device_(device), frames_in_flight_(frames_in_flight), debug_(debug) {
+  // the per-stage limits are the tighter ones since every stage sees the whole heap
+  slots_[0].Capacity = (std::min)({ capacity.Textures, limits.maxDescriptorSetUpdateAfterBindSampledImages,
+    limits.maxPerStageDescriptorUpdateAfterBindSampledImages, limits.maxDescriptorSetUpdateAfterBindSamplers,
+    limits.maxPerStageDescriptorUpdateAfterBindSamplers });
+  slots_[1].Capacity = (std::min)({ capacity.StorageBuffers, limits.maxDescriptorSetUpdateAfterBindStorageBuffers,
+    limits.maxPerStageDescriptorUpdateAfterBindStorageBuffers });
+  slots_[2].Capacity = (std::min)({ capacity.StorageImages, limits.maxDescriptorSetUpdateAfterBindStorageImages,
+    limits.maxPerStageDescriptorUpdateAfterBindStorageImages });
+
+  std::array<vk::DescriptorSetLayoutBinding, 3> bindings;
+  std::array<vk::DescriptorBindingFlags, 3> binding_flags;
+  std::array<vk::DescriptorPoolSize, 3> pool_sizes;
+  for (uint32_t i = 0; i < 3; ++i) {
+    vk::DescriptorType type = descriptor_type(static_cast<BindlessType>(i));
+    bindings[i] = vk::DescriptorSetLayoutBinding{ i, type, slots_[i].Capacity, vk::ShaderStageFlagBits::eAll };
+    // slots are written while the set is bound, and unused slots may hold anything
+    binding_flags[i] = vk::DescriptorBindingFlagBits::ePartiallyBound | vk::DescriptorBindingFlagBits::eUpdateAfterBind |
+      vk::DescriptorBindingFlagBits::eUpdateUnusedWhilePending;
+    pool_sizes[i] = vk::DescriptorPoolSize{ type, slots_[i].Capacity };
+  }
+
+  vk::DescriptorSetLayoutBindingFlagsCreateInfo flags_info{};
+  flags_info.bindingCount = static_cast<uint32_t>(binding_flags.size());
+  flags_info.pBindingFlags = binding_flags.data();
+
+  vk::DescriptorSetLayoutCreateInfo layout_info{};
+  layout_info.pNext = &flags_info;
+  layout_info.flags = vk::DescriptorSetLayoutCreateFlagBits::eUpdateAfterBindPool;
+  layout_info.bindingCount = static_cast<uint32_t>(bindings.size());
+  layout_info.pBindings = bindings.data();
+
+  vk::DescriptorPoolCreateInfo pool_info{};
+  pool_info.flags = vk::DescriptorPoolCreateFlagBits::eUpdateAfterBind;
+  pool_info.maxSets = 1;
+  pool_info.poolSizeCount = static_cast<uint32_t>(pool_sizes.size());
+  pool_info.pPoolSizes = pool_sizes.data();
+
+  vk::PushConstantRange push_range{ vk::ShaderStageFlagBits::eAll, 0, PushConstantSize };
+
+  try {
+    set_layout_ = device_.createDescriptorSetLayout(layout_info);
+    pool_ = device_.createDescriptorPool(pool_info);
+
+    vk::DescriptorSetAllocateInfo allocate_info{ pool_, 1, &set_layout_ };
+    set_ = device_.allocateDescriptorSets(allocate_info)[0];
+
+    vk::PipelineLayoutCreateInfo pipeline_layout_info{};
+    pipeline_layout_info.setLayoutCount = 1;
+    pipeline_layout_info.pSetLayouts = &set_layout_;
+    pipeline_layout_info.pushConstantRangeCount = 1;
+    pipeline_layout_info.pPushConstantRanges = &push_range;
+    pipeline_layout_ = device_.createPipelineLayout(pipeline_layout_info);
+  }
+  catch (vk::SystemError e) {
+    throw std::runtime_error("Failed to create the bindless descriptor heap!");
+  }
+
+  if (debug_) {
+    LOG_DEBUG("Bindless heap: " << slots_[0].Capacity << " textures, " << slots_[1].Capacity << " storage buffers, "
+      << slots_[2].Capacity << " storage images");
+  }
+}
+
+BindlessHeap::~BindlessHeap() {
+  device_.destroyPipelineLayout(pipeline_layout_);
+  device_.destroyDescriptorPool(pool_);
+  device_.destroyDescriptorSetLayout(set_layout_);
+}
+
+uint32_t BindlessHeap::add_texture(vk::ImageView view, vk::Sampler sampler, vk::ImageLayout layout) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  uint32_t slot = allocate_slot(BindlessType::Texture);
+  if (slot != InvalidSlot) {
+    writes_.push_back({ BindlessType::Texture, slot, vk::DescriptorImageInfo{ sampler, view, layout }, {} });
+  }
+  return slot;
+}
+
+uint32_t BindlessHeap::add_storage_buffer(vk::Buffer buffer, vk::DeviceSize offset, vk::DeviceSize range) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  uint32_t slot = allocate_slot(BindlessType::StorageBuffer);
+  if (slot != InvalidSlot) {
+    writes_.push_back({ BindlessType::StorageBuffer, slot, {}, vk::DescriptorBufferInfo{ buffer, offset, range } });
+  }
+  return slot;
+}
+
+uint32_t BindlessHeap::add_storage_image(vk::ImageView view, vk::ImageLayout layout) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  uint32_t slot = allocate_slot(BindlessType::StorageImage);
+  if (slot != InvalidSlot) {
+    writes_.push_back({ BindlessType::StorageImage, slot, vk::DescriptorImageInfo{ nullptr, view, layout }, {} });
+  }
+  return slot;
+}
+
+void BindlessHeap::release(BindlessType type, uint32_t slot) {
+  if (slot == InvalidSlot) {
+    return;
+  }
+  std::lock_guard<std::mutex> lock(mutex_);
+  // the frame being recorded may still reference the slot, as may the ones in flight before it
+  releases_.push_back({ type, slot, frame_number_ + frames_in_flight_ });
+}
+
+void BindlessHeap::begin_frame(uint64_t frame_number) {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    frame_number_ = frame_number;
+    while (!releases_.empty() && releases_.front().RetireFrame <= frame_number_) {
+      SlotPool& pool = slots_[static_cast<uint32_t>(releases_.front().Type)];
+      pool.Free.push_back(releases_.front().Slot);
+      --pool.Live;
+      releases_.pop_front();
+    }
+  }
+  flush();
+}
+
+void BindlessHeap::flush() {
+  std::lock_guard<std::mutex> lock(mutex_);
+  if (writes_.empty()) {
+    return;
+  }
+
+  std::vector<vk::WriteDescriptorSet> writes;
+  writes.reserve(writes_.size());
+  for (const PendingWrite& pending : writes_) {
+    vk::WriteDescriptorSet write{};
+    write.dstSet = set_;
+    write.dstBinding = static_cast<uint32_t>(pending.Type);
+    write.dstArrayElement = pending.Slot;
+    write.descriptorCount = 1;
+    write.descriptorType = descriptor_type(pending.Type);
+    if (pending.Type == BindlessType::StorageBuffer) {
+      write.pBufferInfo = &pending.Buffer;
+    }
+    else {
+      write.pImageInfo = &pending.Image;
+    }
+    writes.push_back(write);
+  }
+
+  device_.updateDescriptorSets(writes, nullptr);
+  total_writes_ += writes.size();
+  writes_.clear();
+}
+
+void BindlessHeap::bind(vk::CommandBuffer command_buffer, vk::PipelineBindPoint bind_point) const {
+  command_buffer.bindDescriptorSets(bind_point, pipeline_layout_, 0, set_, nullptr);
+}
+
+void BindlessHeap::push(vk::CommandBuffer command_buffer, const void* data, uint32_t size) const {
+  command_buffer.pushConstants(pipeline_layout_, vk::ShaderStageFlagBits::eAll, 0, (std::min)(size, PushConstantSize), data);
+}
+
+vk::DescriptorSetLayout BindlessHeap::set_layout() const {
+  return set_layout_;
+}
+
+vk::PipelineLayout BindlessHeap::pipeline_layout() const {
+  return pipeline_layout_;
+}
+
+uint32_t BindlessHeap::capacity(BindlessType type) const {
+  return slots_[static_cast<uint32_t>(type)].Capacity;
+}
+
+uint32_t BindlessHeap::allocate_slot(BindlessType type) {
+  SlotPool& pool = slots_[static_cast<uint32_t>(type)];
+
+  uint32_t slot = InvalidSlot;
+  if (!pool.Free.empty()) {
+    slot = pool.Free.back();
+    pool.Free.pop_back();
+  }
+  else if (pool.Next < pool.Capacity) {
+    slot = pool.Next++;
+  }
+  else {
+    LOG_ERROR("Bindless heap is out of " << vk::to_string(descriptor_type(type)) << " slots");
+    return InvalidSlot;
+  }
+
+  ++pool.Live;
+  return slot;
+}
+
+vk::DescriptorType BindlessHeap::descriptor_type(BindlessType type) {
+  switch (type) {
+  case BindlessType::Texture:
+    return vk::DescriptorType::eCombinedImageSampler;
+  case BindlessType::StorageBuffer:
+    return vk::DescriptorType::eStorageBuffer;
+  case BindlessType::StorageImage:
+  default:
+    return vk::DescriptorType::eStorageImage;
+  }
+}
+
+BindlessStats BindlessHeap::stats() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+
+  BindlessStats stats;
+  for (uint32_t i = 0; i < 3; ++i) {
+    stats.Live[i] = slots_[i].Live;
+    stats.HighWater[i] = slots_[i].Next;
+  }
+  stats.PendingRelease = static_cast<uint32_t>(releases_.size());
+  stats.Writes = total_writes_;
+  return stats;
+}
+
+void BindlessHeap::report() const {
+  BindlessStats stats = this->stats();
+
+  std::cout << "Bindless heap: textures " << stats.Live[0] << "/" << slots_[0].Capacity << " (high water " << stats.HighWater[0]
+    << "), storage buffers " << stats.Live[1] << "/" << slots_[1].Capacity << " (high water " << stats.HighWater[1]
+    << "), storage images " << stats.Live[2] << "/" << slots_[2].Capacity << " (high water " << stats.HighWater[2]
+    << "), " << stats.PendingRelease << " pending release, " << stats.Writes << " descriptor writes" << std::endl;
+}
@@ -0,0 +1,104 @@
+#pragma once
+#include "Headers.h"
+
+#include <deque>
+#include <mutex>
+
+// descriptor array bindings of the global set, shaders declare the same layout
+enum class BindlessType : uint32_t {
+  Texture = 0,        // combined image samplers
+  StorageBuffer = 1,
+  StorageImage = 2,
+  Count = 3
+};
+
+struct BindlessCapacity {
+  uint32_t Textures = 16384;
+  uint32_t StorageBuffers = 16384;
+  uint32_t StorageImages = 4096;
+};
+
+struct BindlessStats {
+  uint32_t Live[3] = {};
+  uint32_t HighWater[3] = {};
+  uint32_t PendingRelease = 0;
+  uint64_t Writes = 0;
+};
+
+// One global update-after-bind descriptor set holding every texture, storage
+// buffer and storage image. Resources get a slot index once and draws pick
+// them by index through push constants, so nothing is allocated or bound per
+// draw. Released slots stay untouched until every frame that could still
+// read them has retired, then go back on the free list.
+class BindlessHeap {
+public:
+  static constexpr uint32_t InvalidSlot = UINT32_MAX;
+  // shared push constant block, draws put their resource indices here
+  static constexpr uint32_t PushConstantSize = 128;
+
+  // capacity is clamped to the device's update-after-bind limits
+  BindlessHeap(const vk::Device& device, const vk::PhysicalDeviceVulkan12Properties& limits, BindlessCapacity capacity,
+    uint32_t frames_in_flight, const bool debug);
+  ~BindlessHeap();
+
+  uint32_t add_texture(vk::ImageView view, vk::Sampler sampler, vk::ImageLayout layout = vk::ImageLayout::eShaderReadOnlyOptimal);
+  uint32_t add_storage_buffer(vk::Buffer buffer, vk::DeviceSize offset = 0, vk::DeviceSize range = VK_WHOLE_SIZE);
+  uint32_t add_storage_image(vk::ImageView view, vk::ImageLayout layout = vk::ImageLayout::eGeneral);
+  // the slot is recycled once the frames in flight at this point have retired
+  void release(BindlessType type, uint32_t slot);
+
+  // call after the frame's fence wait, recycles released slots and writes queued descriptors
+  void begin_frame(uint64_t frame_number);
+  // writes descriptors added since the last flush, begin_frame() calls it too
+  void flush();
+
+  void bind(vk::CommandBuffer command_buffer, vk::PipelineBindPoint bind_point) const;
+  void push(vk::CommandBuffer command_buffer, const void* data, uint32_t size) const;
+
+  vk::DescriptorSetLayout set_layout() const;
+  // set 0 is the heap, push constants cover every stage
+  vk::PipelineLayout pipeline_layout() const;
+  uint32_t capacity(BindlessType type) const;
+
+  BindlessStats stats() const;
+  void report() const;
+
+private:
+  struct SlotPool {
+    uint32_t Capacity = 0;
+    uint32_t Next = 0;
+    std::vector<uint32_t> Free;
+    uint32_t Live = 0;
+  };
+
+  struct PendingRelease {
+    BindlessType Type;
+    uint32_t Slot;
+    uint64_t RetireFrame;
+  };
+
+  struct PendingWrite {
+    BindlessType Type;
+    uint32_t Slot;
+    vk::DescriptorImageInfo Image;
+    vk::DescriptorBufferInfo Buffer;
+  };
+
+  uint32_t allocate_slot(BindlessType type);
+  static vk::DescriptorType descriptor_type(BindlessType type);
+
+  vk::Device device_;
+  vk::DescriptorPool pool_;
+  vk::DescriptorSetLayout set_layout_;
+  vk::PipelineLayout pipeline_layout_;
+  vk::DescriptorSet set_;
+  uint32_t frames_in_flight_;
+  bool debug_;
+
+  SlotPool slots_[static_cast<uint32_t>(BindlessType::Count)];
+  std::deque<PendingRelease> releases_;
+  std::vector<PendingWrite> writes_;
+  uint64_t frame_number_ = 0;
+  uint64_t total_writes_ = 0;
+  mutable std::mutex mutex_;
+};
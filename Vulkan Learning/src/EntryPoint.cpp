@@ -1,11 +1,67 @@
 #include "Application.h"
+#include "Assets/AssetPacker.h"
+#include "Config.h"
+#include "Memory/AllocatorBenchmark.h"
+#include "RenderGraph/RenderGraphBenchmark.h"
+#include "Scene/SceneBenchmark.h"
+#include "Shaders/ShaderCompiler.h"
 
-int main(int argc, int** argv) {
+int main(int argc, char** argv) {
   
-  Application* app = new Application();
-  app->run();
+  AppConfig config = parse_config(argc, argv);
+  Log::set_level(config.LogLevel);
+  if (!config.LogJsonPath.empty()) {
+    Log::set_json_path(config.LogJsonPath);
+  }
+
+  if (config.BenchAllocator) {
+    run_allocator_benchmark();
+    Log::shutdown();
+    return 0;
+  }
+  if (config.CompileShaders) {
+    uint32_t failed = compile_shader_directory(config.ShaderDir, config.ShaderCacheDir);
+    Log::shutdown();
+    return failed == 0 ? 0 : 1;
+  }
+  if (config.PackAssets) {
+    uint32_t failed = pack_asset_directory(config.AssetDir, config.AssetPackPath);
+    Log::shutdown();
+    return failed == 0 ? 0 : 1;
+  }
+  if (config.BenchRenderGraph) {
+    run_render_graph_benchmark();
+    Log::shutdown();
+    return 0;
+  }
+  if (config.BenchScene) {
+    run_scene_benchmark(config.SceneObjects, config.WorkerThreads);
+    Log::shutdown();
+    return 0;
+  }
+
+  Application* app = new Application(config);
+  if (config.BenchRecording) {
+    app->run_recording_benchmark();
+  }
+  else if (config.BenchCulling) {
+    app->run_culling_benchmark();
+  }
+  else if (config.BenchAsyncCompute) {
+    app->run_async_compute_benchmark();
+  }
+  else if (config.BenchAssets) {
+    app->run_asset_benchmark();
+  }
+  else if (config.BenchDevices) {
+    app->run_split_device_benchmark();
+  }
+  else {
+    app->run();
+  }
 
   delete app;
+  Log::shutdown();
 
   return 0;
-}
\ No newline at end of file
+}
@@ -0,0 +1,97 @@
+#include "FrameStats.h"
+
+#include <cmath>
+
+FrameStats::FrameStats(size_t window) {
+  samples_.reserve(window);
+}
+
+void FrameStats::begin_frame() {
+  frame_start_ = Clock::now();
+  current_ = FrameTiming{};
+
+  if (has_last_frame_) {
+    current_.IntervalMs = std::chrono::duration<double, std::milli>(frame_start_ - last_frame_start_).count();
+  }
+  last_frame_start_ = frame_start_;
+  has_last_frame_ = true;
+}
+
+void FrameStats::begin_gpu_wait() {
+  wait_start_ = Clock::now();
+}
+
+void FrameStats::end_gpu_wait() {
+  current_.GpuWaitMs += std::chrono::duration<double, std::milli>(Clock::now() - wait_start_).count();
+}
+
+void FrameStats::end_frame() {
+  double total_ms = std::chrono::duration<double, std::milli>(Clock::now() - frame_start_).count();
+  current_.CpuMs = total_ms - current_.GpuWaitMs;
+
+  if (samples_.size() < samples_.capacity()) {
+    samples_.push_back(current_);
+  }
+  else {
+    samples_[next_sample_] = current_;
+  }
+  next_sample_ = (next_sample_ + 1) % samples_.capacity();
+  ++total_frames_;
+}
+
+const FrameTiming& FrameStats::last() const {
+  return current_;
+}
+
+FrameStatsSummary FrameStats::summarize() const {
+  FrameStatsSummary summary;
+  summary.Frames = total_frames_;
+  if (samples_.empty()) {
+    return summary;
+  }
+
+  // the very first frame has no interval
+  size_t interval_count = 0;
+  summary.MinIntervalMs = 1e30;
+  for (const FrameTiming& sample : samples_) {
+    summary.AvgCpuMs += sample.CpuMs;
+    summary.AvgGpuWaitMs += sample.GpuWaitMs;
+    if (sample.IntervalMs > 0.0) {
+      summary.AvgIntervalMs += sample.IntervalMs;
+      summary.MinIntervalMs = (std::min)(summary.MinIntervalMs, sample.IntervalMs);
+      summary.MaxIntervalMs = (std::max)(summary.MaxIntervalMs, sample.IntervalMs);
+      ++interval_count;
+    }
+  }
+
+  summary.AvgCpuMs /= samples_.size();
+  summary.AvgGpuWaitMs /= samples_.size();
+  if (interval_count == 0) {
+    summary.MinIntervalMs = 0.0;
+    return summary;
+  }
+  summary.AvgIntervalMs /= interval_count;
+  summary.Fps = 1000.0 / summary.AvgIntervalMs;
+
+  double variance = 0.0;
+  for (const FrameTiming& sample : samples_) {
+    if (sample.IntervalMs > 0.0) {
+      double delta = sample.IntervalMs - summary.AvgIntervalMs;
+      variance += delta * delta;
+    }
+  }
+  summary.IntervalJitterMs = std::sqrt(variance / interval_count);
+
+  return summary;
+}
+
+void FrameStats::report() const {
+  FrameStatsSummary summary = summarize();
+
+  std::cout << "Frames: " << summary.Frames
+    << " | fps: " << summary.Fps
+    << " | cpu: " << summary.AvgCpuMs << "ms"
+    << " | gpu wait: " << summary.AvgGpuWaitMs << "ms"
+    << " | interval: " << summary.AvgIntervalMs << "ms (min " << summary.MinIntervalMs
+    << ", max " << summary.MaxIntervalMs << ", jitter " << summary.IntervalJitterMs << ")" << std::endl;
+}
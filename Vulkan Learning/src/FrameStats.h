@@ -0,0 +1,54 @@
+#pragma once
+#include "Headers.h"
+
+#include <chrono>
+
+struct FrameTiming {
+  // time the CPU spent on the frame excluding the fence wait
+  double CpuMs = 0.0;
+  // time blocked waiting for the GPU to retire the frame slot
+  double GpuWaitMs = 0.0;
+  // time between the starts of consecutive frames
+  double IntervalMs = 0.0;
+};
+
+struct FrameStatsSummary {
+  uint64_t Frames = 0;
+  double AvgCpuMs = 0.0;
+  double AvgGpuWaitMs = 0.0;
+  double AvgIntervalMs = 0.0;
+  double MinIntervalMs = 0.0;
+  double MaxIntervalMs = 0.0;
+  // standard deviation of the frame interval, the frame pacing jitter
+  double IntervalJitterMs = 0.0;
+  double Fps = 0.0;
+};
+
+// Rolling window of per-frame timings. When frames overlap properly the
+// frame interval approaches max(cpu, gpu) instead of cpu + gpu.
+class FrameStats {
+public:
+  FrameStats(size_t window = 240);
+
+  void begin_frame();
+  void begin_gpu_wait();
+  void end_gpu_wait();
+  void end_frame();
+
+  const FrameTiming& last() const;
+  FrameStatsSummary summarize() const;
+  void report() const;
+
+private:
+  using Clock = std::chrono::steady_clock;
+
+  std::vector<FrameTiming> samples_;
+  size_t next_sample_ = 0;
+  uint64_t total_frames_ = 0;
+
+  FrameTiming current_;
+  Clock::time_point frame_start_;
+  Clock::time_point wait_start_;
+  Clock::time_point last_frame_start_;
+  bool has_last_frame_ = false;
+};
@@ -0,0 +1,118 @@
+#include "GlfwWindow.h"
+
+namespace {
+  bool glfw_initialized = false;
+}
+
+GlfwWindow::GlfwWindow(bool debug) {
+  debug_ = debug;
+  init_glfw(debug_);
+
+  create_glfw_window();
+  
+}
+
+void GlfwWindow::init_glfw(bool debug) {
+  if (glfw_initialized) {
+    return;
+  }
+
+  if (debug) {
+    LOG_DEBUG("Initializing GLFW...");
+    if (!glfwInit())
+    {
+      LOG_ERROR("GLFW Failed to initialize!");
+    }
+  } else {
+    glfwInit();
+  }
+
+  glfwSetErrorCallback(error_callback);
+  glfw_initialized = true;
+}
+
+GlfwWindow::~GlfwWindow() {
+  if (debug_) {
+    LOG_DEBUG("Deleting GLFW Window...");
+  }
+  glfwDestroyWindow(glfw_window_);
+  glfwTerminate();
+  glfw_initialized = false;
+}
+
+void GlfwWindow::error_callback(int error_code, const char* description) {
+  LOG_AT(Log::Level::Error, "glfw", "error code " << error_code << ": " << description);
+}
+
+void GlfwWindow::framebuffer_size_callback(GLFWwindow* window, int width, int height) {
+  GlfwWindow* self = static_cast<GlfwWindow*>(glfwGetWindowUserPointer(window));
+  self->resized_ = true;
+}
+
+void GlfwWindow::on_update() {
+  glfwPollEvents();
+}
+
+void GlfwWindow::wait_events() {
+  glfwWaitEvents();
+}
+
+void GlfwWindow::wait_events_timeout(double timeout_seconds) {
+  glfwWaitEventsTimeout(timeout_seconds);
+}
+
+bool GlfwWindow::should_close() {
+  return glfwWindowShouldClose(glfw_window_);
+}
+
+bool GlfwWindow::is_minimized() {
+  int width, height;
+  glfwGetFramebufferSize(glfw_window_, &width, &height);
+  return width == 0 || height == 0;
+}
+
+bool GlfwWindow::consume_resize() {
+  bool resized = resized_;
+  resized_ = false;
+  return resized;
+}
+
+void GlfwWindow::create_glfw_window() {
+  if (debug_) {
+    LOG_DEBUG("Initializing GLFW Window...");
+  }
+
+  glfwWindowHint(GLFW_CLIENT_API, GLFW_NO_API);
+  glfwWindowHint(GLFW_RESIZABLE, GLFW_TRUE);
+  glfw_window_ = glfwCreateWindow(640, 480, "Vulkan Learning", nullptr, nullptr);
+  glfwSetWindowUserPointer(glfw_window_, this);
+  glfwSetFramebufferSizeCallback(glfw_window_, framebuffer_size_callback);
+
+  if (debug_) {
+    if (!glfw_window_)
+    {
+      LOG_ERROR("GLFW Window failed to initialize!");
+    }
+  }
+}
+
+void GlfwWindow::create_surface(const vk::Instance& instance, vk::SurfaceKHR& surface, const bool debug) {
+  if (debug) {
+    LOG_DEBUG("Creating Window Surface...");
+  }
+
+  VkSurfaceKHR raw_surface = VK_NULL_HANDLE;
+  VkResult result = glfwCreateWindowSurface(static_cast<VkInstance>(instance), glfw_window_, nullptr, &raw_surface);
+  // a null surface would be taken for headless, so device selection would drop the present requirements
+  if (result != VK_SUCCESS) {
+    throw std::runtime_error("Failed to create window surface!");
+  }
+  surface = raw_surface;
+  if (debug) {
+    LOG_DEBUG("Window Surface Created!");
+  }
+}
+
+GLFWwindow* GlfwWindow::get_glfw_window() {
+  return glfw_window_;
+}
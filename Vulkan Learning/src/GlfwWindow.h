@@ -0,0 +1,33 @@
+#pragma once
+#include "Window.h"
+
+// GLFW handles events and sizing the same way on every platform, backends
+// only differ in how the Vulkan surface is created.
+class GlfwWindow : public Window {
+public:
+  GlfwWindow(bool debug);
+  ~GlfwWindow() override;
+
+  // safe to call again, the window constructor calls it too
+  static void init_glfw(bool debug);
+  static void error_callback(int error, const char* description);
+  static void framebuffer_size_callback(GLFWwindow* window, int width, int height);
+
+  void on_update() override;
+  void wait_events() override;
+  void wait_events_timeout(double timeout_seconds) override;
+  bool should_close() override;
+  bool is_minimized() override;
+  bool consume_resize() override;
+  // portable path through glfwCreateWindowSurface
+  void create_surface(const vk::Instance& instance, vk::SurfaceKHR& surface, const bool debug) override;
+
+  GLFWwindow* get_glfw_window() override;
+
+protected:
+  void create_glfw_window();
+
+  GLFWwindow* glfw_window_ = nullptr;
+  bool debug_;
+  bool resized_ = false;
+};
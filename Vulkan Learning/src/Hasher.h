@@ -0,0 +1,46 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <type_traits>
+
+// FNV-1a over the bytes of every value, fed one value at a time so padding
+// never gets hashed. Pipeline descs and shader sources both key their caches
+// with it, so the two can never disagree on how a value is hashed.
+class Hasher {
+public:
+  template <typename T>
+  void add(const T& value) {
+    static_assert(std::is_trivially_copyable<T>::value, "hash fields individually");
+    static_assert(!std::is_pointer<T>::value, "hash what the pointer refers to");
+    const uint8_t* bytes = reinterpret_cast<const uint8_t*>(&value);
+    for (size_t i = 0; i < sizeof(T); ++i) {
+      hash_ = (hash_ ^ bytes[i]) * 1099511628211ull;
+    }
+  }
+
+  // length first, so "ab" + "c" and "a" + "bc" differ
+  void add(const std::string& text) {
+    add(static_cast<uint64_t>(text.size()));
+    for (char c : text) {
+      add(c);
+    }
+  }
+
+  void add(const char* text) {
+    add(std::string(text));
+  }
+
+  // the raw handle value, only stable for the lifetime of the object
+  template <typename Handle>
+  void add_handle(Handle handle) {
+    add(reinterpret_cast<uint64_t>(static_cast<typename Handle::CType>(handle)));
+  }
+
+  uint64_t value() const {
+    return hash_;
+  }
+
+private:
+  uint64_t hash_ = 14695981039346656037ull;
+};
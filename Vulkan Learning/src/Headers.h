@@ -7,3 +7,5 @@
 
 #include <glfw3.h>
 #include <vulkan/vulkan.hpp>
+
+#include "Logging/Log.h"
@@ -0,0 +1,101 @@
+#include "JobSystem.h"
+
+JobSystem::JobSystem(uint32_t worker_count) {
+  if (worker_count == 0) {
+    worker_count = (std::max)(1u, std::thread::hardware_concurrency());
+  }
+
+  workers_.reserve(worker_count);
+  for (uint32_t i = 0; i < worker_count; ++i) {
+    workers_.emplace_back(&JobSystem::worker_loop, this, i);
+  }
+}
+
+JobSystem::~JobSystem() {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    stopping_ = true;
+  }
+  jobs_available_.notify_all();
+
+  for (std::thread& worker : workers_) {
+    worker.join();
+  }
+}
+
+uint32_t JobSystem::worker_count() const {
+  return static_cast<uint32_t>(workers_.size());
+}
+
+void JobSystem::submit(Job job) {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    jobs_.push_back(std::move(job));
+  }
+  jobs_available_.notify_one();
+}
+
+void JobSystem::parallel_for(uint32_t count, uint32_t chunks, const RangeJob& job) {
+  chunks = (std::max)(1u, (std::min)(chunks, count));
+  if (count == 0) {
+    return;
+  }
+
+  std::mutex done_mutex;
+  std::condition_variable done;
+  uint32_t remaining = chunks;
+  // the first chunk to throw, the rest still run so remaining reaches zero
+  std::exception_ptr error;
+
+  uint32_t per_chunk = count / chunks;
+  uint32_t leftover = count % chunks;
+  uint32_t begin = 0;
+
+  for (uint32_t chunk = 0; chunk < chunks; ++chunk) {
+    // the first `leftover` chunks take one extra item
+    uint32_t end = begin + per_chunk + (chunk < leftover ? 1 : 0);
+
+    submit([&, chunk, begin, end](uint32_t worker) {
+      std::exception_ptr chunk_error;
+      try {
+        job(chunk, begin, end, worker);
+      }
+      catch (...) {
+        chunk_error = std::current_exception();
+      }
+
+      std::lock_guard<std::mutex> lock(done_mutex);
+      if (chunk_error && !error) {
+        error = chunk_error;
+      }
+      if (--remaining == 0) {
+        done.notify_one();
+      }
+    });
+
+    begin = end;
+  }
+
+  std::unique_lock<std::mutex> lock(done_mutex);
+  done.wait(lock, [&] { return remaining == 0; });
+  if (error) {
+    std::rethrow_exception(error);
+  }
+}
+
+void JobSystem::worker_loop(uint32_t worker) {
+  while (true) {
+    Job job;
+    {
+      std::unique_lock<std::mutex> lock(mutex_);
+      jobs_available_.wait(lock, [this] { return stopping_ || !jobs_.empty(); });
+      if (stopping_ && jobs_.empty()) {
+        return;
+      }
+      job = std::move(jobs_.front());
+      jobs_.pop_front();
+    }
+
+    job(worker);
+  }
+}
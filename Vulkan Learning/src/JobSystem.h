@@ -0,0 +1,39 @@
+#pragma once
+#include "Headers.h"
+
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <thread>
+
+// Fixed pool of worker threads. Every worker has a stable index so callers
+// can keep per-thread resources (command pools etc.) without locking.
+class JobSystem {
+public:
+  using Job = std::function<void(uint32_t worker)>;
+  using RangeJob = std::function<void(uint32_t chunk, uint32_t begin, uint32_t end, uint32_t worker)>;
+
+  // 0 uses one worker per hardware thread
+  JobSystem(uint32_t worker_count = 0);
+  ~JobSystem();
+
+  uint32_t worker_count() const;
+
+  void submit(Job job);
+
+  // splits [0, count) into `chunks` contiguous ranges and blocks until all of
+  // them ran, must not be called from a worker thread. If chunks throw, the
+  // first exception is rethrown here once every chunk has finished
+  void parallel_for(uint32_t count, uint32_t chunks, const RangeJob& job);
+
+private:
+  void worker_loop(uint32_t worker);
+
+  std::vector<std::thread> workers_;
+  std::deque<Job> jobs_;
+  std::mutex mutex_;
+  std::condition_variable jobs_available_;
+  bool stopping_ = false;
+};
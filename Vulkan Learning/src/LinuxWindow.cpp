@@ -0,0 +1,11 @@
+#include "LinuxWindow.h"
+
+LinuxWindow::LinuxWindow(bool debug)
+  : GlfwWindow(debug) {
+  if (debug_) {
+#if defined(GLFW_PLATFORM_WAYLAND)
+    // glfwGetPlatform is GLFW 3.4+
+    LOG_DEBUG("GLFW platform: " << (glfwGetPlatform() == GLFW_PLATFORM_WAYLAND ? "Wayland" : "X11"));
+#endif
+  }
+}
@@ -0,0 +1,10 @@
+#pragma once
+#include "GlfwWindow.h"
+
+// X11 or Wayland, whichever GLFW was built for and found at runtime. The
+// surface comes from glfwCreateWindowSurface, which picks VK_KHR_xcb_surface,
+// VK_KHR_xlib_surface or VK_KHR_wayland_surface to match.
+class LinuxWindow : public GlfwWindow {
+public:
+  LinuxWindow(bool debug);
+};
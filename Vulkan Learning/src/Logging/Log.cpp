@@ -0,0 +1,359 @@
+#include "Logging/Log.h"
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdio>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <sstream>
+#include <thread>
+#include <vector>
+
+namespace Log {
+  namespace {
+    using Clock = std::chrono::steady_clock;
+
+    // single producer (the owning thread), single consumer (whoever holds the drain lock)
+    class ThreadRing {
+    public:
+      static constexpr size_t Capacity = 1024;
+
+      explicit ThreadRing(uint32_t index) : Index(index) {}
+
+      bool push(Record& record) {
+        size_t tail = tail_.load(std::memory_order_relaxed);
+        if (tail - head_.load(std::memory_order_acquire) == Capacity) {
+          return false;
+        }
+        slots_[tail % Capacity] = std::move(record);
+        tail_.store(tail + 1, std::memory_order_release);
+        return true;
+      }
+
+      bool pop(Record& record) {
+        size_t head = head_.load(std::memory_order_relaxed);
+        if (head == tail_.load(std::memory_order_acquire)) {
+          return false;
+        }
+        record = std::move(slots_[head % Capacity]);
+        head_.store(head + 1, std::memory_order_release);
+        return true;
+      }
+
+      bool empty() const {
+        return head_.load(std::memory_order_acquire) == tail_.load(std::memory_order_acquire);
+      }
+
+      const uint32_t Index;
+      // cleared when the owning thread exits, the ring is released once drained
+      std::atomic<bool> Alive{ true };
+
+    private:
+      std::array<Record, Capacity> slots_;
+      std::atomic<size_t> head_{ 0 };
+      std::atomic<size_t> tail_{ 0 };
+    };
+
+    const char* level_name(Level level) {
+      switch (level) {
+      case Level::Trace: return "TRACE";
+      case Level::Debug: return "DEBUG";
+      case Level::Info: return "INFO ";
+      case Level::Warn: return "WARN ";
+      case Level::Error: return "ERROR";
+      }
+      return "?????";
+    }
+
+    const char* json_level_name(Level level) {
+      switch (level) {
+      case Level::Trace: return "trace";
+      case Level::Debug: return "debug";
+      case Level::Info: return "info";
+      case Level::Warn: return "warn";
+      case Level::Error: return "error";
+      }
+      return "unknown";
+    }
+
+    std::string json_escaped(const std::string& text) {
+      std::string out;
+      out.reserve(text.size());
+      for (char c : text) {
+        switch (c) {
+        case '"': out += "\\\""; break;
+        case '\\': out += "\\\\"; break;
+        case '\n': out += "\\n"; break;
+        case '\r': out += "\\r"; break;
+        case '\t': out += "\\t"; break;
+        default:
+          if (static_cast<unsigned char>(c) < 0x20) {
+            char escape[8];
+            std::snprintf(escape, sizeof(escape), "\\u%04x", c);
+            out += escape;
+          }
+          else {
+            out += c;
+          }
+        }
+      }
+      return out;
+    }
+
+    class Writer {
+    public:
+      Writer() : origin_(Clock::now()) {}
+      ~Writer() {
+        stop();
+      }
+
+      uint64_t now_ns() const {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - origin_).count();
+      }
+
+      std::shared_ptr<ThreadRing> register_thread() {
+        std::lock_guard<std::mutex> lock(registry_mutex_);
+        auto ring = std::make_shared<ThreadRing>(next_thread_++);
+        rings_.push_back(ring);
+        if (!started_) {
+          started_ = true;
+          running_ = true;
+          thread_ = std::thread(&Writer::loop, this);
+        }
+        return ring;
+      }
+
+      void submitted(Level level) {
+        // errors are written promptly in case the process is about to die
+        if (level == Level::Error) {
+          wake_.notify_one();
+        }
+      }
+
+      bool running() const {
+        return running_;
+      }
+
+      void drain() {
+        std::lock_guard<std::mutex> drain_lock(drain_mutex_);
+
+        std::vector<std::shared_ptr<ThreadRing>> rings;
+        {
+          std::lock_guard<std::mutex> lock(registry_mutex_);
+          rings = rings_;
+        }
+
+        batch_.clear();
+        Record record;
+        for (const std::shared_ptr<ThreadRing>& ring : rings) {
+          while (ring->pop(record)) {
+            batch_.push_back(std::move(record));
+          }
+        }
+        write_batch();
+
+        std::lock_guard<std::mutex> lock(registry_mutex_);
+        rings_.erase(std::remove_if(rings_.begin(), rings_.end(),
+          [](const std::shared_ptr<ThreadRing>& ring) { return !ring->Alive && ring->empty(); }), rings_.end());
+      }
+
+      // used once the writer is gone, or when a thread's ring is unavailable
+      void write_direct(Record& record) {
+        std::lock_guard<std::mutex> drain_lock(drain_mutex_);
+        batch_.clear();
+        batch_.push_back(std::move(record));
+        write_batch();
+      }
+
+      void set_json_path(const std::string& path) {
+        std::lock_guard<std::mutex> drain_lock(drain_mutex_);
+        json_.close();
+        if (!path.empty()) {
+          json_.open(path, std::ios::out | std::ios::trunc);
+        }
+      }
+
+      void stop() {
+        {
+          std::lock_guard<std::mutex> lock(wake_mutex_);
+          if (!running_) {
+            return;
+          }
+          running_ = false;
+        }
+        wake_.notify_one();
+        if (thread_.joinable()) {
+          thread_.join();
+        }
+        drain();
+        json_.close();
+      }
+
+      std::atomic<uint64_t> Dropped{ 0 };
+
+    private:
+      void loop() {
+        std::unique_lock<std::mutex> lock(wake_mutex_);
+        while (running_) {
+          wake_.wait_for(lock, std::chrono::milliseconds(2));
+          lock.unlock();
+          drain();
+          lock.lock();
+        }
+      }
+
+      void write_batch() {
+        if (batch_.empty()) {
+          return;
+        }
+        // rings are drained one after another, interleave them back into time order
+        std::stable_sort(batch_.begin(), batch_.end(), [](const Record& a, const Record& b) { return a.TimeNs < b.TimeNs; });
+
+        text_.str("");
+        text_ << std::fixed << std::setprecision(3);
+        for (const Record& record : batch_) {
+          text_ << "[" << std::setw(10) << record.TimeNs / 1e6 << "ms] " << level_name(record.Severity)
+            << " [t" << record.Thread << "] ";
+          if (record.VkSeverity != 0) {
+            text_ << "[" << record.Source << (record.VkTypes & VK_TYPE_VALIDATION ? " validation" : "")
+              << (record.VkTypes & VK_TYPE_PERFORMANCE ? " performance" : "") << "] ";
+            if (!record.MessageIdName.empty()) {
+              text_ << record.MessageIdName << " ";
+            }
+          }
+          else if (std::string(record.Source) != "app") {
+            text_ << "[" << record.Source << "] ";
+          }
+          text_ << record.Message << '\n';
+
+          if (json_.is_open()) {
+            json_ << "{\"time_ms\":" << std::fixed << std::setprecision(3) << record.TimeNs / 1e6
+              << ",\"level\":\"" << json_level_name(record.Severity) << "\",\"thread\":" << record.Thread
+              << ",\"source\":\"" << json_escaped(record.Source) << "\"";
+            if (record.VkSeverity != 0) {
+              json_ << ",\"vk_severity\":" << record.VkSeverity << ",\"vk_types\":" << record.VkTypes
+                << ",\"message_id_name\":\"" << json_escaped(record.MessageIdName)
+                << "\",\"message_id_number\":" << record.MessageIdNumber;
+            }
+            json_ << ",\"message\":\"" << json_escaped(record.Message) << "\"}\n";
+          }
+        }
+
+        const std::string text = text_.str();
+        std::cout.write(text.data(), text.size());
+        std::cout.flush();
+        if (json_.is_open()) {
+          json_.flush();
+        }
+      }
+
+      // VkDebugUtilsMessageTypeFlagBitsEXT, repeated here so the logger doesn't pull in Vulkan
+      static constexpr uint32_t VK_TYPE_VALIDATION = 0x2;
+      static constexpr uint32_t VK_TYPE_PERFORMANCE = 0x4;
+
+      Clock::time_point origin_;
+
+      std::mutex registry_mutex_;
+      std::vector<std::shared_ptr<ThreadRing>> rings_;
+      uint32_t next_thread_ = 0;
+      bool started_ = false;
+
+      std::mutex wake_mutex_;
+      std::condition_variable wake_;
+      std::atomic<bool> running_{ false };
+      std::thread thread_;
+
+      // held by whoever consumes the rings
+      std::mutex drain_mutex_;
+      std::vector<Record> batch_;
+      std::ostringstream text_;
+      std::ofstream json_;
+    };
+
+    Writer& writer() {
+      static Writer instance;
+      return instance;
+    }
+
+    std::atomic<int> runtime_level{ 0 };
+
+    struct ThreadHandle {
+      std::shared_ptr<ThreadRing> Ring;
+      ~ThreadHandle() {
+        if (Ring) {
+          Ring->Alive = false;
+        }
+      }
+    };
+
+    ThreadRing& local_ring() {
+      thread_local ThreadHandle handle;
+      if (!handle.Ring) {
+        handle.Ring = writer().register_thread();
+      }
+      return *handle.Ring;
+    }
+  }
+
+  void set_level(Level level) {
+    runtime_level = static_cast<int>(level);
+  }
+
+  bool enabled(Level level) {
+    return static_cast<int>(level) >= runtime_level.load(std::memory_order_relaxed);
+  }
+
+  void set_json_path(const std::string& path) {
+    writer().set_json_path(path);
+  }
+
+  void write(Record record) {
+    Writer& log_writer = writer();
+    record.TimeNs = log_writer.now_ns();
+
+    ThreadRing& ring = local_ring();
+    record.Thread = ring.Index;
+    if (!log_writer.running()) {
+      log_writer.write_direct(record);
+      return;
+    }
+
+    Level level = record.Severity;
+    while (!ring.push(record)) {
+      // below warnings a full ring drops, anything more severe waits for the writer
+      if (level < Level::Warn) {
+        ++log_writer.Dropped;
+        return;
+      }
+      log_writer.submitted(Level::Error);
+      std::this_thread::yield();
+    }
+    log_writer.submitted(level);
+  }
+
+  void write(Level level, const char* source, std::string message) {
+    Record record;
+    record.Severity = level;
+    record.Source = source;
+    record.Message = std::move(message);
+    write(std::move(record));
+  }
+
+  void flush() {
+    writer().drain();
+  }
+
+  void shutdown() {
+    writer().stop();
+  }
+
+  uint64_t dropped() {
+    return writer().Dropped;
+  }
+}// namespace Log
@@ -0,0 +1,81 @@
+#pragma once
+
+#include <cstdint>
+#include <sstream>
+#include <string>
+
+// Lowest level compiled in, statements below it are discarded at compile time:
+// 0 trace, 1 debug, 2 info, 3 warn, 4 error.
+#ifndef LOG_MIN_LEVEL
+#define LOG_MIN_LEVEL 0
+#endif
+
+// Asynchronous logger. Each thread appends records to its own lock-free ring
+// and a background writer drains all rings in batches, so logging never
+// flushes the console on the calling thread.
+namespace Log {
+  enum class Level : uint8_t {
+    Trace,
+    Debug,
+    Info,
+    Warn,
+    Error
+  };
+
+  struct Record {
+    Level Severity = Level::Info;
+    // nanoseconds since the logger started
+    uint64_t TimeNs = 0;
+    // threads are numbered in order of their first record
+    uint32_t Thread = 0;
+    // subsystem the record came from, a string literal
+    const char* Source = "app";
+    std::string Message;
+
+    // raw VkDebugUtilsMessengerCallbackDataEXT fields, zero for everything else
+    uint32_t VkSeverity = 0;
+    uint32_t VkTypes = 0;
+    int32_t MessageIdNumber = 0;
+    std::string MessageIdName;
+  };
+
+  constexpr int MinLevel = LOG_MIN_LEVEL;
+
+  constexpr bool compiled_in(Level level) {
+    return static_cast<int>(level) >= MinLevel;
+  }
+
+  // runtime threshold on top of LOG_MIN_LEVEL
+  void set_level(Level level);
+  bool enabled(Level level);
+  // additionally write every record as one JSON object per line, empty closes the file
+  void set_json_path(const std::string& path);
+
+  // safe from any thread, including driver callback threads
+  void write(Record record);
+  void write(Level level, const char* source, std::string message);
+
+  // blocks until every record queued so far was written
+  void flush();
+  // drains and stops the writer, later records are written synchronously
+  void shutdown();
+  // records dropped because a thread's ring was full
+  uint64_t dropped();
+}// namespace Log
+
+#define LOG_AT(level, source, expr)                                          \
+  do {                                                                       \
+    if constexpr (Log::compiled_in(level)) {                                 \
+      if (Log::enabled(level)) {                                             \
+        std::ostringstream log_stream;                                       \
+        log_stream << expr;                                                  \
+        Log::write(level, source, log_stream.str());                         \
+      }                                                                      \
+    }                                                                        \
+  } while (0)
+
+#define LOG_TRACE(expr) LOG_AT(Log::Level::Trace, "app", expr)
+#define LOG_DEBUG(expr) LOG_AT(Log::Level::Debug, "app", expr)
+#define LOG_INFO(expr) LOG_AT(Log::Level::Info, "app", expr)
+#define LOG_WARN(expr) LOG_AT(Log::Level::Warn, "app", expr)
+#define LOG_ERROR(expr) LOG_AT(Log::Level::Error, "app", expr)
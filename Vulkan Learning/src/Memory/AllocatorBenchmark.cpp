@@ -0,0 +1,90 @@
+#include "Memory/AllocatorBenchmark.h"
+#include "Memory/BuddyAllocator.h"
+#include "Memory/RingAllocator.h"
+
+#include <chrono>
+#include <random>
+
+namespace {
+  double elapsed_ms(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+  }
+
+  void benchmark_buddy(uint32_t operations) {
+    BuddyAllocator buddy(256ull * 1024 * 1024);
+    std::mt19937 rng(1234);
+    // mostly small resources with the occasional large one
+    std::uniform_int_distribution<uint32_t> small_size(256, 64 * 1024);
+    std::uniform_int_distribution<uint32_t> large_size(256 * 1024, 4 * 1024 * 1024);
+    std::uniform_int_distribution<uint32_t> pick(0, 99);
+
+    std::vector<uint64_t> live;
+    live.reserve(operations);
+    uint32_t failed = 0;
+
+    auto start = std::chrono::steady_clock::now();
+    for (uint32_t i = 0; i < operations; ++i) {
+      // free as often as we allocate so the heap churns around a steady state
+      if (!live.empty() && pick(rng) < 50) {
+        size_t victim = rng() % live.size();
+        buddy.free(live[victim]);
+        live[victim] = live.back();
+        live.pop_back();
+        continue;
+      }
+
+      uint64_t size = pick(rng) < 95 ? small_size(rng) : large_size(rng);
+      std::optional<uint64_t> offset = buddy.allocate(size, 256);
+      if (offset) {
+        live.push_back(*offset);
+      }
+      else {
+        ++failed;
+      }
+    }
+    double churn_ms = elapsed_ms(start);
+
+    BuddyStats stats = buddy.stats();
+    std::cout << "Buddy: " << operations << " mixed ops in " << churn_ms << "ms ("
+      << operations / churn_ms / 1000.0 << "M ops/s), " << failed << " failed" << std::endl;
+    std::cout << "  live " << stats.AllocationCount << " allocations, " << stats.Requested / 1024 << "KiB requested in "
+      << stats.Allocated / 1024 << "KiB of blocks (internal waste "
+      << (stats.Allocated ? 100.0 * (stats.Allocated - stats.Requested) / stats.Allocated : 0.0) << "%), "
+      << stats.FreeBlockCount << " free blocks, external fragmentation " << stats.external_fragmentation() << std::endl;
+
+    start = std::chrono::steady_clock::now();
+    for (uint64_t offset : live) {
+      buddy.free(offset);
+    }
+    std::cout << "  freed the rest in " << elapsed_ms(start) << "ms, empty: " << (buddy.empty() ? "yes" : "no") << std::endl;
+  }
+
+  void benchmark_ring(uint32_t frames, uint32_t allocations_per_frame) {
+    const uint32_t frames_in_flight = 3;
+    RingAllocator ring(64ull * 1024 * 1024, frames_in_flight);
+    std::mt19937 rng(1234);
+    std::uniform_int_distribution<uint32_t> size(64, 4096);
+    uint32_t failed = 0;
+
+    auto start = std::chrono::steady_clock::now();
+    for (uint32_t frame = 0; frame < frames; ++frame) {
+      ring.begin_frame(frame % frames_in_flight);
+      for (uint32_t i = 0; i < allocations_per_frame; ++i) {
+        if (!ring.allocate(size(rng), 256)) {
+          ++failed;
+        }
+      }
+    }
+    double ms = elapsed_ms(start);
+
+    uint64_t total = static_cast<uint64_t>(frames) * allocations_per_frame;
+    std::cout << "Ring: " << total << " allocations over " << frames << " frames in " << ms << "ms ("
+      << total / ms / 1000.0 << "M allocs/s), " << failed << " failed, high water "
+      << ring.high_water() / 1024 << "KiB of " << ring.capacity() / 1024 << "KiB" << std::endl;
+  }
+}
+
+void run_allocator_benchmark() {
+  benchmark_buddy(1000000);
+  benchmark_ring(1000, 2000);
+}
@@ -0,0 +1,4 @@
+#pragma once
+
+// CPU-side allocate/free throughput of the sub-allocation strategies, no device needed
+void run_allocator_benchmark();
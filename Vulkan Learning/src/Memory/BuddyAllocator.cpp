@@ -0,0 +1,106 @@
+#include "BuddyAllocator.h"
+
+BuddyAllocator::BuddyAllocator(uint64_t capacity, uint64_t min_block) {
+  min_block_ = min_block;
+  max_order_ = 0;
+  while ((min_block_ << (max_order_ + 1)) <= capacity) {
+    ++max_order_;
+  }
+  capacity_ = min_block_ << max_order_;
+
+  free_lists_.resize(max_order_ + 1);
+  free_lists_[max_order_].insert(0);
+}
+
+std::optional<uint64_t> BuddyAllocator::allocate(uint64_t size, uint64_t alignment) {
+  // blocks are aligned to their own size, so asking for the alignment is enough
+  uint32_t order = order_for((std::max)(size, alignment));
+  if (order > max_order_) {
+    return std::nullopt;
+  }
+
+  uint32_t found = order;
+  while (found <= max_order_ && free_lists_[found].empty()) {
+    ++found;
+  }
+  if (found > max_order_) {
+    return std::nullopt;
+  }
+
+  uint64_t offset = *free_lists_[found].begin();
+  free_lists_[found].erase(free_lists_[found].begin());
+
+  // split down to the requested order, keeping the lower half each time
+  while (found > order) {
+    --found;
+    free_lists_[found].insert(offset + block_size(found));
+  }
+
+  allocations_[offset] = { order, size };
+  allocated_ += block_size(order);
+  requested_ += size;
+  return offset;
+}
+
+void BuddyAllocator::free(uint64_t offset) {
+  auto it = allocations_.find(offset);
+  if (it == allocations_.end()) {
+    return;
+  }
+
+  uint32_t order = it->second.first;
+  allocated_ -= block_size(order);
+  requested_ -= it->second.second;
+  allocations_.erase(it);
+
+  // merge with the buddy for as long as it is free
+  while (order < max_order_) {
+    uint64_t buddy = offset ^ block_size(order);
+    auto buddy_it = free_lists_[order].find(buddy);
+    if (buddy_it == free_lists_[order].end()) {
+      break;
+    }
+    free_lists_[order].erase(buddy_it);
+    offset = (std::min)(offset, buddy);
+    ++order;
+  }
+
+  free_lists_[order].insert(offset);
+}
+
+uint64_t BuddyAllocator::capacity() const {
+  return capacity_;
+}
+
+bool BuddyAllocator::empty() const {
+  return allocations_.empty();
+}
+
+BuddyStats BuddyAllocator::stats() const {
+  BuddyStats stats;
+  stats.Capacity = capacity_;
+  stats.Allocated = allocated_;
+  stats.Requested = requested_;
+  stats.AllocationCount = static_cast<uint32_t>(allocations_.size());
+
+  for (uint32_t order = 0; order <= max_order_; ++order) {
+    stats.FreeBlockCount += static_cast<uint32_t>(free_lists_[order].size());
+    if (!free_lists_[order].empty()) {
+      stats.LargestFree = block_size(order);
+    }
+  }
+
+  return stats;
+}
+
+uint32_t BuddyAllocator::order_for(uint64_t size) const {
+  uint32_t order = 0;
+  while (block_size(order) < size && order <= max_order_) {
+    ++order;
+  }
+  return order;
+}
+
+uint64_t BuddyAllocator::block_size(uint32_t order) const {
+  return min_block_ << order;
+}
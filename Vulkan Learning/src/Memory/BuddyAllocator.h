@@ -0,0 +1,52 @@
+#pragma once
+#include "Headers.h"
+
+#include <unordered_map>
+#include <unordered_set>
+
+struct BuddyStats {
+  uint64_t Capacity = 0;
+  // bytes handed out in power of two blocks
+  uint64_t Allocated = 0;
+  // bytes actually requested, Allocated - Requested is internal fragmentation
+  uint64_t Requested = 0;
+  uint64_t LargestFree = 0;
+  uint32_t AllocationCount = 0;
+  uint32_t FreeBlockCount = 0;
+
+  // 0 when all free space is one block, approaching 1 as it splinters
+  double external_fragmentation() const {
+    uint64_t free_bytes = Capacity - Allocated;
+    return free_bytes == 0 ? 0.0 : 1.0 - static_cast<double>(LargestFree) / free_bytes;
+  }
+};
+
+// Offset-only buddy allocator over [0, capacity). Blocks are powers of two
+// and naturally aligned to their size, so any alignment up to the block size
+// is free. Used for long-lived resources inside one device memory block.
+class BuddyAllocator {
+public:
+  // capacity is rounded down to a power of two multiple of min_block
+  BuddyAllocator(uint64_t capacity, uint64_t min_block = 256);
+
+  std::optional<uint64_t> allocate(uint64_t size, uint64_t alignment = 1);
+  void free(uint64_t offset);
+
+  uint64_t capacity() const;
+  bool empty() const;
+  BuddyStats stats() const;
+
+private:
+  uint32_t order_for(uint64_t size) const;
+  uint64_t block_size(uint32_t order) const;
+
+  uint64_t capacity_;
+  uint64_t min_block_;
+  uint32_t max_order_;
+  // free block offsets per order, order 0 is min_block_ sized
+  std::vector<std::unordered_set<uint64_t>> free_lists_;
+  // offset -> (order, requested size) of live allocations
+  std::unordered_map<uint64_t, std::pair<uint32_t, uint64_t>> allocations_;
+  uint64_t allocated_ = 0;
+  uint64_t requested_ = 0;
+};
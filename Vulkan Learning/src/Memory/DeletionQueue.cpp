@@ -0,0 +1,135 @@
+#include "Memory/DeletionQueue.h"
+
+DeletionQueue::DeletionQueue(const vk::Device& device, MemoryAllocator& allocator, QueueScheduler& scheduler, const bool debug)
+  : device_(device), allocator_(allocator), scheduler_(scheduler), debug_(debug) {
+}
+
+DeletionQueue::~DeletionQueue() {
+  std::lock_guard<std::mutex> lock(mutex_);
+  // points past the last submission will never be signaled, the idle device is the guarantee here
+  for (Batch& batch : batches_) {
+    destroy(batch);
+  }
+  batches_.clear();
+}
+
+void DeletionQueue::retire(vk::Buffer buffer, const MemoryAllocation& memory, const QueuePoint& point) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  batch_for(point).Resources.push_back({ buffer, nullptr, memory });
+}
+
+void DeletionQueue::retire(vk::Image image, const MemoryAllocation& memory, const QueuePoint& point) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  batch_for(point).Resources.push_back({ nullptr, image, memory });
+}
+
+void DeletionQueue::retire(vk::ImageView view, const QueuePoint& point) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  batch_for(point).Views.push_back(view);
+}
+
+void DeletionQueue::retire(vk::Pipeline pipeline, const QueuePoint& point) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  batch_for(point).Pipelines.push_back(pipeline);
+}
+
+void DeletionQueue::retire(vk::Semaphore semaphore, const QueuePoint& point) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  batch_for(point).Semaphores.push_back(semaphore);
+}
+
+void DeletionQueue::retire(vk::UniqueSwapchainKHR swapchain, const QueuePoint& point) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  batch_for(point).Swapchains.push_back(std::move(swapchain));
+}
+
+void DeletionQueue::retire(std::function<void()> destroy, const QueuePoint& point) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  batch_for(point).Callbacks.push_back(std::move(destroy));
+}
+
+QueuePoint DeletionQueue::frame_point() const {
+  QueuePoint point = scheduler_.last_point(QueueScheduler::GraphicsQueue);
+  ++point.Value;
+  return point;
+}
+
+void DeletionQueue::collect() {
+  std::lock_guard<std::mutex> lock(mutex_);
+
+  bool destroyed = false;
+  for (auto it = batches_.begin(); it != batches_.end();) {
+    if (!scheduler_.is_complete(it->Point)) {
+      ++it;
+      continue;
+    }
+    destroy(*it);
+    it = batches_.erase(it);
+    destroyed = true;
+  }
+  if (destroyed) {
+    ++stats_.Collections;
+  }
+}
+
+DeletionStats DeletionQueue::stats() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return stats_;
+}
+
+void DeletionQueue::report() const {
+  DeletionStats stats = this->stats();
+  std::cout << "Deletion queue: " << stats.Destroyed << " of " << stats.Retired << " retired objects destroyed in "
+    << stats.Collections << " collections, at most " << stats.PendingHighWater << " pending" << std::endl;
+}
+
+DeletionQueue::Batch& DeletionQueue::batch_for(const QueuePoint& point) {
+  ++stats_.Retired;
+  ++pending_;
+  stats_.PendingHighWater = (std::max)(stats_.PendingHighWater, pending_);
+
+  // retirements cluster on the frame point, so the newest batch is nearly always the one
+  for (auto it = batches_.rbegin(); it != batches_.rend(); ++it) {
+    if (it->Point.Queue == point.Queue && it->Point.Value == point.Value) {
+      ++it->Count;
+      return *it;
+    }
+  }
+  Batch batch;
+  batch.Point = point;
+  batch.Count = 1;
+  batches_.push_back(std::move(batch));
+  return batches_.back();
+}
+
+void DeletionQueue::destroy(Batch& batch) {
+  for (const std::function<void()>& callback : batch.Callbacks) {
+    callback();
+  }
+  // views before the images they look at
+  for (vk::ImageView view : batch.Views) {
+    device_.destroyImageView(view);
+  }
+  for (const Allocated& resource : batch.Resources) {
+    if (resource.Buffer) {
+      device_.destroyBuffer(resource.Buffer);
+    }
+    if (resource.Image) {
+      device_.destroyImage(resource.Image);
+    }
+    allocator_.free(resource.Memory);
+  }
+  for (vk::Pipeline pipeline : batch.Pipelines) {
+    device_.destroyPipeline(pipeline);
+  }
+  for (vk::Semaphore semaphore : batch.Semaphores) {
+    device_.destroySemaphore(semaphore);
+  }
+  batch.Swapchains.clear();
+
+  stats_.Destroyed += batch.Count;
+  pending_ -= batch.Count;
+  if (debug_) {
+    LOG_DEBUG("Destroyed " << batch.Count << " objects retired at queue " << batch.Point.Queue << " value " << batch.Point.Value);
+  }
+}
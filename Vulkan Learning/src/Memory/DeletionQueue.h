@@ -0,0 +1,82 @@
+#pragma once
+#include "Headers.h"
+#include "Memory/MemoryAllocator.h"
+#include "Scheduling/QueueScheduler.h"
+
+#include <deque>
+#include <functional>
+#include <mutex>
+
+struct DeletionStats {
+  uint64_t Retired = 0;
+  uint64_t Destroyed = 0;
+  // collect() calls that destroyed at least one batch
+  uint64_t Collections = 0;
+  uint64_t PendingHighWater = 0;
+};
+
+// Destroys Vulkan objects once the GPU has passed the timeline point they
+// were retired at, instead of draining the device with waitIdle. Objects
+// retired at the same point share a batch, batches are destroyed by collect()
+// in the order their points complete.
+//
+// Most objects are retired at frame_point(), the value the frame being
+// recorded will signal. Anything the presentation engine holds has no
+// completion signal of its own and is retired a few frames later.
+//
+// retire() may be called from any thread; frame_point() and collect() read
+// the scheduler and belong to the thread that submits.
+class DeletionQueue {
+public:
+  DeletionQueue(const vk::Device& device, MemoryAllocator& allocator, QueueScheduler& scheduler, const bool debug);
+  // the device must be idle, everything still queued is destroyed
+  ~DeletionQueue();
+
+  void retire(vk::Buffer buffer, const MemoryAllocation& memory, const QueuePoint& point);
+  void retire(vk::Image image, const MemoryAllocation& memory, const QueuePoint& point);
+  void retire(vk::ImageView view, const QueuePoint& point);
+  void retire(vk::Pipeline pipeline, const QueuePoint& point);
+  void retire(vk::Semaphore semaphore, const QueuePoint& point);
+  void retire(vk::UniqueSwapchainKHR swapchain, const QueuePoint& point);
+  // anything else, e.g. dropping bookkeeping that names the object
+  void retire(std::function<void()> destroy, const QueuePoint& point);
+
+  // the graphics point the next graphics submission will signal
+  QueuePoint frame_point() const;
+  // destroys every batch whose point the GPU has passed, call once per frame
+  void collect();
+
+  DeletionStats stats() const;
+  void report() const;
+
+private:
+  struct Allocated {
+    vk::Buffer Buffer;
+    vk::Image Image;
+    MemoryAllocation Memory;
+  };
+
+  struct Batch {
+    QueuePoint Point;
+    std::vector<Allocated> Resources;
+    std::vector<vk::ImageView> Views;
+    std::vector<vk::Pipeline> Pipelines;
+    std::vector<vk::Semaphore> Semaphores;
+    std::vector<vk::UniqueSwapchainKHR> Swapchains;
+    std::vector<std::function<void()>> Callbacks;
+    uint64_t Count = 0;
+  };
+
+  Batch& batch_for(const QueuePoint& point);
+  void destroy(Batch& batch);
+
+  vk::Device device_;
+  MemoryAllocator& allocator_;
+  QueueScheduler& scheduler_;
+  bool debug_;
+
+  std::deque<Batch> batches_;
+  uint64_t pending_ = 0;
+  DeletionStats stats_;
+  mutable std::mutex mutex_;
+};
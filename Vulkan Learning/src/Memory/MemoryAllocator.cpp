@@ -0,0 +1,223 @@
+#include "Memory/MemoryAllocator.h"
+
+MemoryAllocator::MemoryAllocator(const vk::PhysicalDevice& physical_device, const vk::Device& device, const bool debug,
+  vk::DeviceSize block_size) {
+  device_ = device;
+  debug_ = debug;
+  block_size_ = block_size;
+  memory_props_ = physical_device.getMemoryProperties();
+  max_allocations_ = physical_device.getProperties().limits.maxMemoryAllocationCount;
+  pools_.resize(memory_props_.memoryTypeCount * 2);
+
+  if (debug_) {
+    LOG_DEBUG("Memory Allocator: " << memory_props_.memoryTypeCount << " memory types, "
+      << memory_props_.memoryHeapCount << " heaps, " << max_allocations_ << " max allocations");
+  }
+}
+
+MemoryAllocator::~MemoryAllocator() {
+  for (Pool& pool : pools_) {
+    for (Block& block : pool.Blocks) {
+      if (block.Memory) {
+        device_.freeMemory(block.Memory);
+      }
+    }
+  }
+}
+
+MemoryAllocation MemoryAllocator::allocate(const vk::MemoryRequirements& requirements, vk::MemoryPropertyFlags properties, bool linear) {
+  uint32_t memory_type = find_memory_type(requirements.memoryTypeBits, properties);
+
+  std::lock_guard<std::mutex> lock(mutex_);
+
+  if (requirements.size > block_size_ / 2) {
+    return allocate_dedicated(requirements, memory_type, linear);
+  }
+
+  Pool& pool = pool_for(memory_type, linear);
+  MemoryAllocation allocation;
+  allocation.MemoryType = memory_type;
+  allocation.Size = requirements.size;
+  allocation.Linear = linear;
+
+  for (uint32_t i = 0; i < pool.Blocks.size(); ++i) {
+    Block& block = pool.Blocks[i];
+    if (!block.Memory) {
+      continue;
+    }
+    std::optional<uint64_t> offset = block.Allocator->allocate(requirements.size, requirements.alignment);
+    if (offset) {
+      allocation.Memory = block.Memory;
+      allocation.Offset = *offset;
+      allocation.Block = i;
+      allocation.Mapped = block.Mapped ? static_cast<char*>(block.Mapped) + *offset : nullptr;
+      return allocation;
+    }
+  }
+
+  // no room anywhere, open a new block, reusing a released slot if possible
+  vk::DeviceSize heap_size = memory_props_.memoryHeaps[memory_props_.memoryTypes[memory_type].heapIndex].size;
+  vk::DeviceSize target = (std::max)((std::min)(block_size_, heap_size / 8), (std::max)(requirements.size, requirements.alignment));
+  // the buddy allocator only manages power of two ranges
+  vk::DeviceSize size = 256;
+  while (size < target) {
+    size <<= 1;
+  }
+
+  Block block;
+  block.Memory = allocate_device_memory(size, memory_type, &block.Mapped);
+  block.Allocator = std::make_unique<BuddyAllocator>(size);
+
+  uint32_t index = static_cast<uint32_t>(pool.Blocks.size());
+  for (uint32_t i = 0; i < pool.Blocks.size(); ++i) {
+    if (!pool.Blocks[i].Memory) {
+      index = i;
+      break;
+    }
+  }
+  if (index == pool.Blocks.size()) {
+    pool.Blocks.push_back(std::move(block));
+  }
+  else {
+    pool.Blocks[index] = std::move(block);
+  }
+
+  Block& new_block = pool.Blocks[index];
+  uint64_t offset = new_block.Allocator->allocate(requirements.size, requirements.alignment).value();
+  allocation.Memory = new_block.Memory;
+  allocation.Offset = offset;
+  allocation.Block = index;
+  allocation.Mapped = new_block.Mapped ? static_cast<char*>(new_block.Mapped) + offset : nullptr;
+  return allocation;
+}
+
+MemoryAllocation MemoryAllocator::allocate_for_buffer(vk::Buffer buffer, vk::MemoryPropertyFlags properties) {
+  MemoryAllocation allocation = allocate(device_.getBufferMemoryRequirements(buffer), properties, true);
+  device_.bindBufferMemory(buffer, allocation.Memory, allocation.Offset);
+  return allocation;
+}
+
+MemoryAllocation MemoryAllocator::allocate_for_image(vk::Image image, vk::MemoryPropertyFlags properties) {
+  MemoryAllocation allocation = allocate(device_.getImageMemoryRequirements(image), properties, false);
+  device_.bindImageMemory(image, allocation.Memory, allocation.Offset);
+  return allocation;
+}
+
+void MemoryAllocator::free(const MemoryAllocation& allocation) {
+  if (!allocation.Memory) {
+    return;
+  }
+
+  std::lock_guard<std::mutex> lock(mutex_);
+
+  if (allocation.Block == UINT32_MAX) {
+    device_.freeMemory(allocation.Memory);
+    --device_allocations_;
+    --dedicated_allocations_;
+    dedicated_bytes_ -= allocation.Size;
+    return;
+  }
+
+  Pool& pool = pool_for(allocation.MemoryType, allocation.Linear);
+  Block& block = pool.Blocks[allocation.Block];
+  block.Allocator->free(allocation.Offset);
+
+  // give empty blocks back to the driver, but keep the first one to avoid thrashing
+  if (block.Allocator->empty() && allocation.Block != 0) {
+    device_.freeMemory(block.Memory);
+    --device_allocations_;
+    block = Block{};
+  }
+}
+
+uint32_t MemoryAllocator::find_memory_type(uint32_t type_bits, vk::MemoryPropertyFlags properties) const {
+  for (uint32_t i = 0; i < memory_props_.memoryTypeCount; ++i) {
+    if ((type_bits & (1u << i)) && (memory_props_.memoryTypes[i].propertyFlags & properties) == properties) {
+      return i;
+    }
+  }
+
+  throw std::runtime_error("Failed to find a suitable memory type!");
+}
+
+const vk::PhysicalDeviceMemoryProperties& MemoryAllocator::memory_properties() const {
+  return memory_props_;
+}
+
+MemoryStats MemoryAllocator::stats() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+
+  MemoryStats stats;
+  stats.DeviceAllocations = device_allocations_;
+  stats.MaxDeviceAllocations = max_allocations_;
+  stats.DedicatedAllocations = dedicated_allocations_;
+  stats.ReservedBytes = dedicated_bytes_;
+  stats.AllocatedBytes = dedicated_bytes_;
+  stats.RequestedBytes = dedicated_bytes_;
+
+  for (const Pool& pool : pools_) {
+    for (const Block& block : pool.Blocks) {
+      if (!block.Memory) {
+        continue;
+      }
+      BuddyStats block_stats = block.Allocator->stats();
+      stats.SubAllocations += block_stats.AllocationCount;
+      stats.ReservedBytes += block_stats.Capacity;
+      stats.AllocatedBytes += block_stats.Allocated;
+      stats.RequestedBytes += block_stats.Requested;
+      stats.WorstFragmentation = (std::max)(stats.WorstFragmentation, block_stats.external_fragmentation());
+    }
+  }
+
+  return stats;
+}
+
+void MemoryAllocator::report() const {
+  MemoryStats stats = this->stats();
+
+  std::cout << "Device memory: " << stats.DeviceAllocations << "/" << stats.MaxDeviceAllocations << " allocations ("
+    << stats.DedicatedAllocations << " dedicated), " << stats.SubAllocations << " sub-allocations, "
+    << stats.RequestedBytes / 1024 << "KiB requested, " << stats.AllocatedBytes / 1024 << "KiB allocated, "
+    << stats.ReservedBytes / 1024 << "KiB reserved, worst fragmentation " << stats.WorstFragmentation << std::endl;
+}
+
+MemoryAllocation MemoryAllocator::allocate_dedicated(const vk::MemoryRequirements& requirements, uint32_t memory_type, bool linear) {
+  MemoryAllocation allocation;
+  allocation.Memory = allocate_device_memory(requirements.size, memory_type, &allocation.Mapped);
+  allocation.Size = requirements.size;
+  allocation.MemoryType = memory_type;
+  allocation.Linear = linear;
+
+  ++dedicated_allocations_;
+  dedicated_bytes_ += requirements.size;
+  return allocation;
+}
+
+vk::DeviceMemory MemoryAllocator::allocate_device_memory(vk::DeviceSize size, uint32_t memory_type, void** mapped) {
+  if (device_allocations_ >= max_allocations_) {
+    throw std::runtime_error("Exceeded maxMemoryAllocationCount!");
+  }
+
+  vk::MemoryAllocateInfo alloc_info{};
+  alloc_info.allocationSize = size;
+  alloc_info.memoryTypeIndex = memory_type;
+
+  vk::DeviceMemory memory = device_.allocateMemory(alloc_info);
+  ++device_allocations_;
+
+  // host visible memory stays mapped for its whole lifetime
+  *mapped = nullptr;
+  if (memory_props_.memoryTypes[memory_type].propertyFlags & vk::MemoryPropertyFlagBits::eHostVisible) {
+    *mapped = device_.mapMemory(memory, 0, VK_WHOLE_SIZE);
+  }
+
+  if (debug_) {
+    LOG_DEBUG("Allocated " << size / 1024 << "KiB of device memory from type " << memory_type);
+  }
+
+  return memory;
+}
+
+MemoryAllocator::Pool& MemoryAllocator::pool_for(uint32_t memory_type, bool linear) {
+  return pools_[memory_type * 2 + (linear ? 1 : 0)];
+}
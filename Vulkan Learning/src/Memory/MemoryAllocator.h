@@ -0,0 +1,82 @@
+#pragma once
+#include "Headers.h"
+#include "Memory/BuddyAllocator.h"
+
+#include <memory>
+#include <mutex>
+
+struct MemoryAllocation {
+  vk::DeviceMemory Memory;
+  vk::DeviceSize Offset = 0;
+  vk::DeviceSize Size = 0;
+  // null unless the memory type is host visible
+  void* Mapped = nullptr;
+  uint32_t MemoryType = 0;
+  // block inside the pool, UINT32_MAX for dedicated allocations
+  uint32_t Block = UINT32_MAX;
+  bool Linear = true;
+};
+
+struct MemoryStats {
+  // live vkAllocateMemory calls against maxMemoryAllocationCount
+  uint32_t DeviceAllocations = 0;
+  uint32_t MaxDeviceAllocations = 0;
+  uint32_t DedicatedAllocations = 0;
+  uint32_t SubAllocations = 0;
+  uint64_t ReservedBytes = 0;
+  uint64_t AllocatedBytes = 0;
+  uint64_t RequestedBytes = 0;
+  // worst external fragmentation over all blocks
+  double WorstFragmentation = 0.0;
+};
+
+// Carves large device memory blocks into buddy sub-allocations, with one
+// pool per memory type. Buffers and optimal-tiling images live in separate
+// pools so bufferImageGranularity never has to be considered. Requests
+// larger than half a block get their own dedicated allocation.
+class MemoryAllocator {
+public:
+  MemoryAllocator(const vk::PhysicalDevice& physical_device, const vk::Device& device, const bool debug,
+    vk::DeviceSize block_size = 64ull * 1024 * 1024);
+  ~MemoryAllocator();
+
+  // linear is true for buffers and linear images, false for optimal images
+  MemoryAllocation allocate(const vk::MemoryRequirements& requirements, vk::MemoryPropertyFlags properties, bool linear);
+  MemoryAllocation allocate_for_buffer(vk::Buffer buffer, vk::MemoryPropertyFlags properties);
+  MemoryAllocation allocate_for_image(vk::Image image, vk::MemoryPropertyFlags properties);
+  void free(const MemoryAllocation& allocation);
+
+  uint32_t find_memory_type(uint32_t type_bits, vk::MemoryPropertyFlags properties) const;
+  const vk::PhysicalDeviceMemoryProperties& memory_properties() const;
+
+  MemoryStats stats() const;
+  void report() const;
+
+private:
+  struct Block {
+    vk::DeviceMemory Memory;
+    void* Mapped = nullptr;
+    std::unique_ptr<BuddyAllocator> Allocator;
+  };
+
+  struct Pool {
+    std::vector<Block> Blocks;
+  };
+
+  MemoryAllocation allocate_dedicated(const vk::MemoryRequirements& requirements, uint32_t memory_type, bool linear);
+  vk::DeviceMemory allocate_device_memory(vk::DeviceSize size, uint32_t memory_type, void** mapped);
+  Pool& pool_for(uint32_t memory_type, bool linear);
+
+  vk::Device device_;
+  vk::PhysicalDeviceMemoryProperties memory_props_;
+  vk::DeviceSize block_size_;
+  uint32_t max_allocations_;
+  bool debug_;
+
+  // indexed by memory type * 2 + linear
+  std::vector<Pool> pools_;
+  uint32_t device_allocations_ = 0;
+  uint32_t dedicated_allocations_ = 0;
+  uint64_t dedicated_bytes_ = 0;
+  mutable std::mutex mutex_;
+};
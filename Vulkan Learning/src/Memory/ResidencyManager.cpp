@@ -0,0 +1,266 @@
+#include "Memory/ResidencyManager.h"
+#include "Profiling/GpuProfiler.h"
+
+#include <iomanip>
+
+namespace {
+  // the driver only refreshes its numbers at submits and presents, no point asking every frame
+  constexpr uint64_t PollInterval = 8;
+  // without VK_EXT_memory_budget, assume the rest of the system leaves us this much of each heap
+  constexpr double FallbackBudgetShare = 0.8;
+  // releasing starts above the high watermark and stops once usage is back under the low one,
+  // so a heap hovering around its budget does not evict a little every frame
+  constexpr double HighWatermark = 0.95;
+  constexpr double LowWatermark = 0.85;
+
+  const char* category_names[] = { "textures", "buffers", "render targets" };
+
+  double mib(vk::DeviceSize bytes) {
+    return bytes / (1024.0 * 1024.0);
+  }
+}
+
+ResidencyManager::ResidencyManager(const vk::PhysicalDevice& physical_device, bool memory_budget, uint32_t frames_in_flight, const bool debug)
+  : physical_device_(physical_device), memory_budget_(memory_budget), frames_in_flight_(frames_in_flight), debug_(debug) {
+  memory_props_ = physical_device_.getMemoryProperties();
+
+  heaps_.resize(memory_props_.memoryHeapCount);
+  for (uint32_t i = 0; i < memory_props_.memoryHeapCount; ++i) {
+    heaps_[i].Size = memory_props_.memoryHeaps[i].size;
+    heaps_[i].DeviceLocal = static_cast<bool>(memory_props_.memoryHeaps[i].flags & vk::MemoryHeapFlagBits::eDeviceLocal);
+    counter_names_.push_back("heap " + std::to_string(i) + " usage MiB");
+    counter_names_.push_back("heap " + std::to_string(i) + " budget MiB");
+  }
+  tracked_at_poll_.assign(heaps_.size(), 0);
+  driver_usage_.assign(heaps_.size(), 0);
+  stats_.BudgetExtension = memory_budget_;
+
+  std::lock_guard<std::mutex> lock(mutex_);
+  poll_budget();
+
+  if (debug_) {
+    if (memory_budget_) {
+      LOG_DEBUG("Tracking residency against VK_EXT_memory_budget");
+    }
+    else {
+      LOG_DEBUG("VK_EXT_memory_budget is not supported, residency budgets are " << FallbackBudgetShare * 100.0 << "% of each heap");
+    }
+  }
+}
+
+uint64_t ResidencyManager::track(ResidencyCategory category, const MemoryAllocation& allocation, ReleaseFunction release, bool downsample) {
+  Entry entry{ category, heap_of(allocation), allocation.Size, std::move(release), downsample, 0 };
+
+  std::lock_guard<std::mutex> lock(mutex_);
+  // a new resource counts as just used, it is about to be drawn with
+  entry.LastUsed = frame_number_;
+  heaps_[entry.Heap].Tracked[static_cast<size_t>(category)] += entry.Size;
+
+  uint64_t id = next_id_++;
+  entries_.emplace(id, std::move(entry));
+  return id;
+}
+
+void ResidencyManager::untrack(uint64_t id) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  auto it = entries_.find(id);
+  if (it == entries_.end()) {
+    return;
+  }
+  heaps_[it->second.Heap].Tracked[static_cast<size_t>(it->second.Category)] -= it->second.Size;
+  entries_.erase(it);
+}
+
+void ResidencyManager::touch(uint64_t id) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  auto it = entries_.find(id);
+  if (it != entries_.end()) {
+    it->second.LastUsed = frame_number_;
+  }
+}
+
+void ResidencyManager::resize(uint64_t id, const MemoryAllocation& allocation) {
+  uint32_t heap = heap_of(allocation);
+
+  std::lock_guard<std::mutex> lock(mutex_);
+  auto it = entries_.find(id);
+  if (it == entries_.end()) {
+    return;
+  }
+  Entry& entry = it->second;
+  size_t category = static_cast<size_t>(entry.Category);
+  // the new allocation may have landed in another heap
+  heaps_[entry.Heap].Tracked[category] -= entry.Size;
+  heaps_[heap].Tracked[category] += allocation.Size;
+  entry.Heap = heap;
+  entry.Size = allocation.Size;
+  entry.LastUsed = frame_number_;
+}
+
+void ResidencyManager::begin_frame(uint64_t frame_number) {
+  std::vector<vk::DeviceSize> excess(heaps_.size(), 0);
+  std::vector<Victim> victims;
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    frame_number_ = frame_number;
+    if (frame_number_ - last_poll_ >= PollInterval) {
+      poll_budget();
+      last_poll_ = frame_number_;
+    }
+
+    bool pressure = false;
+    for (uint32_t heap = 0; heap < heaps_.size(); ++heap) {
+      HeapResidency& residency = heaps_[heap];
+      residency.Usage = usage_of(heap);
+      if (residency.Budget != 0 && residency.Usage > residency.Budget * HighWatermark) {
+        excess[heap] = residency.Usage - static_cast<vk::DeviceSize>(residency.Budget * LowWatermark);
+        pressure = true;
+      }
+    }
+    if (!pressure) {
+      return;
+    }
+    ++stats_.PressureFrames;
+
+    for (const auto& [id, entry] : entries_) {
+      // frames in flight may still read it, releasing now would need a stall
+      bool in_flight = frame_number_ - entry.LastUsed <= frames_in_flight_;
+      if (entry.Release && excess[entry.Heap] != 0 && entry.Size != 0 && !in_flight) {
+        victims.push_back({ id, entry.Heap, entry.Size, entry.Release, entry.Downsample, entry.LastUsed });
+      }
+    }
+  }
+
+  std::sort(victims.begin(), victims.end(), [](const Victim& a, const Victim& b) { return a.LastUsed < b.LastUsed; });
+
+  std::vector<vk::DeviceSize> released(heaps_.size(), 0);
+  for (const Victim& victim : victims) {
+    if (released[victim.Heap] >= excess[victim.Heap]) {
+      continue;
+    }
+
+    // a smaller mip chain keeps the resource drawable, so that is tried before evicting
+    bool downsampled = false;
+    vk::DeviceSize remaining = victim.Size;
+    if (victim.Downsample) {
+      remaining = victim.Release(ResidencyAction::Downsample);
+      downsampled = remaining < victim.Size;
+    }
+    if (!downsampled) {
+      remaining = victim.Release(ResidencyAction::Evict);
+    }
+    if (remaining >= victim.Size) {
+      continue;
+    }
+    released[victim.Heap] += victim.Size - remaining;
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    // the callback may already have untracked or resized it
+    auto it = entries_.find(victim.Id);
+    if (it != entries_.end() && it->second.Size == victim.Size) {
+      heaps_[victim.Heap].Tracked[static_cast<size_t>(it->second.Category)] -= victim.Size - remaining;
+      it->second.Size = remaining;
+    }
+    if (downsampled) {
+      ++stats_.Downsamples;
+    }
+    else {
+      ++stats_.Evictions;
+    }
+    stats_.ReleasedBytes += victim.Size - remaining;
+  }
+
+  std::lock_guard<std::mutex> lock(mutex_);
+  for (uint32_t heap = 0; heap < heaps_.size(); ++heap) {
+    heaps_[heap].Usage = usage_of(heap);
+    if (released[heap] < excess[heap]) {
+      // warned once, after that the counter in the report tells how often it happened
+      if (stats_.UnrelievedFrames++ == 0) {
+        LOG_WARN("Heap " << heap << " is over budget by " << mib(excess[heap] - released[heap])
+          << "MiB and nothing else can be released");
+      }
+      break;
+    }
+  }
+}
+
+void ResidencyManager::poll_budget() {
+  if (!memory_budget_) {
+    for (HeapResidency& heap : heaps_) {
+      heap.Budget = static_cast<vk::DeviceSize>(heap.Size * FallbackBudgetShare);
+    }
+    return;
+  }
+
+  auto props = physical_device_.getMemoryProperties2<vk::PhysicalDeviceMemoryProperties2, vk::PhysicalDeviceMemoryBudgetPropertiesEXT>();
+  const vk::PhysicalDeviceMemoryBudgetPropertiesEXT& budget = props.get<vk::PhysicalDeviceMemoryBudgetPropertiesEXT>();
+  for (uint32_t heap = 0; heap < heaps_.size(); ++heap) {
+    heaps_[heap].Budget = budget.heapBudget[heap];
+    driver_usage_[heap] = budget.heapUsage[heap];
+    tracked_at_poll_[heap] = tracked_of(heap);
+  }
+}
+
+vk::DeviceSize ResidencyManager::usage_of(uint32_t heap) const {
+  vk::DeviceSize tracked = tracked_of(heap);
+  if (!memory_budget_) {
+    return tracked;
+  }
+  // the driver's number is from the last poll, what was tracked or released since is applied on top
+  if (tracked >= tracked_at_poll_[heap]) {
+    return driver_usage_[heap] + (tracked - tracked_at_poll_[heap]);
+  }
+  vk::DeviceSize released = tracked_at_poll_[heap] - tracked;
+  return driver_usage_[heap] > released ? driver_usage_[heap] - released : 0;
+}
+
+vk::DeviceSize ResidencyManager::tracked_of(uint32_t heap) const {
+  vk::DeviceSize tracked = 0;
+  for (vk::DeviceSize bytes : heaps_[heap].Tracked) {
+    tracked += bytes;
+  }
+  return tracked;
+}
+
+uint32_t ResidencyManager::heap_of(const MemoryAllocation& allocation) const {
+  return memory_props_.memoryTypes[allocation.MemoryType].heapIndex;
+}
+
+ResidencyStats ResidencyManager::stats() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  ResidencyStats stats = stats_;
+  stats.Heaps = heaps_;
+  return stats;
+}
+
+void ResidencyManager::report() const {
+  ResidencyStats stats = this->stats();
+
+  std::cout << "Residency (" << (stats.BudgetExtension ? "VK_EXT_memory_budget" : "estimated budgets") << "): "
+    << stats.Downsamples << " downsamples, " << stats.Evictions << " evictions, " << mib(stats.ReleasedBytes)
+    << "MiB released, over the high watermark in " << stats.PressureFrames << " frames ("
+    << stats.UnrelievedFrames << " unrelieved)" << std::endl;
+  for (size_t heap = 0; heap < stats.Heaps.size(); ++heap) {
+    const HeapResidency& residency = stats.Heaps[heap];
+    std::cout << "  heap " << heap << (residency.DeviceLocal ? " (device local)" : "") << std::fixed << std::setprecision(1)
+      << ": " << mib(residency.Usage) << " / " << mib(residency.Budget) << "MiB budget of " << mib(residency.Size) << "MiB";
+    for (size_t category = 0; category < residency.Tracked.size(); ++category) {
+      std::cout << ", " << category_names[category] << " " << mib(residency.Tracked[category]) << "MiB";
+    }
+    std::cout << std::defaultfloat << std::endl;
+  }
+}
+
+void ResidencyManager::publish(GpuProfiler* profiler) const {
+  if (!profiler) {
+    return;
+  }
+
+  ResidencyStats stats = this->stats();
+  for (size_t heap = 0; heap < stats.Heaps.size(); ++heap) {
+    profiler->record_counter(counter_names_[heap * 2], mib(stats.Heaps[heap].Usage));
+    profiler->record_counter(counter_names_[heap * 2 + 1], mib(stats.Heaps[heap].Budget));
+  }
+  profiler->record_counter("residency downsamples", static_cast<double>(stats.Downsamples));
+  profiler->record_counter("residency evictions", static_cast<double>(stats.Evictions));
+}
@@ -0,0 +1,126 @@
+#pragma once
+#include "Headers.h"
+#include "Memory/MemoryAllocator.h"
+
+#include <array>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+class GpuProfiler;
+
+enum class ResidencyCategory {
+  Texture,
+  Buffer,
+  RenderTarget,
+  Count
+};
+
+enum class ResidencyAction {
+  // drop the most detailed mips, only asked of resources tracked as downsamplable
+  Downsample,
+  // give the memory back entirely, the owner streams it in again on next use
+  Evict
+};
+
+struct HeapResidency {
+  vk::DeviceSize Size = 0;
+  // VK_EXT_memory_budget's heapBudget, otherwise a fixed share of the heap
+  vk::DeviceSize Budget = 0;
+  // the driver's heapUsage plus what was tracked since the last poll, only tracked bytes without the extension
+  vk::DeviceSize Usage = 0;
+  std::array<vk::DeviceSize, static_cast<size_t>(ResidencyCategory::Count)> Tracked{};
+  bool DeviceLocal = false;
+};
+
+struct ResidencyStats {
+  bool BudgetExtension = false;
+  std::vector<HeapResidency> Heaps;
+  uint64_t Downsamples = 0;
+  uint64_t Evictions = 0;
+  uint64_t ReleasedBytes = 0;
+  // frames that found a heap above the high watermark
+  uint64_t PressureFrames = 0;
+  // of those, frames where everything releasable was still in use
+  uint64_t UnrelievedFrames = 0;
+};
+
+// Keeps device memory under the budget VK_EXT_memory_budget reports per heap.
+// Owners track their allocations by category; streamable ones pass a release
+// callback. When a heap climbs past the high watermark the least recently
+// touched streamable resources are downsampled or evicted until the heap is
+// back under the low watermark, skipping anything a frame in flight may read.
+// Without the extension the budget is a fixed share of each heap and usage is
+// only what was tracked here.
+//
+// track/untrack/touch/resize may be called from any thread. begin_frame runs
+// the release callbacks without holding the lock, so callbacks may call back in.
+class ResidencyManager {
+public:
+  // returns the bytes still resident afterwards, the unchanged size when the owner cannot comply
+  using ReleaseFunction = std::function<vk::DeviceSize(ResidencyAction action)>;
+
+  ResidencyManager(const vk::PhysicalDevice& physical_device, bool memory_budget, uint32_t frames_in_flight, const bool debug);
+
+  // a null release keeps the resource resident, it only counts towards usage
+  uint64_t track(ResidencyCategory category, const MemoryAllocation& allocation, ReleaseFunction release = nullptr,
+    bool downsample = false);
+  void untrack(uint64_t id);
+  // the frame being recorded uses the resource
+  void touch(uint64_t id);
+  // the owner reallocated, e.g. streamed an evicted resource back in
+  void resize(uint64_t id, const MemoryAllocation& allocation);
+
+  // once per frame: refreshes the budgets every few frames and releases least recently used resources over budget
+  void begin_frame(uint64_t frame_number);
+
+  ResidencyStats stats() const;
+  void report() const;
+  // heap usage, budgets and release counters as counter tracks in the trace, a null profiler is ignored
+  void publish(GpuProfiler* profiler) const;
+
+private:
+  struct Entry {
+    ResidencyCategory Category;
+    uint32_t Heap;
+    vk::DeviceSize Size;
+    ReleaseFunction Release;
+    bool Downsample;
+    uint64_t LastUsed;
+  };
+
+  // copied out so the callbacks run without the lock
+  struct Victim {
+    uint64_t Id;
+    uint32_t Heap;
+    vk::DeviceSize Size;
+    ReleaseFunction Release;
+    bool Downsample;
+    uint64_t LastUsed;
+  };
+
+  void poll_budget();
+  vk::DeviceSize usage_of(uint32_t heap) const;
+  vk::DeviceSize tracked_of(uint32_t heap) const;
+  uint32_t heap_of(const MemoryAllocation& allocation) const;
+
+  vk::PhysicalDevice physical_device_;
+  vk::PhysicalDeviceMemoryProperties memory_props_;
+  bool memory_budget_;
+  uint32_t frames_in_flight_;
+  bool debug_;
+
+  std::vector<HeapResidency> heaps_;
+  // tracked bytes per heap when the driver's usage was read, so usage between polls can be estimated
+  std::vector<vk::DeviceSize> tracked_at_poll_;
+  std::vector<vk::DeviceSize> driver_usage_;
+  std::vector<std::string> counter_names_;
+  std::unordered_map<uint64_t, Entry> entries_;
+  uint64_t next_id_ = 1;
+  uint64_t frame_number_ = 0;
+  uint64_t last_poll_ = 0;
+
+  ResidencyStats stats_;
+  mutable std::mutex mutex_;
+};
@@ -0,0 +1,59 @@
+#include "RingAllocator.h"
+
+RingAllocator::RingAllocator(uint64_t capacity, uint32_t frames_in_flight) {
+  capacity_ = capacity;
+  frame_ends_.assign(frames_in_flight, 0);
+}
+
+void RingAllocator::begin_frame(uint32_t frame_index) {
+  frame_ends_[current_frame_] = head_;
+  current_frame_ = frame_index;
+
+  // everything this slot allocated last time round has retired
+  release(frame_ends_[frame_index]);
+}
+
+uint64_t RingAllocator::head() const {
+  return head_;
+}
+
+void RingAllocator::release(uint64_t position) {
+  tail_ = (std::max)(tail_, (std::min)(position, head_));
+}
+
+std::optional<uint64_t> RingAllocator::allocate(uint64_t size, uint64_t alignment) {
+  uint64_t position = head_ % capacity_;
+  uint64_t offset = (position + alignment - 1) / alignment * alignment;
+
+  // never split an allocation across the end, skip to the start instead
+  if (offset + size > capacity_) {
+    offset = 0;
+  }
+
+  uint64_t padding = offset >= position ? offset - position : capacity_ - position;
+  uint64_t new_head = head_ + padding + size;
+  if (new_head - tail_ > capacity_) {
+    return std::nullopt;
+  }
+
+  head_ = new_head;
+  high_water_ = (std::max)(high_water_, head_ - tail_);
+  ++allocation_count_;
+  return offset;
+}
+
+uint64_t RingAllocator::capacity() const {
+  return capacity_;
+}
+
+uint64_t RingAllocator::used() const {
+  return head_ - tail_;
+}
+
+uint64_t RingAllocator::high_water() const {
+  return high_water_;
+}
+
+uint64_t RingAllocator::allocation_count() const {
+  return allocation_count_;
+}
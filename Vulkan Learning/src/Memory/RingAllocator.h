@@ -0,0 +1,38 @@
+#pragma once
+#include "Headers.h"
+
+// Offset-only ring allocator for per-frame transient data. Allocations are
+// never freed individually, instead everything a frame allocated is released
+// at once when that frame slot comes around again and its fence has signaled.
+// Users that retire on something other than frame slots (timeline values)
+// can remember head() and release() up to it themselves.
+class RingAllocator {
+public:
+  RingAllocator(uint64_t capacity, uint32_t frames_in_flight);
+
+  // releases the allocations made the last time this frame slot was active
+  void begin_frame(uint32_t frame_index);
+  std::optional<uint64_t> allocate(uint64_t size, uint64_t alignment = 1);
+
+  // monotonic position just past the newest allocation
+  uint64_t head() const;
+  // frees everything allocated before `position`
+  void release(uint64_t position);
+
+  uint64_t capacity() const;
+  uint64_t used() const;
+  // highest number of bytes live at once since creation
+  uint64_t high_water() const;
+  uint64_t allocation_count() const;
+
+private:
+  uint64_t capacity_;
+  // monotonic byte positions, the physical offset is position % capacity_
+  uint64_t head_ = 0;
+  uint64_t tail_ = 0;
+  uint64_t high_water_ = 0;
+  uint64_t allocation_count_ = 0;
+  uint32_t current_frame_ = 0;
+  // head_ at the end of each frame slot's last use
+  std::vector<uint64_t> frame_ends_;
+};
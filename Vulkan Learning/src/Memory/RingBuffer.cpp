@@ -0,0 +1,44 @@
+#include "Memory/RingBuffer.h"
+
+RingBuffer::RingBuffer(const vk::Device& device, MemoryAllocator& allocator, vk::DeviceSize capacity, vk::BufferUsageFlags usage,
+  uint32_t frames_in_flight)
+  : device_(device), memory_allocator_(allocator), ring_(capacity, frames_in_flight) {
+  vk::BufferCreateInfo buffer_info{};
+  buffer_info.size = capacity;
+  buffer_info.usage = usage;
+  buffer_info.sharingMode = vk::SharingMode::eExclusive;
+
+  buffer_ = device_.createBuffer(buffer_info);
+  memory_ = memory_allocator_.allocate_for_buffer(buffer_,
+    vk::MemoryPropertyFlagBits::eHostVisible | vk::MemoryPropertyFlagBits::eHostCoherent);
+}
+
+RingBuffer::~RingBuffer() {
+  device_.destroyBuffer(buffer_);
+  memory_allocator_.free(memory_);
+}
+
+void RingBuffer::begin_frame(uint32_t frame_index) {
+  ring_.begin_frame(frame_index);
+}
+
+std::optional<RingSlice> RingBuffer::allocate(vk::DeviceSize size, vk::DeviceSize alignment) {
+  std::optional<uint64_t> offset = ring_.allocate(size, alignment);
+  if (!offset) {
+    return std::nullopt;
+  }
+
+  RingSlice slice;
+  slice.Buffer = buffer_;
+  slice.Offset = *offset;
+  slice.Mapped = static_cast<char*>(memory_.Mapped) + *offset;
+  return slice;
+}
+
+vk::Buffer RingBuffer::buffer() const {
+  return buffer_;
+}
+
+const RingAllocator& RingBuffer::allocator() const {
+  return ring_;
+}
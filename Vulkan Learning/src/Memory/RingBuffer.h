@@ -0,0 +1,32 @@
+#pragma once
+#include "Headers.h"
+#include "Memory/MemoryAllocator.h"
+#include "Memory/RingAllocator.h"
+
+struct RingSlice {
+  vk::Buffer Buffer;
+  vk::DeviceSize Offset = 0;
+  void* Mapped = nullptr;
+};
+
+// Persistently mapped host-visible buffer handed out in per-frame slices,
+// for transient data that only has to live until its frame retires.
+class RingBuffer {
+public:
+  RingBuffer(const vk::Device& device, MemoryAllocator& allocator, vk::DeviceSize capacity, vk::BufferUsageFlags usage,
+    uint32_t frames_in_flight);
+  ~RingBuffer();
+
+  void begin_frame(uint32_t frame_index);
+  std::optional<RingSlice> allocate(vk::DeviceSize size, vk::DeviceSize alignment);
+
+  vk::Buffer buffer() const;
+  const RingAllocator& allocator() const;
+
+private:
+  vk::Device device_;
+  MemoryAllocator& memory_allocator_;
+  vk::Buffer buffer_;
+  MemoryAllocation memory_;
+  RingAllocator ring_;
+};
@@ -0,0 +1,84 @@
+#include "ParallelRecorder.h"
+
+ParallelRecorder::ParallelRecorder(const vk::Device& device, uint32_t queue_family, uint32_t frames_in_flight, JobSystem& jobs, const bool debug)
+  : device_(device), jobs_(jobs) {
+  if (debug) {
+    LOG_DEBUG("Creating Recording Pools for " << jobs_.worker_count() << " Workers...");
+  }
+
+  vk::CommandPoolCreateInfo pool_info{};
+  pool_info.flags = vk::CommandPoolCreateFlagBits::eTransient;
+  pool_info.queueFamilyIndex = queue_family;
+
+  pools_.resize(frames_in_flight);
+  for (std::vector<WorkerPool>& frame_pools : pools_) {
+    frame_pools.resize(jobs_.worker_count());
+    for (WorkerPool& pool : frame_pools) {
+      pool.Pool = device_.createCommandPool(pool_info);
+    }
+  }
+}
+
+ParallelRecorder::~ParallelRecorder() {
+  for (std::vector<WorkerPool>& frame_pools : pools_) {
+    for (WorkerPool& pool : frame_pools) {
+      device_.destroyCommandPool(pool.Pool);
+    }
+  }
+}
+
+void ParallelRecorder::begin_frame(uint32_t frame_index) {
+  current_frame_ = frame_index;
+  for (WorkerPool& pool : pools_[current_frame_]) {
+    device_.resetCommandPool(pool.Pool);
+    pool.Used = 0;
+  }
+}
+
+void ParallelRecorder::record(vk::CommandBuffer primary, uint32_t item_count, const RecordFunction& record_function,
+  const vk::CommandBufferInheritanceInfo& inheritance, uint32_t thread_count) {
+  if (item_count == 0) {
+    return;
+  }
+  if (thread_count == 0 || thread_count > jobs_.worker_count()) {
+    thread_count = jobs_.worker_count();
+  }
+
+  std::vector<WorkerPool>& frame_pools = pools_[current_frame_];
+  recorded_.assign((std::min)(thread_count, item_count), nullptr);
+
+  vk::CommandBufferBeginInfo begin_info{};
+  begin_info.flags = vk::CommandBufferUsageFlagBits::eOneTimeSubmit;
+  if (inheritance.renderPass) {
+    begin_info.flags |= vk::CommandBufferUsageFlagBits::eRenderPassContinue;
+  }
+  begin_info.pInheritanceInfo = &inheritance;
+
+  jobs_.parallel_for(item_count, thread_count, [&](uint32_t chunk, uint32_t begin, uint32_t end, uint32_t worker) {
+    // only this worker ever touches its pool, no locking needed
+    vk::CommandBuffer command_buffer = next_buffer(frame_pools[worker]);
+    command_buffer.begin(begin_info);
+    record_function(command_buffer, begin, end);
+    command_buffer.end();
+    recorded_[chunk] = command_buffer;
+  });
+
+  // chunk order keeps the submission deterministic regardless of scheduling
+  primary.executeCommands(recorded_);
+}
+
+uint32_t ParallelRecorder::thread_count() const {
+  return jobs_.worker_count();
+}
+
+vk::CommandBuffer ParallelRecorder::next_buffer(WorkerPool& pool) {
+  if (pool.Used == pool.Buffers.size()) {
+    vk::CommandBufferAllocateInfo alloc_info{};
+    alloc_info.commandPool = pool.Pool;
+    alloc_info.level = vk::CommandBufferLevel::eSecondary;
+    alloc_info.commandBufferCount = 1;
+    pool.Buffers.push_back(device_.allocateCommandBuffers(alloc_info)[0]);
+  }
+
+  return pool.Buffers[pool.Used++];
+}
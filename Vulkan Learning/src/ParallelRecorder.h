@@ -0,0 +1,44 @@
+#pragma once
+#include "Headers.h"
+#include "JobSystem.h"
+
+#include <functional>
+
+// Records secondary command buffers on the JobSystem workers and stitches
+// them into a primary buffer. Every worker owns one command pool per frame in
+// flight, so recording never takes a lock and a whole frame's buffers are
+// recycled with a single pool reset once that frame's fence has signaled.
+class ParallelRecorder {
+public:
+  // records items [begin, end) into a secondary command buffer
+  using RecordFunction = std::function<void(vk::CommandBuffer command_buffer, uint32_t begin, uint32_t end)>;
+
+  ParallelRecorder(const vk::Device& device, uint32_t queue_family, uint32_t frames_in_flight, JobSystem& jobs, const bool debug);
+  ~ParallelRecorder();
+
+  // resets every worker pool of the frame, only call once its fence has signaled
+  void begin_frame(uint32_t frame_index);
+
+  // splits the items across `thread_count` workers (0 uses all of them) and
+  // executes the resulting secondary buffers in order inside `primary`
+  void record(vk::CommandBuffer primary, uint32_t item_count, const RecordFunction& record_function,
+    const vk::CommandBufferInheritanceInfo& inheritance, uint32_t thread_count = 0);
+
+  uint32_t thread_count() const;
+
+private:
+  struct WorkerPool {
+    vk::CommandPool Pool;
+    std::vector<vk::CommandBuffer> Buffers;
+    uint32_t Used = 0;
+  };
+
+  vk::CommandBuffer next_buffer(WorkerPool& pool);
+
+  vk::Device device_;
+  JobSystem& jobs_;
+  // [frame in flight][worker]
+  std::vector<std::vector<WorkerPool>> pools_;
+  uint32_t current_frame_ = 0;
+  std::vector<vk::CommandBuffer> recorded_;
+};
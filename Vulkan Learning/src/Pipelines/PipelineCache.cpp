@@ -0,0 +1,218 @@
+#include "Pipelines/PipelineCache.h"
+
+#include <filesystem>
+#include <fstream>
+
+PipelineCache::PipelineCache(const vk::PhysicalDevice& physical_device, const vk::Device& device, const std::string& path, const bool debug)
+  : PipelineCache(physical_device, device, path, read_file(path), debug) {
+}
+
+PipelineCache::PipelineCache(const vk::PhysicalDevice& physical_device, const vk::Device& device, const std::string& path,
+  std::vector<uint8_t> data, const bool debug) {
+  device_ = device;
+  path_ = path;
+  debug_ = debug;
+  props_ = physical_device.getProperties();
+
+  // creation feedback is core in 1.3, the instance caps what the device may use
+  uint32_t api_version = (std::min)(props_.apiVersion, vk::enumerateInstanceVersion());
+  feedback_supported_ = api_version >= VK_API_VERSION_1_3;
+  stats_.FeedbackAvailable = feedback_supported_;
+
+  if (path_.empty()) {
+    if (debug_) {
+      LOG_DEBUG("Pipeline cache disabled");
+    }
+    return;
+  }
+
+  if (!data.empty()) {
+    std::string problem = validate(data, props_);
+    if (problem.empty()) {
+      stats_.WarmStart = true;
+      stats_.LoadedBytes = data.size();
+    }
+    else {
+      if (debug_) {
+        LOG_DEBUG("Discarding pipeline cache " << path_ << ": " << problem);
+      }
+      data.clear();
+    }
+  }
+
+  vk::PipelineCacheCreateInfo create_info{};
+  create_info.initialDataSize = data.size();
+  create_info.pInitialData = data.empty() ? nullptr : data.data();
+
+  try {
+    cache_ = device_.createPipelineCache(create_info);
+  }
+  catch (vk::SystemError e) {
+    // the driver may still refuse data that passed our header checks, start cold then
+    create_info.initialDataSize = 0;
+    create_info.pInitialData = nullptr;
+    cache_ = device_.createPipelineCache(create_info);
+    stats_.WarmStart = false;
+    stats_.LoadedBytes = 0;
+  }
+
+  if (debug_) {
+    LOG_DEBUG("Pipeline cache " << (stats_.WarmStart ? "warm" : "cold") << " start, "
+      << stats_.LoadedBytes << " bytes loaded from " << path_);
+  }
+}
+
+std::vector<uint8_t> PipelineCache::read_file(const std::string& path) {
+  std::vector<uint8_t> data;
+  if (path.empty()) {
+    return data;
+  }
+
+  std::ifstream file(path, std::ios::binary | std::ios::ate);
+  if (file) {
+    data.resize(static_cast<size_t>(file.tellg()));
+    file.seekg(0);
+    file.read(reinterpret_cast<char*>(data.data()), data.size());
+  }
+  return data;
+}
+
+PipelineCache::~PipelineCache() {
+  if (cache_) {
+    device_.destroyPipelineCache(cache_);
+  }
+}
+
+void PipelineCache::save() {
+  if (!cache_) {
+    return;
+  }
+
+  std::vector<uint8_t> data = device_.getPipelineCacheData(cache_);
+
+  // write next to the target and rename, so a crash never leaves a torn cache behind
+  std::string temp_path = path_ + ".tmp";
+  {
+    std::ofstream file(temp_path, std::ios::binary | std::ios::trunc);
+    if (!file) {
+      LOG_WARN("Failed to write pipeline cache " << temp_path);
+      return;
+    }
+    file.write(reinterpret_cast<const char*>(data.data()), data.size());
+  }
+
+  std::error_code error;
+  std::filesystem::rename(temp_path, path_, error);
+  if (error) {
+    LOG_WARN("Failed to replace pipeline cache " << path_ << ": " << error.message());
+  }
+  else if (debug_) {
+    LOG_DEBUG("Saved " << data.size() << " bytes of pipeline cache to " << path_);
+  }
+}
+
+vk::PipelineCache PipelineCache::get() const {
+  return cache_;
+}
+
+vk::Pipeline PipelineCache::create_graphics_pipeline(vk::GraphicsPipelineCreateInfo create_info) {
+  vk::PipelineCreationFeedback feedback{};
+  std::vector<vk::PipelineCreationFeedback> stage_feedback(create_info.stageCount);
+  vk::PipelineCreationFeedbackCreateInfo feedback_info{};
+  if (feedback_supported_) {
+    feedback_info.pPipelineCreationFeedback = &feedback;
+    feedback_info.pipelineStageCreationFeedbackCount = create_info.stageCount;
+    feedback_info.pPipelineStageCreationFeedbacks = stage_feedback.data();
+    feedback_info.pNext = create_info.pNext;
+    create_info.pNext = &feedback_info;
+  }
+
+  auto start = std::chrono::steady_clock::now();
+  vk::Pipeline pipeline = device_.createGraphicsPipeline(cache_, create_info).value;
+  record(feedback, start);
+  return pipeline;
+}
+
+vk::Pipeline PipelineCache::create_compute_pipeline(vk::ComputePipelineCreateInfo create_info) {
+  vk::PipelineCreationFeedback feedback{};
+  vk::PipelineCreationFeedback stage_feedback{};
+  vk::PipelineCreationFeedbackCreateInfo feedback_info{};
+  if (feedback_supported_) {
+    feedback_info.pPipelineCreationFeedback = &feedback;
+    feedback_info.pipelineStageCreationFeedbackCount = 1;
+    feedback_info.pPipelineStageCreationFeedbacks = &stage_feedback;
+    feedback_info.pNext = create_info.pNext;
+    create_info.pNext = &feedback_info;
+  }
+
+  auto start = std::chrono::steady_clock::now();
+  vk::Pipeline pipeline = device_.createComputePipeline(cache_, create_info).value;
+  record(feedback, start);
+  return pipeline;
+}
+
+PipelineCacheStats PipelineCache::stats() const {
+  std::lock_guard<std::mutex> lock(stats_mutex_);
+  return stats_;
+}
+
+void PipelineCache::report() const {
+  PipelineCacheStats stats = this->stats();
+
+  std::cout << "Pipeline cache (" << (stats.WarmStart ? "warm" : "cold") << "): " << stats.Pipelines
+    << " pipelines in " << stats.TotalMs << "ms";
+  if (stats.FeedbackAvailable && stats.Pipelines > 0) {
+    uint32_t misses = stats.Pipelines - stats.CacheHits;
+    std::cout << ", hit rate " << 100.0 * stats.CacheHits / stats.Pipelines << "%"
+      << ", avg hit " << (stats.CacheHits ? stats.HitMs / stats.CacheHits : 0.0) << "ms"
+      << ", avg miss " << (misses ? stats.MissMs / misses : 0.0) << "ms";
+  }
+  else if (!stats.FeedbackAvailable) {
+    std::cout << ", hit rate unavailable without creation feedback";
+  }
+  std::cout << std::endl;
+}
+
+std::string PipelineCache::validate(const std::vector<uint8_t>& data, const vk::PhysicalDeviceProperties& props) {
+  VkPipelineCacheHeaderVersionOne header;
+  if (data.size() < sizeof(header)) {
+    return "file is smaller than the cache header";
+  }
+  memcpy(&header, data.data(), sizeof(header));
+
+  if (header.headerSize < sizeof(header) || header.headerSize > data.size()) {
+    return "bad header size";
+  }
+  if (header.headerVersion != VK_PIPELINE_CACHE_HEADER_VERSION_ONE) {
+    return "unknown header version";
+  }
+  if (header.vendorID != props.vendorID) {
+    return "vendor id mismatch";
+  }
+  if (header.deviceID != props.deviceID) {
+    return "device id mismatch";
+  }
+  if (memcmp(header.pipelineCacheUUID, props.pipelineCacheUUID.data(), VK_UUID_SIZE) != 0) {
+    return "pipeline cache uuid mismatch, driver changed";
+  }
+
+  return "";
+}
+
+void PipelineCache::record(vk::PipelineCreationFeedback feedback, std::chrono::steady_clock::time_point start) {
+  double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+  std::lock_guard<std::mutex> lock(stats_mutex_);
+  ++stats_.Pipelines;
+  stats_.TotalMs += ms;
+
+  if (feedback.flags & vk::PipelineCreationFeedbackFlagBits::eValid) {
+    if (feedback.flags & vk::PipelineCreationFeedbackFlagBits::eApplicationPipelineCacheHit) {
+      ++stats_.CacheHits;
+      stats_.HitMs += ms;
+    }
+    else {
+      stats_.MissMs += ms;
+    }
+  }
+}
@@ -0,0 +1,60 @@
+#pragma once
+#include "Headers.h"
+
+#include <chrono>
+#include <mutex>
+#include <string>
+
+struct PipelineCacheStats {
+  // a valid cache file was loaded at startup
+  bool WarmStart = false;
+  size_t LoadedBytes = 0;
+  uint32_t Pipelines = 0;
+  // only counted when the driver reports creation feedback
+  uint32_t CacheHits = 0;
+  bool FeedbackAvailable = false;
+  double HitMs = 0.0;
+  double MissMs = 0.0;
+  double TotalMs = 0.0;
+};
+
+// vk::PipelineCache that is loaded from disk at startup and written back on
+// shutdown. The file header is checked against the physical device, so a
+// cache from another GPU or driver is dropped instead of handed to the driver.
+class PipelineCache {
+public:
+  // an empty path disables the cache entirely, which gives the cold baseline
+  PipelineCache(const vk::PhysicalDevice& physical_device, const vk::Device& device, const std::string& path, const bool debug);
+  // data is the file at path as read by read_file, so the disk read can overlap device creation
+  PipelineCache(const vk::PhysicalDevice& physical_device, const vk::Device& device, const std::string& path,
+    std::vector<uint8_t> data, const bool debug);
+  ~PipelineCache();
+
+  void save();
+  vk::PipelineCache get() const;
+
+  // create through the cache while timing the call and collecting hit feedback
+  vk::Pipeline create_graphics_pipeline(vk::GraphicsPipelineCreateInfo create_info);
+  vk::Pipeline create_compute_pipeline(vk::ComputePipelineCreateInfo create_info);
+
+  PipelineCacheStats stats() const;
+  void report() const;
+
+  // the whole file, empty when the path is empty or the file is missing
+  static std::vector<uint8_t> read_file(const std::string& path);
+  // returns an empty string when the data may be passed to the driver
+  static std::string validate(const std::vector<uint8_t>& data, const vk::PhysicalDeviceProperties& props);
+
+private:
+  void record(vk::PipelineCreationFeedback feedback, std::chrono::steady_clock::time_point start);
+
+  vk::Device device_;
+  vk::PipelineCache cache_;
+  vk::PhysicalDeviceProperties props_;
+  std::string path_;
+  bool feedback_supported_ = false;
+  bool debug_;
+
+  PipelineCacheStats stats_;
+  mutable std::mutex stats_mutex_;
+};
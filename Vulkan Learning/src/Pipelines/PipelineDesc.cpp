@@ -0,0 +1,80 @@
+#include "Pipelines/PipelineDesc.h"
+#include "Hasher.h"
+
+namespace {
+  void add_stage(Hasher& hasher, const ShaderStageDesc& stage) {
+    hasher.add(stage.Stage);
+    hasher.add_handle(stage.Module);
+    hasher.add(stage.Entry);
+  }
+}
+
+uint64_t GraphicsPipelineDesc::hash() const {
+  Hasher hasher;
+
+  hasher.add(Stages.size());
+  for (const ShaderStageDesc& stage : Stages) {
+    add_stage(hasher, stage);
+  }
+
+  hasher.add(VertexBindings.size());
+  for (const vk::VertexInputBindingDescription& binding : VertexBindings) {
+    hasher.add(binding.binding);
+    hasher.add(binding.stride);
+    hasher.add(binding.inputRate);
+  }
+  hasher.add(VertexAttributes.size());
+  for (const vk::VertexInputAttributeDescription& attribute : VertexAttributes) {
+    hasher.add(attribute.location);
+    hasher.add(attribute.binding);
+    hasher.add(attribute.format);
+    hasher.add(attribute.offset);
+  }
+  hasher.add(Topology);
+
+  hasher.add(PolygonMode);
+  hasher.add(static_cast<VkCullModeFlags>(CullMode));
+  hasher.add(FrontFace);
+  hasher.add(DepthBias);
+  hasher.add(Samples);
+
+  hasher.add(DepthTest);
+  hasher.add(DepthWrite);
+  hasher.add(DepthCompare);
+
+  hasher.add(Blend.size());
+  for (const vk::PipelineColorBlendAttachmentState& blend : Blend) {
+    hasher.add(blend.blendEnable);
+    hasher.add(blend.srcColorBlendFactor);
+    hasher.add(blend.dstColorBlendFactor);
+    hasher.add(blend.colorBlendOp);
+    hasher.add(blend.srcAlphaBlendFactor);
+    hasher.add(blend.dstAlphaBlendFactor);
+    hasher.add(blend.alphaBlendOp);
+    hasher.add(static_cast<VkColorComponentFlags>(blend.colorWriteMask));
+  }
+  hasher.add(DynamicStates.size());
+  for (vk::DynamicState state : DynamicStates) {
+    hasher.add(state);
+  }
+
+  hasher.add_handle(Layout);
+  hasher.add_handle(RenderPass);
+  hasher.add(Subpass);
+  hasher.add(ColorFormats.size());
+  for (vk::Format format : ColorFormats) {
+    hasher.add(format);
+  }
+  hasher.add(DepthFormat);
+
+  return hasher.value();
+}
+
+uint64_t ComputePipelineDesc::hash() const {
+  Hasher hasher;
+  // keeps a compute desc from colliding with a graphics desc of the same stage
+  hasher.add(vk::PipelineBindPoint::eCompute);
+  add_stage(hasher, Stage);
+  hasher.add_handle(Layout);
+  return hasher.value();
+}
@@ -0,0 +1,50 @@
+#pragma once
+#include "Headers.h"
+
+#include <string>
+
+struct ShaderStageDesc {
+  vk::ShaderStageFlagBits Stage = vk::ShaderStageFlagBits::eVertex;
+  vk::ShaderModule Module;
+  std::string Entry = "main";
+};
+
+// Complete, self-owned graphics pipeline state. Unlike vk::GraphicsPipelineCreateInfo
+// it holds no pointers, so it can be hashed and handed to another thread.
+struct GraphicsPipelineDesc {
+  std::vector<ShaderStageDesc> Stages;
+
+  std::vector<vk::VertexInputBindingDescription> VertexBindings;
+  std::vector<vk::VertexInputAttributeDescription> VertexAttributes;
+  vk::PrimitiveTopology Topology = vk::PrimitiveTopology::eTriangleList;
+
+  vk::PolygonMode PolygonMode = vk::PolygonMode::eFill;
+  vk::CullModeFlags CullMode = vk::CullModeFlagBits::eBack;
+  vk::FrontFace FrontFace = vk::FrontFace::eCounterClockwise;
+  bool DepthBias = false;
+  vk::SampleCountFlagBits Samples = vk::SampleCountFlagBits::e1;
+
+  bool DepthTest = false;
+  bool DepthWrite = false;
+  vk::CompareOp DepthCompare = vk::CompareOp::eLessOrEqual;
+
+  // one per color attachment
+  std::vector<vk::PipelineColorBlendAttachmentState> Blend;
+  std::vector<vk::DynamicState> DynamicStates = { vk::DynamicState::eViewport, vk::DynamicState::eScissor };
+
+  vk::PipelineLayout Layout;
+  vk::RenderPass RenderPass;
+  uint32_t Subpass = 0;
+  // attachment formats for dynamic rendering, only used when RenderPass is null
+  std::vector<vk::Format> ColorFormats;
+  vk::Format DepthFormat = vk::Format::eUndefined;
+
+  uint64_t hash() const;
+};
+
+struct ComputePipelineDesc {
+  ShaderStageDesc Stage{ vk::ShaderStageFlagBits::eCompute };
+  vk::PipelineLayout Layout;
+
+  uint64_t hash() const;
+};
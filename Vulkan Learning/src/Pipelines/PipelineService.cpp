@@ -0,0 +1,223 @@
+#include "Pipelines/PipelineService.h"
+
+PipelineHandle::PipelineHandle(std::shared_ptr<Entry> entry)
+  : entry_(std::move(entry)) {
+}
+
+bool PipelineHandle::valid() const {
+  return entry_ != nullptr;
+}
+
+bool PipelineHandle::ready() const {
+  return entry_ && entry_->Status.load(std::memory_order_acquire) == State::Ready;
+}
+
+bool PipelineHandle::failed() const {
+  return entry_ && entry_->Status.load(std::memory_order_acquire) == State::Failed;
+}
+
+vk::Pipeline PipelineHandle::get_or(vk::Pipeline fallback) const {
+  // Pipeline is written before the release store of Ready
+  return ready() ? entry_->Pipeline : fallback;
+}
+
+uint64_t PipelineHandle::key() const {
+  return entry_ ? entry_->Key : 0;
+}
+
+PipelineService::PipelineService(const vk::Device& device, PipelineCache& cache, uint32_t worker_count, const bool debug)
+  : device_(device), cache_(cache), debug_(debug) {
+  if (worker_count == 0) {
+    worker_count = (std::max)(1u, std::thread::hardware_concurrency() / 2);
+  }
+  jobs_ = new JobSystem(worker_count);
+
+  if (debug_) {
+    LOG_DEBUG("Pipeline service compiling on " << worker_count << " threads");
+  }
+}
+
+PipelineService::~PipelineService() {
+  wait_idle();
+  delete jobs_;
+
+  for (auto& [key, entry] : entries_) {
+    if (entry->Status == PipelineHandle::State::Ready) {
+      device_.destroyPipeline(entry->Pipeline);
+    }
+  }
+}
+
+PipelineHandle PipelineService::request_graphics(const GraphicsPipelineDesc& desc) {
+  PipelineCache& cache = cache_;
+  return request(desc.hash(), [&cache, desc]() { return compile_graphics(cache, desc); });
+}
+
+PipelineHandle PipelineService::request_compute(const ComputePipelineDesc& desc) {
+  PipelineCache& cache = cache_;
+  return request(desc.hash(), [&cache, desc]() { return compile_compute(cache, desc); });
+}
+
+PipelineHandle PipelineService::request(uint64_t key, Compile compile) {
+  std::shared_ptr<PipelineHandle::Entry> entry;
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    ++stats_.Requests;
+
+    // 64-bit state hashes are trusted as identities, a collision would hand back the other pipeline
+    auto it = entries_.find(key);
+    if (it != entries_.end()) {
+      ++stats_.Hits;
+      return PipelineHandle(it->second);
+    }
+
+    entry = std::make_shared<PipelineHandle::Entry>();
+    entry->Key = key;
+    entry->Requested = std::chrono::steady_clock::now();
+    entries_.emplace(key, entry);
+
+    ++stats_.QueueDepth;
+    stats_.MaxQueueDepth = (std::max)(stats_.MaxQueueDepth, stats_.QueueDepth);
+  }
+
+  jobs_->submit([this, entry, compile = std::move(compile)](uint32_t worker) {
+    auto start = std::chrono::steady_clock::now();
+    vk::Pipeline pipeline;
+    bool failed = false;
+    try {
+      pipeline = compile();
+    }
+    catch (const std::exception& e) {
+      failed = true;
+      LOG_ERROR("Pipeline " << std::hex << entry->Key << std::dec << " failed to compile: " << e.what());
+    }
+    catch (...) {
+      failed = true;
+      LOG_ERROR("Pipeline " << std::hex << entry->Key << std::dec << " failed to compile");
+    }
+    // always reached, the queue depth has to drop or wait_idle never returns
+    finish(entry, pipeline, failed, start);
+  });
+
+  return PipelineHandle(entry);
+}
+
+void PipelineService::finish(const std::shared_ptr<PipelineHandle::Entry>& entry, vk::Pipeline pipeline, bool failed,
+  std::chrono::steady_clock::time_point compile_start) {
+  auto now = std::chrono::steady_clock::now();
+  double compile_ms = std::chrono::duration<double, std::milli>(now - compile_start).count();
+  double latency_ms = std::chrono::duration<double, std::milli>(now - entry->Requested).count();
+
+  entry->Pipeline = pipeline;
+  entry->Status.store(failed ? PipelineHandle::State::Failed : PipelineHandle::State::Ready, std::memory_order_release);
+
+  std::lock_guard<std::mutex> lock(mutex_);
+  ++stats_.Compiles;
+  if (failed) {
+    ++stats_.Failures;
+  }
+  stats_.TotalCompileMs += compile_ms;
+  stats_.WorstCompileMs = (std::max)(stats_.WorstCompileMs, compile_ms);
+  stats_.WorstLatencyMs = (std::max)(stats_.WorstLatencyMs, latency_ms);
+  if (--stats_.QueueDepth == 0) {
+    idle_.notify_all();
+  }
+}
+
+void PipelineService::wait_idle() {
+  std::unique_lock<std::mutex> lock(mutex_);
+  idle_.wait(lock, [this] { return stats_.QueueDepth == 0; });
+}
+
+vk::Pipeline PipelineService::compile_graphics(PipelineCache& cache, const GraphicsPipelineDesc& desc) {
+  std::vector<vk::PipelineShaderStageCreateInfo> stages;
+  for (const ShaderStageDesc& stage : desc.Stages) {
+    stages.push_back(vk::PipelineShaderStageCreateInfo{ vk::PipelineShaderStageCreateFlags{}, stage.Stage, stage.Module, stage.Entry.c_str() });
+  }
+
+  vk::PipelineVertexInputStateCreateInfo vertex_input{};
+  vertex_input.vertexBindingDescriptionCount = static_cast<uint32_t>(desc.VertexBindings.size());
+  vertex_input.pVertexBindingDescriptions = desc.VertexBindings.data();
+  vertex_input.vertexAttributeDescriptionCount = static_cast<uint32_t>(desc.VertexAttributes.size());
+  vertex_input.pVertexAttributeDescriptions = desc.VertexAttributes.data();
+
+  vk::PipelineInputAssemblyStateCreateInfo input_assembly{};
+  input_assembly.topology = desc.Topology;
+
+  // viewport and scissor are dynamic, only the counts are baked in
+  vk::PipelineViewportStateCreateInfo viewport{};
+  viewport.viewportCount = 1;
+  viewport.scissorCount = 1;
+
+  vk::PipelineRasterizationStateCreateInfo rasterization{};
+  rasterization.polygonMode = desc.PolygonMode;
+  rasterization.cullMode = desc.CullMode;
+  rasterization.frontFace = desc.FrontFace;
+  rasterization.depthBiasEnable = desc.DepthBias;
+  rasterization.lineWidth = 1.0f;
+
+  vk::PipelineMultisampleStateCreateInfo multisample{};
+  multisample.rasterizationSamples = desc.Samples;
+
+  vk::PipelineDepthStencilStateCreateInfo depth_stencil{};
+  depth_stencil.depthTestEnable = desc.DepthTest;
+  depth_stencil.depthWriteEnable = desc.DepthWrite;
+  depth_stencil.depthCompareOp = desc.DepthCompare;
+
+  vk::PipelineColorBlendStateCreateInfo blend{};
+  blend.attachmentCount = static_cast<uint32_t>(desc.Blend.size());
+  blend.pAttachments = desc.Blend.data();
+
+  vk::PipelineDynamicStateCreateInfo dynamic{};
+  dynamic.dynamicStateCount = static_cast<uint32_t>(desc.DynamicStates.size());
+  dynamic.pDynamicStates = desc.DynamicStates.data();
+
+  vk::GraphicsPipelineCreateInfo create_info{};
+  create_info.stageCount = static_cast<uint32_t>(stages.size());
+  create_info.pStages = stages.data();
+  create_info.pVertexInputState = &vertex_input;
+  create_info.pInputAssemblyState = &input_assembly;
+  create_info.pViewportState = &viewport;
+  create_info.pRasterizationState = &rasterization;
+  create_info.pMultisampleState = &multisample;
+  create_info.pDepthStencilState = &depth_stencil;
+  create_info.pColorBlendState = &blend;
+  create_info.pDynamicState = &dynamic;
+  create_info.layout = desc.Layout;
+  create_info.renderPass = desc.RenderPass;
+  create_info.subpass = desc.Subpass;
+
+  vk::PipelineRenderingCreateInfo rendering{};
+  if (!desc.RenderPass) {
+    rendering.colorAttachmentCount = static_cast<uint32_t>(desc.ColorFormats.size());
+    rendering.pColorAttachmentFormats = desc.ColorFormats.data();
+    rendering.depthAttachmentFormat = desc.DepthFormat;
+    create_info.pNext = &rendering;
+  }
+
+  return cache.create_graphics_pipeline(create_info);
+}
+
+vk::Pipeline PipelineService::compile_compute(PipelineCache& cache, const ComputePipelineDesc& desc) {
+  vk::ComputePipelineCreateInfo create_info{};
+  create_info.stage = vk::PipelineShaderStageCreateInfo{ vk::PipelineShaderStageCreateFlags{}, desc.Stage.Stage,
+    desc.Stage.Module, desc.Stage.Entry.c_str() };
+  create_info.layout = desc.Layout;
+
+  return cache.create_compute_pipeline(create_info);
+}
+
+PipelineServiceStats PipelineService::stats() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return stats_;
+}
+
+void PipelineService::report() const {
+  PipelineServiceStats stats = this->stats();
+
+  std::cout << "Pipeline service: " << stats.Requests << " requests, hit rate "
+    << (stats.Requests ? 100.0 * stats.Hits / stats.Requests : 0.0) << "%, "
+    << stats.Compiles << " compiles (" << stats.Failures << " failed), queue depth " << stats.QueueDepth
+    << " (max " << stats.MaxQueueDepth << "), avg compile " << (stats.Compiles ? stats.TotalCompileMs / stats.Compiles : 0.0)
+    << "ms, worst compile " << stats.WorstCompileMs << "ms, worst request to ready " << stats.WorstLatencyMs << "ms" << std::endl;
+}
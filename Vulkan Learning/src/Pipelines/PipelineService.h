@@ -0,0 +1,100 @@
+#pragma once
+#include "Headers.h"
+#include "JobSystem.h"
+#include "Pipelines/PipelineCache.h"
+#include "Pipelines/PipelineDesc.h"
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+
+struct PipelineServiceStats {
+  uint64_t Requests = 0;
+  // requests that found an entry, whether it was still compiling or ready
+  uint64_t Hits = 0;
+  uint64_t Compiles = 0;
+  uint64_t Failures = 0;
+  uint32_t QueueDepth = 0;
+  uint32_t MaxQueueDepth = 0;
+  double TotalCompileMs = 0.0;
+  double WorstCompileMs = 0.0;
+  // request to ready, includes time spent waiting in the queue
+  double WorstLatencyMs = 0.0;
+};
+
+// Shared state of one pipeline, cheap to poll from the render thread.
+class PipelineHandle {
+public:
+  PipelineHandle() = default;
+
+  bool valid() const;
+  bool ready() const;
+  bool failed() const;
+  // the compiled pipeline, or fallback while it compiles or after it failed
+  vk::Pipeline get_or(vk::Pipeline fallback) const;
+  uint64_t key() const;
+
+private:
+  friend class PipelineService;
+
+  enum class State : uint8_t {
+    Pending,
+    Ready,
+    Failed
+  };
+
+  struct Entry {
+    uint64_t Key = 0;
+    std::atomic<State> Status{ State::Pending };
+    vk::Pipeline Pipeline;
+    std::chrono::steady_clock::time_point Requested;
+  };
+
+  explicit PipelineHandle(std::shared_ptr<Entry> entry);
+
+  std::shared_ptr<Entry> entry_;
+};
+
+// Compiles pipelines off the render thread. Requests are keyed by a hash of
+// the full pipeline state, so asking for the same state twice returns the same
+// handle, and misses compile on a dedicated worker pool through the
+// PipelineCache. Until a handle is ready the caller draws with a fallback.
+class PipelineService {
+public:
+  // 0 worker threads uses half the hardware threads, leaving the rest to frame recording
+  PipelineService(const vk::Device& device, PipelineCache& cache, uint32_t worker_count, const bool debug);
+  // waits for compiles still in flight, then destroys every pipeline it created
+  ~PipelineService();
+
+  PipelineHandle request_graphics(const GraphicsPipelineDesc& desc);
+  PipelineHandle request_compute(const ComputePipelineDesc& desc);
+
+  // blocks until the compile queue is empty, e.g. behind a loading screen
+  void wait_idle();
+
+  PipelineServiceStats stats() const;
+  void report() const;
+
+private:
+  using Compile = std::function<vk::Pipeline()>;
+
+  PipelineHandle request(uint64_t key, Compile compile);
+  void finish(const std::shared_ptr<PipelineHandle::Entry>& entry, vk::Pipeline pipeline, bool failed,
+    std::chrono::steady_clock::time_point compile_start);
+
+  static vk::Pipeline compile_graphics(PipelineCache& cache, const GraphicsPipelineDesc& desc);
+  static vk::Pipeline compile_compute(PipelineCache& cache, const ComputePipelineDesc& desc);
+
+  vk::Device device_;
+  PipelineCache& cache_;
+  JobSystem* jobs_ = nullptr;
+  bool debug_;
+
+  std::unordered_map<uint64_t, std::shared_ptr<PipelineHandle::Entry>> entries_;
+  PipelineServiceStats stats_;
+  mutable std::mutex mutex_;
+  std::condition_variable idle_;
+};
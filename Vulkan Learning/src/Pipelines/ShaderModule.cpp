@@ -0,0 +1,23 @@
+#include "Pipelines/ShaderModule.h"
+#include "Shaders/ShaderCompiler.h"
+
+vk::ShaderModule load_shader_module(const vk::Device& device, const std::string& path) {
+  std::vector<uint32_t> code = read_spirv(path);
+  if (code.empty()) {
+    throw std::runtime_error("Failed to load shader " + path + "!");
+  }
+  return create_shader_module(device, code, path);
+}
+
+vk::ShaderModule create_shader_module(const vk::Device& device, const std::vector<uint32_t>& code, const std::string& name) {
+  vk::ShaderModuleCreateInfo create_info{};
+  create_info.codeSize = code.size() * sizeof(uint32_t);
+  create_info.pCode = code.data();
+
+  try {
+    return device.createShaderModule(create_info);
+  }
+  catch (vk::SystemError e) {
+    throw std::runtime_error("Failed to create shader module " + name + "!");
+  }
+}
@@ -0,0 +1,11 @@
+#pragma once
+#include "Headers.h"
+
+#include <string>
+
+// Loads a SPIR-V binary produced by the glslc build step, throws when it is
+// missing or not SPIR-V.
+vk::ShaderModule load_shader_module(const vk::Device& device, const std::string& path);
+
+// name only appears in the error
+vk::ShaderModule create_shader_module(const vk::Device& device, const std::vector<uint32_t>& code, const std::string& name);
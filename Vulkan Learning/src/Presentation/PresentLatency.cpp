@@ -0,0 +1,96 @@
+#include "Presentation/PresentLatency.h"
+
+PresentLatency::PresentLatency(const vk::Device& device, const vk::DispatchLoaderDynamic* dispatch, size_t window)
+  : device_(device), dispatch_(dispatch) {
+  samples_.reserve(window);
+  last_input_ = Clock::now();
+}
+
+void PresentLatency::mark_input() {
+  last_input_ = Clock::now();
+}
+
+uint64_t PresentLatency::on_present(vk::SwapchainKHR swapchain) {
+  if (!dispatch_) {
+    add_sample(last_input_, Clock::now());
+    return 0;
+  }
+
+  uint64_t id = next_id_++;
+  pending_.push_back({ swapchain, id, last_input_ });
+  return id;
+}
+
+void PresentLatency::poll() {
+  while (!pending_.empty()) {
+    const Pending& pending = pending_.front();
+    vk::Result result = vk::Result::eTimeout;
+    try {
+      result = device_.waitForPresentKHR(pending.Swapchain, pending.Id, 0, *dispatch_);
+    }
+    catch (const vk::SystemError&) {
+      // out of date or lost surface, the present never completes on this swapchain
+      pending_.pop_front();
+      continue;
+    }
+    // presents complete in order, so the first one still queued ends the scan
+    if (result == vk::Result::eTimeout) {
+      return;
+    }
+    add_sample(pending.Input, Clock::now());
+    pending_.pop_front();
+  }
+}
+
+void PresentLatency::forget(vk::SwapchainKHR swapchain) {
+  std::deque<Pending> kept;
+  for (const Pending& pending : pending_) {
+    if (pending.Swapchain != swapchain) {
+      kept.push_back(pending);
+    }
+  }
+  pending_.swap(kept);
+}
+
+bool PresentLatency::uses_present_wait() const {
+  return dispatch_ != nullptr;
+}
+
+void PresentLatency::add_sample(Clock::time_point input, Clock::time_point end) {
+  double ms = std::chrono::duration<double, std::milli>(end - input).count();
+  if (samples_.size() < samples_.capacity()) {
+    samples_.push_back(ms);
+  }
+  else {
+    samples_[next_sample_] = ms;
+  }
+  next_sample_ = (next_sample_ + 1) % samples_.capacity();
+  ++total_samples_;
+}
+
+PresentLatencySummary PresentLatency::summarize() const {
+  PresentLatencySummary summary;
+  summary.Samples = total_samples_;
+  summary.Displayed = uses_present_wait();
+  if (samples_.empty()) {
+    return summary;
+  }
+
+  summary.MinMs = samples_[0];
+  summary.MaxMs = samples_[0];
+  for (double sample : samples_) {
+    summary.AvgMs += sample;
+    summary.MinMs = (std::min)(summary.MinMs, sample);
+    summary.MaxMs = (std::max)(summary.MaxMs, sample);
+  }
+  summary.AvgMs /= samples_.size();
+
+  return summary;
+}
+
+void PresentLatency::report() const {
+  PresentLatencySummary summary = summarize();
+
+  std::cout << "Input to " << (summary.Displayed ? "display" : "present call") << " latency: " << summary.AvgMs
+    << "ms (min " << summary.MinMs << ", max " << summary.MaxMs << ") over " << summary.Samples << " presents" << std::endl;
+}
@@ -0,0 +1,60 @@
+#pragma once
+#include "Headers.h"
+
+#include <chrono>
+#include <deque>
+
+struct PresentLatencySummary {
+  uint64_t Samples = 0;
+  double AvgMs = 0.0;
+  double MinMs = 0.0;
+  double MaxMs = 0.0;
+  // true when samples end at the display via VK_KHR_present_wait, false when they end at vkQueuePresentKHR
+  bool Displayed = false;
+};
+
+// Measures the time from the last input poll to the frame reaching the screen.
+//
+// With VK_KHR_present_id/present_wait every present is tagged with an id and
+// the ids are polled without blocking once per frame, so a sample is an upper
+// bound that is at most one frame late. Without them the sample ends when the
+// present is queued, which misses the compositor and scanout.
+class PresentLatency {
+public:
+  // dispatch must be initialized for device, null falls back to present call timing
+  PresentLatency(const vk::Device& device, const vk::DispatchLoaderDynamic* dispatch, size_t window = 240);
+
+  // called right after the window events were polled
+  void mark_input();
+  // returns the present id to chain with vk::PresentIdKHR, 0 when present wait is unavailable
+  uint64_t on_present(vk::SwapchainKHR swapchain);
+  // retires every present that has reached the display so far, never blocks
+  void poll();
+  // drops pending presents of a swapchain about to be destroyed
+  void forget(vk::SwapchainKHR swapchain);
+
+  bool uses_present_wait() const;
+  PresentLatencySummary summarize() const;
+  void report() const;
+
+private:
+  using Clock = std::chrono::steady_clock;
+
+  struct Pending {
+    vk::SwapchainKHR Swapchain;
+    uint64_t Id;
+    Clock::time_point Input;
+  };
+
+  void add_sample(Clock::time_point input, Clock::time_point end);
+
+  vk::Device device_;
+  const vk::DispatchLoaderDynamic* dispatch_;
+  Clock::time_point last_input_;
+  uint64_t next_id_ = 1;
+  std::deque<Pending> pending_;
+
+  std::vector<double> samples_;
+  size_t next_sample_ = 0;
+  uint64_t total_samples_ = 0;
+};
@@ -0,0 +1,304 @@
+#include "Profiling/GpuProfiler.h"
+
+#include <cmath>
+#include <fstream>
+#include <iomanip>
+
+GpuProfiler::GpuScope::GpuScope(GpuProfiler* profiler, vk::CommandBuffer command_buffer, const char* name)
+  : profiler_(profiler), command_buffer_(command_buffer), scope_(UINT32_MAX) {
+  if (profiler_) {
+    scope_ = profiler_->begin_gpu_scope(command_buffer_, name);
+  }
+}
+
+GpuProfiler::GpuScope::~GpuScope() {
+  if (profiler_) {
+    profiler_->end_gpu_scope(command_buffer_, scope_);
+  }
+}
+
+GpuProfiler::CpuScope::CpuScope(GpuProfiler* profiler, const char* name)
+  : profiler_(profiler), name_(name), start_(Clock::now()) {
+}
+
+GpuProfiler::CpuScope::~CpuScope() {
+  if (profiler_) {
+    profiler_->record_cpu(name_, start_, Clock::now());
+  }
+}
+
+GpuProfiler::GpuProfiler(const vk::PhysicalDevice& physical_device, const vk::Device& device, float timestamp_period,
+  uint32_t timestamp_valid_bits, uint32_t frames_in_flight, const vk::DispatchLoaderDynamic* dispatch,
+  const bool debug, uint32_t max_scopes, size_t history_events)
+  : device_(device), period_ns_(timestamp_period), max_scopes_(max_scopes), debug_(debug), history_events_(history_events) {
+  timestamp_mask_ = timestamp_valid_bits >= 64 ? UINT64_MAX : (uint64_t(1) << timestamp_valid_bits) - 1;
+
+  // steady_clock is CLOCK_MONOTONIC, any other host domain would need its own conversion
+  if (dispatch) {
+    std::vector<vk::TimeDomainEXT> domains = physical_device.getCalibrateableTimeDomainsEXT(*dispatch);
+    bool has_device = std::find(domains.begin(), domains.end(), vk::TimeDomainEXT::eDevice) != domains.end();
+    bool has_monotonic = std::find(domains.begin(), domains.end(), vk::TimeDomainEXT::eClockMonotonic) != domains.end();
+    if (has_device && has_monotonic) {
+      dispatch_ = dispatch;
+    }
+  }
+
+  slots_.resize(frames_in_flight);
+  names_.assign(static_cast<size_t>(frames_in_flight) * max_scopes_, nullptr);
+
+  // two timestamps per scope
+  vk::QueryPoolCreateInfo create_info{};
+  create_info.queryType = vk::QueryType::eTimestamp;
+  create_info.queryCount = frames_in_flight * max_scopes_ * 2;
+  try {
+    query_pool_ = device_.createQueryPool(create_info);
+  }
+  catch (vk::SystemError e) {
+    throw std::runtime_error("Failed to create timestamp query pool!");
+  }
+
+  if (debug_) {
+    LOG_DEBUG("GPU profiler: " << max_scopes_ << " scopes per frame, " << timestamp_period << "ns per tick, "
+      << (dispatch_ ? "calibrated" : "submit aligned") << " timeline");
+  }
+}
+
+GpuProfiler::~GpuProfiler() {
+  device_.destroyQueryPool(query_pool_);
+}
+
+void GpuProfiler::begin_frame(uint32_t frame) {
+  collect(frame);
+  current_frame_ = frame;
+  scope_count_ = 0;
+}
+
+void GpuProfiler::reset_queries(vk::CommandBuffer command_buffer) {
+  command_buffer.resetQueryPool(query_pool_, current_frame_ * max_scopes_ * 2, max_scopes_ * 2);
+}
+
+void GpuProfiler::mark_submit() {
+  FrameSlot& slot = slots_[current_frame_];
+  uint32_t scope_count = scope_count_.load();
+  if (scope_count > max_scopes_) {
+    dropped_scopes_ += scope_count - max_scopes_;
+  }
+  slot.ScopeCount = (std::min)(scope_count, max_scopes_);
+  slot.Submitted = true;
+  slot.SubmitUs = now_us(Clock::now());
+}
+
+uint32_t GpuProfiler::begin_gpu_scope(vk::CommandBuffer command_buffer, const char* name) {
+  uint32_t scope = scope_count_.fetch_add(1);
+  if (scope >= max_scopes_) {
+    return UINT32_MAX;
+  }
+
+  uint32_t query = (current_frame_ * max_scopes_ + scope) * 2;
+  names_[current_frame_ * max_scopes_ + scope] = name;
+  command_buffer.writeTimestamp(vk::PipelineStageFlagBits::eTopOfPipe, query_pool_, query);
+  return scope;
+}
+
+void GpuProfiler::end_gpu_scope(vk::CommandBuffer command_buffer, uint32_t scope) {
+  if (scope == UINT32_MAX) {
+    return;
+  }
+  uint32_t query = (current_frame_ * max_scopes_ + scope) * 2 + 1;
+  command_buffer.writeTimestamp(vk::PipelineStageFlagBits::eBottomOfPipe, query_pool_, query);
+}
+
+void GpuProfiler::record_cpu(const char* name, Clock::time_point start, Clock::time_point end) {
+  ProfileEvent event{};
+  event.Name = name;
+  event.StartUs = now_us(start);
+  event.DurationUs = std::chrono::duration<double, std::micro>(end - start).count();
+
+  std::lock_guard<std::mutex> lock(mutex_);
+  event.Track = cpu_track();
+  push_event(event, false);
+}
+
+void GpuProfiler::record_counter(const std::string& name, double value) {
+  ProfileCounter counter{ name, now_us(Clock::now()), value };
+
+  std::lock_guard<std::mutex> lock(mutex_);
+  counters_.push_back(std::move(counter));
+  if (counters_.size() > history_events_) {
+    counters_.pop_front();
+  }
+}
+
+void GpuProfiler::collect(uint32_t frame) {
+  FrameSlot& slot = slots_[frame];
+  if (!slot.Submitted) {
+    return;
+  }
+  slot.Submitted = false;
+  if (slot.ScopeCount == 0) {
+    return;
+  }
+
+  // the slot's fence has signaled, so anything not available now never will be
+  uint32_t first_query = frame * max_scopes_ * 2;
+  uint32_t query_count = slot.ScopeCount * 2;
+  vk::ResultValue<std::vector<uint64_t>> results = device_.getQueryPoolResults<uint64_t>(query_pool_, first_query,
+    query_count, query_count * sizeof(uint64_t), sizeof(uint64_t), vk::QueryResultFlagBits::e64);
+  if (results.result != vk::Result::eSuccess) {
+    return;
+  }
+  const std::vector<uint64_t>& ticks = results.value;
+
+  double offset_ns = calibrate();
+  if (std::isnan(offset_ns)) {
+    uint64_t first_tick = UINT64_MAX;
+    for (uint32_t scope = 0; scope < slot.ScopeCount; ++scope) {
+      first_tick = (std::min)(first_tick, ticks[scope * 2] & timestamp_mask_);
+    }
+    offset_ns = slot.SubmitUs * 1000.0 - first_tick * period_ns_;
+  }
+
+  std::lock_guard<std::mutex> lock(mutex_);
+  for (uint32_t scope = 0; scope < slot.ScopeCount; ++scope) {
+    uint64_t begin = ticks[scope * 2] & timestamp_mask_;
+    uint64_t end = ticks[scope * 2 + 1] & timestamp_mask_;
+    // the counter wrapped inside the scope
+    if (end < begin) {
+      continue;
+    }
+
+    ProfileEvent event{};
+    event.Name = names_[frame * max_scopes_ + scope];
+    event.Track = 0;
+    event.StartUs = (begin * period_ns_ + offset_ns) / 1000.0;
+    event.DurationUs = (end - begin) * period_ns_ / 1000.0;
+    push_event(event, true);
+  }
+}
+
+double GpuProfiler::calibrate() {
+  if (!dispatch_) {
+    return std::nan("");
+  }
+
+  std::array<vk::CalibratedTimestampInfoEXT, 2> infos{};
+  infos[0].timeDomain = vk::TimeDomainEXT::eDevice;
+  infos[1].timeDomain = vk::TimeDomainEXT::eClockMonotonic;
+  try {
+    std::pair<std::vector<uint64_t>, uint64_t> timestamps = device_.getCalibratedTimestampsEXT(infos, *dispatch_);
+    return static_cast<double>(timestamps.first[1]) - (timestamps.first[0] & timestamp_mask_) * period_ns_;
+  }
+  catch (vk::SystemError e) {
+    return std::nan("");
+  }
+}
+
+void GpuProfiler::push_event(const ProfileEvent& event, bool gpu) {
+  ProfileScopeStats& stats = (gpu ? gpu_stats_ : cpu_stats_)[event.Name];
+  ++stats.Count;
+  stats.TotalUs += event.DurationUs;
+  stats.MaxUs = (std::max)(stats.MaxUs, event.DurationUs);
+
+  events_.push_back(event);
+  if (events_.size() > history_events_) {
+    events_.pop_front();
+  }
+}
+
+uint32_t GpuProfiler::cpu_track() {
+  std::thread::id thread = std::this_thread::get_id();
+  auto it = std::find(threads_.begin(), threads_.end(), thread);
+  if (it == threads_.end()) {
+    threads_.push_back(thread);
+    return static_cast<uint32_t>(threads_.size());
+  }
+  return static_cast<uint32_t>(it - threads_.begin()) + 1;
+}
+
+double GpuProfiler::now_us(Clock::time_point time) {
+  return std::chrono::duration<double, std::micro>(time.time_since_epoch()).count();
+}
+
+bool GpuProfiler::calibrated() const {
+  return dispatch_ != nullptr;
+}
+
+std::map<std::string, ProfileScopeStats> GpuProfiler::gpu_stats() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return gpu_stats_;
+}
+
+void GpuProfiler::report() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+
+  auto print = [](const char* title, const std::map<std::string, ProfileScopeStats>& stats) {
+    std::cout << title << std::endl;
+    for (const auto& [name, scope] : stats) {
+      std::cout << "  " << std::left << std::setw(24) << name << std::right << std::fixed << std::setprecision(3)
+        << " avg " << std::setw(9) << scope.TotalUs / scope.Count / 1000.0 << "ms"
+        << "  max " << std::setw(9) << scope.MaxUs / 1000.0 << "ms"
+        << "  x" << scope.Count << std::defaultfloat << std::endl;
+    }
+  };
+  print("GPU scopes:", gpu_stats_);
+  print("CPU scopes:", cpu_stats_);
+  if (dropped_scopes_ != 0) {
+    std::cout << "  " << dropped_scopes_ << " GPU scopes dropped, raise max_scopes" << std::endl;
+  }
+}
+
+bool GpuProfiler::export_chrome_trace(const std::string& path) const {
+  std::ofstream file(path);
+  if (!file) {
+    LOG_WARN("Could not write trace to " << path);
+    return false;
+  }
+
+  auto escaped = [](const char* text) {
+    std::string out;
+    for (const char* c = text; *c; ++c) {
+      if (*c == '"' || *c == '\\') {
+        out += '\\';
+      }
+      out += *c;
+    }
+    return out;
+  };
+
+  std::lock_guard<std::mutex> lock(mutex_);
+
+  // timestamps are relative to the oldest event so the viewer opens at zero
+  double origin = 0.0;
+  if (!events_.empty() || !counters_.empty()) {
+    origin = events_.empty() ? counters_.front().TimeUs : events_.front().StartUs;
+    for (const ProfileEvent& event : events_) {
+      origin = (std::min)(origin, event.StartUs);
+    }
+    for (const ProfileCounter& counter : counters_) {
+      origin = (std::min)(origin, counter.TimeUs);
+    }
+  }
+
+  file << std::fixed << std::setprecision(3);
+  file << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[" << std::endl;
+  file << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":0,\"tid\":0,\"args\":{\"name\":\"GPU graphics queue\"}}";
+  for (size_t thread = 0; thread < threads_.size(); ++thread) {
+    file << "," << std::endl << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":0,\"tid\":" << thread + 1
+      << ",\"args\":{\"name\":\"CPU thread " << thread << "\"}}";
+  }
+  for (const ProfileEvent& event : events_) {
+    file << "," << std::endl << "{\"name\":\"" << escaped(event.Name) << "\",\"cat\":\"" << (event.Track == 0 ? "gpu" : "cpu")
+      << "\",\"ph\":\"X\",\"pid\":0,\"tid\":" << event.Track << ",\"ts\":" << event.StartUs - origin
+      << ",\"dur\":" << event.DurationUs << "}";
+  }
+  for (const ProfileCounter& counter : counters_) {
+    file << "," << std::endl << "{\"name\":\"" << escaped(counter.Name.c_str()) << "\",\"ph\":\"C\",\"pid\":0,\"ts\":"
+      << counter.TimeUs - origin << ",\"args\":{\"value\":" << counter.Value << "}}";
+  }
+  file << std::endl << "]}" << std::endl;
+
+  if (debug_) {
+    LOG_DEBUG("Wrote " << events_.size() << " trace events to " << path);
+  }
+  return true;
+}
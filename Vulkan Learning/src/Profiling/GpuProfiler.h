@@ -0,0 +1,136 @@
+#pragma once
+#include "Headers.h"
+
+#include <atomic>
+#include <chrono>
+#include <deque>
+#include <map>
+#include <mutex>
+#include <string>
+#include <thread>
+
+struct ProfileEvent {
+  // scope names are expected to be string literals and are not copied
+  const char* Name;
+  // 0 is the graphics queue, CPU threads are numbered from 1 in order of first appearance
+  uint32_t Track;
+  // microseconds on the steady_clock timeline shared by CPU and GPU events
+  double StartUs;
+  double DurationUs;
+};
+
+// one sample of a counter track, e.g. heap usage; exported next to the scopes
+struct ProfileCounter {
+  std::string Name;
+  double TimeUs;
+  double Value;
+};
+
+struct ProfileScopeStats {
+  uint64_t Count = 0;
+  double TotalUs = 0.0;
+  double MaxUs = 0.0;
+};
+
+// Timestamp query profiler. GPU scopes write a pair of timestamps into a
+// query range owned by the frame slot; the range is read back the next time
+// the slot comes around, after its fence was waited on, so reading results
+// never stalls the frame. CPU scopes land on the same timeline: with
+// VK_EXT_calibrated_timestamps the GPU clock is mapped onto CLOCK_MONOTONIC,
+// otherwise the first GPU scope of a frame is aligned with its submission.
+class GpuProfiler {
+public:
+  // times a block of commands, a null profiler turns it into a no-op
+  class GpuScope {
+  public:
+    GpuScope(GpuProfiler* profiler, vk::CommandBuffer command_buffer, const char* name);
+    ~GpuScope();
+
+    GpuScope(const GpuScope&) = delete;
+    GpuScope& operator=(const GpuScope&) = delete;
+
+  private:
+    GpuProfiler* profiler_;
+    vk::CommandBuffer command_buffer_;
+    uint32_t scope_;
+  };
+
+  class CpuScope {
+  public:
+    CpuScope(GpuProfiler* profiler, const char* name);
+    ~CpuScope();
+
+    CpuScope(const CpuScope&) = delete;
+    CpuScope& operator=(const CpuScope&) = delete;
+
+  private:
+    GpuProfiler* profiler_;
+    const char* name_;
+    std::chrono::steady_clock::time_point start_;
+  };
+
+  // dispatch must be initialized for device when calibrated timestamps are enabled, null skips calibration
+  GpuProfiler(const vk::PhysicalDevice& physical_device, const vk::Device& device, float timestamp_period,
+    uint32_t timestamp_valid_bits, uint32_t frames_in_flight, const vk::DispatchLoaderDynamic* dispatch,
+    const bool debug, uint32_t max_scopes = 128, size_t history_events = 1 << 16);
+  ~GpuProfiler();
+
+  // call once the frame slot's fence has signaled, collects what the GPU wrote for it last time around
+  void begin_frame(uint32_t frame);
+  // must be recorded before any scope of the frame
+  void reset_queries(vk::CommandBuffer command_buffer);
+  // the scopes recorded since begin_frame() were just submitted
+  void mark_submit();
+
+  // thread safe, so secondary command buffers recorded on workers can be timed too
+  uint32_t begin_gpu_scope(vk::CommandBuffer command_buffer, const char* name);
+  void end_gpu_scope(vk::CommandBuffer command_buffer, uint32_t scope);
+  void record_cpu(const char* name, std::chrono::steady_clock::time_point start, std::chrono::steady_clock::time_point end);
+  // thread safe, a sample on the named counter track at the current time
+  void record_counter(const std::string& name, double value);
+
+  bool calibrated() const;
+  std::map<std::string, ProfileScopeStats> gpu_stats() const;
+  void report() const;
+  // writes the event history in the Chrome trace event format, viewable in chrome://tracing or Perfetto
+  bool export_chrome_trace(const std::string& path) const;
+
+private:
+  using Clock = std::chrono::steady_clock;
+
+  struct FrameSlot {
+    uint32_t ScopeCount = 0;
+    bool Submitted = false;
+    double SubmitUs = 0.0;
+  };
+
+  void collect(uint32_t frame);
+  // offset from GPU nanoseconds to steady_clock nanoseconds, NaN when not calibrated
+  double calibrate();
+  void push_event(const ProfileEvent& event, bool gpu);
+  uint32_t cpu_track();
+  static double now_us(Clock::time_point time);
+
+  vk::Device device_;
+  const vk::DispatchLoaderDynamic* dispatch_ = nullptr;
+  vk::QueryPool query_pool_;
+  double period_ns_;
+  uint64_t timestamp_mask_;
+  uint32_t max_scopes_;
+  bool debug_;
+
+  std::vector<FrameSlot> slots_;
+  // scope names, max_scopes_ per frame slot
+  std::vector<const char*> names_;
+  uint32_t current_frame_ = 0;
+  std::atomic<uint32_t> scope_count_{ 0 };
+  uint64_t dropped_scopes_ = 0;
+
+  size_t history_events_;
+  std::deque<ProfileEvent> events_;
+  std::deque<ProfileCounter> counters_;
+  std::map<std::string, ProfileScopeStats> gpu_stats_;
+  std::map<std::string, ProfileScopeStats> cpu_stats_;
+  std::vector<std::thread::id> threads_;
+  mutable std::mutex mutex_;
+};
@@ -0,0 +1,650 @@
+#include "RenderGraph/RenderGraph.h"
+
+#include <algorithm>
+#include <chrono>
+
+namespace {
+  struct UseInfo {
+    vk::PipelineStageFlags2 Stages;
+    vk::AccessFlags2 ReadAccess;
+    vk::AccessFlags2 WriteAccess;
+    vk::ImageLayout Layout;
+    vk::ImageUsageFlags ImageUsage;
+    vk::BufferUsageFlags BufferUsage;
+  };
+
+  // only stage and access bits that exist in the legacy enums, so batches can fall back to vkCmdPipelineBarrier
+  UseInfo use_info(GraphUse use) {
+    using Stage = vk::PipelineStageFlagBits2;
+    using Access = vk::AccessFlagBits2;
+    using Layout = vk::ImageLayout;
+
+    switch (use) {
+    case GraphUse::ColorAttachment:
+      return { Stage::eColorAttachmentOutput, Access::eColorAttachmentRead, Access::eColorAttachmentWrite,
+        Layout::eColorAttachmentOptimal, vk::ImageUsageFlagBits::eColorAttachment, {} };
+    case GraphUse::DepthAttachment:
+      return { Stage::eEarlyFragmentTests | Stage::eLateFragmentTests, Access::eDepthStencilAttachmentRead,
+        Access::eDepthStencilAttachmentWrite, Layout::eDepthStencilAttachmentOptimal, vk::ImageUsageFlagBits::eDepthStencilAttachment, {} };
+    case GraphUse::DepthRead:
+      return { Stage::eEarlyFragmentTests | Stage::eLateFragmentTests, Access::eDepthStencilAttachmentRead,
+        Access::eDepthStencilAttachmentRead, Layout::eDepthStencilReadOnlyOptimal, vk::ImageUsageFlagBits::eDepthStencilAttachment, {} };
+    case GraphUse::Sampled:
+      return { Stage::eFragmentShader, Access::eShaderRead, Access::eShaderRead, Layout::eShaderReadOnlyOptimal,
+        vk::ImageUsageFlagBits::eSampled, vk::BufferUsageFlagBits::eUniformTexelBuffer };
+    case GraphUse::Storage:
+      return { Stage::eComputeShader, Access::eShaderRead, Access::eShaderWrite, Layout::eGeneral,
+        vk::ImageUsageFlagBits::eStorage, vk::BufferUsageFlagBits::eStorageBuffer };
+    case GraphUse::TransferSrc:
+      return { Stage::eTransfer, Access::eTransferRead, Access::eTransferRead, Layout::eTransferSrcOptimal,
+        vk::ImageUsageFlagBits::eTransferSrc, vk::BufferUsageFlagBits::eTransferSrc };
+    case GraphUse::TransferDst:
+      return { Stage::eTransfer, Access::eTransferWrite, Access::eTransferWrite, Layout::eTransferDstOptimal,
+        vk::ImageUsageFlagBits::eTransferDst, vk::BufferUsageFlagBits::eTransferDst };
+    case GraphUse::IndirectRead:
+      return { Stage::eDrawIndirect, Access::eIndirectCommandRead, Access::eIndirectCommandRead, Layout::eUndefined,
+        {}, vk::BufferUsageFlagBits::eIndirectBuffer };
+    case GraphUse::VertexRead:
+      return { Stage::eVertexInput, Access::eVertexAttributeRead | Access::eIndexRead, Access::eVertexAttributeRead | Access::eIndexRead,
+        Layout::eUndefined, {}, vk::BufferUsageFlagBits::eVertexBuffer | vk::BufferUsageFlagBits::eIndexBuffer };
+    case GraphUse::UniformRead:
+    default:
+      return { Stage::eFragmentShader, Access::eUniformRead, Access::eUniformRead, Layout::eUndefined,
+        {}, vk::BufferUsageFlagBits::eUniformBuffer };
+    }
+  }
+
+  uint32_t bytes_per_texel(vk::Format format) {
+    switch (format) {
+    case vk::Format::eR8Unorm:
+      return 1;
+    case vk::Format::eR16Sfloat:
+    case vk::Format::eD16Unorm:
+      return 2;
+    case vk::Format::eR16G16B16A16Sfloat:
+    case vk::Format::eR32G32Sfloat:
+    case vk::Format::eD32SfloatS8Uint:
+      return 8;
+    case vk::Format::eR32G32B32A32Sfloat:
+      return 16;
+    default:
+      return 4;
+    }
+  }
+
+  vk::DeviceSize align_up(vk::DeviceSize value, vk::DeviceSize alignment) {
+    return (value + alignment - 1) / alignment * alignment;
+  }
+
+  // what compile() assumes without a device, close to what desktop drivers report
+  vk::MemoryRequirements estimate_requirements(bool texture, const GraphTextureDesc& texture_desc, const GraphBufferDesc& buffer_desc) {
+    if (!texture) {
+      return vk::MemoryRequirements{ align_up(buffer_desc.Size, 256), 256, ~0u };
+    }
+
+    vk::DeviceSize size = 0;
+    uint32_t width = texture_desc.Extent.width;
+    uint32_t height = texture_desc.Extent.height;
+    for (uint32_t level = 0; level < texture_desc.MipLevels; ++level) {
+      size += static_cast<vk::DeviceSize>(width) * height * bytes_per_texel(texture_desc.Format);
+      width = (std::max)(width / 2, 1u);
+      height = (std::max)(height / 2, 1u);
+    }
+    return vk::MemoryRequirements{ align_up(size, 65536), 65536, ~0u };
+  }
+
+  vk::PipelineStageFlags legacy_stages(vk::PipelineStageFlags2 stages, vk::PipelineStageFlagBits none) {
+    VkPipelineStageFlags bits = static_cast<VkPipelineStageFlags>(static_cast<VkPipelineStageFlags2>(stages) & 0xffffffffu);
+    return bits ? vk::PipelineStageFlags(bits) : vk::PipelineStageFlags(none);
+  }
+
+  vk::AccessFlags legacy_access(vk::AccessFlags2 access) {
+    return vk::AccessFlags(static_cast<VkAccessFlags>(static_cast<VkAccessFlags2>(access) & 0xffffffffu));
+  }
+}
+
+void GraphPassBuilder::read(GraphResource resource, GraphUse use, vk::PipelineStageFlags2 stages) {
+  graph_.passes_[pass_].Uses.push_back({ resource, use, stages ? stages : use_info(use).Stages, false });
+}
+
+void GraphPassBuilder::write(GraphResource resource, GraphUse use, vk::PipelineStageFlags2 stages) {
+  graph_.passes_[pass_].Uses.push_back({ resource, use, stages ? stages : use_info(use).Stages, true });
+}
+
+void GraphPassBuilder::side_effect() {
+  graph_.passes_[pass_].SideEffect = true;
+}
+
+GraphPassBuilder::GraphPassBuilder(RenderGraph& graph, uint32_t pass)
+  : graph_(graph), pass_(pass) {
+}
+
+bool RenderGraph::Batch::empty() const {
+  return Images.empty() && !HasMemory;
+}
+
+RenderGraph::~RenderGraph() {
+  destroy_transients();
+}
+
+GraphResource RenderGraph::create_texture(const std::string& name, const GraphTextureDesc& desc) {
+  Resource resource;
+  resource.Name = name;
+  resource.TextureDesc = desc;
+  resources_.push_back(resource);
+  return static_cast<GraphResource>(resources_.size() - 1);
+}
+
+GraphResource RenderGraph::create_buffer(const std::string& name, const GraphBufferDesc& desc) {
+  Resource resource;
+  resource.Name = name;
+  resource.Texture = false;
+  resource.BufferDesc = desc;
+  resources_.push_back(resource);
+  return static_cast<GraphResource>(resources_.size() - 1);
+}
+
+GraphResource RenderGraph::import_texture(const std::string& name, vk::Image image, const GraphTextureDesc& desc,
+  vk::ImageLayout initial_layout, vk::PipelineStageFlags2 initial_stages, vk::ImageLayout final_layout) {
+  GraphResource id = create_texture(name, desc);
+  Resource& resource = resources_[id];
+  resource.Imported = true;
+  resource.Image = image;
+  resource.InitialLayout = initial_layout;
+  resource.InitialStages = initial_stages;
+  resource.FinalLayout = final_layout;
+  return id;
+}
+
+GraphResource RenderGraph::import_buffer(const std::string& name, vk::Buffer buffer, const GraphBufferDesc& desc) {
+  GraphResource id = create_buffer(name, desc);
+  resources_[id].Imported = true;
+  resources_[id].Buffer = buffer;
+  return id;
+}
+
+void RenderGraph::add_pass(const std::string& name, const std::function<void(GraphPassBuilder&)>& setup, Execute execute) {
+  Pass pass;
+  pass.Name = name;
+  pass.Run = std::move(execute);
+  passes_.push_back(std::move(pass));
+
+  GraphPassBuilder builder(*this, static_cast<uint32_t>(passes_.size() - 1));
+  setup(builder);
+}
+
+void RenderGraph::compile(const MemoryQuery& query) {
+  auto start = std::chrono::steady_clock::now();
+
+  cull_passes();
+  compute_lifetimes();
+  alias_transients(query);
+  place_barriers();
+
+  stats_.CompileMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+void RenderGraph::realize(const vk::Device& device, MemoryAllocator& allocator) {
+  auto start = std::chrono::steady_clock::now();
+  destroy_transients();
+  device_ = device;
+  allocator_ = &allocator;
+
+  cull_passes();
+  compute_lifetimes();
+  create_transients();
+  alias_transients([this](GraphResource id) {
+    const Resource& resource = resources_[id];
+    return resource.Texture ? device_.getImageMemoryRequirements(resource.Image) : device_.getBufferMemoryRequirements(resource.Buffer);
+  });
+  place_barriers();
+
+  for (Heap& heap : heaps_) {
+    vk::MemoryRequirements requirements{ heap.Size, heap.Alignment, heap.MemoryTypeBits };
+    heap.Memory = allocator_->allocate(requirements, vk::MemoryPropertyFlagBits::eDeviceLocal, heap.Linear);
+  }
+  for (Resource& resource : resources_) {
+    if (resource.Heap == UINT32_MAX) {
+      continue;
+    }
+    const MemoryAllocation& memory = heaps_[resource.Heap].Memory;
+    if (resource.Texture) {
+      device_.bindImageMemory(resource.Image, memory.Memory, memory.Offset + resource.Offset);
+    }
+    else {
+      device_.bindBufferMemory(resource.Buffer, memory.Memory, memory.Offset + resource.Offset);
+    }
+  }
+
+  stats_.CompileMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+void RenderGraph::execute(vk::CommandBuffer command_buffer, const vk::DispatchLoaderDynamic* sync2) const {
+  for (size_t i = 0; i < order_.size(); ++i) {
+    if (!batches_[i].empty()) {
+      record_batch(command_buffer, batches_[i], sync2);
+    }
+    const Pass& pass = passes_[order_[i]];
+    if (pass.Run) {
+      pass.Run(command_buffer);
+    }
+  }
+  if (!final_batch_.empty()) {
+    record_batch(command_buffer, final_batch_, sync2);
+  }
+}
+
+void RenderGraph::reset() {
+  destroy_transients();
+  passes_.clear();
+  resources_.clear();
+  order_.clear();
+  batches_.clear();
+  final_batch_ = Batch{};
+  stats_ = RenderGraphStats{};
+}
+
+vk::Image RenderGraph::image(GraphResource resource) const {
+  return resources_[resource].Image;
+}
+
+vk::Buffer RenderGraph::buffer(GraphResource resource) const {
+  return resources_[resource].Buffer;
+}
+
+const RenderGraphStats& RenderGraph::stats() const {
+  return stats_;
+}
+
+void RenderGraph::report() const {
+  std::cout << "Render graph: " << stats_.Passes << " passes (" << stats_.CulledPasses << " culled), " << stats_.BarrierBatches
+    << " barrier batches with " << stats_.ImageBarriers << " image and " << stats_.MemoryBarriers << " memory barriers (naive "
+    << stats_.NaiveBarriers << "), " << stats_.TransientResources << " transients in " << stats_.AliasingHeaps << " heaps, "
+    << stats_.AliasedBytes / 1024 << "KiB instead of " << stats_.TransientBytes / 1024 << "KiB, compiled in "
+    << stats_.CompileMs << "ms" << std::endl;
+}
+
+void RenderGraph::cull_passes() {
+  // walk backwards from what leaves the graph, a pass lives if something live reads what it writes
+  std::vector<bool> needed(resources_.size(), false);
+  for (size_t i = 0; i < resources_.size(); ++i) {
+    needed[i] = resources_[i].Imported;
+  }
+
+  stats_.Passes = static_cast<uint32_t>(passes_.size());
+  stats_.CulledPasses = 0;
+  for (size_t i = passes_.size(); i-- > 0;) {
+    Pass& pass = passes_[i];
+    pass.Alive = pass.SideEffect;
+    for (const Use& use : pass.Uses) {
+      pass.Alive = pass.Alive || (use.Write && needed[use.Resource]);
+    }
+
+    if (!pass.Alive) {
+      ++stats_.CulledPasses;
+      continue;
+    }
+    for (const Use& use : pass.Uses) {
+      if (!use.Write) {
+        needed[use.Resource] = true;
+      }
+    }
+  }
+
+  order_.clear();
+  for (uint32_t i = 0; i < passes_.size(); ++i) {
+    if (passes_[i].Alive) {
+      order_.push_back(i);
+    }
+  }
+}
+
+void RenderGraph::compute_lifetimes() {
+  for (Resource& resource : resources_) {
+    resource.FirstUse = UINT32_MAX;
+    resource.LastUse = 0;
+    resource.LastStages = vk::PipelineStageFlags2{};
+    resource.ImageUsage = vk::ImageUsageFlags{};
+    resource.BufferUsage = vk::BufferUsageFlags{};
+    resource.Heap = UINT32_MAX;
+    resource.AliasWait = vk::PipelineStageFlags2{};
+  }
+
+  for (uint32_t position = 0; position < order_.size(); ++position) {
+    for (const Use& use : passes_[order_[position]].Uses) {
+      Resource& resource = resources_[use.Resource];
+      if (resource.FirstUse == UINT32_MAX) {
+        resource.FirstUse = position;
+      }
+      if (resource.LastUse != position) {
+        resource.LastStages = vk::PipelineStageFlags2{};
+      }
+      resource.LastUse = position;
+      resource.LastStages |= use.Stages;
+
+      UseInfo info = use_info(use.Kind);
+      resource.ImageUsage |= info.ImageUsage;
+      resource.BufferUsage |= info.BufferUsage;
+    }
+  }
+}
+
+void RenderGraph::create_transients() {
+  for (Resource& resource : resources_) {
+    if (resource.Imported || resource.FirstUse == UINT32_MAX) {
+      continue;
+    }
+
+    if (resource.Texture) {
+      vk::ImageCreateInfo image_info{};
+      image_info.imageType = vk::ImageType::e2D;
+      image_info.format = resource.TextureDesc.Format;
+      image_info.extent = vk::Extent3D{ resource.TextureDesc.Extent.width, resource.TextureDesc.Extent.height, 1 };
+      image_info.mipLevels = resource.TextureDesc.MipLevels;
+      image_info.arrayLayers = 1;
+      image_info.samples = vk::SampleCountFlagBits::e1;
+      image_info.tiling = vk::ImageTiling::eOptimal;
+      image_info.usage = resource.ImageUsage;
+      image_info.sharingMode = vk::SharingMode::eExclusive;
+      image_info.initialLayout = vk::ImageLayout::eUndefined;
+      resource.Image = device_.createImage(image_info);
+    }
+    else {
+      vk::BufferCreateInfo buffer_info{};
+      buffer_info.size = resource.BufferDesc.Size;
+      buffer_info.usage = resource.BufferUsage;
+      buffer_info.sharingMode = vk::SharingMode::eExclusive;
+      resource.Buffer = device_.createBuffer(buffer_info);
+    }
+  }
+}
+
+void RenderGraph::alias_transients(const MemoryQuery& query) {
+  struct Placement {
+    GraphResource Resource;
+    vk::DeviceSize Offset;
+    vk::DeviceSize End;
+  };
+
+  heaps_.clear();
+  stats_.TransientResources = 0;
+  stats_.TransientBytes = 0;
+  stats_.AliasedBytes = 0;
+
+  std::vector<GraphResource> transients;
+  for (GraphResource id = 0; id < resources_.size(); ++id) {
+    Resource& resource = resources_[id];
+    if (resource.Imported || resource.FirstUse == UINT32_MAX) {
+      continue;
+    }
+    resource.Requirements = query ? query(id) : estimate_requirements(resource.Texture, resource.TextureDesc, resource.BufferDesc);
+    transients.push_back(id);
+    ++stats_.TransientResources;
+    stats_.TransientBytes += resource.Requirements.size;
+  }
+
+  // largest first packs best, ties keep declaration order so compiles are deterministic
+  std::stable_sort(transients.begin(), transients.end(), [this](GraphResource a, GraphResource b) {
+    return resources_[a].Requirements.size > resources_[b].Requirements.size;
+  });
+
+  // images and buffers never share a heap, so bufferImageGranularity never comes into it
+  std::vector<std::vector<Placement>> placements;
+  for (GraphResource id : transients) {
+    Resource& resource = resources_[id];
+    bool linear = !resource.Texture;
+
+    uint32_t heap_index = 0;
+    while (heap_index < heaps_.size() &&
+      (heaps_[heap_index].Linear != linear || heaps_[heap_index].MemoryTypeBits != resource.Requirements.memoryTypeBits)) {
+      ++heap_index;
+    }
+    if (heap_index == heaps_.size()) {
+      Heap heap;
+      heap.Linear = linear;
+      heap.MemoryTypeBits = resource.Requirements.memoryTypeBits;
+      heaps_.push_back(heap);
+      placements.emplace_back();
+    }
+    Heap& heap = heaps_[heap_index];
+
+    // first fit between the placed resources whose lifetimes overlap this one
+    std::vector<Placement> overlapping;
+    for (const Placement& placed : placements[heap_index]) {
+      const Resource& other = resources_[placed.Resource];
+      if (other.LastUse >= resource.FirstUse && resource.LastUse >= other.FirstUse) {
+        overlapping.push_back(placed);
+      }
+    }
+    std::sort(overlapping.begin(), overlapping.end(), [](const Placement& a, const Placement& b) { return a.Offset < b.Offset; });
+
+    vk::DeviceSize alignment = resource.Requirements.alignment;
+    vk::DeviceSize size = resource.Requirements.size;
+    vk::DeviceSize offset = 0;
+    for (const Placement& placed : overlapping) {
+      if (align_up(offset, alignment) + size <= placed.Offset) {
+        break;
+      }
+      offset = (std::max)(offset, placed.End);
+    }
+    offset = align_up(offset, alignment);
+
+    resource.Heap = heap_index;
+    resource.Offset = offset;
+    placements[heap_index].push_back({ id, offset, offset + size });
+    heap.Size = (std::max)(heap.Size, offset + size);
+    heap.Alignment = (std::max)(heap.Alignment, alignment);
+  }
+
+  // a resource taking over memory has to wait for the previous occupants to finish with it
+  for (const std::vector<Placement>& heap : placements) {
+    for (const Placement& placed : heap) {
+      Resource& resource = resources_[placed.Resource];
+      for (const Placement& previous : heap) {
+        const Resource& other = resources_[previous.Resource];
+        bool memory_overlaps = previous.Offset < placed.End && placed.Offset < previous.End;
+        if (memory_overlaps && other.LastUse < resource.FirstUse) {
+          resource.AliasWait |= other.LastStages;
+        }
+      }
+    }
+  }
+
+  stats_.AliasingHeaps = static_cast<uint32_t>(heaps_.size());
+  for (const Heap& heap : heaps_) {
+    stats_.AliasedBytes += heap.Size;
+  }
+}
+
+void RenderGraph::place_barriers() {
+  std::vector<State> states(resources_.size());
+  for (size_t i = 0; i < resources_.size(); ++i) {
+    const Resource& resource = resources_[i];
+    // imported contents come from outside work, transients only wait for the memory's previous occupants
+    states[i].WriteStages = resource.Imported ? resource.InitialStages : resource.AliasWait;
+    states[i].Layout = resource.Imported ? resource.InitialLayout : vk::ImageLayout::eUndefined;
+  }
+
+  stats_.BarrierBatches = 0;
+  stats_.ImageBarriers = 0;
+  stats_.MemoryBarriers = 0;
+  stats_.NaiveBarriers = 0;
+
+  auto image_barrier = [this](const Resource& resource, const State& state, vk::PipelineStageFlags2 dst_stages,
+    vk::AccessFlags2 dst_access, vk::ImageLayout layout) {
+    vk::ImageMemoryBarrier2 barrier{};
+    barrier.srcStageMask = state.WriteStages | state.ReadStages | state.TransitionStages;
+    barrier.srcAccessMask = state.WriteAccess;
+    barrier.dstStageMask = dst_stages;
+    barrier.dstAccessMask = dst_access;
+    barrier.oldLayout = state.Layout;
+    barrier.newLayout = layout;
+    barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    barrier.image = resource.Image;
+    barrier.subresourceRange = vk::ImageSubresourceRange{ resource.TextureDesc.Aspect, 0, VK_REMAINING_MIP_LEVELS, 0, VK_REMAINING_ARRAY_LAYERS };
+    return barrier;
+  };
+
+  auto merge = [](Batch& batch, vk::PipelineStageFlags2 src_stages, vk::AccessFlags2 src_access,
+    vk::PipelineStageFlags2 dst_stages, vk::AccessFlags2 dst_access) {
+    batch.Memory.srcStageMask |= src_stages;
+    batch.Memory.srcAccessMask |= src_access;
+    batch.Memory.dstStageMask |= dst_stages;
+    batch.Memory.dstAccessMask |= dst_access;
+    batch.HasMemory = true;
+  };
+
+  batches_.assign(order_.size(), Batch{});
+  for (uint32_t position = 0; position < order_.size(); ++position) {
+    Batch& batch = batches_[position];
+    const Pass& pass = passes_[order_[position]];
+
+    // a resource used several ways in one pass is synchronized once for all of them
+    std::vector<Use> merged;
+    for (const Use& use : pass.Uses) {
+      ++stats_.NaiveBarriers;
+      auto same = std::find_if(merged.begin(), merged.end(), [&use](const Use& m) { return m.Resource == use.Resource; });
+      if (same == merged.end()) {
+        merged.push_back(use);
+      }
+      else {
+        same->Stages |= use.Stages;
+        same->Write = same->Write || use.Write;
+        // two layouts in one pass can only be met by general
+        if (use_info(same->Kind).Layout != use_info(use.Kind).Layout) {
+          same->Kind = GraphUse::Storage;
+        }
+      }
+    }
+
+    for (const Use& use : merged) {
+      const Resource& resource = resources_[use.Resource];
+      State& state = states[use.Resource];
+      UseInfo info = use_info(use.Kind);
+
+      vk::AccessFlags2 access = use.Write ? (info.WriteAccess | info.ReadAccess) : info.ReadAccess;
+      vk::ImageLayout layout = resource.Texture ? info.Layout : vk::ImageLayout::eUndefined;
+      bool transition = resource.Texture && layout != state.Layout;
+
+      if (use.Write || transition) {
+        vk::PipelineStageFlags2 src_stages = state.WriteStages | state.ReadStages | state.TransitionStages;
+        if (transition) {
+          batch.Images.push_back(image_barrier(resource, state, use.Stages, access, layout));
+        }
+        else if (src_stages) {
+          merge(batch, src_stages, state.WriteAccess, use.Stages, access);
+        }
+
+        if (use.Write) {
+          state.WriteStages = use.Stages;
+          state.WriteAccess = info.WriteAccess;
+          state.ReadStages = vk::PipelineStageFlags2{};
+          state.ReadAccess = vk::AccessFlags2{};
+          state.TransitionStages = vk::PipelineStageFlags2{};
+        }
+        else {
+          state.ReadStages = use.Stages;
+          state.ReadAccess = access;
+          state.TransitionStages = use.Stages;
+        }
+        state.Layout = layout;
+        continue;
+      }
+
+      // a read only waits if it touches stages or access the earlier reads did not already cover
+      vk::PipelineStageFlags2 pending = state.WriteStages | state.TransitionStages;
+      bool covered = !(use.Stages & ~state.ReadStages) && !(access & ~state.ReadAccess);
+      if (pending && !covered) {
+        merge(batch, pending, state.WriteAccess, use.Stages, access);
+      }
+      state.ReadStages |= use.Stages;
+      state.ReadAccess |= access;
+    }
+  }
+
+  // imported images leave in the layout whoever consumes them next expects
+  final_batch_ = Batch{};
+  for (size_t i = 0; i < resources_.size(); ++i) {
+    const Resource& resource = resources_[i];
+    if (!resource.Imported || !resource.Texture || resource.FinalLayout == vk::ImageLayout::eUndefined ||
+      resource.FinalLayout == states[i].Layout) {
+      continue;
+    }
+    ++stats_.NaiveBarriers;
+    final_batch_.Images.push_back(image_barrier(resource, states[i], vk::PipelineStageFlagBits2::eNone, vk::AccessFlags2{},
+      resource.FinalLayout));
+  }
+
+  for (const Batch& batch : batches_) {
+    stats_.BarrierBatches += batch.empty() ? 0 : 1;
+    stats_.ImageBarriers += static_cast<uint32_t>(batch.Images.size());
+    stats_.MemoryBarriers += batch.HasMemory ? 1 : 0;
+  }
+  stats_.BarrierBatches += final_batch_.empty() ? 0 : 1;
+  stats_.ImageBarriers += static_cast<uint32_t>(final_batch_.Images.size());
+}
+
+void RenderGraph::record_batch(vk::CommandBuffer command_buffer, const Batch& batch, const vk::DispatchLoaderDynamic* sync2) const {
+  if (sync2) {
+    vk::DependencyInfo dependency{};
+    dependency.memoryBarrierCount = batch.HasMemory ? 1 : 0;
+    dependency.pMemoryBarriers = &batch.Memory;
+    dependency.imageMemoryBarrierCount = static_cast<uint32_t>(batch.Images.size());
+    dependency.pImageMemoryBarriers = batch.Images.data();
+    command_buffer.pipelineBarrier2(dependency, *sync2);
+    return;
+  }
+
+  // one legacy barrier with the union of every stage mask in the batch
+  vk::PipelineStageFlags2 src_stages = batch.HasMemory ? batch.Memory.srcStageMask : vk::PipelineStageFlags2{};
+  vk::PipelineStageFlags2 dst_stages = batch.HasMemory ? batch.Memory.dstStageMask : vk::PipelineStageFlags2{};
+  std::vector<vk::ImageMemoryBarrier> images;
+  for (const vk::ImageMemoryBarrier2& barrier : batch.Images) {
+    src_stages |= barrier.srcStageMask;
+    dst_stages |= barrier.dstStageMask;
+
+    vk::ImageMemoryBarrier legacy{};
+    legacy.srcAccessMask = legacy_access(barrier.srcAccessMask);
+    legacy.dstAccessMask = legacy_access(barrier.dstAccessMask);
+    legacy.oldLayout = barrier.oldLayout;
+    legacy.newLayout = barrier.newLayout;
+    legacy.srcQueueFamilyIndex = barrier.srcQueueFamilyIndex;
+    legacy.dstQueueFamilyIndex = barrier.dstQueueFamilyIndex;
+    legacy.image = barrier.image;
+    legacy.subresourceRange = barrier.subresourceRange;
+    images.push_back(legacy);
+  }
+
+  std::vector<vk::MemoryBarrier> memory;
+  if (batch.HasMemory) {
+    memory.push_back(vk::MemoryBarrier{ legacy_access(batch.Memory.srcAccessMask), legacy_access(batch.Memory.dstAccessMask) });
+  }
+  command_buffer.pipelineBarrier(legacy_stages(src_stages, vk::PipelineStageFlagBits::eTopOfPipe),
+    legacy_stages(dst_stages, vk::PipelineStageFlagBits::eBottomOfPipe), vk::DependencyFlags{}, memory, nullptr, images);
+}
+
+void RenderGraph::destroy_transients() {
+  if (!allocator_) {
+    return;
+  }
+
+  for (Resource& resource : resources_) {
+    if (resource.Imported) {
+      continue;
+    }
+    if (resource.Image) {
+      device_.destroyImage(resource.Image);
+      resource.Image = nullptr;
+    }
+    if (resource.Buffer) {
+      device_.destroyBuffer(resource.Buffer);
+      resource.Buffer = nullptr;
+    }
+  }
+  for (Heap& heap : heaps_) {
+    allocator_->free(heap.Memory);
+  }
+  heaps_.clear();
+  allocator_ = nullptr;
+}
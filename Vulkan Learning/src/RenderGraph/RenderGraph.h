@@ -0,0 +1,204 @@
+#pragma once
+#include "Headers.h"
+#include "Memory/MemoryAllocator.h"
+
+#include <functional>
+#include <string>
+
+using GraphResource = uint32_t;
+
+// how a pass touches a resource, decides access, layout and usage flags
+enum class GraphUse : uint8_t {
+  ColorAttachment,
+  DepthAttachment,
+  DepthRead,
+  Sampled,
+  // storage image or buffer, read or written depending on how the pass declares it
+  Storage,
+  TransferSrc,
+  TransferDst,
+  IndirectRead,
+  VertexRead,
+  UniformRead
+};
+
+struct GraphTextureDesc {
+  vk::Format Format = vk::Format::eR8G8B8A8Unorm;
+  vk::Extent2D Extent{};
+  uint32_t MipLevels = 1;
+  vk::ImageAspectFlags Aspect = vk::ImageAspectFlagBits::eColor;
+};
+
+struct GraphBufferDesc {
+  vk::DeviceSize Size = 0;
+};
+
+struct RenderGraphStats {
+  uint32_t Passes = 0;
+  uint32_t CulledPasses = 0;
+  // vkCmdPipelineBarrier2 calls, at most one per pass plus the final transitions
+  uint32_t BarrierBatches = 0;
+  uint32_t ImageBarriers = 0;
+  uint32_t MemoryBarriers = 0;
+  // one barrier per resource use, what hand-written per-resource barriers amount to
+  uint32_t NaiveBarriers = 0;
+  uint32_t TransientResources = 0;
+  uint32_t AliasingHeaps = 0;
+  // transient memory with and without aliasing
+  uint64_t TransientBytes = 0;
+  uint64_t AliasedBytes = 0;
+  double CompileMs = 0.0;
+};
+
+class RenderGraph;
+
+// Declares what a pass reads and writes, handed to the setup callback.
+class GraphPassBuilder {
+public:
+  // stages default to the ones the use implies, e.g. shader uses default to the fragment shader
+  void read(GraphResource resource, GraphUse use, vk::PipelineStageFlags2 stages = {});
+  void write(GraphResource resource, GraphUse use, vk::PipelineStageFlags2 stages = {});
+  // the pass runs even when nothing reads what it writes, e.g. readbacks or secondary recording
+  void side_effect();
+
+private:
+  friend class RenderGraph;
+  GraphPassBuilder(RenderGraph& graph, uint32_t pass);
+
+  RenderGraph& graph_;
+  uint32_t pass_;
+};
+
+// A frame described as passes that declare their resource uses. compile()
+// drops passes that contribute nothing to an imported resource or side
+// effect, batches the barriers each pass needs into one synchronization2
+// dependency, and packs transient resources with disjoint lifetimes into
+// shared memory. compile() touches no Vulkan objects, so a graph can be built
+// and measured without a device; realize() then creates the transients.
+//
+// Passes run in declaration order. Rebuilding every frame is cheap as long as
+// the graph is only compiled; realized transients are freed by reset(), so
+// graphs that own transients are rebuilt once the GPU is done with them.
+class RenderGraph {
+public:
+  using Execute = std::function<void(vk::CommandBuffer)>;
+  // memory requirements of a transient, compile() estimates them when null
+  using MemoryQuery = std::function<vk::MemoryRequirements(GraphResource)>;
+
+  RenderGraph() = default;
+  // transients must no longer be in use by the GPU
+  ~RenderGraph();
+
+  GraphResource create_texture(const std::string& name, const GraphTextureDesc& desc);
+  GraphResource create_buffer(const std::string& name, const GraphBufferDesc& desc);
+  // external image, initial_stages is where outside work last touched it, e.g. the acquire semaphore's wait stage
+  GraphResource import_texture(const std::string& name, vk::Image image, const GraphTextureDesc& desc, vk::ImageLayout initial_layout,
+    vk::PipelineStageFlags2 initial_stages, vk::ImageLayout final_layout);
+  GraphResource import_buffer(const std::string& name, vk::Buffer buffer, const GraphBufferDesc& desc);
+
+  void add_pass(const std::string& name, const std::function<void(GraphPassBuilder&)>& setup, Execute execute);
+
+  void compile(const MemoryQuery& query = nullptr);
+  // creates the transients, compiles with their real requirements and binds them into aliased memory
+  void realize(const vk::Device& device, MemoryAllocator& allocator);
+  // a null dispatcher records legacy vkCmdPipelineBarrier calls instead
+  void execute(vk::CommandBuffer command_buffer, const vk::DispatchLoaderDynamic* sync2) const;
+  // forgets passes and resources, frees realized transients
+  void reset();
+
+  vk::Image image(GraphResource resource) const;
+  vk::Buffer buffer(GraphResource resource) const;
+  const RenderGraphStats& stats() const;
+  void report() const;
+
+private:
+  friend class GraphPassBuilder;
+
+  struct Use {
+    GraphResource Resource;
+    GraphUse Kind;
+    vk::PipelineStageFlags2 Stages;
+    bool Write;
+  };
+
+  struct Pass {
+    std::string Name;
+    std::vector<Use> Uses;
+    Execute Run;
+    bool SideEffect = false;
+    bool Alive = false;
+  };
+
+  struct Resource {
+    std::string Name;
+    bool Texture = true;
+    bool Imported = false;
+    GraphTextureDesc TextureDesc;
+    GraphBufferDesc BufferDesc;
+    vk::Image Image;
+    vk::Buffer Buffer;
+    vk::ImageLayout InitialLayout = vk::ImageLayout::eUndefined;
+    vk::PipelineStageFlags2 InitialStages;
+    vk::ImageLayout FinalLayout = vk::ImageLayout::eUndefined;
+
+    // filled in by compile(), positions in the order of live passes
+    uint32_t FirstUse = UINT32_MAX;
+    uint32_t LastUse = 0;
+    vk::PipelineStageFlags2 LastStages;
+    vk::ImageUsageFlags ImageUsage;
+    vk::BufferUsageFlags BufferUsage;
+    vk::MemoryRequirements Requirements;
+    uint32_t Heap = UINT32_MAX;
+    vk::DeviceSize Offset = 0;
+    // last stages of the resources whose memory this one takes over
+    vk::PipelineStageFlags2 AliasWait;
+  };
+
+  // synchronization state of a resource while barriers are placed
+  struct State {
+    vk::PipelineStageFlags2 WriteStages;
+    vk::AccessFlags2 WriteAccess;
+    // reads since the last write, and what they already made visible
+    vk::PipelineStageFlags2 ReadStages;
+    vk::AccessFlags2 ReadAccess;
+    // dst stages of the last layout transition that was not a write
+    vk::PipelineStageFlags2 TransitionStages;
+    vk::ImageLayout Layout = vk::ImageLayout::eUndefined;
+  };
+
+  struct Batch {
+    std::vector<vk::ImageMemoryBarrier2> Images;
+    vk::MemoryBarrier2 Memory;
+    bool HasMemory = false;
+
+    bool empty() const;
+  };
+
+  struct Heap {
+    bool Linear = false;
+    uint32_t MemoryTypeBits = 0;
+    vk::DeviceSize Size = 0;
+    vk::DeviceSize Alignment = 1;
+    MemoryAllocation Memory;
+  };
+
+  void cull_passes();
+  void compute_lifetimes();
+  void create_transients();
+  void alias_transients(const MemoryQuery& query);
+  void place_barriers();
+  void record_batch(vk::CommandBuffer command_buffer, const Batch& batch, const vk::DispatchLoaderDynamic* sync2) const;
+  void destroy_transients();
+
+  std::vector<Pass> passes_;
+  std::vector<Resource> resources_;
+  // indices of live passes in execution order, with the barriers each one needs first
+  std::vector<uint32_t> order_;
+  std::vector<Batch> batches_;
+  Batch final_batch_;
+  std::vector<Heap> heaps_;
+  RenderGraphStats stats_;
+
+  vk::Device device_;
+  MemoryAllocator* allocator_ = nullptr;
+};
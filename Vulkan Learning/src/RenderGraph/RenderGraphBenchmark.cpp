@@ -0,0 +1,108 @@
+#include "RenderGraph/RenderGraphBenchmark.h"
+#include "RenderGraph/RenderGraph.h"
+
+#include <chrono>
+
+namespace {
+  constexpr vk::Extent2D FrameExtent{ 1920, 1080 };
+  constexpr uint32_t BloomLevels = 5;
+
+  // gbuffer, ssao, lighting, a bloom chain and post into an imported backbuffer, plus a debug view nothing reads
+  void build_frame(RenderGraph& graph) {
+    using Stage = vk::PipelineStageFlagBits2;
+
+    GraphResource backbuffer = graph.import_texture("backbuffer", nullptr, { vk::Format::eB8G8R8A8Unorm, FrameExtent },
+      vk::ImageLayout::eUndefined, Stage::eColorAttachmentOutput, vk::ImageLayout::ePresentSrcKHR);
+    GraphResource draws = graph.import_buffer("draw commands", nullptr, { 4 * 1024 * 1024 });
+
+    GraphResource albedo = graph.create_texture("albedo", { vk::Format::eR8G8B8A8Unorm, FrameExtent });
+    GraphResource normals = graph.create_texture("normals", { vk::Format::eR16G16B16A16Sfloat, FrameExtent });
+    GraphResource depth = graph.create_texture("depth", { vk::Format::eD32Sfloat, FrameExtent, 1, vk::ImageAspectFlagBits::eDepth });
+    GraphResource ssao = graph.create_texture("ssao", { vk::Format::eR8Unorm, FrameExtent });
+    GraphResource hdr = graph.create_texture("hdr", { vk::Format::eR16G16B16A16Sfloat, FrameExtent });
+    GraphResource debug_view = graph.create_texture("debug view", { vk::Format::eR8G8B8A8Unorm, FrameExtent });
+    GraphResource histogram = graph.create_buffer("luminance histogram", { 256 * sizeof(uint32_t) });
+
+    graph.add_pass("gbuffer", [&](GraphPassBuilder& pass) {
+      pass.read(draws, GraphUse::IndirectRead);
+      pass.write(albedo, GraphUse::ColorAttachment);
+      pass.write(normals, GraphUse::ColorAttachment);
+      pass.write(depth, GraphUse::DepthAttachment);
+    }, nullptr);
+
+    graph.add_pass("ssao", [&](GraphPassBuilder& pass) {
+      pass.read(depth, GraphUse::Sampled, Stage::eComputeShader);
+      pass.read(normals, GraphUse::Sampled, Stage::eComputeShader);
+      pass.write(ssao, GraphUse::Storage);
+    }, nullptr);
+
+    graph.add_pass("lighting", [&](GraphPassBuilder& pass) {
+      pass.read(albedo, GraphUse::Sampled);
+      pass.read(normals, GraphUse::Sampled);
+      pass.read(depth, GraphUse::Sampled);
+      pass.read(ssao, GraphUse::Sampled);
+      pass.write(hdr, GraphUse::ColorAttachment);
+    }, nullptr);
+
+    graph.add_pass("debug normals", [&](GraphPassBuilder& pass) {
+      pass.read(normals, GraphUse::Sampled);
+      pass.write(debug_view, GraphUse::ColorAttachment);
+    }, nullptr);
+
+    // downsample then upsample, every level is its own transient
+    std::vector<GraphResource> bloom;
+    GraphResource source = hdr;
+    vk::Extent2D extent = FrameExtent;
+    for (uint32_t level = 0; level < BloomLevels; ++level) {
+      extent = vk::Extent2D{ (std::max)(extent.width / 2, 1u), (std::max)(extent.height / 2, 1u) };
+      GraphResource target = graph.create_texture("bloom down " + std::to_string(level), { vk::Format::eR16G16B16A16Sfloat, extent });
+      graph.add_pass("bloom down " + std::to_string(level), [&](GraphPassBuilder& pass) {
+        pass.read(source, GraphUse::Sampled, Stage::eComputeShader);
+        pass.write(target, GraphUse::Storage);
+      }, nullptr);
+      bloom.push_back(target);
+      source = target;
+    }
+    for (uint32_t level = BloomLevels - 1; level-- > 0;) {
+      GraphResource target = graph.create_texture("bloom up " + std::to_string(level), { vk::Format::eR16G16B16A16Sfloat,
+        vk::Extent2D{ (std::max)(FrameExtent.width >> (level + 1), 1u), (std::max)(FrameExtent.height >> (level + 1), 1u) } });
+      graph.add_pass("bloom up " + std::to_string(level), [&](GraphPassBuilder& pass) {
+        pass.read(source, GraphUse::Sampled, Stage::eComputeShader);
+        pass.read(bloom[level], GraphUse::Sampled, Stage::eComputeShader);
+        pass.write(target, GraphUse::Storage);
+      }, nullptr);
+      source = target;
+    }
+
+    graph.add_pass("luminance", [&](GraphPassBuilder& pass) {
+      pass.read(hdr, GraphUse::Sampled, Stage::eComputeShader);
+      pass.write(histogram, GraphUse::Storage);
+    }, nullptr);
+
+    graph.add_pass("post", [&](GraphPassBuilder& pass) {
+      pass.read(hdr, GraphUse::Sampled);
+      pass.read(source, GraphUse::Sampled);
+      pass.read(histogram, GraphUse::Storage, Stage::eFragmentShader);
+      pass.write(backbuffer, GraphUse::ColorAttachment);
+    }, nullptr);
+  }
+}
+
+void run_render_graph_benchmark() {
+  constexpr uint32_t Builds = 10000;
+
+  RenderGraph graph;
+  build_frame(graph);
+  graph.compile();
+  graph.report();
+
+  // what a per-frame rebuild costs on the CPU
+  auto start = std::chrono::steady_clock::now();
+  for (uint32_t i = 0; i < Builds; ++i) {
+    graph.reset();
+    build_frame(graph);
+    graph.compile();
+  }
+  double total_ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+  std::cout << "Render graph: build + compile " << total_ms * 1000.0 / Builds << "us per frame over " << Builds << " frames" << std::endl;
+}
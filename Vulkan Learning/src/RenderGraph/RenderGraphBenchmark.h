@@ -0,0 +1,4 @@
+#pragma once
+
+// compiles a representative deferred frame and reports culling, barrier batching and aliasing, no device needed
+void run_render_graph_benchmark();
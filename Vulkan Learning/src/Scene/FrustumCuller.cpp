@@ -0,0 +1,331 @@
+#include "Scene/FrustumCuller.h"
+#include "Scene/SceneStore.h"
+#include "JobSystem.h"
+
+#include <cstring>
+
+#if defined(__x86_64__) || defined(_M_X64)
+#define FRUSTUM_CULL_X64 1
+#include <immintrin.h>
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+#elif defined(__ARM_NEON) || defined(_M_ARM64)
+#define FRUSTUM_CULL_NEON 1
+#include <arm_neon.h>
+#endif
+
+// the avx2 kernel is built without -mavx2 for the whole file and only runs after the cpuid check
+#if defined(FRUSTUM_CULL_X64) && (defined(__GNUC__) || defined(__clang__))
+#define FRUSTUM_CULL_AVX2_TARGET __attribute__((target("avx2")))
+#else
+#define FRUSTUM_CULL_AVX2_TARGET
+#endif
+
+namespace {
+  // below this many spheres a range is culled inline
+  constexpr uint32_t MinParallelSpheres = 16384;
+  constexpr uint32_t ChunksPerWorker = 4;
+
+  uint32_t cull_scalar(const float planes[6][4], const float* x, const float* y, const float* z, const float* radius,
+    uint32_t begin, uint32_t end, uint32_t* out) {
+    uint32_t count = 0;
+    for (uint32_t i = begin; i < end; ++i) {
+      bool inside = true;
+      for (int p = 0; p < 6; ++p) {
+        float distance = x[i] * planes[p][0] + y[i] * planes[p][1] + z[i] * planes[p][2] + planes[p][3];
+        inside &= distance >= -radius[i];
+      }
+      // store unconditionally and only advance on a hit, no branch to mispredict
+      out[count] = i;
+      count += inside ? 1 : 0;
+    }
+    return count;
+  }
+
+#ifdef FRUSTUM_CULL_X64
+  uint32_t cull_sse(const float planes[6][4], const float* x, const float* y, const float* z, const float* radius,
+    uint32_t begin, uint32_t end, uint32_t* out) {
+    __m128 plane[6][4];
+    for (int p = 0; p < 6; ++p) {
+      for (int c = 0; c < 4; ++c) {
+        plane[p][c] = _mm_set1_ps(planes[p][c]);
+      }
+    }
+    const __m128 zero = _mm_setzero_ps();
+
+    uint32_t count = 0;
+    uint32_t i = begin;
+    for (; i + 4 <= end; i += 4) {
+      __m128 px = _mm_loadu_ps(x + i);
+      __m128 py = _mm_loadu_ps(y + i);
+      __m128 pz = _mm_loadu_ps(z + i);
+      __m128 negative_radius = _mm_sub_ps(zero, _mm_loadu_ps(radius + i));
+
+      __m128 inside = _mm_castsi128_ps(_mm_set1_epi32(-1));
+      for (int p = 0; p < 6; ++p) {
+        __m128 distance = _mm_add_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(px, plane[p][0]), _mm_mul_ps(py, plane[p][1])),
+          _mm_mul_ps(pz, plane[p][2])), plane[p][3]);
+        inside = _mm_and_ps(inside, _mm_cmpge_ps(distance, negative_radius));
+      }
+
+      int mask = _mm_movemask_ps(inside);
+      if (mask == 0) {
+        continue;
+      }
+      out[count] = i;
+      count += mask & 1;
+      out[count] = i + 1;
+      count += (mask >> 1) & 1;
+      out[count] = i + 2;
+      count += (mask >> 2) & 1;
+      out[count] = i + 3;
+      count += (mask >> 3) & 1;
+    }
+    return count + cull_scalar(planes, x, y, z, radius, i, end, out + count);
+  }
+
+  // for every 8 bit mask, the lanes that are set moved to the front and how many there are
+  struct CompactTable {
+    alignas(32) uint32_t Lanes[256][8];
+    uint8_t Count[256];
+
+    CompactTable() {
+      for (uint32_t mask = 0; mask < 256; ++mask) {
+        uint32_t count = 0;
+        for (uint32_t lane = 0; lane < 8; ++lane) {
+          if (mask & (1u << lane)) {
+            Lanes[mask][count++] = lane;
+          }
+        }
+        Count[mask] = static_cast<uint8_t>(count);
+        for (uint32_t lane = count; lane < 8; ++lane) {
+          Lanes[mask][lane] = 0;
+        }
+      }
+    }
+  };
+
+  const CompactTable& compact_table() {
+    static const CompactTable table;
+    return table;
+  }
+
+  FRUSTUM_CULL_AVX2_TARGET
+  uint32_t cull_avx2(const float planes[6][4], const float* x, const float* y, const float* z, const float* radius,
+    uint32_t begin, uint32_t end, uint32_t* out) {
+    const CompactTable& table = compact_table();
+
+    __m256 plane[6][4];
+    for (int p = 0; p < 6; ++p) {
+      for (int c = 0; c < 4; ++c) {
+        plane[p][c] = _mm256_set1_ps(planes[p][c]);
+      }
+    }
+    const __m256 zero = _mm256_setzero_ps();
+    const __m256i lane_offsets = _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7);
+
+    uint32_t count = 0;
+    uint32_t i = begin;
+    for (; i + 8 <= end; i += 8) {
+      __m256 px = _mm256_loadu_ps(x + i);
+      __m256 py = _mm256_loadu_ps(y + i);
+      __m256 pz = _mm256_loadu_ps(z + i);
+      __m256 negative_radius = _mm256_sub_ps(zero, _mm256_loadu_ps(radius + i));
+
+      __m256 inside = _mm256_castsi256_ps(_mm256_set1_epi32(-1));
+      for (int p = 0; p < 6; ++p) {
+        __m256 distance = _mm256_add_ps(_mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(px, plane[p][0]), _mm256_mul_ps(py, plane[p][1])),
+          _mm256_mul_ps(pz, plane[p][2])), plane[p][3]);
+        inside = _mm256_and_ps(inside, _mm256_cmp_ps(distance, negative_radius, _CMP_GE_OQ));
+      }
+
+      int mask = _mm256_movemask_ps(inside);
+      if (mask == 0) {
+        continue;
+      }
+      // count <= i - begin, so the full 8 lane store stays inside out
+      __m256i indices = _mm256_add_epi32(_mm256_set1_epi32(static_cast<int>(i)), lane_offsets);
+      __m256i shuffle = _mm256_load_si256(reinterpret_cast<const __m256i*>(table.Lanes[mask]));
+      _mm256_storeu_si256(reinterpret_cast<__m256i*>(out + count), _mm256_permutevar8x32_epi32(indices, shuffle));
+      count += table.Count[mask];
+    }
+    return count + cull_scalar(planes, x, y, z, radius, i, end, out + count);
+  }
+
+  bool cpu_has_avx2() {
+#ifdef _MSC_VER
+    int info[4];
+    __cpuid(info, 0);
+    if (info[0] < 7) {
+      return false;
+    }
+    __cpuid(info, 1);
+    // the OS has to save ymm registers as well as the CPU having them
+    bool osxsave = (info[2] & (1 << 27)) != 0;
+    if (!osxsave || (_xgetbv(0) & 0x6) != 0x6) {
+      return false;
+    }
+    __cpuidex(info, 7, 0);
+    return (info[1] & (1 << 5)) != 0;
+#else
+    return __builtin_cpu_supports("avx2");
+#endif
+  }
+#endif
+
+#ifdef FRUSTUM_CULL_NEON
+  uint32_t cull_neon(const float planes[6][4], const float* x, const float* y, const float* z, const float* radius,
+    uint32_t begin, uint32_t end, uint32_t* out) {
+    float32x4_t plane[6][4];
+    for (int p = 0; p < 6; ++p) {
+      for (int c = 0; c < 4; ++c) {
+        plane[p][c] = vdupq_n_f32(planes[p][c]);
+      }
+    }
+
+    uint32_t count = 0;
+    uint32_t i = begin;
+    for (; i + 4 <= end; i += 4) {
+      float32x4_t px = vld1q_f32(x + i);
+      float32x4_t py = vld1q_f32(y + i);
+      float32x4_t pz = vld1q_f32(z + i);
+      float32x4_t negative_radius = vnegq_f32(vld1q_f32(radius + i));
+
+      uint32x4_t inside = vdupq_n_u32(0xFFFFFFFFu);
+      for (int p = 0; p < 6; ++p) {
+        float32x4_t distance = vaddq_f32(vaddq_f32(vaddq_f32(vmulq_f32(px, plane[p][0]), vmulq_f32(py, plane[p][1])),
+          vmulq_f32(pz, plane[p][2])), plane[p][3]);
+        inside = vandq_u32(inside, vcgeq_f32(distance, negative_radius));
+      }
+
+      // 0 or 1 per lane
+      uint32x4_t hits = vshrq_n_u32(inside, 31);
+      if (vgetq_lane_u64(vreinterpretq_u64_u32(hits), 0) == 0 && vgetq_lane_u64(vreinterpretq_u64_u32(hits), 1) == 0) {
+        continue;
+      }
+      out[count] = i;
+      count += vgetq_lane_u32(hits, 0);
+      out[count] = i + 1;
+      count += vgetq_lane_u32(hits, 1);
+      out[count] = i + 2;
+      count += vgetq_lane_u32(hits, 2);
+      out[count] = i + 3;
+      count += vgetq_lane_u32(hits, 3);
+    }
+    return count + cull_scalar(planes, x, y, z, radius, i, end, out + count);
+  }
+#endif
+}
+
+const char* cull_kernel_name(CullKernel kernel) {
+  switch (kernel) {
+  case CullKernel::Sse:
+    return "sse";
+  case CullKernel::Avx2:
+    return "avx2";
+  case CullKernel::Neon:
+    return "neon";
+  case CullKernel::Scalar:
+  default:
+    return "scalar";
+  }
+}
+
+bool cull_kernel_supported(CullKernel kernel) {
+  switch (kernel) {
+  case CullKernel::Scalar:
+    return true;
+#ifdef FRUSTUM_CULL_X64
+  case CullKernel::Sse:
+    return true;
+  case CullKernel::Avx2: {
+    static const bool avx2 = cpu_has_avx2();
+    return avx2;
+  }
+#endif
+#ifdef FRUSTUM_CULL_NEON
+  case CullKernel::Neon:
+    return true;
+#endif
+  default:
+    return false;
+  }
+}
+
+CullKernel best_cull_kernel() {
+  for (CullKernel kernel : { CullKernel::Avx2, CullKernel::Sse, CullKernel::Neon }) {
+    if (cull_kernel_supported(kernel)) {
+      return kernel;
+    }
+  }
+  return CullKernel::Scalar;
+}
+
+uint32_t cull_spheres(CullKernel kernel, const float planes[6][4], const float* x, const float* y, const float* z,
+  const float* radius, uint32_t begin, uint32_t end, uint32_t* out) {
+  switch (kernel) {
+#ifdef FRUSTUM_CULL_X64
+  case CullKernel::Sse:
+    return cull_sse(planes, x, y, z, radius, begin, end, out);
+  case CullKernel::Avx2:
+    return cull_avx2(planes, x, y, z, radius, begin, end, out);
+#endif
+#ifdef FRUSTUM_CULL_NEON
+  case CullKernel::Neon:
+    return cull_neon(planes, x, y, z, radius, begin, end, out);
+#endif
+  default:
+    return cull_scalar(planes, x, y, z, radius, begin, end, out);
+  }
+}
+
+FrustumCuller::FrustumCuller(CullKernel kernel)
+  : kernel_(kernel) {
+  if (!cull_kernel_supported(kernel_)) {
+    LOG_WARN("Cull kernel " << cull_kernel_name(kernel_) << " is not supported here, falling back to " << cull_kernel_name(best_cull_kernel()));
+    kernel_ = best_cull_kernel();
+  }
+}
+
+uint32_t FrustumCuller::cull(const SceneStore& scene, const float planes[6][4], std::vector<uint32_t>& visible, JobSystem* jobs) {
+  uint32_t count = scene.size();
+  // the kernels write every candidate, so they go to scratch and only the hits are copied out
+  if (scratch_.size() < count) {
+    scratch_.resize(count);
+  }
+
+  const float* x = scene.bounds_x();
+  const float* y = scene.bounds_y();
+  const float* z = scene.bounds_z();
+  const float* radius = scene.bounds_radius();
+
+  if (!jobs || count < MinParallelSpheres) {
+    uint32_t found = cull_spheres(kernel_, planes, x, y, z, radius, 0, count, scratch_.data());
+    visible.assign(scratch_.begin(), scratch_.begin() + found);
+    return found;
+  }
+
+  uint32_t chunks = (std::min)(count, jobs->worker_count() * ChunksPerWorker);
+  chunk_counts_.assign(chunks, 0);
+  chunk_begins_.assign(chunks, 0);
+  jobs->parallel_for(count, chunks, [&](uint32_t chunk, uint32_t begin, uint32_t end, uint32_t) {
+    // each range writes from its own first index, so no two chunks overlap
+    chunk_begins_[chunk] = begin;
+    chunk_counts_[chunk] = cull_spheres(kernel_, planes, x, y, z, radius, begin, end, scratch_.data() + begin);
+  });
+
+  uint32_t found = 0;
+  for (uint32_t chunk_count : chunk_counts_) {
+    found += chunk_count;
+  }
+  visible.resize(found);
+
+  // concatenate the per-chunk runs in order, so the list stays ascending
+  uint32_t offset = 0;
+  for (uint32_t chunk = 0; chunk < chunks; ++chunk) {
+    memcpy(visible.data() + offset, scratch_.data() + chunk_begins_[chunk], chunk_counts_[chunk] * sizeof(uint32_t));
+    offset += chunk_counts_[chunk];
+  }
+  return found;
+}
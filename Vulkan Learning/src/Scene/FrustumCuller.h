@@ -0,0 +1,49 @@
+#pragma once
+#include "Headers.h"
+
+class JobSystem;
+class SceneStore;
+
+// instruction set the sphere test runs with, every kernel gives the same list
+enum class CullKernel {
+  Scalar,
+  // 4 spheres per step, always available on x64
+  Sse,
+  // 8 spheres per step, compaction through a permute table, picked at runtime
+  Avx2,
+  // 4 spheres per step on ARM
+  Neon
+};
+
+const char* cull_kernel_name(CullKernel kernel);
+bool cull_kernel_supported(CullKernel kernel);
+// the widest kernel this CPU runs
+CullKernel best_cull_kernel();
+
+// writes the index of every sphere in [begin, end) that touches the frustum to
+// out in ascending order and returns how many there were. Planes use the
+// CullView::Frustum convention (normalised, inside when dot(xyz, p) + w >= 0),
+// out needs room for end - begin indices.
+uint32_t cull_spheres(CullKernel kernel, const float planes[6][4], const float* x, const float* y, const float* z,
+  const float* radius, uint32_t begin, uint32_t end, uint32_t* out);
+
+// Culls a SceneStore's world bounds into a compact list of dense indices. The
+// list is meant to be handed to ParallelRecorder::record as the item range, so
+// the recorder only ever walks visible nodes.
+class FrustumCuller {
+public:
+  FrustumCuller(CullKernel kernel = best_cull_kernel());
+
+  // splits the scene into contiguous ranges across the job system when there
+  // is one, each range culls into its own stretch of scratch and the runs are
+  // concatenated in order
+  uint32_t cull(const SceneStore& scene, const float planes[6][4], std::vector<uint32_t>& visible, JobSystem* jobs = nullptr);
+
+  CullKernel kernel() const { return kernel_; }
+
+private:
+  CullKernel kernel_;
+  std::vector<uint32_t> scratch_;
+  std::vector<uint32_t> chunk_counts_;
+  std::vector<uint32_t> chunk_begins_;
+};
@@ -0,0 +1,140 @@
+#include "Scene/SceneBenchmark.h"
+#include "Scene/FrustumCuller.h"
+#include "Scene/SceneStore.h"
+#include "JobSystem.h"
+
+#include <chrono>
+#include <cmath>
+#include <random>
+
+namespace {
+  constexpr uint32_t UpdateFrames = 10;
+  constexpr uint32_t CullFrames = 50;
+  // children per root, the hierarchy is two levels deep
+  constexpr uint32_t ClusterSize = 64;
+  constexpr float WorldExtent = 2000.0f;
+  constexpr float ZFar = 1000.0f;
+
+  double elapsed_ms(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+  }
+
+  // clusters of small props scattered through a cube around the camera
+  void build_scene(SceneStore& scene, uint32_t objects) {
+    std::mt19937 rng(1234);
+    std::uniform_real_distribution<float> world(-WorldExtent, WorldExtent);
+    std::uniform_real_distribution<float> offset(-20.0f, 20.0f);
+    std::uniform_real_distribution<float> angle(0.0f, 6.2831853f);
+    std::uniform_real_distribution<float> radius(0.5f, 2.0f);
+
+    SceneHandle root;
+    for (uint32_t i = 0; i < objects; ++i) {
+      SceneNodeDesc desc;
+      desc.BoundsRadius = radius(rng);
+      desc.Mesh = i % 16;
+      desc.Material = i % 7;
+
+      if (i % ClusterSize == 0) {
+        desc.Local.Position[0] = world(rng);
+        desc.Local.Position[1] = world(rng) * 0.1f;
+        desc.Local.Position[2] = world(rng);
+        float half = angle(rng) * 0.5f;
+        desc.Local.Rotation[1] = std::sin(half);
+        desc.Local.Rotation[3] = std::cos(half);
+        root = scene.create(desc);
+        continue;
+      }
+
+      desc.Parent = root;
+      desc.Local.Position[0] = offset(rng);
+      desc.Local.Position[1] = offset(rng) * 0.25f;
+      desc.Local.Position[2] = offset(rng);
+      scene.create(desc);
+    }
+  }
+
+  // camera at the origin turning around y, 60 degree vertical fov at 16:9
+  void camera_planes(float yaw, float planes[6][4]) {
+    const float half_y = 0.5f * 1.0471976f;
+    float half_x = std::atan(std::tan(half_y) * 16.0f / 9.0f);
+
+    float forward[3] = { std::sin(yaw), 0.0f, std::cos(yaw) };
+    float right[3] = { std::cos(yaw), 0.0f, -std::sin(yaw) };
+    float up[3] = { 0.0f, 1.0f, 0.0f };
+
+    auto side = [&](int p, const float* axis, float sign, float half) {
+      for (int c = 0; c < 3; ++c) {
+        planes[p][c] = sign * axis[c] * std::cos(half) + forward[c] * std::sin(half);
+      }
+      planes[p][3] = 0.0f;
+    };
+    side(0, right, 1.0f, half_x);
+    side(1, right, -1.0f, half_x);
+    side(2, up, 1.0f, half_y);
+    side(3, up, -1.0f, half_y);
+    for (int c = 0; c < 3; ++c) {
+      planes[4][c] = forward[c];
+      planes[5][c] = -forward[c];
+    }
+    planes[4][3] = -0.1f;
+    planes[5][3] = ZFar;
+  }
+
+  void benchmark_update(SceneStore& scene, JobSystem* jobs, const char* label) {
+    auto start = std::chrono::steady_clock::now();
+    for (uint32_t frame = 0; frame < UpdateFrames; ++frame) {
+      scene.update_transforms(jobs);
+    }
+    double ms = elapsed_ms(start) / UpdateFrames;
+    std::cout << "  update " << label << ": " << ms << "ms per frame (" << scene.size() / ms / 1000.0 << "M nodes/s)" << std::endl;
+  }
+
+  // returns the visible total over all frames so kernels can be checked against each other
+  uint64_t benchmark_cull(const SceneStore& scene, CullKernel kernel, JobSystem* jobs, const char* label) {
+    FrustumCuller culler(kernel);
+    std::vector<uint32_t> visible;
+    visible.reserve(scene.size());
+
+    float planes[6][4];
+    uint64_t total_visible = 0;
+    double total_ms = 0.0;
+    for (uint32_t frame = 0; frame < CullFrames; ++frame) {
+      camera_planes(6.2831853f * frame / CullFrames, planes);
+      auto start = std::chrono::steady_clock::now();
+      total_visible += culler.cull(scene, planes, visible, jobs);
+      total_ms += elapsed_ms(start);
+    }
+
+    double ms = total_ms / CullFrames;
+    std::cout << "  cull " << cull_kernel_name(culler.kernel()) << " " << label << ": " << ms << "ms per frame ("
+      << scene.size() / ms / 1000.0 << "M spheres/s), " << total_visible / CullFrames << " visible" << std::endl;
+    return total_visible;
+  }
+}
+
+void run_scene_benchmark(uint32_t objects, uint32_t worker_threads) {
+  SceneStore scene;
+  auto start = std::chrono::steady_clock::now();
+  build_scene(scene, objects);
+  scene.update_transforms();
+  std::cout << "Scene: " << scene.size() << " nodes in " << scene.levels() << " levels, built in " << elapsed_ms(start) << "ms" << std::endl;
+
+  JobSystem jobs(worker_threads);
+  std::string workers = std::to_string(jobs.worker_count()) + (jobs.worker_count() == 1 ? " worker" : " workers");
+
+  benchmark_update(scene, nullptr, "1 thread");
+  benchmark_update(scene, &jobs, workers.c_str());
+
+  uint64_t reference = benchmark_cull(scene, CullKernel::Scalar, nullptr, "1 thread");
+  for (CullKernel kernel : { CullKernel::Sse, CullKernel::Avx2, CullKernel::Neon }) {
+    if (!cull_kernel_supported(kernel)) {
+      continue;
+    }
+    if (benchmark_cull(scene, kernel, nullptr, "1 thread") != reference) {
+      LOG_WARN("Cull kernel " << cull_kernel_name(kernel) << " disagrees with the scalar kernel");
+    }
+  }
+  if (benchmark_cull(scene, best_cull_kernel(), &jobs, workers.c_str()) != reference) {
+    LOG_WARN("Parallel culling disagrees with the scalar kernel");
+  }
+}
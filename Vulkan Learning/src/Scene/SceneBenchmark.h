@@ -0,0 +1,6 @@
+#pragma once
+#include "Headers.h"
+
+// hierarchical transform updates and frustum culling of `objects` bounding
+// spheres on one thread, every cull kernel and all workers, no device needed
+void run_scene_benchmark(uint32_t objects, uint32_t worker_threads);
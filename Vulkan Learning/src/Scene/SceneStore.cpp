@@ -0,0 +1,276 @@
+#include "Scene/SceneStore.h"
+#include "JobSystem.h"
+
+#include <cmath>
+#include <cstring>
+
+namespace {
+  // levels smaller than this are cheaper to run inline than to hand out
+  constexpr uint32_t MinParallelNodes = 4096;
+  // chunks per worker, a few so a slow worker does not hold up the level
+  constexpr uint32_t ChunksPerWorker = 4;
+
+  // a = b * c for affine 3x4 column-major matrices
+  void multiply(const float* b, const float* c, float* a) {
+    for (int column = 0; column < 4; ++column) {
+      for (int row = 0; row < 3; ++row) {
+        float value = b[row] * c[column * 3 + 0] + b[3 + row] * c[column * 3 + 1] + b[6 + row] * c[column * 3 + 2];
+        a[column * 3 + row] = column == 3 ? value + b[9 + row] : value;
+      }
+    }
+  }
+}
+
+SceneHandle SceneStore::create(const SceneNodeDesc& desc) {
+  if (desc.Parent.valid() && !alive(desc.Parent)) {
+    throw std::runtime_error("Failed to create scene node, the parent is not alive!");
+  }
+
+  uint32_t index;
+  if (!free_slots_.empty()) {
+    index = free_slots_.back();
+    free_slots_.pop_back();
+  }
+  else {
+    index = static_cast<uint32_t>(slots_.size());
+    slots_.push_back({});
+  }
+
+  Slot& slot = slots_[index];
+  slot.Dense = size();
+  SceneHandle handle{ index, slot.Generation };
+
+  handles_.push_back(handle);
+  parent_handles_.push_back(desc.Parent);
+  parent_.push_back(UINT32_MAX);
+  position_x_.push_back(desc.Local.Position[0]);
+  position_y_.push_back(desc.Local.Position[1]);
+  position_z_.push_back(desc.Local.Position[2]);
+  rotation_x_.push_back(desc.Local.Rotation[0]);
+  rotation_y_.push_back(desc.Local.Rotation[1]);
+  rotation_z_.push_back(desc.Local.Rotation[2]);
+  rotation_w_.push_back(desc.Local.Rotation[3]);
+  scale_.push_back(desc.Local.Scale);
+  local_x_.push_back(desc.BoundsCenter[0]);
+  local_y_.push_back(desc.BoundsCenter[1]);
+  local_z_.push_back(desc.BoundsCenter[2]);
+  local_radius_.push_back(desc.BoundsRadius);
+  world_.push_back({});
+  world_scale_.push_back(1.0f);
+  world_x_.push_back(0.0f);
+  world_y_.push_back(0.0f);
+  world_z_.push_back(0.0f);
+  world_radius_.push_back(0.0f);
+  mesh_.push_back(desc.Mesh);
+  material_.push_back(desc.Material);
+
+  order_dirty_ = true;
+  return handle;
+}
+
+void SceneStore::destroy(SceneHandle handle) {
+  uint32_t dense = checked_dense(handle);
+  erase_dense(dense);
+
+  Slot& slot = slots_[handle.Index];
+  slot.Dense = UINT32_MAX;
+  ++slot.Generation;
+  free_slots_.push_back(handle.Index);
+
+  // orphaned children are found by their dead parent handle on the next sort
+  order_dirty_ = true;
+}
+
+bool SceneStore::alive(SceneHandle handle) const {
+  return handle.Index < slots_.size() && slots_[handle.Index].Generation == handle.Generation && slots_[handle.Index].Dense != UINT32_MAX;
+}
+
+uint32_t SceneStore::dense_index(SceneHandle handle) const {
+  return alive(handle) ? slots_[handle.Index].Dense : UINT32_MAX;
+}
+
+uint32_t SceneStore::checked_dense(SceneHandle handle) const {
+  if (!alive(handle)) {
+    throw std::runtime_error("Failed to find scene node, the handle is stale!");
+  }
+  return slots_[handle.Index].Dense;
+}
+
+void SceneStore::set_local(SceneHandle handle, const SceneTransform& local) {
+  uint32_t dense = checked_dense(handle);
+  position_x_[dense] = local.Position[0];
+  position_y_[dense] = local.Position[1];
+  position_z_[dense] = local.Position[2];
+  rotation_x_[dense] = local.Rotation[0];
+  rotation_y_[dense] = local.Rotation[1];
+  rotation_z_[dense] = local.Rotation[2];
+  rotation_w_[dense] = local.Rotation[3];
+  scale_[dense] = local.Scale;
+}
+
+SceneTransform SceneStore::local(SceneHandle handle) const {
+  uint32_t dense = checked_dense(handle);
+  SceneTransform local;
+  local.Position[0] = position_x_[dense];
+  local.Position[1] = position_y_[dense];
+  local.Position[2] = position_z_[dense];
+  local.Rotation[0] = rotation_x_[dense];
+  local.Rotation[1] = rotation_y_[dense];
+  local.Rotation[2] = rotation_z_[dense];
+  local.Rotation[3] = rotation_w_[dense];
+  local.Scale = scale_[dense];
+  return local;
+}
+
+void SceneStore::set_parent(SceneHandle handle, SceneHandle parent) {
+  uint32_t dense = checked_dense(handle);
+  if (parent.valid()) {
+    // walk up from the new parent, reaching the node means a cycle
+    for (SceneHandle ancestor = parent; alive(ancestor); ancestor = parent_handles_[slots_[ancestor.Index].Dense]) {
+      if (ancestor == handle) {
+        throw std::runtime_error("Failed to set scene parent, it would create a cycle!");
+      }
+    }
+    checked_dense(parent);
+  }
+  parent_handles_[dense] = parent;
+  order_dirty_ = true;
+}
+
+void SceneStore::set_bounds(SceneHandle handle, const float center[3], float radius) {
+  uint32_t dense = checked_dense(handle);
+  local_x_[dense] = center[0];
+  local_y_[dense] = center[1];
+  local_z_[dense] = center[2];
+  local_radius_[dense] = radius;
+}
+
+void SceneStore::set_render(SceneHandle handle, uint32_t mesh, uint32_t material) {
+  uint32_t dense = checked_dense(handle);
+  mesh_[dense] = mesh;
+  material_[dense] = material;
+}
+
+void SceneStore::erase_dense(uint32_t dense) {
+  uint32_t last = size() - 1;
+  if (dense != last) {
+    slots_[handles_[last].Index].Dense = dense;
+  }
+  for_each_array([dense, last](auto& array) {
+    array[dense] = array[last];
+    array.pop_back();
+  });
+}
+
+void SceneStore::sort_by_depth() {
+  uint32_t count = size();
+
+  // resolve parent handles against the current order, dead parents make roots
+  for (uint32_t i = 0; i < count; ++i) {
+    if (parent_handles_[i].valid() && !alive(parent_handles_[i])) {
+      parent_handles_[i] = SceneHandle{};
+    }
+    parent_[i] = dense_index(parent_handles_[i]);
+  }
+
+  // depth of every node, each chain is walked once and memoised on the way back
+  std::vector<uint32_t> depth(count, UINT32_MAX);
+  std::vector<uint32_t> chain;
+  uint32_t max_depth = 0;
+  for (uint32_t i = 0; i < count; ++i) {
+    uint32_t node = i;
+    while (node != UINT32_MAX && depth[node] == UINT32_MAX) {
+      chain.push_back(node);
+      node = parent_[node];
+    }
+    uint32_t d = node == UINT32_MAX ? 0 : depth[node] + 1;
+    while (!chain.empty()) {
+      depth[chain.back()] = d++;
+      chain.pop_back();
+    }
+    max_depth = (std::max)(max_depth, depth[i]);
+  }
+
+  // counting sort keeps the existing order inside a level
+  level_offsets_.assign(count ? max_depth + 2 : 1, 0);
+  for (uint32_t i = 0; i < count; ++i) {
+    ++level_offsets_[depth[i] + 1];
+  }
+  for (size_t level = 1; level < level_offsets_.size(); ++level) {
+    level_offsets_[level] += level_offsets_[level - 1];
+  }
+  std::vector<uint32_t> order(count);
+  std::vector<uint32_t> cursor(level_offsets_.begin(), level_offsets_.end() - 1);
+  for (uint32_t i = 0; i < count; ++i) {
+    order[cursor[depth[i]]++] = i;
+  }
+
+  for_each_array([&order](auto& array) {
+    auto sorted = array;
+    for (size_t i = 0; i < order.size(); ++i) {
+      sorted[i] = array[order[i]];
+    }
+    array.swap(sorted);
+  });
+
+  for (uint32_t i = 0; i < count; ++i) {
+    slots_[handles_[i].Index].Dense = i;
+  }
+  for (uint32_t i = 0; i < count; ++i) {
+    parent_[i] = dense_index(parent_handles_[i]);
+  }
+
+  order_dirty_ = false;
+}
+
+void SceneStore::update_range(uint32_t begin, uint32_t end) {
+  for (uint32_t i = begin; i < end; ++i) {
+    float x = rotation_x_[i], y = rotation_y_[i], z = rotation_z_[i], w = rotation_w_[i];
+    float s = scale_[i];
+
+    float local[12] = {
+      s * (1.0f - 2.0f * (y * y + z * z)), s * (2.0f * (x * y + z * w)), s * (2.0f * (x * z - y * w)),
+      s * (2.0f * (x * y - z * w)), s * (1.0f - 2.0f * (x * x + z * z)), s * (2.0f * (y * z + x * w)),
+      s * (2.0f * (x * z + y * w)), s * (2.0f * (y * z - x * w)), s * (1.0f - 2.0f * (x * x + y * y)),
+      position_x_[i], position_y_[i], position_z_[i]
+    };
+
+    float* world = world_[i].M;
+    uint32_t parent = parent_[i];
+    if (parent == UINT32_MAX) {
+      memcpy(world, local, sizeof(local));
+      world_scale_[i] = s;
+    }
+    else {
+      multiply(world_[parent].M, local, world);
+      world_scale_[i] = world_scale_[parent] * s;
+    }
+
+    float cx = local_x_[i], cy = local_y_[i], cz = local_z_[i];
+    world_x_[i] = world[0] * cx + world[3] * cy + world[6] * cz + world[9];
+    world_y_[i] = world[1] * cx + world[4] * cy + world[7] * cz + world[10];
+    world_z_[i] = world[2] * cx + world[5] * cy + world[8] * cz + world[11];
+    world_radius_[i] = local_radius_[i] * std::fabs(world_scale_[i]);
+  }
+}
+
+void SceneStore::update_transforms(JobSystem* jobs) {
+  if (order_dirty_) {
+    sort_by_depth();
+  }
+
+  for (uint32_t level = 0; level < levels(); ++level) {
+    uint32_t begin = level_offsets_[level];
+    uint32_t count = level_offsets_[level + 1] - begin;
+
+    if (!jobs || count < MinParallelNodes) {
+      update_range(begin, begin + count);
+      continue;
+    }
+
+    // every parent is in an earlier level, so ranges of one level never race
+    jobs->parallel_for(count, jobs->worker_count() * ChunksPerWorker, [this, begin](uint32_t, uint32_t first, uint32_t last, uint32_t) {
+      update_range(begin + first, begin + last);
+    });
+  }
+}
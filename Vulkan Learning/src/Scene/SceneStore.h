@@ -0,0 +1,121 @@
+#pragma once
+#include "Headers.h"
+
+class JobSystem;
+
+// index into the slot table plus the generation it was created with, stays
+// valid across other nodes being added, removed or reordered
+struct SceneHandle {
+  uint32_t Index = UINT32_MAX;
+  uint32_t Generation = 0;
+
+  bool valid() const { return Index != UINT32_MAX; }
+  bool operator==(const SceneHandle& other) const { return Index == other.Index && Generation == other.Generation; }
+  bool operator!=(const SceneHandle& other) const { return !(*this == other); }
+};
+
+struct SceneTransform {
+  float Position[3] = { 0.0f, 0.0f, 0.0f };
+  // unit quaternion x, y, z, w
+  float Rotation[4] = { 0.0f, 0.0f, 0.0f, 1.0f };
+  // uniform so a bounding sphere stays a sphere
+  float Scale = 1.0f;
+};
+
+// column-major 3x4, the implicit last row is 0 0 0 1
+struct SceneMatrix {
+  float M[12];
+};
+
+struct SceneNodeDesc {
+  SceneTransform Local;
+  // sphere in the node's local space
+  float BoundsCenter[3] = { 0.0f, 0.0f, 0.0f };
+  float BoundsRadius = 0.0f;
+  uint32_t Mesh = 0;
+  uint32_t Material = 0;
+  SceneHandle Parent;
+};
+
+// Structure-of-arrays scene storage. Every per-node property lives in its own
+// dense array so the transform update and the culling kernel stream exactly
+// the fields they touch. Dense order is by hierarchy depth, so every level is
+// one contiguous range whose parents were all written by the previous level;
+// edits only mark the order stale and the next update re-sorts once.
+class SceneStore {
+public:
+  SceneHandle create(const SceneNodeDesc& desc);
+  // children of a destroyed node become roots and keep their local transform
+  void destroy(SceneHandle handle);
+  bool alive(SceneHandle handle) const;
+
+  void set_local(SceneHandle handle, const SceneTransform& local);
+  SceneTransform local(SceneHandle handle) const;
+  // throws when the new parent is the node itself or one of its descendants
+  void set_parent(SceneHandle handle, SceneHandle parent);
+  void set_bounds(SceneHandle handle, const float center[3], float radius);
+  void set_render(SceneHandle handle, uint32_t mesh, uint32_t material);
+
+  // recomputes world matrices and world bounds level by level, each level
+  // split into contiguous ranges across the job system when there is one
+  void update_transforms(JobSystem* jobs = nullptr);
+
+  uint32_t size() const { return static_cast<uint32_t>(handles_.size()); }
+  uint32_t levels() const { return static_cast<uint32_t>(level_offsets_.size()) - 1; }
+
+  // dense arrays, valid until the next create/destroy/set_parent + update
+  const SceneMatrix* world() const { return world_.data(); }
+  const float* bounds_x() const { return world_x_.data(); }
+  const float* bounds_y() const { return world_y_.data(); }
+  const float* bounds_z() const { return world_z_.data(); }
+  const float* bounds_radius() const { return world_radius_.data(); }
+  const uint32_t* meshes() const { return mesh_.data(); }
+  const uint32_t* materials() const { return material_.data(); }
+  SceneHandle handle(uint32_t dense) const { return handles_[dense]; }
+  uint32_t dense_index(SceneHandle handle) const;
+
+private:
+  struct Slot {
+    uint32_t Dense = UINT32_MAX;
+    uint32_t Generation = 0;
+  };
+
+  uint32_t checked_dense(SceneHandle handle) const;
+  void erase_dense(uint32_t dense);
+  void sort_by_depth();
+  void update_range(uint32_t begin, uint32_t end);
+
+  // every dense array, so erase and reorder cannot miss one
+  template <typename F>
+  void for_each_array(F&& f) {
+    f(handles_); f(parent_handles_); f(parent_);
+    f(position_x_); f(position_y_); f(position_z_);
+    f(rotation_x_); f(rotation_y_); f(rotation_z_); f(rotation_w_);
+    f(scale_);
+    f(local_x_); f(local_y_); f(local_z_); f(local_radius_);
+    f(world_); f(world_scale_);
+    f(world_x_); f(world_y_); f(world_z_); f(world_radius_);
+    f(mesh_); f(material_);
+  }
+
+  std::vector<Slot> slots_;
+  std::vector<uint32_t> free_slots_;
+
+  // dense, indexed together
+  std::vector<SceneHandle> handles_;
+  std::vector<SceneHandle> parent_handles_;
+  std::vector<uint32_t> parent_;
+  std::vector<float> position_x_, position_y_, position_z_;
+  std::vector<float> rotation_x_, rotation_y_, rotation_z_, rotation_w_;
+  std::vector<float> scale_;
+  std::vector<float> local_x_, local_y_, local_z_, local_radius_;
+  std::vector<SceneMatrix> world_;
+  std::vector<float> world_scale_;
+  std::vector<float> world_x_, world_y_, world_z_, world_radius_;
+  std::vector<uint32_t> mesh_;
+  std::vector<uint32_t> material_;
+
+  // level l occupies [level_offsets_[l], level_offsets_[l + 1])
+  std::vector<uint32_t> level_offsets_{ 0 };
+  bool order_dirty_ = false;
+};
@@ -0,0 +1,150 @@
+#include "Scheduling/AsyncComputeBenchmark.h"
+
+#include <chrono>
+
+namespace {
+  struct BusyPush {
+    uint32_t BufferIndex;
+    uint32_t Count;
+    uint32_t Iterations;
+  };
+}
+
+AsyncComputeBenchmark::AsyncComputeBenchmark(const vk::Device& device, MemoryAllocator& allocator, BindlessHeap& heap,
+  PipelineService& pipelines, QueueScheduler& scheduler, ShaderLibrary& shaders, uint32_t graphics_family,
+  uint32_t compute_family, const bool debug)
+  : device_(device), allocator_(allocator), heap_(heap), pipelines_(pipelines), scheduler_(scheduler), debug_(debug) {
+  ComputePipelineDesc desc{};
+  desc.Layout = heap_.pipeline_layout();
+  desc.Stage.Module = shaders.load(ShaderSource{ "busy.comp" });
+  pipeline_ = pipelines_.request_compute(desc);
+
+  graphics_work_ = create_workload(graphics_family, compute_family);
+  compute_work_ = create_workload(graphics_family, compute_family);
+  heap_.flush();
+
+  vk::CommandPoolCreateInfo pool_info{};
+  pool_info.flags = vk::CommandPoolCreateFlagBits::eResetCommandBuffer;
+  pool_info.queueFamilyIndex = graphics_family;
+  command_pool_ = device_.createCommandPool(pool_info);
+
+  vk::CommandBufferAllocateInfo alloc_info{};
+  alloc_info.commandPool = command_pool_;
+  alloc_info.level = vk::CommandBufferLevel::ePrimary;
+  alloc_info.commandBufferCount = Slots;
+  command_buffers_ = device_.allocateCommandBuffers(alloc_info);
+  slot_points_.resize(Slots);
+}
+
+AsyncComputeBenchmark::~AsyncComputeBenchmark() {
+  pipelines_.wait_idle();
+  for (const QueuePoint& point : slot_points_) {
+    scheduler_.wait(point);
+  }
+  for (uint32_t queue = 1; queue <= scheduler_.compute_queue_count(); ++queue) {
+    scheduler_.wait(scheduler_.last_point(queue));
+  }
+
+  destroy_workload(graphics_work_);
+  destroy_workload(compute_work_);
+  device_.destroyCommandPool(command_pool_);
+}
+
+void AsyncComputeBenchmark::run(uint32_t frames) {
+  pipelines_.wait_idle();
+  if (!pipeline_.ready()) {
+    LOG_ERROR("The async compute benchmark pipeline failed to compile");
+    return;
+  }
+
+  std::cout << "Async compute: " << frames << " frames of two " << ElementCount << "-thread dispatches, "
+    << scheduler_.compute_queue_count() << " compute queues" << (scheduler_.async_compute() ? "" : " sharing the graphics family")
+    << std::endl;
+
+  // the first frames warm clocks and caches for both modes
+  run_mode(false, (std::min)(frames, 10u));
+  double serial_ms = run_mode(false, frames);
+  double async_ms = run_mode(true, frames);
+
+  std::cout << "  serial: " << serial_ms / frames << "ms per frame" << std::endl;
+  std::cout << "  async:  " << async_ms / frames << "ms per frame, speedup " << serial_ms / async_ms << "x" << std::endl;
+  scheduler_.report();
+}
+
+AsyncComputeBenchmark::Workload AsyncComputeBenchmark::create_workload(uint32_t graphics_family, uint32_t compute_family) {
+  Workload workload;
+  uint32_t families[] = { graphics_family, compute_family };
+
+  // shared by both queues without ownership transfers, contents are never read back
+  vk::BufferCreateInfo buffer_info{};
+  buffer_info.size = static_cast<vk::DeviceSize>(ElementCount) * 4 * sizeof(float);
+  buffer_info.usage = vk::BufferUsageFlagBits::eStorageBuffer;
+  if (graphics_family != compute_family) {
+    buffer_info.sharingMode = vk::SharingMode::eConcurrent;
+    buffer_info.queueFamilyIndexCount = 2;
+    buffer_info.pQueueFamilyIndices = families;
+  }
+  else {
+    buffer_info.sharingMode = vk::SharingMode::eExclusive;
+  }
+  workload.Buffer = device_.createBuffer(buffer_info);
+  workload.Memory = allocator_.allocate_for_buffer(workload.Buffer, vk::MemoryPropertyFlagBits::eDeviceLocal);
+  workload.Slot = heap_.add_storage_buffer(workload.Buffer);
+  return workload;
+}
+
+void AsyncComputeBenchmark::destroy_workload(Workload& workload) {
+  if (workload.Slot != BindlessHeap::InvalidSlot) {
+    heap_.release(BindlessType::StorageBuffer, workload.Slot);
+  }
+  device_.destroyBuffer(workload.Buffer);
+  allocator_.free(workload.Memory);
+}
+
+void AsyncComputeBenchmark::record_dispatch(vk::CommandBuffer command_buffer, const Workload& workload) {
+  BusyPush push{ workload.Slot, ElementCount, Iterations };
+  heap_.bind(command_buffer, vk::PipelineBindPoint::eCompute);
+  heap_.push(command_buffer, &push, sizeof(push));
+  command_buffer.bindPipeline(vk::PipelineBindPoint::eCompute, pipeline_.get_or(nullptr));
+  command_buffer.dispatch(ElementCount / 256, 1, 1);
+}
+
+double AsyncComputeBenchmark::run_mode(bool async, uint32_t frames) {
+  QueuePoint graphics_done;
+  QueuePoint compute_done;
+
+  auto start = std::chrono::steady_clock::now();
+  for (uint32_t frame = 0; frame < frames; ++frame) {
+    uint32_t slot = frame % Slots;
+    scheduler_.wait(slot_points_[slot]);
+
+    // frame N's post-processing reads frame N-1's output, points with a value of 0 wait on nothing
+    QueuePoint previous_compute = compute_done;
+    if (async) {
+      compute_done = scheduler_.submit_compute([this](vk::CommandBuffer command_buffer) {
+        record_dispatch(command_buffer, compute_work_);
+      }, { graphics_done });
+    }
+
+    vk::CommandBuffer command_buffer = command_buffers_[slot];
+    command_buffer.reset();
+    vk::CommandBufferBeginInfo begin_info{};
+    begin_info.flags = vk::CommandBufferUsageFlagBits::eOneTimeSubmit;
+    command_buffer.begin(begin_info);
+    record_dispatch(command_buffer, graphics_work_);
+    if (!async) {
+      record_dispatch(command_buffer, compute_work_);
+    }
+    command_buffer.end();
+
+    // and frame N's raster consumes the previous frame's compute results
+    QueueSubmit submit;
+    graphics_done = scheduler_.submit_graphics(submit, command_buffer, { previous_compute }, vk::PipelineStageFlagBits::eComputeShader,
+      nullptr);
+    slot_points_[slot] = graphics_done;
+  }
+
+  scheduler_.wait(graphics_done);
+  scheduler_.wait(compute_done);
+  return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
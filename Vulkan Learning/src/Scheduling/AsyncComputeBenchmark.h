@@ -0,0 +1,52 @@
+#pragma once
+#include "Headers.h"
+#include "Descriptors/BindlessHeap.h"
+#include "Memory/MemoryAllocator.h"
+#include "Pipelines/PipelineService.h"
+#include "Scheduling/QueueScheduler.h"
+#include "Shaders/ShaderLibrary.h"
+
+// Runs a graphics-side and a compute-side workload every frame, first both on
+// the graphics queue and then with the compute half on the async queue, where
+// frame N's compute waits on frame N-1's graphics and the other way round.
+// Both halves are the same ALU-bound dispatch standing in for raster and
+// post-processing; the frame time difference is how much the queues overlap.
+class AsyncComputeBenchmark {
+public:
+  AsyncComputeBenchmark(const vk::Device& device, MemoryAllocator& allocator, BindlessHeap& heap, PipelineService& pipelines,
+    QueueScheduler& scheduler, ShaderLibrary& shaders, uint32_t graphics_family, uint32_t compute_family, const bool debug);
+  ~AsyncComputeBenchmark();
+
+  void run(uint32_t frames);
+
+private:
+  struct Workload {
+    vk::Buffer Buffer;
+    MemoryAllocation Memory;
+    uint32_t Slot = BindlessHeap::InvalidSlot;
+  };
+
+  static constexpr uint32_t Slots = 3;
+  static constexpr uint32_t ElementCount = 1 << 20;
+  static constexpr uint32_t Iterations = 4096;
+
+  Workload create_workload(uint32_t graphics_family, uint32_t compute_family);
+  void destroy_workload(Workload& workload);
+  void record_dispatch(vk::CommandBuffer command_buffer, const Workload& workload);
+  double run_mode(bool async, uint32_t frames);
+
+  vk::Device device_;
+  MemoryAllocator& allocator_;
+  BindlessHeap& heap_;
+  PipelineService& pipelines_;
+  QueueScheduler& scheduler_;
+  bool debug_;
+
+  PipelineHandle pipeline_;
+  Workload graphics_work_;
+  Workload compute_work_;
+
+  vk::CommandPool command_pool_;
+  std::vector<vk::CommandBuffer> command_buffers_;
+  std::vector<QueuePoint> slot_points_;
+};
@@ -0,0 +1,194 @@
+#include "Scheduling/QueueScheduler.h"
+
+void QueueSubmit::wait(vk::Semaphore semaphore, vk::PipelineStageFlags stages, uint64_t value) {
+  WaitSemaphores.push_back(semaphore);
+  WaitStages.push_back(stages);
+  WaitValues.push_back(value);
+}
+
+void QueueSubmit::signal(vk::Semaphore semaphore, uint64_t value) {
+  SignalSemaphores.push_back(semaphore);
+  SignalValues.push_back(value);
+}
+
+QueueScheduler::QueueScheduler(const vk::Device& device, vk::Queue graphics_queue, std::vector<vk::Queue> compute_queues,
+  uint32_t compute_family, bool async_compute, const bool debug)
+  : device_(device), async_compute_(async_compute), debug_(debug) {
+  if (debug_) {
+    LOG_DEBUG("Creating Queue Scheduler with " << compute_queues.size() << " compute queues on family " << compute_family
+      << (async_compute_ ? " (async)" : " (shared with graphics)"));
+  }
+
+  vk::SemaphoreTypeCreateInfo type_info{};
+  type_info.semaphoreType = vk::SemaphoreType::eTimeline;
+  type_info.initialValue = 0;
+  vk::SemaphoreCreateInfo semaphore_info{};
+  semaphore_info.pNext = &type_info;
+
+  // even when a compute queue is the graphics queue, each role keeps its own monotonic timeline
+  timelines_.push_back({ graphics_queue, device_.createSemaphore(semaphore_info) });
+  for (vk::Queue queue : compute_queues) {
+    timelines_.push_back({ queue, device_.createSemaphore(semaphore_info) });
+  }
+  stats_.Submits.resize(timelines_.size(), 0);
+
+  vk::CommandPoolCreateInfo pool_info{};
+  pool_info.flags = vk::CommandPoolCreateFlagBits::eResetCommandBuffer | vk::CommandPoolCreateFlagBits::eTransient;
+  pool_info.queueFamilyIndex = compute_family;
+  command_pool_ = device_.createCommandPool(pool_info);
+}
+
+QueueScheduler::~QueueScheduler() {
+  for (uint32_t queue = 0; queue < timelines_.size(); ++queue) {
+    wait(last_point(queue));
+  }
+  for (const Timeline& timeline : timelines_) {
+    device_.destroySemaphore(timeline.Semaphore);
+  }
+  device_.destroyCommandPool(command_pool_);
+}
+
+QueuePoint QueueScheduler::submit_graphics(QueueSubmit& submit, vk::CommandBuffer command_buffer, const std::vector<QueuePoint>& waits,
+  vk::PipelineStageFlags wait_stages, vk::Fence fence) {
+  return this->submit(GraphicsQueue, submit, command_buffer, waits, wait_stages, fence);
+}
+
+QueuePoint QueueScheduler::submit_compute(const std::function<void(vk::CommandBuffer)>& record, const std::vector<QueuePoint>& waits,
+  vk::PipelineStageFlags wait_stages) {
+  collect();
+
+  vk::CommandBuffer command_buffer;
+  if (free_command_buffers_.empty()) {
+    vk::CommandBufferAllocateInfo alloc_info{};
+    alloc_info.commandPool = command_pool_;
+    alloc_info.level = vk::CommandBufferLevel::ePrimary;
+    alloc_info.commandBufferCount = 1;
+    command_buffer = device_.allocateCommandBuffers(alloc_info)[0];
+  }
+  else {
+    command_buffer = free_command_buffers_.back();
+    free_command_buffers_.pop_back();
+  }
+
+  vk::CommandBufferBeginInfo begin_info{};
+  begin_info.flags = vk::CommandBufferUsageFlagBits::eOneTimeSubmit;
+  command_buffer.begin(begin_info);
+  record(command_buffer);
+  command_buffer.end();
+
+  uint32_t queue = 1 + next_compute_;
+  next_compute_ = (next_compute_ + 1) % compute_queue_count();
+
+  QueueSubmit submit_info;
+  QueuePoint point = submit(queue, submit_info, command_buffer, waits, wait_stages, nullptr);
+  in_flight_.push_back({ command_buffer, point });
+  return point;
+}
+
+bool QueueScheduler::is_complete(const QueuePoint& point) {
+  return completed_value(point.Queue) >= point.Value;
+}
+
+void QueueScheduler::wait(const QueuePoint& point) {
+  if (point.Value == 0 || is_complete(point)) {
+    return;
+  }
+
+  vk::SemaphoreWaitInfo wait_info{};
+  wait_info.semaphoreCount = 1;
+  wait_info.pSemaphores = &timelines_[point.Queue].Semaphore;
+  wait_info.pValues = &point.Value;
+  (void)device_.waitSemaphores(wait_info, UINT64_MAX);
+  timelines_[point.Queue].Completed = (std::max)(timelines_[point.Queue].Completed, point.Value);
+}
+
+QueuePoint QueueScheduler::last_point(uint32_t queue) const {
+  return QueuePoint{ queue, timelines_[queue].Submitted };
+}
+
+uint32_t QueueScheduler::compute_queue_count() const {
+  return static_cast<uint32_t>(timelines_.size() - 1);
+}
+
+bool QueueScheduler::async_compute() const {
+  return async_compute_;
+}
+
+SchedulerStats QueueScheduler::stats() const {
+  return stats_;
+}
+
+void QueueScheduler::report() const {
+  std::cout << "Queue scheduler: graphics " << stats_.Submits[GraphicsQueue] << " submits";
+  for (uint32_t queue = 1; queue < stats_.Submits.size(); ++queue) {
+    std::cout << ", compute " << queue - 1 << " " << stats_.Submits[queue] << " submits";
+  }
+  std::cout << ", " << stats_.CrossQueueWaits << " cross-queue waits, " << stats_.CompletedWaits << " already complete"
+    << (async_compute_ ? "" : " (no async compute family)") << std::endl;
+}
+
+QueuePoint QueueScheduler::submit(uint32_t queue, QueueSubmit& submit, vk::CommandBuffer command_buffer, const std::vector<QueuePoint>& waits,
+  vk::PipelineStageFlags wait_stages, vk::Fence fence) {
+  // one wait per queue on the latest point needed from it
+  std::vector<uint64_t> needed(timelines_.size(), 0);
+  for (const QueuePoint& point : waits) {
+    if (point.Value > timelines_[point.Queue].Submitted) {
+      throw std::runtime_error("Failed to schedule a wait on work that was never submitted!");
+    }
+    needed[point.Queue] = (std::max)(needed[point.Queue], point.Value);
+  }
+  for (uint32_t other = 0; other < timelines_.size(); ++other) {
+    if (needed[other] == 0) {
+      continue;
+    }
+    if (completed_value(other) >= needed[other]) {
+      ++stats_.CompletedWaits;
+      continue;
+    }
+    submit.wait(timelines_[other].Semaphore, wait_stages, needed[other]);
+    if (other != queue) {
+      ++stats_.CrossQueueWaits;
+    }
+  }
+
+  Timeline& timeline = timelines_[queue];
+  QueuePoint point{ queue, timeline.Submitted + 1 };
+  submit.signal(timeline.Semaphore, point.Value);
+
+  vk::TimelineSemaphoreSubmitInfo timeline_info{};
+  timeline_info.waitSemaphoreValueCount = static_cast<uint32_t>(submit.WaitValues.size());
+  timeline_info.pWaitSemaphoreValues = submit.WaitValues.data();
+  timeline_info.signalSemaphoreValueCount = static_cast<uint32_t>(submit.SignalValues.size());
+  timeline_info.pSignalSemaphoreValues = submit.SignalValues.data();
+
+  vk::SubmitInfo submit_info{};
+  submit_info.pNext = &timeline_info;
+  submit_info.waitSemaphoreCount = static_cast<uint32_t>(submit.WaitSemaphores.size());
+  submit_info.pWaitSemaphores = submit.WaitSemaphores.data();
+  submit_info.pWaitDstStageMask = submit.WaitStages.data();
+  submit_info.commandBufferCount = 1;
+  submit_info.pCommandBuffers = &command_buffer;
+  submit_info.signalSemaphoreCount = static_cast<uint32_t>(submit.SignalSemaphores.size());
+  submit_info.pSignalSemaphores = submit.SignalSemaphores.data();
+  timeline.Queue.submit(submit_info, fence);
+
+  timeline.Submitted = point.Value;
+  ++stats_.Submits[queue];
+  return point;
+}
+
+uint64_t QueueScheduler::completed_value(uint32_t queue) {
+  Timeline& timeline = timelines_[queue];
+  if (timeline.Completed < timeline.Submitted) {
+    timeline.Completed = device_.getSemaphoreCounterValue(timeline.Semaphore);
+  }
+  return timeline.Completed;
+}
+
+void QueueScheduler::collect() {
+  auto done = std::partition(in_flight_.begin(), in_flight_.end(), [this](const InFlight& entry) { return !is_complete(entry.Point); });
+  for (auto it = done; it != in_flight_.end(); ++it) {
+    free_command_buffers_.push_back(it->CommandBuffer);
+  }
+  in_flight_.erase(done, in_flight_.end());
+}
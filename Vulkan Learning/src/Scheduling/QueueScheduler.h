@@ -0,0 +1,102 @@
+#pragma once
+#include "Headers.h"
+
+#include <functional>
+#include <vector>
+
+// a value on one queue's timeline, Queue is QueueScheduler::GraphicsQueue or a compute queue index + 1
+struct QueuePoint {
+  uint32_t Queue = 0;
+  uint64_t Value = 0;
+};
+
+// waits and signals of one vkQueueSubmit, binary semaphores take a value of 0
+struct QueueSubmit {
+  std::vector<vk::Semaphore> WaitSemaphores;
+  std::vector<vk::PipelineStageFlags> WaitStages;
+  std::vector<uint64_t> WaitValues;
+  std::vector<vk::Semaphore> SignalSemaphores;
+  std::vector<uint64_t> SignalValues;
+
+  void wait(vk::Semaphore semaphore, vk::PipelineStageFlags stages, uint64_t value = 0);
+  void signal(vk::Semaphore semaphore, uint64_t value = 0);
+};
+
+struct SchedulerStats {
+  // per queue, graphics first
+  std::vector<uint64_t> Submits;
+  // semaphore waits inserted between different queues
+  uint64_t CrossQueueWaits = 0;
+  // dependencies dropped because the GPU had already passed them
+  uint64_t CompletedWaits = 0;
+};
+
+// Orders work across the graphics queue and the compute queues with one
+// timeline semaphore per queue. Compute passes go through submit_compute(),
+// round robin over the compute queues, and the graphics frame through
+// submit_graphics(); both wait on the points they depend on and return the
+// point that marks their completion.
+//
+// Without an async compute family the compute queues are further queues of
+// the graphics family, or the graphics queue itself, so dependencies hold the
+// same way and callers do not branch. Resources shared between families have
+// to be concurrent or transferred by the caller.
+//
+// Points can only be waited on once their submission was made, which rules
+// out a queue waiting on work queued behind it. Not thread-safe, submit from
+// the thread that owns the queues.
+class QueueScheduler {
+public:
+  static constexpr uint32_t GraphicsQueue = 0;
+
+  QueueScheduler(const vk::Device& device, vk::Queue graphics_queue, std::vector<vk::Queue> compute_queues, uint32_t compute_family,
+    bool async_compute, const bool debug);
+  ~QueueScheduler();
+
+  QueuePoint submit_graphics(QueueSubmit& submit, vk::CommandBuffer command_buffer, const std::vector<QueuePoint>& waits,
+    vk::PipelineStageFlags wait_stages, vk::Fence fence);
+  // records into a pooled command buffer that is recycled once the returned point is reached
+  QueuePoint submit_compute(const std::function<void(vk::CommandBuffer)>& record, const std::vector<QueuePoint>& waits,
+    vk::PipelineStageFlags wait_stages = vk::PipelineStageFlagBits::eComputeShader);
+
+  bool is_complete(const QueuePoint& point);
+  void wait(const QueuePoint& point);
+  // last point submitted to a queue
+  QueuePoint last_point(uint32_t queue) const;
+  uint32_t compute_queue_count() const;
+  bool async_compute() const;
+
+  SchedulerStats stats() const;
+  void report() const;
+
+private:
+  struct Timeline {
+    vk::Queue Queue;
+    vk::Semaphore Semaphore;
+    uint64_t Submitted = 0;
+    uint64_t Completed = 0;
+  };
+
+  struct InFlight {
+    vk::CommandBuffer CommandBuffer;
+    QueuePoint Point;
+  };
+
+  QueuePoint submit(uint32_t queue, QueueSubmit& submit, vk::CommandBuffer command_buffer, const std::vector<QueuePoint>& waits,
+    vk::PipelineStageFlags wait_stages, vk::Fence fence);
+  uint64_t completed_value(uint32_t queue);
+  void collect();
+
+  vk::Device device_;
+  bool async_compute_;
+  bool debug_;
+
+  std::vector<Timeline> timelines_;
+  uint32_t next_compute_ = 0;
+
+  vk::CommandPool command_pool_;
+  std::vector<vk::CommandBuffer> free_command_buffers_;
+  std::vector<InFlight> in_flight_;
+
+  SchedulerStats stats_;
+};
@@ -0,0 +1,134 @@
+#include "Scheduling/SplitDeviceBenchmark.h"
+
+#include <chrono>
+
+SplitDeviceBenchmark::SplitDeviceBenchmark(std::vector<SplitDevice> devices, const bool debug)
+  : debug_(debug) {
+  for (const SplitDevice& device : devices) {
+    create_lane(device);
+  }
+
+  if (debug_) {
+    LOG_DEBUG("Split device benchmark on " << lanes_.size() << " devices");
+  }
+}
+
+SplitDeviceBenchmark::~SplitDeviceBenchmark() {
+  for (Lane& lane : lanes_) {
+    destroy_lane(lane);
+  }
+}
+
+void SplitDeviceBenchmark::run(uint32_t repetitions) {
+  uint32_t lane_count = static_cast<uint32_t>(lanes_.size());
+  std::cout << "Split devices: " << Copies << " copies of " << CopyBytes / (1024 * 1024) << "MiB, best of "
+    << repetitions << " runs" << std::endl;
+  for (const Lane& lane : lanes_) {
+    std::cout << "  " << lane.Device.Name << std::endl;
+  }
+  if (lane_count < 2) {
+    LOG_WARN("Only one device is open, pass --device-count to split the work");
+  }
+
+  // the first run warms clocks on every device
+  run_split(lane_count);
+
+  double best_single = 0.0;
+  double best_split = 0.0;
+  for (uint32_t i = 0; i < repetitions; ++i) {
+    double single = run_split(1);
+    double split = run_split(lane_count);
+    best_single = i == 0 ? single : (std::min)(best_single, single);
+    best_split = i == 0 ? split : (std::min)(best_split, split);
+  }
+
+  // every copy reads and writes its size
+  double gib = 2.0 * Copies * CopyBytes / (1024.0 * 1024.0 * 1024.0);
+  std::cout << "  1 device: " << best_single << "ms (" << gib / best_single * 1000.0 << "GiB/s)" << std::endl;
+  std::cout << "  " << lane_count << " devices: " << best_split << "ms (" << gib / best_split * 1000.0
+    << "GiB/s), speedup " << best_single / best_split << "x" << std::endl;
+}
+
+void SplitDeviceBenchmark::create_lane(const SplitDevice& device) {
+  Lane lane;
+  lane.Device = device;
+  vk::Device handle = device.Device;
+
+  // contents are never read back, uninitialised memory copies just as fast
+  vk::BufferCreateInfo buffer_info{};
+  buffer_info.size = CopyBytes;
+  buffer_info.usage = vk::BufferUsageFlagBits::eTransferSrc | vk::BufferUsageFlagBits::eTransferDst;
+  buffer_info.sharingMode = vk::SharingMode::eExclusive;
+  lane.Source = handle.createBuffer(buffer_info);
+  lane.SourceMemory = device.Allocator->allocate_for_buffer(lane.Source, vk::MemoryPropertyFlagBits::eDeviceLocal);
+  lane.Destination = handle.createBuffer(buffer_info);
+  lane.DestinationMemory = device.Allocator->allocate_for_buffer(lane.Destination, vk::MemoryPropertyFlagBits::eDeviceLocal);
+
+  vk::CommandPoolCreateInfo pool_info{};
+  pool_info.flags = vk::CommandPoolCreateFlagBits::eResetCommandBuffer;
+  pool_info.queueFamilyIndex = device.Family;
+  lane.CommandPool = handle.createCommandPool(pool_info);
+
+  vk::CommandBufferAllocateInfo alloc_info{};
+  alloc_info.commandPool = lane.CommandPool;
+  alloc_info.level = vk::CommandBufferLevel::ePrimary;
+  alloc_info.commandBufferCount = 1;
+  lane.CommandBuffer = handle.allocateCommandBuffers(alloc_info)[0];
+  // signalled, so a lane that never ran can still be waited on at teardown
+  lane.Fence = handle.createFence(vk::FenceCreateInfo{ vk::FenceCreateFlagBits::eSignaled });
+
+  lanes_.push_back(lane);
+}
+
+void SplitDeviceBenchmark::destroy_lane(Lane& lane) {
+  vk::Device handle = lane.Device.Device;
+  (void)handle.waitForFences(lane.Fence, VK_TRUE, UINT64_MAX);
+  handle.destroyFence(lane.Fence);
+  handle.destroyCommandPool(lane.CommandPool);
+  handle.destroyBuffer(lane.Source);
+  handle.destroyBuffer(lane.Destination);
+  lane.Device.Allocator->free(lane.SourceMemory);
+  lane.Device.Allocator->free(lane.DestinationMemory);
+}
+
+void SplitDeviceBenchmark::record(Lane& lane, uint32_t copies) {
+  vk::CommandBuffer command_buffer = lane.CommandBuffer;
+  command_buffer.reset();
+  vk::CommandBufferBeginInfo begin_info{};
+  begin_info.flags = vk::CommandBufferUsageFlagBits::eOneTimeSubmit;
+  command_buffer.begin(begin_info);
+
+  vk::BufferCopy region{ 0, 0, CopyBytes };
+  // every copy overwrites the last one's destination
+  vk::MemoryBarrier barrier{ vk::AccessFlagBits::eTransferWrite, vk::AccessFlagBits::eTransferWrite };
+  for (uint32_t i = 0; i < copies; ++i) {
+    if (i != 0) {
+      command_buffer.pipelineBarrier(vk::PipelineStageFlagBits::eTransfer, vk::PipelineStageFlagBits::eTransfer,
+        vk::DependencyFlags{}, barrier, nullptr, nullptr);
+    }
+    command_buffer.copyBuffer(lane.Source, lane.Destination, region);
+  }
+  command_buffer.end();
+}
+
+double SplitDeviceBenchmark::run_split(uint32_t lane_count) {
+  // recording is outside the timed part, only the devices working side by side is measured
+  uint32_t per_lane = Copies / lane_count;
+  uint32_t leftover = Copies % lane_count;
+  for (uint32_t i = 0; i < lane_count; ++i) {
+    record(lanes_[i], per_lane + (i < leftover ? 1 : 0));
+    lanes_[i].Device.Device.resetFences(lanes_[i].Fence);
+  }
+
+  auto start = std::chrono::steady_clock::now();
+  for (uint32_t i = 0; i < lane_count; ++i) {
+    vk::SubmitInfo submit_info{};
+    submit_info.commandBufferCount = 1;
+    submit_info.pCommandBuffers = &lanes_[i].CommandBuffer;
+    lanes_[i].Device.Queue.submit(submit_info, lanes_[i].Fence);
+  }
+  for (uint32_t i = 0; i < lane_count; ++i) {
+    (void)lanes_[i].Device.Device.waitForFences(lanes_[i].Fence, VK_TRUE, UINT64_MAX);
+  }
+  return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
@@ -0,0 +1,53 @@
+#pragma once
+#include "Headers.h"
+#include "Memory/MemoryAllocator.h"
+
+#include <string>
+
+// A logical device the split workload may run on, owned by the caller
+struct SplitDevice {
+  std::string Name;
+  vk::Device Device;
+  MemoryAllocator* Allocator = nullptr;
+  vk::Queue Queue;
+  uint32_t Family = 0;
+};
+
+// Splits a fixed batch of large device-local buffer copies across every open
+// device, first all of it on the rendering device and then spread evenly over
+// the rendering device and the secondaries. Copies are bandwidth bound and
+// independent, so the difference is how well the devices work side by side.
+class SplitDeviceBenchmark {
+public:
+  // devices[0] is the rendering device, the caller keeps every device alive until this is gone
+  SplitDeviceBenchmark(std::vector<SplitDevice> devices, const bool debug);
+  // waits for every lane
+  ~SplitDeviceBenchmark();
+
+  void run(uint32_t repetitions);
+
+private:
+  // one device's share of the work
+  struct Lane {
+    SplitDevice Device;
+    vk::Buffer Source;
+    MemoryAllocation SourceMemory;
+    vk::Buffer Destination;
+    MemoryAllocation DestinationMemory;
+    vk::CommandPool CommandPool;
+    vk::CommandBuffer CommandBuffer;
+    vk::Fence Fence;
+  };
+
+  static constexpr uint32_t Copies = 64;
+  static constexpr vk::DeviceSize CopyBytes = 32 * 1024 * 1024;
+
+  void create_lane(const SplitDevice& device);
+  void destroy_lane(Lane& lane);
+  void record(Lane& lane, uint32_t copies);
+  // runs the batch on the first lane_count lanes and returns the wall time
+  double run_split(uint32_t lane_count);
+
+  bool debug_;
+  std::vector<Lane> lanes_;
+};
@@ -0,0 +1,330 @@
+#include "Shaders/ShaderCompiler.h"
+#include "Hasher.h"
+
+#include <atomic>
+#include <cctype>
+#include <chrono>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <random>
+#include <set>
+#include <sstream>
+
+namespace {
+  // bump when the command line changes, cached binaries from other options must miss.
+  // The premake build step passes the same options, keep the two in sync
+  const char* CompilerOptions = "glslc --target-env=vulkan1.2 -O";
+
+  const char* GlslStages[] = { ".vert", ".frag", ".comp", ".geom", ".tesc", ".tese", ".mesh", ".task",
+    ".rgen", ".rchit", ".rmiss", ".rahit", ".rint", ".rcall" };
+
+  std::string read_text(const std::string& path, bool& found) {
+    std::ifstream file(path, std::ios::binary);
+    found = static_cast<bool>(file);
+    std::stringstream text;
+    text << file.rdbuf();
+    return text.str();
+  }
+
+  std::string hex(uint64_t value) {
+    static const char* digits = "0123456789abcdef";
+    std::string result(16, '0');
+    for (int i = 15; i >= 0; --i) {
+      result[i] = digits[value & 0xf];
+      value >>= 4;
+    }
+    return result;
+  }
+
+  bool ends_with(const std::string& text, const std::string& suffix) {
+    return text.size() >= suffix.size() && text.compare(text.size() - suffix.size(), suffix.size(), suffix) == 0;
+  }
+
+  bool is_identifier(const std::string& text) {
+    if (text.empty() || std::isdigit(static_cast<unsigned char>(text[0]))) {
+      return false;
+    }
+    for (char c : text) {
+      if (!std::isalnum(static_cast<unsigned char>(c)) && c != '_') {
+        return false;
+      }
+    }
+    return true;
+  }
+
+  // numbers and identifiers, enough for feature switches and sizes without ever needing shell quoting
+  bool is_define_value(const std::string& text) {
+    for (char c : text) {
+      if (!std::isalnum(static_cast<unsigned char>(c)) && c != '_' && c != '.' && c != '+' && c != '-') {
+        return false;
+      }
+    }
+    return true;
+  }
+
+  // one argument for std::system. sh takes anything inside single quotes literally, cmd has no
+  // escape for a double quote and expands %VAR% even inside quotes, so those paths are refused
+  bool quote_argument(const std::string& argument, std::string& quoted) {
+#ifdef _WIN32
+    if (argument.find_first_of("\"%") != std::string::npos) {
+      return false;
+    }
+    quoted = "\"" + argument + "\"";
+#else
+    quoted = "'";
+    for (char c : argument) {
+      quoted += c == '\'' ? std::string("'\\''") : std::string(1, c);
+    }
+    quoted += "'";
+#endif
+    return true;
+  }
+
+  // per call, so a hot reload and a foreground load compiling the same hash never share a file,
+  // the process token keeps two instances sharing a cache directory apart
+  std::string unique_suffix() {
+    static const uint64_t process_token = (static_cast<uint64_t>(std::random_device{}()) << 32) | std::random_device{}();
+    static std::atomic<uint64_t> counter{ 0 };
+    return "." + hex(process_token) + "-" + std::to_string(counter.fetch_add(1)) + ".tmp";
+  }
+
+  // "include" lines only, which is all our shaders and the GL_GOOGLE_include_directive use
+  void collect_includes(const std::filesystem::path& path, std::vector<std::string>& files, std::set<std::string>& seen) {
+    std::string key = path.lexically_normal().generic_string();
+    if (!seen.insert(key).second) {
+      return;
+    }
+    files.push_back(key);
+
+    bool found = false;
+    std::string text = read_text(key, found);
+    std::istringstream lines(text);
+    std::string line;
+    while (std::getline(lines, line)) {
+      size_t directive = line.find("#include");
+      if (directive == std::string::npos) {
+        continue;
+      }
+      size_t open = line.find('"', directive);
+      size_t close = open == std::string::npos ? std::string::npos : line.find('"', open + 1);
+      if (close != std::string::npos) {
+        collect_includes(path.parent_path() / line.substr(open + 1, close - open - 1), files, seen);
+      }
+    }
+  }
+}
+
+bool ShaderBinary::ok() const {
+  return !Code.empty();
+}
+
+bool is_shader_source(const std::string& path) {
+  if (ends_with(path, ".hlsl")) {
+    return true;
+  }
+  for (const char* stage : GlslStages) {
+    if (ends_with(path, stage)) {
+      return true;
+    }
+  }
+  return false;
+}
+
+std::vector<uint32_t> read_spirv(const std::string& path) {
+  std::vector<uint32_t> code;
+  std::ifstream file(path, std::ios::binary | std::ios::ate);
+  if (file) {
+    size_t size = static_cast<size_t>(file.tellg());
+    code.resize(size / sizeof(uint32_t));
+    file.seekg(0);
+    file.read(reinterpret_cast<char*>(code.data()), code.size() * sizeof(uint32_t));
+  }
+
+  const uint32_t spirv_magic = 0x07230203;
+  if (code.empty() || code[0] != spirv_magic) {
+    code.clear();
+  }
+  return code;
+}
+
+ShaderCompiler::ShaderCompiler(const std::string& cache_dir, const bool debug)
+  : cache_dir_(cache_dir), debug_(debug) {
+  if (!cache_dir_.empty()) {
+    std::error_code error;
+    std::filesystem::create_directories(cache_dir_, error);
+    if (error) {
+      LOG_WARN("Cannot create shader cache " << cache_dir_ << ", shaders compile every time");
+      cache_dir_.clear();
+    }
+  }
+}
+
+ShaderBinary ShaderCompiler::compile(const ShaderSource& source) {
+  ShaderBinary binary;
+  binary.Hash = source_hash(source);
+
+  std::string cached = cache_dir_.empty() ? std::string() : cache_dir_ + "/" + hex(binary.Hash) + ".spv";
+  if (!cached.empty()) {
+    binary.Code = read_spirv(cached);
+    if (binary.ok()) {
+      binary.FromCache = true;
+      std::lock_guard<std::mutex> lock(mutex_);
+      ++stats_.CacheHits;
+      return binary;
+    }
+  }
+
+  // compile next to the final name and rename, so concurrent readers never see a partial file
+  std::string output = (cached.empty() ? source.Path : cached) + unique_suffix();
+  std::string log;
+  auto start = std::chrono::steady_clock::now();
+  bool compiled = run_compiler(source, output, log);
+  double compile_ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+  if (compiled) {
+    binary.Code = read_spirv(output);
+  }
+  std::error_code error;
+  if (binary.ok() && !cached.empty()) {
+    std::filesystem::rename(output, cached, error);
+  }
+  std::filesystem::remove(output, error);
+
+  std::lock_guard<std::mutex> lock(mutex_);
+  ++stats_.Compiles;
+  stats_.TotalCompileMs += compile_ms;
+  stats_.WorstCompileMs = (std::max)(stats_.WorstCompileMs, compile_ms);
+  if (binary.ok()) {
+    if (debug_) {
+      LOG_DEBUG("Compiled " << source.Path << " in " << compile_ms << "ms");
+    }
+    return binary;
+  }
+
+  ++stats_.Failures;
+  binary.Error = log.empty() ? "glslc failed without output, is it on the PATH?" : log;
+  // defines change the code, so the prebuilt binary only stands in for a plain compile
+  if (source.Defines.empty()) {
+    binary.Code = read_spirv(source.Path + ".spv");
+    if (binary.ok()) {
+      ++stats_.Prebuilt;
+      LOG_WARN("Compiling " << source.Path << " failed, using the prebuilt binary");
+    }
+  }
+  return binary;
+}
+
+std::vector<std::string> ShaderCompiler::dependencies(const std::string& path) const {
+  std::vector<std::string> files;
+  std::set<std::string> seen;
+  collect_includes(std::filesystem::path(path), files, seen);
+  return files;
+}
+
+uint64_t ShaderCompiler::source_hash(const ShaderSource& source) const {
+  Hasher hasher;
+  hasher.add(CompilerOptions);
+  hasher.add(source.Entry);
+  for (const ShaderDefine& define : source.Defines) {
+    hasher.add(define.Name);
+    hasher.add(define.Value);
+  }
+  // contents rather than paths, so a moved tree still hits
+  for (const std::string& file : dependencies(source.Path)) {
+    bool found = false;
+    hasher.add(read_text(file, found));
+    hasher.add(static_cast<uint64_t>(found ? 1 : 0));
+  }
+  return hasher.value();
+}
+
+ShaderCompilerStats ShaderCompiler::stats() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return stats_;
+}
+
+void ShaderCompiler::report() const {
+  ShaderCompilerStats stats = this->stats();
+  std::cout << "Shader compiler: " << stats.Compiles << " compiles (" << stats.Failures << " failed, " << stats.Prebuilt
+    << " used prebuilt), " << stats.CacheHits << " cache hits, " << stats.TotalCompileMs << "ms compiling, worst "
+    << stats.WorstCompileMs << "ms" << std::endl;
+}
+
+bool ShaderCompiler::run_compiler(const ShaderSource& source, const std::string& output, std::string& log) const {
+  // everything reaches a shell, so only names and values that need no quoting go in unquoted
+  std::string command = std::string(CompilerOptions);
+  if (ends_with(source.Path, ".hlsl")) {
+    // blur.comp.hlsl -> comp
+    std::string stem = std::filesystem::path(source.Path).stem().string();
+    std::string stage = std::filesystem::path(stem).extension().string();
+    if (stage.empty() || !is_identifier(stage.substr(1))) {
+      log = source.Path + " does not name its stage, expected e.g. name.comp.hlsl";
+      return false;
+    }
+    if (!is_identifier(source.Entry)) {
+      log = "Entry point \"" + source.Entry + "\" is not an identifier";
+      return false;
+    }
+    command += " -x hlsl -fshader-stage=" + stage.substr(1) + " -fentry-point=" + source.Entry;
+  }
+  for (const ShaderDefine& define : source.Defines) {
+    if (!is_identifier(define.Name) || !is_define_value(define.Value)) {
+      log = "Define " + define.Name + "=" + define.Value + " is not an identifier with a plain value";
+      return false;
+    }
+    command += " -D" + define.Name + (define.Value.empty() ? "" : "=" + define.Value);
+  }
+
+  std::string log_path = output + ".log";
+  std::string quoted_source, quoted_output, quoted_log;
+  if (!quote_argument(source.Path, quoted_source) || !quote_argument(output, quoted_output) ||
+    !quote_argument(log_path, quoted_log)) {
+    log = source.Path + " contains characters the shell cannot quote";
+    return false;
+  }
+  command += " " + quoted_source + " -o " + quoted_output + " 2> " + quoted_log;
+#ifdef _WIN32
+  // cmd strips the outer quotes of the whole line
+  command = "\"" + command + "\"";
+#endif
+
+  int result = std::system(command.c_str());
+  bool found = false;
+  log = read_text(log_path, found);
+  std::error_code error;
+  std::filesystem::remove(log_path, error);
+  return result == 0;
+}
+
+uint32_t compile_shader_directory(const std::string& directory, const std::string& cache_dir) {
+  ShaderCompiler compiler(cache_dir, false);
+  uint32_t failed = 0;
+  uint32_t total = 0;
+
+  std::error_code error;
+  for (const auto& entry : std::filesystem::directory_iterator(directory, error)) {
+    std::string path = entry.path().generic_string();
+    if (!entry.is_regular_file() || !is_shader_source(path)) {
+      continue;
+    }
+    ++total;
+
+    ShaderBinary binary = compiler.compile(ShaderSource{ path });
+    if (!binary.Error.empty()) {
+      ++failed;
+      LOG_ERROR("Failed to compile " << path << ":\n" << binary.Error);
+      continue;
+    }
+    std::ofstream file(path + ".spv", std::ios::binary);
+    file.write(reinterpret_cast<const char*>(binary.Code.data()), binary.Code.size() * sizeof(uint32_t));
+  }
+  if (error) {
+    LOG_ERROR("Cannot read shader directory " << directory);
+    return 1;
+  }
+
+  compiler.report();
+  std::cout << "Compiled " << total - failed << " of " << total << " shaders in " << directory << std::endl;
+  return failed;
+}
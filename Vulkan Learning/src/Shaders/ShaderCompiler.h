@@ -0,0 +1,78 @@
+#pragma once
+#include "Headers.h"
+
+#include <mutex>
+#include <string>
+#include <vector>
+
+struct ShaderDefine {
+  std::string Name;
+  std::string Value;
+};
+
+// a GLSL (.vert/.frag/.comp/...) or HLSL source, HLSL names its stage as in blur.comp.hlsl
+struct ShaderSource {
+  std::string Path;
+  std::vector<ShaderDefine> Defines;
+  std::string Entry = "main";
+};
+
+struct ShaderBinary {
+  std::vector<uint32_t> Code;
+  // cache key, covers the source, its includes, the defines and the compiler options
+  uint64_t Hash = 0;
+  bool FromCache = false;
+  // compiler output when Code is empty
+  std::string Error;
+
+  bool ok() const;
+};
+
+struct ShaderCompilerStats {
+  uint64_t Compiles = 0;
+  uint64_t CacheHits = 0;
+  uint64_t Failures = 0;
+  // compiles that failed and fell back to the prebuilt .spv next to the source
+  uint64_t Prebuilt = 0;
+  double TotalCompileMs = 0.0;
+  double WorstCompileMs = 0.0;
+};
+
+// Compiles shaders to SPIR-V by running glslc, the compiler the premake build
+// step uses, and keeps every binary in a cache directory keyed by a hash of
+// the source text, everything it includes, the defines and the options. A hit
+// never starts the compiler, so a warm start only reads files.
+//
+// When the compiler is missing or fails, compile() falls back to the .spv the
+// build step left next to the source, so a shipped build needs no compiler.
+// Thread-safe, compiles run on the calling thread.
+class ShaderCompiler {
+public:
+  // an empty cache_dir compiles every time
+  ShaderCompiler(const std::string& cache_dir, const bool debug);
+
+  ShaderBinary compile(const ShaderSource& source);
+  // the source followed by every file it includes, recursively
+  std::vector<std::string> dependencies(const std::string& path) const;
+  uint64_t source_hash(const ShaderSource& source) const;
+
+  ShaderCompilerStats stats() const;
+  void report() const;
+
+private:
+  bool run_compiler(const ShaderSource& source, const std::string& output, std::string& log) const;
+
+  std::string cache_dir_;
+  bool debug_;
+
+  ShaderCompilerStats stats_;
+  mutable std::mutex mutex_;
+};
+
+// true for the extensions ShaderCompiler understands
+bool is_shader_source(const std::string& path);
+
+// offline step, compiles every source in the directory to <source>.spv next to it
+uint32_t compile_shader_directory(const std::string& directory, const std::string& cache_dir);
+
+std::vector<uint32_t> read_spirv(const std::string& path);
@@ -0,0 +1,261 @@
+#include "Shaders/ShaderLibrary.h"
+#include "Descriptors/BindlessHeap.h"
+#include "Pipelines/ShaderModule.h"
+
+#include <chrono>
+
+namespace {
+  // editors save in bursts, a quarter second keeps reloads responsive without spinning on stat
+  const auto PollInterval = std::chrono::milliseconds(250);
+}
+
+ShaderLibrary::ShaderLibrary(const vk::Device& device, ShaderCompiler& compiler, const std::string& shader_dir,
+  bool hot_reload, const bool debug)
+  : device_(device), compiler_(compiler), shader_dir_(shader_dir), debug_(debug) {
+  if (hot_reload) {
+    watcher_ = std::thread(&ShaderLibrary::watch, this);
+    if (debug_) {
+      LOG_DEBUG("Watching " << shader_dir_ << " for shader changes");
+    }
+  }
+}
+
+ShaderLibrary::~ShaderLibrary() {
+  if (watcher_.joinable()) {
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      stop_ = true;
+    }
+    wake_.notify_all();
+    watcher_.join();
+  }
+
+  for (auto& entry : entries_) {
+    device_.destroyShaderModule(entry.second.Module);
+  }
+  for (vk::ShaderModule module : retired_) {
+    device_.destroyShaderModule(module);
+  }
+}
+
+vk::ShaderModule ShaderLibrary::load(const ShaderSource& source) {
+  std::string key = key_of(source);
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = entries_.find(key);
+    if (it != entries_.end()) {
+      return it->second.Module;
+    }
+  }
+
+  Entry entry;
+  entry.Source = resolve(source);
+  // stamp before compiling, an edit during the compile then still counts as a change
+  entry.Files = stamp(entry.Source.Path);
+  ShaderBinary binary = compiler_.compile(entry.Source);
+  if (!binary.ok()) {
+    LOG_ERROR(binary.Error);
+    throw std::runtime_error("Failed to compile shader " + entry.Source.Path + "!");
+  }
+  entry.Hash = binary.Hash;
+  entry.Reflection = reflect_spirv(binary.Code);
+  entry.Module = create_shader_module(device_, binary.Code, entry.Source.Path);
+
+  if (entry.Reflection.PushConstantSize > BindlessHeap::PushConstantSize) {
+    LOG_WARN(entry.Source.Path << " uses " << entry.Reflection.PushConstantSize << " bytes of push constants, the bindless layout has "
+      << BindlessHeap::PushConstantSize);
+  }
+
+  std::lock_guard<std::mutex> lock(mutex_);
+  vk::ShaderModule module = entry.Module;
+  entries_[key] = std::move(entry);
+  ++stats_.Shaders;
+  return module;
+}
+
+const ShaderReflection& ShaderLibrary::reflection(const ShaderSource& source) const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  auto it = entries_.find(key_of(source));
+  if (it == entries_.end()) {
+    throw std::runtime_error("Failed to find shader " + source.Path + ", load it first!");
+  }
+  return it->second.Reflection;
+}
+
+uint32_t ShaderLibrary::on_reload(const ShaderSource& source, ReloadCallback callback) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  uint32_t id = next_listener_++;
+  listeners_[id] = Listener{ key_of(source), std::move(callback) };
+  return id;
+}
+
+void ShaderLibrary::remove_listener(uint32_t id) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  listeners_.erase(id);
+}
+
+void ShaderLibrary::poll() {
+  std::vector<Reload> finished;
+  std::vector<std::pair<vk::ShaderModule, std::vector<ReloadCallback>>> swapped;
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    finished.swap(finished_);
+  }
+  if (finished.empty()) {
+    return;
+  }
+
+  for (Reload& reload : finished) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = entries_.find(reload.Key);
+    if (it == entries_.end()) {
+      continue;
+    }
+    Entry& entry = it->second;
+    vk::ShaderModule module;
+    try {
+      module = create_shader_module(device_, reload.Binary.Code, entry.Source.Path);
+    }
+    catch (const std::runtime_error& e) {
+      ++stats_.ReloadFailures;
+      LOG_WARN(e.what());
+      continue;
+    }
+
+    retired_.push_back(entry.Module);
+    entry.Module = module;
+    entry.Reflection = std::move(reload.Reflection);
+    entry.Hash = reload.Binary.Hash;
+    ++stats_.Reloads;
+    ++stats_.Retired;
+    LOG_INFO("Reloaded " << entry.Source.Path);
+
+    std::vector<ReloadCallback> callbacks;
+    for (auto& listener : listeners_) {
+      if (listener.second.Key == reload.Key) {
+        callbacks.push_back(listener.second.Callback);
+      }
+    }
+    swapped.push_back({ module, std::move(callbacks) });
+  }
+
+  // outside the lock, callbacks may load more shaders
+  for (auto& reloaded : swapped) {
+    for (ReloadCallback& callback : reloaded.second) {
+      callback(reloaded.first);
+    }
+  }
+}
+
+ShaderLibraryStats ShaderLibrary::stats() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return stats_;
+}
+
+void ShaderLibrary::report() const {
+  ShaderLibraryStats stats = this->stats();
+  std::cout << "Shader library: " << stats.Shaders << " shaders, " << stats.Reloads << " reloads (" << stats.ReloadFailures
+    << " failed), " << stats.Retired << " retired modules" << std::endl;
+  compiler_.report();
+}
+
+std::string ShaderLibrary::key_of(const ShaderSource& source) const {
+  std::string key = source.Path + "|" + source.Entry;
+  for (const ShaderDefine& define : source.Defines) {
+    key += "|" + define.Name + "=" + define.Value;
+  }
+  return key;
+}
+
+ShaderSource ShaderLibrary::resolve(const ShaderSource& source) const {
+  ShaderSource resolved = source;
+  resolved.Path = shader_dir_ + "/" + source.Path;
+  return resolved;
+}
+
+std::vector<std::pair<std::string, std::filesystem::file_time_type>> ShaderLibrary::stamp(const std::string& path) const {
+  std::vector<std::pair<std::string, std::filesystem::file_time_type>> files;
+  for (const std::string& file : compiler_.dependencies(path)) {
+    std::error_code error;
+    // a missing include stamps as the epoch and counts as changed once it appears
+    std::filesystem::file_time_type time = std::filesystem::last_write_time(file, error);
+    files.push_back({ file, error ? std::filesystem::file_time_type{} : time });
+  }
+  return files;
+}
+
+void ShaderLibrary::watch() {
+  std::unique_lock<std::mutex> lock(mutex_);
+  while (!stop_) {
+    wake_.wait_for(lock, PollInterval, [this] { return stop_.load(); });
+    if (stop_) {
+      break;
+    }
+
+    // stat and compile without the lock, loads and poll() must not wait on glslc
+    std::vector<std::pair<std::string, Entry>> snapshot;
+    for (const auto& entry : entries_) {
+      snapshot.push_back({ entry.first, entry.second });
+    }
+    lock.unlock();
+
+    std::vector<Reload> reloads;
+    std::vector<std::pair<std::string, std::vector<std::pair<std::string, std::filesystem::file_time_type>>>> restamped;
+    uint64_t failures = 0;
+    for (auto& watched : snapshot) {
+      Entry& entry = watched.second;
+      bool changed = false;
+      for (const auto& file : entry.Files) {
+        std::error_code error;
+        std::filesystem::file_time_type time = std::filesystem::last_write_time(file.first, error);
+        changed = changed || (!error && time != file.second);
+      }
+      if (!changed) {
+        continue;
+      }
+
+      // the include list may have changed with the edit
+      std::vector<std::pair<std::string, std::filesystem::file_time_type>> files = stamp(entry.Source.Path);
+      ShaderBinary binary = compiler_.compile(entry.Source);
+      if (!binary.Error.empty()) {
+        // the prebuilt fallback is older than the edit, keep the module that is running
+        ++failures;
+        LOG_WARN("Reloading " << entry.Source.Path << " failed, keeping the previous module:\n" << binary.Error);
+        restamped.push_back({ watched.first, std::move(files) });
+        continue;
+      }
+      if (binary.Hash == entry.Hash) {
+        // touched but not changed, e.g. saved without edits
+        restamped.push_back({ watched.first, std::move(files) });
+        continue;
+      }
+
+      Reload reload;
+      reload.Key = watched.first;
+      try {
+        reload.Reflection = reflect_spirv(binary.Code);
+      }
+      catch (const std::runtime_error& e) {
+        ++failures;
+        LOG_WARN("Reloading " << entry.Source.Path << " failed: " << e.what());
+        restamped.push_back({ watched.first, std::move(files) });
+        continue;
+      }
+      reload.Binary = std::move(binary);
+      restamped.push_back({ watched.first, std::move(files) });
+      reloads.push_back(std::move(reload));
+    }
+
+    lock.lock();
+    for (auto& files : restamped) {
+      auto it = entries_.find(files.first);
+      if (it != entries_.end()) {
+        it->second.Files = std::move(files.second);
+      }
+    }
+    for (Reload& reload : reloads) {
+      finished_.push_back(std::move(reload));
+    }
+    stats_.ReloadFailures += failures;
+  }
+}
@@ -0,0 +1,98 @@
+#pragma once
+#include "Headers.h"
+#include "Shaders/ShaderCompiler.h"
+#include "Shaders/SpirvReflection.h"
+
+#include <atomic>
+#include <condition_variable>
+#include <filesystem>
+#include <functional>
+#include <map>
+#include <mutex>
+#include <thread>
+
+struct ShaderLibraryStats {
+  uint32_t Shaders = 0;
+  uint64_t Reloads = 0;
+  uint64_t ReloadFailures = 0;
+  // modules replaced by a reload, kept until shutdown
+  uint32_t Retired = 0;
+};
+
+// Owns every shader module the renderer uses. Sources are compiled through
+// the ShaderCompiler cache and reflected once at load.
+//
+// With hot reload on, a watcher thread polls the modification time of each
+// source and everything it includes, recompiles changed shaders off the
+// render thread and queues the results. poll(), called once a frame, swaps
+// the modules in and runs the reload callbacks, which re-request pipelines
+// from the PipelineService. A failed compile keeps the old module and logs
+// the compiler output. Replaced modules stay alive until the library is
+// destroyed, since pipelines may still be compiling from them.
+class ShaderLibrary {
+public:
+  using ReloadCallback = std::function<void(vk::ShaderModule)>;
+
+  // paths are relative to shader_dir
+  ShaderLibrary(const vk::Device& device, ShaderCompiler& compiler, const std::string& shader_dir, bool hot_reload,
+    const bool debug);
+  ~ShaderLibrary();
+
+  // the same source and defines return the same module, throws when it neither compiles nor has a prebuilt binary
+  vk::ShaderModule load(const ShaderSource& source);
+  // of the current module, the source must have been loaded
+  const ShaderReflection& reflection(const ShaderSource& source) const;
+
+  // called from poll() with the new module, returns an id for remove_listener
+  uint32_t on_reload(const ShaderSource& source, ReloadCallback callback);
+  void remove_listener(uint32_t id);
+
+  // render thread only, applies finished reloads
+  void poll();
+
+  ShaderLibraryStats stats() const;
+  void report() const;
+
+private:
+  struct Entry {
+    ShaderSource Source;
+    vk::ShaderModule Module;
+    ShaderReflection Reflection;
+    uint64_t Hash = 0;
+    // the source and its includes with their last seen write times
+    std::vector<std::pair<std::string, std::filesystem::file_time_type>> Files;
+  };
+
+  struct Reload {
+    std::string Key;
+    ShaderBinary Binary;
+    ShaderReflection Reflection;
+  };
+
+  struct Listener {
+    std::string Key;
+    ReloadCallback Callback;
+  };
+
+  std::string key_of(const ShaderSource& source) const;
+  ShaderSource resolve(const ShaderSource& source) const;
+  std::vector<std::pair<std::string, std::filesystem::file_time_type>> stamp(const std::string& path) const;
+  void watch();
+
+  vk::Device device_;
+  ShaderCompiler& compiler_;
+  std::string shader_dir_;
+  bool debug_;
+
+  std::map<std::string, Entry> entries_;
+  std::map<uint32_t, Listener> listeners_;
+  uint32_t next_listener_ = 0;
+  std::vector<vk::ShaderModule> retired_;
+  std::vector<Reload> finished_;
+  ShaderLibraryStats stats_;
+  mutable std::mutex mutex_;
+
+  std::thread watcher_;
+  std::atomic<bool> stop_{ false };
+  std::condition_variable wake_;
+};
@@ -0,0 +1,396 @@
+#include "Shaders/SpirvReflection.h"
+
+#include <algorithm>
+#include <map>
+#include <string>
+#include <unordered_map>
+
+namespace {
+  // the subset of the SPIR-V grammar reflection needs
+  enum Op : uint32_t {
+    OpEntryPoint = 15,
+    OpExecutionMode = 16,
+    OpTypeBool = 20,
+    OpTypeInt = 21,
+    OpTypeFloat = 22,
+    OpTypeVector = 23,
+    OpTypeMatrix = 24,
+    OpTypeImage = 25,
+    OpTypeSampler = 26,
+    OpTypeSampledImage = 27,
+    OpTypeArray = 28,
+    OpTypeRuntimeArray = 29,
+    OpTypeStruct = 30,
+    OpTypePointer = 32,
+    OpConstant = 43,
+    OpVariable = 59,
+    OpDecorate = 71,
+    OpMemberDecorate = 72,
+    OpTypeAccelerationStructureKHR = 5341
+  };
+
+  enum Decoration : uint32_t {
+    Block = 2,
+    BufferBlock = 3,
+    ArrayStride = 6,
+    MatrixStride = 7,
+    Binding = 33,
+    DescriptorSet = 34,
+    Offset = 35
+  };
+
+  enum StorageClass : uint32_t {
+    UniformConstant = 0,
+    Uniform = 2,
+    PushConstant = 9,
+    StorageBuffer = 12
+  };
+
+  const uint32_t LocalSizeMode = 17;
+  const uint32_t DimBuffer = 5;
+  const uint32_t DimSubpassData = 6;
+
+  struct Type {
+    uint32_t Op = 0;
+    // operands after the result id
+    std::vector<uint32_t> Operands;
+  };
+
+  struct DecorationSet {
+    uint32_t Set = UINT32_MAX;
+    uint32_t Binding = UINT32_MAX;
+    uint32_t ArrayStride = 0;
+    bool Block = false;
+    bool BufferBlock = false;
+    std::map<uint32_t, uint32_t> MemberOffsets;
+    std::map<uint32_t, uint32_t> MemberMatrixStrides;
+  };
+
+  struct Module {
+    std::unordered_map<uint32_t, Type> Types;
+    std::unordered_map<uint32_t, uint32_t> Constants;
+    std::unordered_map<uint32_t, DecorationSet> Decorations;
+  };
+
+  vk::ShaderStageFlags stage_of(uint32_t execution_model) {
+    switch (execution_model) {
+    case 0: return vk::ShaderStageFlagBits::eVertex;
+    case 1: return vk::ShaderStageFlagBits::eTessellationControl;
+    case 2: return vk::ShaderStageFlagBits::eTessellationEvaluation;
+    case 3: return vk::ShaderStageFlagBits::eGeometry;
+    case 4: return vk::ShaderStageFlagBits::eFragment;
+    case 5: return vk::ShaderStageFlagBits::eCompute;
+    case 5364: return vk::ShaderStageFlagBits::eTaskEXT;
+    case 5365: return vk::ShaderStageFlagBits::eMeshEXT;
+    default: return vk::ShaderStageFlagBits::eAll;
+    }
+  }
+
+  const Type& type_of(const Module& module, uint32_t id) {
+    auto it = module.Types.find(id);
+    if (it == module.Types.end()) {
+      throw std::runtime_error("Failed to reflect SPIR-V, unknown type id!");
+    }
+    return it->second;
+  }
+
+  uint32_t size_of(const Module& module, uint32_t id, uint32_t matrix_stride) {
+    const Type& type = type_of(module, id);
+    switch (type.Op) {
+    case OpTypeBool:
+      return 4;
+    case OpTypeInt:
+    case OpTypeFloat:
+      return type.Operands[0] / 8;
+    case OpTypeVector:
+      return size_of(module, type.Operands[0], 0) * type.Operands[1];
+    case OpTypeMatrix:
+      return (matrix_stride ? matrix_stride : size_of(module, type.Operands[0], 0)) * type.Operands[1];
+    case OpTypeArray: {
+      auto decorations = module.Decorations.find(id);
+      uint32_t stride = decorations != module.Decorations.end() ? decorations->second.ArrayStride : 0;
+      if (stride == 0) {
+        stride = size_of(module, type.Operands[0], matrix_stride);
+      }
+      auto length = module.Constants.find(type.Operands[1]);
+      return stride * (length != module.Constants.end() ? length->second : 1);
+    }
+    case OpTypeStruct: {
+      auto decorations = module.Decorations.find(id);
+      uint32_t size = 0;
+      for (uint32_t member = 0; member < type.Operands.size(); ++member) {
+        uint32_t offset = 0;
+        uint32_t member_stride = 0;
+        if (decorations != module.Decorations.end()) {
+          auto found = decorations->second.MemberOffsets.find(member);
+          offset = found != decorations->second.MemberOffsets.end() ? found->second : 0;
+          auto stride = decorations->second.MemberMatrixStrides.find(member);
+          member_stride = stride != decorations->second.MemberMatrixStrides.end() ? stride->second : 0;
+        }
+        size = (std::max)(size, offset + size_of(module, type.Operands[member], member_stride));
+      }
+      return size;
+    }
+    default:
+      return 0;
+    }
+  }
+}
+
+void ReflectedLayout::destroy(const vk::Device& device) {
+  device.destroyPipelineLayout(Layout);
+  for (vk::DescriptorSetLayout set_layout : SetLayouts) {
+    device.destroyDescriptorSetLayout(set_layout);
+  }
+  SetLayouts.clear();
+  Layout = nullptr;
+}
+
+ShaderReflection reflect_spirv(const std::vector<uint32_t>& code) {
+  const uint32_t spirv_magic = 0x07230203;
+  if (code.size() < 5 || code[0] != spirv_magic) {
+    throw std::runtime_error("Failed to reflect SPIR-V, bad header!");
+  }
+
+  ShaderReflection reflection;
+  Module module;
+  // result type and storage class of every variable
+  std::vector<std::pair<uint32_t, uint32_t>> variables;
+  std::vector<uint32_t> variable_ids;
+
+  for (size_t word = 5; word < code.size();) {
+    uint32_t count = code[word] >> 16;
+    uint32_t op = code[word] & 0xffff;
+    if (count == 0 || word + count > code.size()) {
+      throw std::runtime_error("Failed to reflect SPIR-V, truncated instruction!");
+    }
+    const uint32_t* operands = &code[word + 1];
+
+    switch (op) {
+    case OpEntryPoint:
+      reflection.Stage = stage_of(operands[0]);
+      break;
+    case OpExecutionMode:
+      if (operands[1] == LocalSizeMode && count >= 6) {
+        reflection.LocalSize = { operands[2], operands[3], operands[4] };
+      }
+      break;
+    case OpTypeBool:
+    case OpTypeInt:
+    case OpTypeFloat:
+    case OpTypeVector:
+    case OpTypeMatrix:
+    case OpTypeImage:
+    case OpTypeSampler:
+    case OpTypeSampledImage:
+    case OpTypeArray:
+    case OpTypeRuntimeArray:
+    case OpTypeStruct:
+    case OpTypePointer:
+    case OpTypeAccelerationStructureKHR:
+      module.Types[operands[0]] = Type{ op, std::vector<uint32_t>(operands + 1, operands + count - 1) };
+      break;
+    case OpConstant:
+      // array lengths are 32-bit integers
+      module.Constants[operands[1]] = operands[2];
+      break;
+    case OpVariable:
+      variables.push_back({ operands[0], operands[2] });
+      variable_ids.push_back(operands[1]);
+      break;
+    case OpDecorate: {
+      DecorationSet& decorations = module.Decorations[operands[0]];
+      switch (operands[1]) {
+      case Block: decorations.Block = true; break;
+      case BufferBlock: decorations.BufferBlock = true; break;
+      case ArrayStride: decorations.ArrayStride = operands[2]; break;
+      case Binding: decorations.Binding = operands[2]; break;
+      case DescriptorSet: decorations.Set = operands[2]; break;
+      default: break;
+      }
+      break;
+    }
+    case OpMemberDecorate: {
+      DecorationSet& decorations = module.Decorations[operands[0]];
+      if (operands[2] == Offset) {
+        decorations.MemberOffsets[operands[1]] = operands[3];
+      }
+      else if (operands[2] == MatrixStride) {
+        decorations.MemberMatrixStrides[operands[1]] = operands[3];
+      }
+      break;
+    }
+    default:
+      break;
+    }
+    word += count;
+  }
+
+  for (size_t i = 0; i < variables.size(); ++i) {
+    uint32_t storage_class = variables[i].second;
+    const Type& pointer = type_of(module, variables[i].first);
+    uint32_t pointee = pointer.Operands[1];
+
+    if (storage_class == PushConstant) {
+      reflection.PushConstantSize = (std::max)(reflection.PushConstantSize, size_of(module, pointee, 0));
+      continue;
+    }
+    if (storage_class != UniformConstant && storage_class != Uniform && storage_class != StorageBuffer) {
+      continue;
+    }
+
+    const DecorationSet& variable = module.Decorations[variable_ids[i]];
+    if (variable.Binding == UINT32_MAX) {
+      continue;
+    }
+
+    ReflectedBinding binding;
+    binding.Set = variable.Set == UINT32_MAX ? 0 : variable.Set;
+    binding.Binding = variable.Binding;
+    binding.Stages = reflection.Stage;
+
+    // arrays of descriptors, runtime arrays are what bindless tables use
+    const Type* type = &type_of(module, pointee);
+    uint32_t element = pointee;
+    if (type->Op == OpTypeArray) {
+      auto length = module.Constants.find(type->Operands[1]);
+      binding.Count = length != module.Constants.end() ? length->second : 1;
+      element = type->Operands[0];
+    }
+    else if (type->Op == OpTypeRuntimeArray) {
+      binding.Count = 0;
+      element = type->Operands[0];
+    }
+    type = &type_of(module, element);
+
+    switch (type->Op) {
+    case OpTypeSampler:
+      binding.Type = vk::DescriptorType::eSampler;
+      break;
+    case OpTypeSampledImage:
+      binding.Type = vk::DescriptorType::eCombinedImageSampler;
+      break;
+    case OpTypeImage: {
+      uint32_t dim = type->Operands[1];
+      bool storage = type->Operands[5] == 2;
+      if (dim == DimBuffer) {
+        binding.Type = storage ? vk::DescriptorType::eStorageTexelBuffer : vk::DescriptorType::eUniformTexelBuffer;
+      }
+      else if (dim == DimSubpassData) {
+        binding.Type = vk::DescriptorType::eInputAttachment;
+      }
+      else {
+        binding.Type = storage ? vk::DescriptorType::eStorageImage : vk::DescriptorType::eSampledImage;
+      }
+      break;
+    }
+    case OpTypeAccelerationStructureKHR:
+      binding.Type = vk::DescriptorType::eAccelerationStructureKHR;
+      break;
+    case OpTypeStruct: {
+      // pre-1.3 GLSL marks storage buffers as BufferBlock in the Uniform class
+      const DecorationSet& block = module.Decorations[element];
+      bool storage = storage_class == StorageBuffer || block.BufferBlock;
+      binding.Type = storage ? vk::DescriptorType::eStorageBuffer : vk::DescriptorType::eUniformBuffer;
+      break;
+    }
+    default:
+      continue;
+    }
+    reflection.Bindings.push_back(binding);
+  }
+
+  // bindless heaps alias several declarations onto one binding
+  std::vector<ReflectedBinding> merged = merge_bindings({ reflection });
+  reflection.Bindings = std::move(merged);
+  return reflection;
+}
+
+std::vector<ReflectedBinding> merge_bindings(const std::vector<ShaderReflection>& stages) {
+  std::map<std::pair<uint32_t, uint32_t>, ReflectedBinding> merged;
+  for (const ShaderReflection& stage : stages) {
+    for (const ReflectedBinding& binding : stage.Bindings) {
+      auto key = std::make_pair(binding.Set, binding.Binding);
+      auto it = merged.find(key);
+      if (it == merged.end()) {
+        merged[key] = binding;
+        continue;
+      }
+      if (it->second.Type != binding.Type) {
+        throw std::runtime_error("Failed to merge shader bindings, set " + std::to_string(binding.Set) + " binding " +
+          std::to_string(binding.Binding) + " has two descriptor types!");
+      }
+      it->second.Stages |= binding.Stages;
+      // an unbounded array beats any fixed count
+      if (it->second.Count != 0) {
+        it->second.Count = binding.Count == 0 ? 0 : (std::max)(it->second.Count, binding.Count);
+      }
+    }
+  }
+
+  std::vector<ReflectedBinding> result;
+  for (const auto& entry : merged) {
+    result.push_back(entry.second);
+  }
+  return result;
+}
+
+ReflectedLayout create_reflected_layout(const vk::Device& device, const std::vector<ShaderReflection>& stages,
+  uint32_t runtime_array_capacity) {
+  std::vector<ReflectedBinding> bindings = merge_bindings(stages);
+  uint32_t set_count = 0;
+  uint32_t push_constant_size = 0;
+  vk::ShaderStageFlags push_stages;
+  for (const ReflectedBinding& binding : bindings) {
+    set_count = (std::max)(set_count, binding.Set + 1);
+  }
+  for (const ShaderReflection& stage : stages) {
+    if (stage.PushConstantSize > 0) {
+      push_constant_size = (std::max)(push_constant_size, stage.PushConstantSize);
+      push_stages |= stage.Stage;
+    }
+  }
+
+  ReflectedLayout layout;
+  try {
+    // sets the shaders skip still need an (empty) layout
+    for (uint32_t set = 0; set < set_count; ++set) {
+      std::vector<vk::DescriptorSetLayoutBinding> set_bindings;
+      std::vector<vk::DescriptorBindingFlags> flags;
+      bool partially_bound = false;
+      for (const ReflectedBinding& binding : bindings) {
+        if (binding.Set != set) {
+          continue;
+        }
+        bool runtime = binding.Count == 0;
+        set_bindings.push_back(vk::DescriptorSetLayoutBinding{ binding.Binding, binding.Type,
+          runtime ? runtime_array_capacity : binding.Count, binding.Stages });
+        flags.push_back(runtime ? vk::DescriptorBindingFlagBits::ePartiallyBound : vk::DescriptorBindingFlags{});
+        partially_bound = partially_bound || runtime;
+      }
+
+      vk::DescriptorSetLayoutBindingFlagsCreateInfo flags_info{};
+      flags_info.bindingCount = static_cast<uint32_t>(flags.size());
+      flags_info.pBindingFlags = flags.data();
+
+      vk::DescriptorSetLayoutCreateInfo set_info{};
+      set_info.bindingCount = static_cast<uint32_t>(set_bindings.size());
+      set_info.pBindings = set_bindings.data();
+      set_info.pNext = partially_bound ? &flags_info : nullptr;
+      layout.SetLayouts.push_back(device.createDescriptorSetLayout(set_info));
+    }
+
+    vk::PushConstantRange push_range{ push_stages, 0, push_constant_size };
+    vk::PipelineLayoutCreateInfo layout_info{};
+    layout_info.setLayoutCount = static_cast<uint32_t>(layout.SetLayouts.size());
+    layout_info.pSetLayouts = layout.SetLayouts.data();
+    layout_info.pushConstantRangeCount = push_constant_size > 0 ? 1 : 0;
+    layout_info.pPushConstantRanges = &push_range;
+    layout.Layout = device.createPipelineLayout(layout_info);
+  }
+  catch (vk::SystemError e) {
+    layout.destroy(device);
+    throw std::runtime_error("Failed to create a pipeline layout from reflection!");
+  }
+  return layout;
+}
@@ -0,0 +1,42 @@
+#pragma once
+#include "Headers.h"
+
+#include <array>
+#include <vector>
+
+struct ReflectedBinding {
+  uint32_t Set = 0;
+  uint32_t Binding = 0;
+  vk::DescriptorType Type = vk::DescriptorType::eUniformBuffer;
+  // 0 for runtime sized arrays
+  uint32_t Count = 1;
+  vk::ShaderStageFlags Stages;
+};
+
+struct ShaderReflection {
+  vk::ShaderStageFlags Stage;
+  std::vector<ReflectedBinding> Bindings;
+  uint32_t PushConstantSize = 0;
+  // compute and mesh workgroup size, 0 when specialized or not a compute-like stage
+  std::array<uint32_t, 3> LocalSize{};
+};
+
+// a layout built from reflection, owned by the caller
+struct ReflectedLayout {
+  std::vector<vk::DescriptorSetLayout> SetLayouts;
+  vk::PipelineLayout Layout;
+
+  void destroy(const vk::Device& device);
+};
+
+// Reads descriptor bindings, push constant size and workgroup size from a
+// SPIR-V module's decorations and types, enough to build a pipeline layout
+// without hand-writing one. Throws on malformed SPIR-V.
+ShaderReflection reflect_spirv(const std::vector<uint32_t>& code);
+
+// bindings of all stages by set and binding, throws when two stages disagree on a type
+std::vector<ReflectedBinding> merge_bindings(const std::vector<ShaderReflection>& stages);
+
+// runtime arrays get runtime_array_capacity descriptors and are partially bound
+ReflectedLayout create_reflected_layout(const vk::Device& device, const std::vector<ShaderReflection>& stages,
+  uint32_t runtime_array_capacity = 1024);
@@ -0,0 +1,64 @@
+#include "StartupTimer.h"
+
+#include <iomanip>
+
+StartupTimer::Scope::Scope(StartupTimer& timer, const char* name)
+  : timer_(timer), name_(name), start_(Clock::now()) {
+}
+
+StartupTimer::Scope::~Scope() {
+  timer_.record(name_, start_, Clock::now());
+}
+
+StartupTimer::StartupTimer() {
+  origin_ = Clock::now();
+}
+
+StartupTimer::Scope StartupTimer::stage(const char* name) {
+  return Scope(*this, name);
+}
+
+void StartupTimer::record(const char* name, Clock::time_point start, Clock::time_point end) {
+  Stage stage;
+  stage.Name = name;
+  stage.StartMs = std::chrono::duration<double, std::milli>(start - origin_).count();
+  stage.DurationMs = std::chrono::duration<double, std::milli>(end - start).count();
+  stage.Thread = std::this_thread::get_id();
+
+  std::lock_guard<std::mutex> lock(mutex_);
+  stages_.push_back(stage);
+}
+
+double StartupTimer::total_ms() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+
+  double end = 0.0;
+  for (const Stage& stage : stages_) {
+    end = (std::max)(end, stage.StartMs + stage.DurationMs);
+  }
+  return end;
+}
+
+void StartupTimer::report() const {
+  std::vector<Stage> stages;
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    stages = stages_;
+  }
+  std::sort(stages.begin(), stages.end(), [](const Stage& a, const Stage& b) { return a.StartMs < b.StartMs; });
+
+  // number threads in order of first appearance so the timeline reads left to right
+  std::vector<std::thread::id> threads;
+  std::cout << "Startup timeline:" << std::endl;
+  for (const Stage& stage : stages) {
+    auto it = std::find(threads.begin(), threads.end(), stage.Thread);
+    size_t thread = it - threads.begin();
+    if (it == threads.end()) {
+      threads.push_back(stage.Thread);
+    }
+
+    std::cout << "  [thread " << thread << "] " << std::fixed << std::setprecision(2)
+      << std::setw(9) << stage.StartMs << "ms +" << std::setw(8) << stage.DurationMs << "ms  " << stage.Name << std::endl;
+  }
+  std::cout << "  total " << total_ms() << "ms" << std::defaultfloat << std::endl;
+}
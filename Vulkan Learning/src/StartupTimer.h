@@ -0,0 +1,48 @@
+#pragma once
+#include "Headers.h"
+
+#include <chrono>
+#include <mutex>
+#include <string>
+#include <thread>
+
+// Records named startup stages on a shared timeline, from any thread.
+class StartupTimer {
+public:
+  using Clock = std::chrono::steady_clock;
+
+  // times the enclosing block as one stage
+  class Scope {
+  public:
+    Scope(StartupTimer& timer, const char* name);
+    ~Scope();
+
+    Scope(const Scope&) = delete;
+    Scope& operator=(const Scope&) = delete;
+
+  private:
+    StartupTimer& timer_;
+    const char* name_;
+    Clock::time_point start_;
+  };
+
+  StartupTimer();
+
+  Scope stage(const char* name);
+  void record(const char* name, Clock::time_point start, Clock::time_point end);
+
+  double total_ms() const;
+  void report() const;
+
+private:
+  struct Stage {
+    std::string Name;
+    double StartMs;
+    double DurationMs;
+    std::thread::id Thread;
+  };
+
+  Clock::time_point origin_;
+  std::vector<Stage> stages_;
+  mutable std::mutex mutex_;
+};
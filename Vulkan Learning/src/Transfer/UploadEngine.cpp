@@ -0,0 +1,305 @@
+#include "Transfer/UploadEngine.h"
+
+UploadEngine::UploadEngine(const vk::Device& device, MemoryAllocator& allocator, vk::Queue transfer_queue, uint32_t transfer_family,
+  uint32_t graphics_family, vk::DeviceSize staging_capacity, const bool debug)
+  : device_(device), allocator_(allocator), staging_ring_(staging_capacity, 1) {
+  queue_ = transfer_queue;
+  transfer_family_ = transfer_family;
+  graphics_family_ = graphics_family;
+  debug_ = debug;
+
+  if (debug_) {
+    LOG_DEBUG("Creating Upload Engine on queue family " << transfer_family_
+      << (transfer_family_ != graphics_family_ ? " (dedicated)" : " (shared with graphics)")
+      << " with " << staging_capacity / 1024 << "KiB of staging");
+  }
+
+  vk::BufferCreateInfo buffer_info{};
+  buffer_info.size = staging_capacity;
+  buffer_info.usage = vk::BufferUsageFlagBits::eTransferSrc;
+  buffer_info.sharingMode = vk::SharingMode::eExclusive;
+  staging_buffer_ = device_.createBuffer(buffer_info);
+  staging_memory_ = allocator_.allocate_for_buffer(staging_buffer_,
+    vk::MemoryPropertyFlagBits::eHostVisible | vk::MemoryPropertyFlagBits::eHostCoherent);
+
+  vk::CommandPoolCreateInfo pool_info{};
+  pool_info.flags = vk::CommandPoolCreateFlagBits::eResetCommandBuffer | vk::CommandPoolCreateFlagBits::eTransient;
+  pool_info.queueFamilyIndex = transfer_family_;
+  command_pool_ = device_.createCommandPool(pool_info);
+
+  vk::SemaphoreTypeCreateInfo type_info{};
+  type_info.semaphoreType = vk::SemaphoreType::eTimeline;
+  type_info.initialValue = 0;
+  vk::SemaphoreCreateInfo semaphore_info{};
+  semaphore_info.pNext = &type_info;
+  timeline_ = device_.createSemaphore(semaphore_info);
+}
+
+UploadEngine::~UploadEngine() {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    submit_current();
+  }
+  wait(next_value_ - 1);
+
+  device_.destroySemaphore(timeline_);
+  device_.destroyCommandPool(command_pool_);
+  device_.destroyBuffer(staging_buffer_);
+  allocator_.free(staging_memory_);
+}
+
+uint64_t UploadEngine::upload_buffer(vk::Buffer dst, vk::DeviceSize dst_offset, const void* data, vk::DeviceSize size) {
+  std::lock_guard<std::mutex> lock(mutex_);
+
+  // large uploads are split so they never need more than a slice of the ring
+  vk::DeviceSize chunk_size = (std::max)<vk::DeviceSize>(staging_ring_.capacity() / 4, 1);
+  for (vk::DeviceSize done = 0; done < size; done += chunk_size) {
+    vk::DeviceSize chunk = (std::min)(chunk_size, size - done);
+    uint64_t offset = reserve_staging(chunk, 16);
+    memcpy(static_cast<char*>(staging_memory_.Mapped) + offset, static_cast<const char*>(data) + done, chunk);
+
+    vk::BufferCopy region{ offset, dst_offset + done, chunk };
+    current_command_buffer().copyBuffer(staging_buffer_, dst, region);
+  }
+
+  if (transfer_family_ != graphics_family_) {
+    vk::BufferMemoryBarrier release{};
+    release.srcAccessMask = vk::AccessFlagBits::eTransferWrite;
+    release.dstAccessMask = vk::AccessFlags{};
+    release.srcQueueFamilyIndex = transfer_family_;
+    release.dstQueueFamilyIndex = graphics_family_;
+    release.buffer = dst;
+    release.offset = dst_offset;
+    release.size = size;
+    current_command_buffer().pipelineBarrier(vk::PipelineStageFlagBits::eTransfer, vk::PipelineStageFlagBits::eBottomOfPipe,
+      vk::DependencyFlags{}, nullptr, release, nullptr);
+
+    vk::BufferMemoryBarrier acquire = release;
+    acquire.srcAccessMask = vk::AccessFlags{};
+    acquire.dstAccessMask = vk::AccessFlagBits::eMemoryRead;
+    buffer_acquires_.push_back({ next_value_, acquire });
+  }
+
+  stats_.Bytes += size;
+  ++stats_.Uploads;
+  return next_value_;
+}
+
+uint64_t UploadEngine::upload_image(vk::Image dst, vk::Extent3D extent, uint32_t mip_level, uint32_t array_layer,
+  const void* data, vk::DeviceSize size, vk::ImageLayout final_layout) {
+  std::lock_guard<std::mutex> lock(mutex_);
+
+  if (size > staging_ring_.capacity()) {
+    throw std::runtime_error("Image upload is larger than the staging ring!");
+  }
+
+  // texel block copies need at most 16 byte alignment
+  uint64_t offset = reserve_staging(size, 16);
+  memcpy(static_cast<char*>(staging_memory_.Mapped) + offset, data, size);
+
+  vk::CommandBuffer command_buffer = current_command_buffer();
+  vk::ImageSubresourceRange range{ vk::ImageAspectFlagBits::eColor, mip_level, 1, array_layer, 1 };
+
+  vk::ImageMemoryBarrier to_transfer{};
+  to_transfer.srcAccessMask = vk::AccessFlags{};
+  to_transfer.dstAccessMask = vk::AccessFlagBits::eTransferWrite;
+  to_transfer.oldLayout = vk::ImageLayout::eUndefined;
+  to_transfer.newLayout = vk::ImageLayout::eTransferDstOptimal;
+  to_transfer.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+  to_transfer.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+  to_transfer.image = dst;
+  to_transfer.subresourceRange = range;
+  command_buffer.pipelineBarrier(vk::PipelineStageFlagBits::eTopOfPipe, vk::PipelineStageFlagBits::eTransfer,
+    vk::DependencyFlags{}, nullptr, nullptr, to_transfer);
+
+  vk::BufferImageCopy region{};
+  region.bufferOffset = offset;
+  region.imageSubresource = vk::ImageSubresourceLayers{ vk::ImageAspectFlagBits::eColor, mip_level, array_layer, 1 };
+  region.imageExtent = extent;
+  command_buffer.copyBufferToImage(staging_buffer_, dst, vk::ImageLayout::eTransferDstOptimal, region);
+
+  // the layout transition is part of the release, the acquire repeats it exactly
+  vk::ImageMemoryBarrier release = to_transfer;
+  release.srcAccessMask = vk::AccessFlagBits::eTransferWrite;
+  release.dstAccessMask = vk::AccessFlags{};
+  release.oldLayout = vk::ImageLayout::eTransferDstOptimal;
+  release.newLayout = final_layout;
+  if (transfer_family_ != graphics_family_) {
+    release.srcQueueFamilyIndex = transfer_family_;
+    release.dstQueueFamilyIndex = graphics_family_;
+
+    vk::ImageMemoryBarrier acquire = release;
+    acquire.srcAccessMask = vk::AccessFlags{};
+    acquire.dstAccessMask = vk::AccessFlagBits::eMemoryRead;
+    image_acquires_.push_back({ next_value_, acquire });
+  }
+  command_buffer.pipelineBarrier(vk::PipelineStageFlagBits::eTransfer, vk::PipelineStageFlagBits::eBottomOfPipe,
+    vk::DependencyFlags{}, nullptr, nullptr, release);
+
+  stats_.Bytes += size;
+  ++stats_.Uploads;
+  return next_value_;
+}
+
+void UploadEngine::flush() {
+  std::lock_guard<std::mutex> lock(mutex_);
+  submit_current();
+  collect();
+}
+
+uint64_t UploadEngine::record_acquires(vk::CommandBuffer command_buffer) {
+  std::lock_guard<std::mutex> lock(mutex_);
+
+  // only batches that were already submitted can be acquired from
+  uint64_t submitted = next_value_ - 1;
+  uint64_t wait_value = 0;
+  if (submitted > graphics_waited_) {
+    wait_value = submitted;
+    graphics_waited_ = submitted;
+  }
+  std::vector<vk::BufferMemoryBarrier> buffer_barriers;
+  std::vector<vk::ImageMemoryBarrier> image_barriers;
+
+  auto take = [&](auto& pending, auto& barriers) {
+    auto it = pending.begin();
+    while (it != pending.end()) {
+      if (it->Value <= submitted) {
+        barriers.push_back(it->Acquire);
+        it = pending.erase(it);
+      }
+      else {
+        ++it;
+      }
+    }
+  };
+  take(buffer_acquires_, buffer_barriers);
+  take(image_acquires_, image_barriers);
+
+  if (!buffer_barriers.empty() || !image_barriers.empty()) {
+    command_buffer.pipelineBarrier(vk::PipelineStageFlagBits::eTopOfPipe, vk::PipelineStageFlagBits::eAllCommands,
+      vk::DependencyFlags{}, nullptr, buffer_barriers, image_barriers);
+  }
+
+  return wait_value;
+}
+
+bool UploadEngine::is_complete(uint64_t value) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return completed_value() >= value;
+}
+
+void UploadEngine::wait(uint64_t value) {
+  if (value == 0) {
+    return;
+  }
+
+  vk::SemaphoreWaitInfo wait_info{};
+  wait_info.semaphoreCount = 1;
+  wait_info.pSemaphores = &timeline_;
+  wait_info.pValues = &value;
+  (void)device_.waitSemaphores(wait_info, UINT64_MAX);
+}
+
+vk::Semaphore UploadEngine::timeline() const {
+  return timeline_;
+}
+
+UploadStats UploadEngine::stats() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  UploadStats stats = stats_;
+  stats.StagingHighWater = staging_ring_.high_water();
+  return stats;
+}
+
+void UploadEngine::report() const {
+  UploadStats stats = this->stats();
+
+  std::cout << "Uploads: " << stats.Uploads << " (" << stats.Bytes / 1024 << "KiB) in " << stats.Batches << " batches, "
+    << stats.StagingStalls << " staging stalls, staging high water " << stats.StagingHighWater / 1024 << "KiB" << std::endl;
+}
+
+uint64_t UploadEngine::reserve_staging(vk::DeviceSize size, vk::DeviceSize alignment) {
+  while (true) {
+    std::optional<uint64_t> offset = staging_ring_.allocate(size, alignment);
+    if (offset) {
+      return *offset;
+    }
+
+    // out of staging space, push out what we have and wait for the oldest batch
+    submit_current();
+    collect();
+    if (in_flight_.empty()) {
+      throw std::runtime_error("Staging ring is too small for the upload!");
+    }
+    ++stats_.StagingStalls;
+    wait(in_flight_.front().Value);
+    collect();
+  }
+}
+
+vk::CommandBuffer UploadEngine::current_command_buffer() {
+  if (recording_) {
+    return recording_;
+  }
+
+  if (free_command_buffers_.empty()) {
+    vk::CommandBufferAllocateInfo alloc_info{};
+    alloc_info.commandPool = command_pool_;
+    alloc_info.level = vk::CommandBufferLevel::ePrimary;
+    alloc_info.commandBufferCount = 1;
+    free_command_buffers_.push_back(device_.allocateCommandBuffers(alloc_info)[0]);
+  }
+
+  recording_ = free_command_buffers_.back();
+  free_command_buffers_.pop_back();
+
+  recording_.reset();
+  vk::CommandBufferBeginInfo begin_info{};
+  begin_info.flags = vk::CommandBufferUsageFlagBits::eOneTimeSubmit;
+  recording_.begin(begin_info);
+  return recording_;
+}
+
+void UploadEngine::submit_current() {
+  if (!recording_) {
+    return;
+  }
+  recording_.end();
+
+  Batch batch;
+  batch.CommandBuffer = recording_;
+  batch.Value = next_value_++;
+  batch.StagingEnd = staging_ring_.head();
+  recording_ = nullptr;
+
+  vk::TimelineSemaphoreSubmitInfo timeline_info{};
+  timeline_info.signalSemaphoreValueCount = 1;
+  timeline_info.pSignalSemaphoreValues = &batch.Value;
+
+  vk::SubmitInfo submit_info{};
+  submit_info.pNext = &timeline_info;
+  submit_info.commandBufferCount = 1;
+  submit_info.pCommandBuffers = &batch.CommandBuffer;
+  submit_info.signalSemaphoreCount = 1;
+  submit_info.pSignalSemaphores = &timeline_;
+  queue_.submit(submit_info);
+
+  in_flight_.push_back(batch);
+  ++stats_.Batches;
+}
+
+void UploadEngine::collect() {
+  uint64_t completed = completed_value();
+  while (!in_flight_.empty() && in_flight_.front().Value <= completed) {
+    staging_ring_.release(in_flight_.front().StagingEnd);
+    free_command_buffers_.push_back(in_flight_.front().CommandBuffer);
+    in_flight_.pop_front();
+  }
+}
+
+uint64_t UploadEngine::completed_value() {
+  if (completed_cache_ < next_value_ - 1) {
+    completed_cache_ = device_.getSemaphoreCounterValue(timeline_);
+  }
+  return completed_cache_;
+}
@@ -0,0 +1,104 @@
+#pragma once
+#include "Headers.h"
+#include "Memory/MemoryAllocator.h"
+#include "Memory/RingAllocator.h"
+
+#include <deque>
+#include <mutex>
+
+struct UploadStats {
+  uint64_t Bytes = 0;
+  uint64_t Uploads = 0;
+  uint64_t Batches = 0;
+  // times an upload had to wait for the GPU to free staging space
+  uint64_t StagingStalls = 0;
+  uint64_t StagingHighWater = 0;
+};
+
+// Streams buffer and image data to the GPU through a persistently mapped
+// staging ring on the transfer queue. Completion is tracked with a timeline
+// semaphore: every upload returns the value after which its destination is
+// ready, and staging space is recycled as those values are reached.
+//
+// When the transfer family differs from the graphics family, exclusive
+// resources are released on the transfer queue and record_acquires() records
+// the matching acquire barriers on the graphics side.
+//
+// upload_*() may be called from any thread. flush() submits to the transfer
+// queue and must come from the thread that owns it; if the transfer queue is
+// shared with graphics, uploads may flush too, so keep them on that thread.
+class UploadEngine {
+public:
+  UploadEngine(const vk::Device& device, MemoryAllocator& allocator, vk::Queue transfer_queue, uint32_t transfer_family,
+    uint32_t graphics_family, vk::DeviceSize staging_capacity, const bool debug);
+  ~UploadEngine();
+
+  uint64_t upload_buffer(vk::Buffer dst, vk::DeviceSize dst_offset, const void* data, vk::DeviceSize size);
+  // uploads one mip level / layer of a color image and leaves it in final_layout
+  uint64_t upload_image(vk::Image dst, vk::Extent3D extent, uint32_t mip_level, uint32_t array_layer,
+    const void* data, vk::DeviceSize size, vk::ImageLayout final_layout);
+
+  // submits everything recorded since the last flush
+  void flush();
+
+  // records pending ownership acquires into a graphics command buffer and returns
+  // the timeline value its submission has to wait on, 0 when no batch was
+  // submitted since the last call
+  uint64_t record_acquires(vk::CommandBuffer command_buffer);
+
+  bool is_complete(uint64_t value);
+  void wait(uint64_t value);
+  vk::Semaphore timeline() const;
+
+  UploadStats stats() const;
+  void report() const;
+
+private:
+  struct Batch {
+    vk::CommandBuffer CommandBuffer;
+    uint64_t Value = 0;
+    // staging ring head when the batch was submitted
+    uint64_t StagingEnd = 0;
+  };
+
+  template <typename Barrier>
+  struct PendingAcquire {
+    uint64_t Value;
+    Barrier Acquire;
+  };
+
+  uint64_t reserve_staging(vk::DeviceSize size, vk::DeviceSize alignment);
+  vk::CommandBuffer current_command_buffer();
+  void submit_current();
+  void collect();
+  uint64_t completed_value();
+
+  vk::Device device_;
+  MemoryAllocator& allocator_;
+  vk::Queue queue_;
+  uint32_t transfer_family_;
+  uint32_t graphics_family_;
+  bool debug_;
+
+  vk::Buffer staging_buffer_;
+  MemoryAllocation staging_memory_;
+  RingAllocator staging_ring_;
+
+  vk::CommandPool command_pool_;
+  std::vector<vk::CommandBuffer> free_command_buffers_;
+  vk::CommandBuffer recording_;
+  std::deque<Batch> in_flight_;
+
+  vk::Semaphore timeline_;
+  // value the batch being recorded will signal
+  uint64_t next_value_ = 1;
+  uint64_t completed_cache_ = 0;
+  // last value handed to the graphics queue as a wait
+  uint64_t graphics_waited_ = 0;
+
+  std::vector<PendingAcquire<vk::BufferMemoryBarrier>> buffer_acquires_;
+  std::vector<PendingAcquire<vk::ImageMemoryBarrier>> image_acquires_;
+
+  UploadStats stats_;
+  mutable std::mutex mutex_;
+};
@@ -0,0 +1,39 @@
+#pragma once
+#include "Headers.h"
+
+namespace VkInit {
+
+  vk::CommandPool make_command_pool(const vk::Device& device, uint32_t queue_family, vk::CommandPoolCreateFlags flags, const bool debug) {
+    vk::CommandPoolCreateInfo pool_info{};
+    pool_info.flags = flags;
+    pool_info.queueFamilyIndex = queue_family;
+
+    try {
+      return device.createCommandPool(pool_info);
+    }
+    catch (vk::SystemError e) {
+      if (debug) {
+        LOG_ERROR("Command pool creation failed!");
+      }
+      return nullptr;
+    }
+  }
+
+  vk::CommandBuffer make_command_buffer(const vk::Device& device, const vk::CommandPool& pool, vk::CommandBufferLevel level, const bool debug) {
+    vk::CommandBufferAllocateInfo alloc_info{};
+    alloc_info.commandPool = pool;
+    alloc_info.level = level;
+    alloc_info.commandBufferCount = 1;
+
+    try {
+      return device.allocateCommandBuffers(alloc_info)[0];
+    }
+    catch (vk::SystemError e) {
+      if (debug) {
+        LOG_ERROR("Command buffer allocation failed!");
+      }
+      return nullptr;
+    }
+  }
+
+}// namespace VkInit
@@ -1,77 +1,71 @@
 #pragma once
 #include "Headers.h"
-#include "VkUtils/SwapchainDetails.h"
-#include "VkUtils/QueueFamilies.h"
+#include <cctype>
+#include "VkUtils/DeviceCapabilities.h"
 
 namespace VkInit {
 
   // only run in debug
-  void log_physical_device_properties(const vk::PhysicalDevice& device) {
-    vk::PhysicalDeviceProperties props = device.getProperties();
+  void log_physical_device_properties(const VkUtils::DeviceCapabilities& caps) {
+    const vk::PhysicalDeviceProperties& props = caps.Properties;
 
-    std::cout << "Device Name: " << props.deviceName << std::endl;
-    std::cout << "Device Type: ";
+    LOG_DEBUG("Device Name: " << props.deviceName);
+    LOG_DEBUG("Vendor ID: " << props.vendorID << ", Device ID: " << props.deviceID);
 
+    const char* device_type = "Other";
     switch (props.deviceType) {
     case vk::PhysicalDeviceType::eDiscreteGpu:{
-      std::cout << "Discrete Gpu" << std::endl;
+      device_type = "Discrete Gpu";
       break;
     }
     case vk::PhysicalDeviceType::eIntegratedGpu: {
-      std::cout << "Integrated Gpu" << std::endl;
+      device_type = "Integrated Gpu";
       break;
     }
     case vk::PhysicalDeviceType::eCpu: {
-      std::cout << "Cpu" << std::endl;
+      device_type = "Cpu";
       break;
     }
     case vk::PhysicalDeviceType::eVirtualGpu: {
-      std::cout << "Virtual Cpu" << std::endl;
+      device_type = "Virtual Cpu";
       break;
     }
     default: {
-      std::cout << "Other" << std::endl;
       break;
     }
     }
+    LOG_DEBUG("Device Type: " << device_type);
   }
 
-  bool device_is_supported(const vk::PhysicalDevice& device, const bool debug) {
-    std::vector<const char*> extensions{
-      VK_KHR_SWAPCHAIN_EXTENSION_NAME
-    };
+  bool device_is_supported(const VkUtils::DeviceCapabilities& caps, const bool debug) {
+    std::vector<const char*> extensions;
+    if (!caps.Indices.Headless) {
+      extensions.push_back(VK_KHR_SWAPCHAIN_EXTENSION_NAME);
+    }
 
     if (debug) {
-      std::cout << std::endl << "Requesting Device Extensions: ";
+      std::string requested;
       for (const char* extension : extensions) {
-        std::cout << extension << ", ";
+        requested += std::string(extension) + ", ";
       }
-      std::cout << std::endl << std::endl;
+      LOG_DEBUG("Requesting Device Extensions: " << requested);
     }
 
-    std::vector<vk::ExtensionProperties> supported_extensions = device.enumerateDeviceExtensionProperties();
-
-    if (debug) {
-      std::cout << "Supported Device Extensions: ";
-      for (vk::ExtensionProperties props : supported_extensions) {
-        std::cout << props.extensionName << ", ";
-      }
-      std::cout << std::endl << std::endl;
+    // timeline semaphores track upload completion
+    if (caps.Properties.apiVersion < VK_API_VERSION_1_2 || !caps.Vulkan12Features.timelineSemaphore) {
+      if (debug)
+        LOG_WARN("Timeline semaphores are not supported!");
+      return false;
     }
 
     for (const char* req : extensions) {
-      bool temp_supported_layers = false;
-      for (vk::ExtensionProperties prop : supported_extensions) {
-        if (strcmp(req, prop.extensionName) == 0)
-          temp_supported_layers = true;
-      }
-      if (temp_supported_layers) {
+      if (caps.has_extension(req)) {
         if (debug)
-          std::cout << req << " is supported!" << std::endl << std::endl;
+          LOG_DEBUG(req << " is supported!");
       }
       else {
         if (debug)
-          std::cout << req << " is not supported!" << std::endl << std::endl;
+          LOG_WARN(req << " is not supported!");
         return false;
       }
     }
@@ -79,84 +73,290 @@ namespace VkInit {
     return true;
   }
 
-  vk::PhysicalDevice choose_physical_device(const vk::Instance& instance, const vk::SurfaceKHR& surface, const bool debug) {
+  std::string uuid_to_string(const uint8_t* uuid) {
+    static const char* hex = "0123456789abcdef";
+    std::string result;
+    for (uint32_t i = 0; i < VK_UUID_SIZE; ++i) {
+      result += hex[uuid[i] >> 4];
+      result += hex[uuid[i] & 0xF];
+    }
+    return result;
+  }
+
+  // true when the override names the device by (part of) its name or by its device UUID
+  bool device_matches(const VkUtils::DeviceCapabilities& caps, const std::string& device_override) {
+    if (device_override.empty()) {
+      return false;
+    }
+
+    std::string name = caps.Properties.deviceName.data();
+    if (name.find(device_override) != std::string::npos) {
+      return true;
+    }
+
+    std::string wanted;
+    for (char c : device_override) {
+      if (c != '-') {
+        wanted += static_cast<char>(tolower(c));
+      }
+    }
+    return wanted == uuid_to_string(caps.DeviceUUID.data());
+  }
+
+  // 0 means the device cannot run us at all, otherwise higher is better
+  uint64_t score_physical_device(const VkUtils::DeviceCapabilities& caps, const bool debug) {
+    if (!device_is_supported(caps, debug)) {
+      return 0;
+    }
+    if (!caps.Indices.is_complete()) {
+      return 0;
+    }
+    if (!caps.Indices.Headless && (caps.Swapchain.Formats.empty() || caps.Swapchain.PresentModes.empty())) {
+      return 0;
+    }
+
+    const vk::PhysicalDeviceProperties& props = caps.Properties;
+    uint64_t score = 1;
+
+    // adapter type dominates, a CPU device only wins when it is all there is
+    switch (props.deviceType) {
+    case vk::PhysicalDeviceType::eDiscreteGpu: score += 100000; break;
+    case vk::PhysicalDeviceType::eIntegratedGpu: score += 50000; break;
+    case vk::PhysicalDeviceType::eVirtualGpu: score += 25000; break;
+    case vk::PhysicalDeviceType::eCpu: score += 1000; break;
+    default: break;
+    }
+
+    // 100 points per GiB of device local memory
+    const vk::PhysicalDeviceMemoryProperties& memory_props = caps.MemoryProperties;
+    for (uint32_t i = 0; i < memory_props.memoryHeapCount; ++i) {
+      if (memory_props.memoryHeaps[i].flags & vk::MemoryHeapFlagBits::eDeviceLocal) {
+        score += memory_props.memoryHeaps[i].size / (1024ull * 1024 * 1024) * 100;
+      }
+    }
+
+    // dedicated transfer and async compute families let work overlap
+    for (const vk::QueueFamilyProperties& family : caps.QueueFamilies) {
+      if (!(family.queueFlags & vk::QueueFlagBits::eGraphics)) {
+        if (family.queueFlags & vk::QueueFlagBits::eCompute) {
+          score += 500;
+        }
+        else if (family.queueFlags & vk::QueueFlagBits::eTransfer) {
+          score += 500;
+        }
+      }
+    }
+
+    const vk::PhysicalDeviceFeatures& features = caps.Features;
+    if (features.samplerAnisotropy) {
+      score += 100;
+    }
+    if (features.multiDrawIndirect) {
+      score += 100;
+    }
+    score += props.limits.maxImageDimension2D / 1024;
+
+    if (debug) {
+      LOG_DEBUG(props.deviceName << " scored " << score);
+    }
+    return score;
+  }
+
+  // the surface independent capabilities of every device, needs only the instance
+  std::vector<VkUtils::DeviceCapabilities> query_physical_devices(const vk::Instance& instance, const bool debug) {
+    std::vector<VkUtils::DeviceCapabilities> devices;
+    for (vk::PhysicalDevice dev : instance.enumeratePhysicalDevices()) {
+      devices.push_back(VkUtils::query_device_capabilities(dev, nullptr, debug));
+    }
+    return devices;
+  }
+
+  // every usable device out of already queried candidates, best first; a device matching device_override always leads
+  std::vector<VkUtils::DeviceCapabilities> rank_physical_devices(std::vector<VkUtils::DeviceCapabilities> candidates, const std::string& device_override, const bool debug) {
     if (debug) {
-      std::cout << "Choosing Physical Device..." << std::endl;
+      LOG_DEBUG("Ranking Physical Devices...");
     }
 
-    std::vector<vk::PhysicalDevice> devices_vector{ instance.enumeratePhysicalDevices() };
+    std::vector<std::pair<uint64_t, VkUtils::DeviceCapabilities>> scored;
+    bool override_found = false;
 
     if (debug) {
-      std::cout << std::endl << "Physical Devices: " << std::endl << std::endl;
+      LOG_DEBUG("Physical Devices: ");
     }
-    for (vk::PhysicalDevice dev : devices_vector) {
+    for (VkUtils::DeviceCapabilities& caps : candidates) {
       if (debug) {
-        log_physical_device_properties(dev);
+        log_physical_device_properties(caps);
       }
-      if (device_is_supported(dev, debug)) {
-        VkUtils::SwapChainSupportDetails swapchain_support = VkUtils::query_swapchain_support(dev, surface, debug);
-        if (!swapchain_support.Formats.empty() && !swapchain_support.PresentModes.empty()) {
-          return dev;
-        }
+      uint64_t score = score_physical_device(caps, debug);
+      if (score == 0) {
+        continue;
       }
+      if (device_matches(caps, device_override)) {
+        score = UINT64_MAX;
+        override_found = true;
+      }
+      scored.push_back({ score, std::move(caps) });
     }
 
-    return nullptr;
+    if (!device_override.empty() && !override_found) {
+      LOG_WARN("No usable device matches \"" << device_override << "\", falling back to scoring");
+    }
+
+    std::stable_sort(scored.begin(), scored.end(), [](const auto& a, const auto& b) { return a.first > b.first; });
+
+    std::vector<VkUtils::DeviceCapabilities> ranked;
+    for (auto& entry : scored) {
+      ranked.push_back(std::move(entry.second));
+    }
+    return ranked;
   }
 
-  vk::Device create_logical_device(const vk::PhysicalDevice& device, const vk::SurfaceKHR& surface, const bool debug) {
+  // queries and ranks every device of the instance in one go
+  std::vector<VkUtils::DeviceCapabilities> rank_physical_devices(const vk::Instance& instance, const vk::SurfaceKHR& surface, const std::string& device_override, const bool debug) {
+    std::vector<VkUtils::DeviceCapabilities> candidates = query_physical_devices(instance, debug);
+    if (surface) {
+      for (VkUtils::DeviceCapabilities& caps : candidates) {
+        VkUtils::query_surface_support(caps, surface, debug);
+      }
+    }
+    return rank_physical_devices(std::move(candidates), device_override, debug);
+  }
+
+  // candidates come from query_physical_devices, a null surface selects headless mode where present support is not required
+  VkUtils::DeviceCapabilities choose_physical_device(std::vector<VkUtils::DeviceCapabilities> candidates, const vk::SurfaceKHR& surface, const std::string& device_override, const bool debug) {
+    if (debug) {
+      LOG_DEBUG("Choosing Physical Device...");
+    }
+
+    if (surface) {
+      for (VkUtils::DeviceCapabilities& caps : candidates) {
+        VkUtils::query_surface_support(caps, surface, debug);
+      }
+    }
+    std::vector<VkUtils::DeviceCapabilities> ranked = rank_physical_devices(std::move(candidates), device_override, debug);
+    if (ranked.empty()) {
+      throw std::runtime_error("No physical device supports the required features!");
+    }
+
     if (debug) {
-      std::cout << "Creating Logical Device..." << std::endl;
+      LOG_DEBUG("Selected " << ranked[0].Properties.deviceName);
     }
-    VkUtils::QueueFamilyIndices indices = VkUtils::find_queue_families(device, surface, debug);
-    std::vector<uint32_t> unique_indices;
-    unique_indices.push_back(indices.GraphicsFamily.value());
-    if (indices.GraphicsFamily.value() != indices.PresentFamily.value()) {
-      unique_indices.push_back(indices.PresentFamily.value());
+    return ranked[0];
+  }
+
+  vk::Device create_logical_device(const VkUtils::DeviceCapabilities& caps, const VkUtils::QueuePlan& plan, const bool debug) {
+    if (debug) {
+      LOG_DEBUG("Creating Logical Device...");
     }
+    VkUtils::QueueFamilyIndices indices = caps.Indices;
 
-    float queue_priority{ 1.0f };
+    // priorities must outlive the create info, the plan owns them
     std::vector<vk::DeviceQueueCreateInfo> queue_infos;
-    for (uint32_t unique_indice : unique_indices) {
+    for (const auto& family : plan.Priorities) {
       vk::DeviceQueueCreateInfo queue_info {
       vk::DeviceQueueCreateFlags(),
-      unique_indice,
-      1,
-      &queue_priority
+      family.first,
+      static_cast<uint32_t>(family.second.size()),
+      family.second.data()
       };
 
       queue_infos.push_back(queue_info);
+      if (debug) {
+        LOG_DEBUG("Opening " << family.second.size() << " queues of family " << family.first);
+      }
     }
 
-    vk::PhysicalDeviceFeatures device_features {};
+    vk::PhysicalDeviceVulkan12Features vulkan12_features {};
+    vulkan12_features.timelineSemaphore = VK_TRUE;
+
+    // descriptor indexing for the bindless heap, only what BindlessHeap actually uses
+    if (caps.supports_bindless()) {
+      vulkan12_features.descriptorIndexing = VK_TRUE;
+      vulkan12_features.runtimeDescriptorArray = VK_TRUE;
+      vulkan12_features.descriptorBindingPartiallyBound = VK_TRUE;
+      vulkan12_features.descriptorBindingUpdateUnusedWhilePending = VK_TRUE;
+      vulkan12_features.descriptorBindingSampledImageUpdateAfterBind = VK_TRUE;
+      vulkan12_features.descriptorBindingStorageBufferUpdateAfterBind = VK_TRUE;
+      vulkan12_features.descriptorBindingStorageImageUpdateAfterBind = VK_TRUE;
+      vulkan12_features.shaderSampledImageArrayNonUniformIndexing = VK_TRUE;
+      vulkan12_features.shaderStorageBufferArrayNonUniformIndexing = caps.Vulkan12Features.shaderStorageBufferArrayNonUniformIndexing;
+      vulkan12_features.shaderStorageImageArrayNonUniformIndexing = caps.Vulkan12Features.shaderStorageImageArrayNonUniformIndexing;
+    }
+
+    vk::PhysicalDeviceFeatures2 device_features {};
+    device_features.pNext = &vulkan12_features;
+
+    // asset packs ship block compressed textures where the device takes them
+    device_features.features.textureCompressionBC = caps.Features.textureCompressionBC;
+
+    // culled draws are compacted on the GPU, the count and the per-mesh instance base come from buffers
+    if (caps.supports_gpu_culling()) {
+      vulkan12_features.drawIndirectCount = VK_TRUE;
+      device_features.features.multiDrawIndirect = VK_TRUE;
+      device_features.features.drawIndirectFirstInstance = VK_TRUE;
+    }
+
+    vk::PhysicalDevicePresentIdFeaturesKHR present_id_features {};
+    vk::PhysicalDevicePresentWaitFeaturesKHR present_wait_features {};
+    if (!indices.Headless && caps.PresentWait) {
+      present_id_features.presentId = VK_TRUE;
+      present_wait_features.presentWait = VK_TRUE;
+      present_id_features.pNext = &present_wait_features;
+      vulkan12_features.pNext = &present_id_features;
+    }
+
+    // promoted in 1.3 with the same feature struct, which may be chained on either version
+    vk::PhysicalDeviceSynchronization2Features synchronization2_features {};
+    if (caps.Synchronization2) {
+      synchronization2_features.synchronization2 = VK_TRUE;
+      synchronization2_features.pNext = device_features.pNext;
+      device_features.pNext = &synchronization2_features;
+    }
 
     std::vector<const char*> layers{};
     if (debug) {
       layers.push_back("VK_LAYER_KHRONOS_validation");
     }
 
-    std::vector<const char*> device_extensions{
-      VK_KHR_SWAPCHAIN_EXTENSION_NAME
-    };
+    std::vector<const char*> device_extensions;
+    // lets the profiler put GPU timestamps on the CPU timeline
+    if (caps.has_extension(VK_EXT_CALIBRATED_TIMESTAMPS_EXTENSION_NAME)) {
+      device_extensions.push_back(VK_EXT_CALIBRATED_TIMESTAMPS_EXTENSION_NAME);
+    }
+    // lets the residency manager see how close each heap is to its budget
+    if (caps.MemoryBudget) {
+      device_extensions.push_back(VK_EXT_MEMORY_BUDGET_EXTENSION_NAME);
+    }
+    if (caps.Synchronization2 && caps.Properties.apiVersion < VK_API_VERSION_1_3) {
+      device_extensions.push_back(VK_KHR_SYNCHRONIZATION_2_EXTENSION_NAME);
+    }
+    if (!indices.Headless) {
+      device_extensions.push_back(VK_KHR_SWAPCHAIN_EXTENSION_NAME);
+      if (caps.PresentWait) {
+        device_extensions.push_back(VK_KHR_PRESENT_ID_EXTENSION_NAME);
+        device_extensions.push_back(VK_KHR_PRESENT_WAIT_EXTENSION_NAME);
+      }
+    }
 
     vk::DeviceCreateInfo create_info {
       vk::DeviceCreateFlags{},
       static_cast<uint32_t>(queue_infos.size()), queue_infos.data(),
       static_cast<uint32_t>(layers.size()), layers.data(),
       static_cast<uint32_t>(device_extensions.size()), device_extensions.data(),
-      &device_features
+      nullptr
     };
+    create_info.pNext = &device_features;
 
     try {
-      vk::Device logical_device = device.createDevice(create_info);
+      vk::Device logical_device = caps.PhysicalDevice.createDevice(create_info);
       if (debug) {
-        std::cout << "Device successfully abstracted!" << std::endl << std::endl;
+        LOG_DEBUG("Device successfully abstracted!");
       }
       return logical_device;
     }
     catch (vk::SystemError e) {
       if (debug) {
-        std::cout << "Device creation failed!" << std::endl;
+        LOG_ERROR("Device creation failed!");
       }
       return nullptr;
     }
@@ -164,15 +364,26 @@ namespace VkInit {
     return nullptr;
   }
 
-  std::array<vk::Queue, 2> get_queue(const vk::PhysicalDevice & physical_device, const vk::Device& device, const vk::SurfaceKHR& surface, const bool debug) {
+  // graphics, present and transfer queues, in that order
+  std::array<vk::Queue, 3> get_queue(const VkUtils::QueuePlan& plan, const vk::Device& device, const bool debug) {
     if (debug) {
-      std::cout << "Retrieving Graphics Queue..." << std::endl;
+      LOG_DEBUG("Retrieving Graphics Queue...");
     }
-    VkUtils::QueueFamilyIndices indices = VkUtils::find_queue_families(physical_device, surface, debug);
-
     return {
-      device.getQueue(indices.GraphicsFamily.value(), 0),
-      device.getQueue(indices.PresentFamily.value(), 0)
+      device.getQueue(plan.Graphics.Family, plan.Graphics.Index),
+      device.getQueue(plan.Present.Family, plan.Present.Index),
+      device.getQueue(plan.Transfer.Family, plan.Transfer.Index)
     };
   }
+
+  std::vector<vk::Queue> get_compute_queues(const VkUtils::QueuePlan& plan, const vk::Device& device, const bool debug) {
+    if (debug) {
+      LOG_DEBUG("Retrieving Compute Queues...");
+    }
+    std::vector<vk::Queue> queues;
+    for (const VkUtils::QueueSlot& slot : plan.Compute) {
+      queues.push_back(device.getQueue(slot.Family, slot.Index));
+    }
+    return queues;
+  }
 } // namespace VkInit
\ No newline at end of file
@@ -1,101 +1,81 @@
 #pragma once
 #include "Headers.h"
 
-namespace VkInit {
-  bool supported(std::vector<const char*> extensions, std::vector<const char*> layers, const bool debug) {
-
-    // layers
-    uint32_t supported_layers;
-    vk::enumerateInstanceLayerProperties(&supported_layers, nullptr);
+#include <string>
+#include <unordered_set>
 
-    std::vector<vk::LayerProperties> layer_properties { supported_layers };
-    vk::enumerateInstanceLayerProperties(&supported_layers, layer_properties.data());
+namespace VkInit {
+  // one enumeration per list into a hash set, then a lookup per requested name
+  bool supported(const std::vector<const char*>& extensions, const std::vector<const char*>& layers, const bool debug) {
+    std::unordered_set<std::string> layer_names;
+    for (const vk::LayerProperties& prop : vk::enumerateInstanceLayerProperties()) {
+      layer_names.insert(prop.layerName.data());
+    }
+    std::unordered_set<std::string> extension_names;
+    for (const vk::ExtensionProperties& prop : vk::enumerateInstanceExtensionProperties()) {
+      extension_names.insert(prop.extensionName.data());
+    }
 
     if (debug) {
-      std::cout << std::endl << "Supported Layers: ";
-      for (vk::LayerProperties prop : layer_properties) {
-        std::cout << prop.layerName << ", ";
+      std::string supported_names;
+      for (const std::string& name : layer_names) {
+        supported_names += name + ", ";
+      }
+      LOG_DEBUG("Supported Layers: " << supported_names);
+      supported_names.clear();
+      for (const std::string& name : extension_names) {
+        supported_names += name + ", ";
       }
-      std::cout << std::endl << std::endl;
+      LOG_DEBUG("Supported Extensions: " << supported_names);
     }
 
+    bool all_supported = true;
     for (const char* layer : layers) {
-      bool temp_supported_layers = false;
-      for (vk::LayerProperties prop : layer_properties) {
-        if (strcmp(layer, prop.layerName) == 0)
-          temp_supported_layers = true;
-      }
-      if (temp_supported_layers) {
+      if (layer_names.count(layer) != 0) {
         if (debug)
-          std::cout << layer << " is supported!" << std::endl << std::endl;
+          LOG_DEBUG(layer << " is supported!");
       }
       else {
-        if (debug)
-          std::cout << layer << " is not supported!" << std::endl << std::endl;
-        return false;
-      }
-    }
-
-    // extensions
-
-    uint32_t supported_extensions;
-    vk::enumerateInstanceLayerProperties(&supported_extensions, nullptr);
-
-    std::vector<vk::ExtensionProperties> extension_properties{ supported_extensions };
-    vk::enumerateInstanceExtensionProperties(nullptr, &supported_extensions, extension_properties.data());
-
-    if (debug) {
-      std::cout << "Supported Extensions: ";
-      for (vk::ExtensionProperties prop : extension_properties) {
-        std::cout << prop.extensionName << ", ";
+        LOG_WARN(layer << " is not supported!");
+        all_supported = false;
       }
-      std::cout << std::endl << std::endl;
     }
-
     for (const char* extension : extensions) {
-      bool temp_supported_extensions = false;
-      for (vk::ExtensionProperties prop : extension_properties) {
-        if (strcmp(extension, prop.extensionName) == 0)
-          temp_supported_extensions = true;
-      }
-      if (temp_supported_extensions) {
+      if (extension_names.count(extension) != 0) {
         if (debug)
-          std::cout << extension << " is supported!" << std::endl << std::endl;
-        else {
-          if (debug)
-            std::cout << extension << " is not supported!" << std::endl << std::endl;
-          return false;
-        }
+          LOG_DEBUG(extension << " is supported!");
+      }
+      else {
+        LOG_WARN(extension << " is not supported!");
+        all_supported = false;
       }
     }
 
-    return true;
+    return all_supported;
   }
 
-  vk::Instance make_instance(const char* application_name, bool debug) {
+  // window_extensions are the surface extensions the window needs, empty when headless
+  vk::Instance make_instance(const char* application_name, const std::vector<const char*>& window_extensions, bool debug) {
 
     uint32_t version;
     vkEnumerateInstanceVersion(&version);
 
     if (debug) {
-      std::cout << "System supports vulkan version: " << VK_API_VERSION_VARIANT(version) << ", " <<
+      LOG_DEBUG("System supports vulkan version: " << VK_API_VERSION_VARIANT(version) << ", " <<
         VK_API_VERSION_MAJOR(version) << ", " << VK_API_VERSION_MINOR(version) << ", "
-        << VK_API_VERSION_PATCH(version) << std::endl;
+        << VK_API_VERSION_PATCH(version));
     }
 
     version &= ~(0xFFFU); // remove patch for compatibility
 
-    uint32_t count;
-    const char** extensions = glfwGetRequiredInstanceExtensions(&count);
-
-    std::vector<const char*> extensions_vector { extensions, extensions+count };
-    if (debug)
+    std::vector<const char*> extensions_vector = window_extensions;
+    // validation is a debugging aid, release runs must not depend on the SDK being installed
+    std::vector<const char*> layers_vector;
+    if (debug) {
       extensions_vector.push_back("VK_EXT_debug_utils");
+      layers_vector.push_back("VK_LAYER_KHRONOS_validation");
+    }
 
-    std::vector<const char*> layers_vector{
-      "VK_LAYER_KHRONOS_validation"
-    };
-    
     if (!supported(extensions_vector, layers_vector, debug))
       return nullptr;
 
@@ -116,13 +96,13 @@ namespace VkInit {
 
     try {
       if (debug) {
-        std::cout << "Creating Instance..." << std::endl;
+        LOG_DEBUG("Creating Instance...");
       }
       return vk::createInstance(create_info);
     }
     catch (vk::SystemError e) {
       if (debug) {
-        std::cout << "Instance Creation Failed!" << std::endl;
+        LOG_ERROR("Instance Creation Failed!");
       }
       return nullptr;
     }
@@ -135,14 +115,39 @@ namespace VkInit {
     const VkDebugUtilsMessengerCallbackDataEXT* pCallbackData,
     void* pUserData) {
 
-    std::cerr << "validation layer: " << pCallbackData->pMessage << std::endl;
+    // may run on driver threads, so it only queues a record for the log writer
+    Log::Level level = Log::Level::Trace;
+    if (messageSeverity & VK_DEBUG_UTILS_MESSAGE_SEVERITY_ERROR_BIT_EXT) {
+      level = Log::Level::Error;
+    }
+    else if (messageSeverity & VK_DEBUG_UTILS_MESSAGE_SEVERITY_WARNING_BIT_EXT) {
+      level = Log::Level::Warn;
+    }
+    else if (messageSeverity & VK_DEBUG_UTILS_MESSAGE_SEVERITY_INFO_BIT_EXT) {
+      level = Log::Level::Info;
+    }
+    if (!Log::enabled(level)) {
+      return VK_FALSE;
+    }
+
+    Log::Record record;
+    record.Severity = level;
+    record.Source = "vulkan";
+    record.Message = pCallbackData->pMessage ? pCallbackData->pMessage : "";
+    record.VkSeverity = static_cast<uint32_t>(messageSeverity);
+    record.VkTypes = static_cast<uint32_t>(messageType);
+    record.MessageIdNumber = pCallbackData->messageIdNumber;
+    if (pCallbackData->pMessageIdName) {
+      record.MessageIdName = pCallbackData->pMessageIdName;
+    }
+    Log::write(std::move(record));
 
     return VK_FALSE;
   }
 
   // should only run in debug mode
   vk::DebugUtilsMessengerEXT create_debug_messenger (vk::Instance& instance, vk::DispatchLoaderDynamic& dispatch_loader) {
-    std::cout << "Creating Debug Messenger..." << std::endl;
+    LOG_DEBUG("Creating Debug Messenger...");
 
     vk::DebugUtilsMessengerCreateInfoEXT debug_create_info{
       vk::DebugUtilsMessengerCreateFlagsEXT(),
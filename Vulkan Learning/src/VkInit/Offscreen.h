@@ -0,0 +1,48 @@
+#pragma once
+#include "Headers.h"
+#include "Memory/MemoryAllocator.h"
+#include "VkUtils/SwapchainDetails.h"
+
+namespace VkInit {
+
+  VkUtils::OffscreenBundle create_offscreen_targets(const vk::Device& logical_device, MemoryAllocator& allocator, vk::Extent2D extent, uint32_t image_count, const bool debug) {
+    if (debug) {
+      LOG_DEBUG("Creating " << image_count << " Offscreen Render Targets...");
+    }
+
+    VkUtils::OffscreenBundle bundle;
+    bundle.Format = vk::Format::eR8G8B8A8Unorm;
+    bundle.Extent = extent;
+
+    for (uint32_t i = 0; i < image_count; ++i) {
+      vk::ImageCreateInfo image_info{};
+      image_info.imageType = vk::ImageType::e2D;
+      image_info.format = bundle.Format;
+      image_info.extent = vk::Extent3D{ extent.width, extent.height, 1 };
+      image_info.mipLevels = 1;
+      image_info.arrayLayers = 1;
+      image_info.samples = vk::SampleCountFlagBits::e1;
+      image_info.tiling = vk::ImageTiling::eOptimal;
+      image_info.usage = vk::ImageUsageFlagBits::eColorAttachment | vk::ImageUsageFlagBits::eTransferSrc |
+        vk::ImageUsageFlagBits::eTransferDst;
+      image_info.sharingMode = vk::SharingMode::eExclusive;
+      image_info.initialLayout = vk::ImageLayout::eUndefined;
+
+      try {
+        vk::Image image = logical_device.createImage(image_info);
+        bundle.Images.push_back(image);
+        bundle.Memory.push_back(allocator.allocate_for_image(image, vk::MemoryPropertyFlagBits::eDeviceLocal));
+      }
+      catch (vk::SystemError e) {
+        throw std::runtime_error("Failed to create offscreen render target!");
+      }
+    }
+
+    if (debug) {
+      LOG_DEBUG("Offscreen Render Targets Successfully Created!");
+    }
+
+    return bundle;
+  }
+
+}// namespace VkInit
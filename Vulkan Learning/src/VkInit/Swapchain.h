@@ -1,13 +1,13 @@
 #pragma once
 #include "Headers.h"
-#include "VkUtils/SwapchainDetails.h"
-#include "VkUtils/QueueFamilies.h"
+#include "Config.h"
+#include "VkUtils/DeviceCapabilities.h"
 
 namespace VkInit {
 
   vk::SurfaceFormatKHR choose_swap_surface_format(std::vector <vk::SurfaceFormatKHR> formats, const bool debug) {
     if (debug) {
-      std::cout << "Selecting Surface Format..." << std::endl;
+      LOG_DEBUG("Selecting Surface Format...");
     }
     for (const auto& format : formats) {
       if (format.format == vk::Format::eB8G8R8A8Snorm && format.colorSpace == vk::ColorSpaceKHR::eSrgbNonlinear) {
@@ -18,23 +18,68 @@ namespace VkInit {
     return formats[0];
   }
 
-  vk::PresentModeKHR choose_present_mode(std::vector<vk::PresentModeKHR> modes, const bool debug) {
+  // modes in order of preference, FIFO is always supported so every list ends with it
+  std::vector<vk::PresentModeKHR> present_mode_preference(PresentProfile profile) {
+    switch (profile) {
+    case PresentProfile::LowLatency:
+      return { vk::PresentModeKHR::eMailbox, vk::PresentModeKHR::eImmediate, vk::PresentModeKHR::eFifoRelaxed, vk::PresentModeKHR::eFifo };
+    case PresentProfile::Throughput:
+      return { vk::PresentModeKHR::eImmediate, vk::PresentModeKHR::eMailbox, vk::PresentModeKHR::eFifoRelaxed, vk::PresentModeKHR::eFifo };
+    case PresentProfile::PowerSaving:
+    default:
+      return { vk::PresentModeKHR::eFifo };
+    }
+  }
+
+  vk::PresentModeKHR choose_present_mode(const std::vector<vk::PresentModeKHR>& modes, PresentProfile profile, const bool debug) {
     if (debug) {
-      std::cout << "Selecting Present Mode..." << std::endl;
+      LOG_DEBUG("Selecting Present Mode...");
     }
 
-    for (const auto& mode : modes) {
-      if (mode == vk::PresentModeKHR::eMailbox) {
-        return mode;
+    for (vk::PresentModeKHR preferred : present_mode_preference(profile)) {
+      if (std::find(modes.begin(), modes.end(), preferred) != modes.end()) {
+        return preferred;
       }
     }
 
     return vk::PresentModeKHR::eFifo;
   }
 
+  // requested overrides the profile, the result is always within the surface limits
+  uint32_t choose_image_count(const vk::SurfaceCapabilitiesKHR& capabilities, vk::PresentModeKHR mode, PresentProfile profile,
+    uint32_t requested, const bool debug) {
+    if (debug) {
+      LOG_DEBUG("Selecting Swapchain Image Count...");
+    }
+
+    uint32_t image_count = requested;
+    if (image_count == 0) {
+      switch (profile) {
+      case PresentProfile::LowLatency:
+        // mailbox needs a spare image to replace, otherwise every extra image is queued latency
+        image_count = capabilities.minImageCount + (mode == vk::PresentModeKHR::eMailbox ? 1 : 0);
+        break;
+      case PresentProfile::Throughput:
+        image_count = capabilities.minImageCount + 2;
+        break;
+      case PresentProfile::PowerSaving:
+      default:
+        image_count = capabilities.minImageCount;
+        break;
+      }
+    }
+
+    image_count = (std::max)(image_count, capabilities.minImageCount);
+    // a maxImageCount of 0 means there is no upper limit
+    if (capabilities.maxImageCount != 0) {
+      image_count = (std::min)(image_count, capabilities.maxImageCount);
+    }
+    return image_count;
+  }
+
   vk::Extent2D choose_swap_extent(const vk::SurfaceCapabilitiesKHR& capabilities, GLFWwindow* window, const bool debug) {
     if (debug) {
-      std::cout << "Selecting Surface Extent..." << std::endl;
+      LOG_DEBUG("Selecting Surface Extent...");
     }
     if (capabilities.currentExtent.width != UINT32_MAX) {
       return capabilities.currentExtent;
@@ -55,21 +100,23 @@ namespace VkInit {
     }
   }
 
-  VkUtils::SwapChainBundle create_swapchain(const vk::PhysicalDevice& physical_device, const vk::Device& logical_device, const vk::SurfaceKHR& surface, GLFWwindow* window, const bool debug) {
+  // old_swapchain is retired by the new one but stays alive until the caller destroys it
+  VkUtils::SwapChainBundle create_swapchain(const VkUtils::DeviceCapabilities& caps, const vk::Device& logical_device, const vk::SurfaceKHR& surface, GLFWwindow* window,
+    PresentProfile profile, uint32_t requested_images, vk::SwapchainKHR old_swapchain, const bool debug) {
     if (debug) {
-      std::cout << "Creating Swapchain..." << std::endl;
+      LOG_DEBUG("Creating Swapchain...");
     }
 
     VkUtils::SwapChainBundle bundle;
 
-    VkUtils::SwapChainSupportDetails details = VkUtils::query_swapchain_support(physical_device, surface, debug);
+    // formats and present modes are fixed per device, only the surface capabilities follow the window
+    VkUtils::SwapChainSupportDetails details = caps.Swapchain;
+    details.Capabilities = caps.PhysicalDevice.getSurfaceCapabilitiesKHR(surface);
 
     vk::SurfaceFormatKHR format = choose_swap_surface_format(details.Formats, debug);
-    vk::PresentModeKHR present_mode = choose_present_mode(details.PresentModes, debug);
+    vk::PresentModeKHR present_mode = choose_present_mode(details.PresentModes, profile, debug);
     vk::Extent2D extent = choose_swap_extent(details.Capabilities, window, debug);
-
-    uint32_t image_count = (std::min)(details.Capabilities.minImageCount + 1,
-      details.Capabilities.maxImageCount);
+    uint32_t image_count = choose_image_count(details.Capabilities, present_mode, profile, requested_images, debug);
 
     vk::SwapchainCreateInfoKHR create_info{};
 
@@ -80,9 +127,9 @@ namespace VkInit {
     create_info.imageColorSpace = format.colorSpace;
     create_info.imageExtent = extent;
     create_info.imageArrayLayers = 1;
-    create_info.imageUsage = vk::ImageUsageFlagBits::eColorAttachment;
+    create_info.imageUsage = vk::ImageUsageFlagBits::eColorAttachment | vk::ImageUsageFlagBits::eTransferDst;
 
-    VkUtils::QueueFamilyIndices indices = VkUtils::find_queue_families(physical_device, surface, debug);
+    const VkUtils::QueueFamilyIndices& indices = caps.Indices;
     uint32_t queue_family_indices[] = { indices.GraphicsFamily.value(), indices.PresentFamily.value() };
 
     if (queue_family_indices[0] != queue_family_indices[1]) {
@@ -98,7 +145,7 @@ namespace VkInit {
     create_info.compositeAlpha = vk::CompositeAlphaFlagBitsKHR::eOpaque;
     create_info.presentMode = present_mode;
     create_info.clipped = true;
-    create_info.oldSwapchain = vk::SwapchainKHR{ nullptr };
+    create_info.oldSwapchain = old_swapchain;
 
     vk::SwapchainKHR swapchain{};
     try {
@@ -106,7 +153,8 @@ namespace VkInit {
       bundle.Format = format.format;
       bundle.Extent = extent;
       if (debug) {
-        std::cout << "Swapchain Successfully Created!" << std::endl << std::endl;
+        LOG_DEBUG("Present mode " << vk::to_string(present_mode) << " with at least " << image_count << " images");
+        LOG_DEBUG("Swapchain Successfully Created!");
       }
     }
     catch (vk::SystemError e) {
@@ -0,0 +1,36 @@
+#pragma once
+#include "Headers.h"
+
+namespace VkInit {
+
+  vk::Semaphore make_semaphore(const vk::Device& device, const bool debug) {
+    vk::SemaphoreCreateInfo semaphore_info{};
+
+    try {
+      return device.createSemaphore(semaphore_info);
+    }
+    catch (vk::SystemError e) {
+      if (debug) {
+        LOG_ERROR("Semaphore creation failed!");
+      }
+      return nullptr;
+    }
+  }
+
+  // fences start signaled so the first wait on a fresh frame returns immediately
+  vk::Fence make_fence(const vk::Device& device, const bool debug) {
+    vk::FenceCreateInfo fence_info{};
+    fence_info.flags = vk::FenceCreateFlagBits::eSignaled;
+
+    try {
+      return device.createFence(fence_info);
+    }
+    catch (vk::SystemError e) {
+      if (debug) {
+        LOG_ERROR("Fence creation failed!");
+      }
+      return nullptr;
+    }
+  }
+
+}// namespace VkInit
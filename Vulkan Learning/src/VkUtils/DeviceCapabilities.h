@@ -0,0 +1,137 @@
+#pragma once
+#include "Headers.h"
+#include "VkUtils/QueueFamilies.h"
+#include "VkUtils/SwapchainDetails.h"
+
+#include <string>
+#include <unordered_set>
+
+namespace VkUtils {
+  // Everything VkInit needs to know about a physical device, queried once per
+  // device and shared instead of asking the driver again at every step.
+  struct DeviceCapabilities {
+    vk::PhysicalDevice PhysicalDevice;
+    vk::PhysicalDeviceProperties Properties;
+    vk::PhysicalDeviceFeatures Features;
+    vk::PhysicalDeviceVulkan12Features Vulkan12Features;
+    // descriptor indexing limits live here, zeroed below 1.2
+    vk::PhysicalDeviceVulkan12Properties Vulkan12Properties;
+    vk::PhysicalDeviceMemoryProperties MemoryProperties;
+    std::array<uint8_t, VK_UUID_SIZE> DeviceUUID{};
+    std::vector<vk::QueueFamilyProperties> QueueFamilies;
+    // one entry per queue family, empty when headless
+    std::vector<bool> PresentSupport;
+    std::unordered_set<std::string> Extensions;
+    QueueFamilyIndices Indices;
+    // only filled in when there is a surface
+    SwapChainSupportDetails Swapchain;
+    // VK_KHR_present_id + VK_KHR_present_wait, lets presents be waited on for latency measurements
+    bool PresentWait = false;
+    // core in 1.3, otherwise VK_KHR_synchronization2, the render graph falls back to legacy barriers without it
+    bool Synchronization2 = false;
+
+    // VK_EXT_memory_budget, per heap budget and usage through the *2 memory properties query
+    bool MemoryBudget = false;
+
+    bool has_extension(const char* name) const {
+      return Extensions.count(name) != 0;
+    }
+
+    // everything the bindless descriptor heap relies on
+    bool supports_bindless() const {
+      const vk::PhysicalDeviceVulkan12Features& f = Vulkan12Features;
+      return Properties.apiVersion >= VK_API_VERSION_1_2 && f.descriptorIndexing && f.runtimeDescriptorArray &&
+        f.descriptorBindingPartiallyBound && f.descriptorBindingUpdateUnusedWhilePending &&
+        f.descriptorBindingSampledImageUpdateAfterBind && f.descriptorBindingStorageBufferUpdateAfterBind &&
+        f.descriptorBindingStorageImageUpdateAfterBind && f.shaderSampledImageArrayNonUniformIndexing;
+    }
+
+    // GPU-driven drawing: culling shaders index the bindless heap and write count-driven multi-draws
+    bool supports_gpu_culling() const {
+      return supports_bindless() && Vulkan12Features.drawIndirectCount && Features.multiDrawIndirect &&
+        Features.drawIndirectFirstInstance;
+    }
+  };
+
+  // the present and swapchain half of the capabilities, so devices can be queried before the window has a surface
+  void query_surface_support(DeviceCapabilities& caps, const vk::SurfaceKHR& surface, const bool debug) {
+    const vk::PhysicalDevice& device = caps.PhysicalDevice;
+    caps.PresentSupport.resize(caps.QueueFamilies.size());
+    for (uint32_t i = 0; i < caps.QueueFamilies.size(); ++i) {
+      caps.PresentSupport[i] = device.getSurfaceSupportKHR(i, surface);
+    }
+    caps.Swapchain = query_swapchain_support(device, surface, debug);
+
+    if (caps.Properties.apiVersion >= VK_API_VERSION_1_1 &&
+      caps.has_extension(VK_KHR_PRESENT_ID_EXTENSION_NAME) && caps.has_extension(VK_KHR_PRESENT_WAIT_EXTENSION_NAME)) {
+      auto features = device.getFeatures2<vk::PhysicalDeviceFeatures2, vk::PhysicalDevicePresentIdFeaturesKHR,
+        vk::PhysicalDevicePresentWaitFeaturesKHR>();
+      caps.PresentWait = features.get<vk::PhysicalDevicePresentIdFeaturesKHR>().presentId &&
+        features.get<vk::PhysicalDevicePresentWaitFeaturesKHR>().presentWait;
+    }
+    caps.Indices = find_queue_families(caps.QueueFamilies, caps.PresentSupport, debug);
+  }
+
+  // a null surface skips every present and swapchain query
+  DeviceCapabilities query_device_capabilities(const vk::PhysicalDevice& device, const vk::SurfaceKHR& surface, const bool debug) {
+    DeviceCapabilities caps;
+    caps.PhysicalDevice = device;
+    caps.Properties = device.getProperties();
+    caps.MemoryProperties = device.getMemoryProperties();
+
+    // the *2 queries are 1.1, older devices only get the 1.0 features
+    if (caps.Properties.apiVersion >= VK_API_VERSION_1_1) {
+      auto features = device.getFeatures2<vk::PhysicalDeviceFeatures2, vk::PhysicalDeviceVulkan12Features>();
+      caps.Features = features.get<vk::PhysicalDeviceFeatures2>().features;
+      caps.Vulkan12Features = features.get<vk::PhysicalDeviceVulkan12Features>();
+      caps.Vulkan12Features.pNext = nullptr;
+
+      auto props = device.getProperties2<vk::PhysicalDeviceProperties2, vk::PhysicalDeviceIDProperties>();
+      const vk::PhysicalDeviceIDProperties& id_props = props.get<vk::PhysicalDeviceIDProperties>();
+      std::copy(id_props.deviceUUID.begin(), id_props.deviceUUID.end(), caps.DeviceUUID.begin());
+
+      if (caps.Properties.apiVersion >= VK_API_VERSION_1_2) {
+        auto props12 = device.getProperties2<vk::PhysicalDeviceProperties2, vk::PhysicalDeviceVulkan12Properties>();
+        caps.Vulkan12Properties = props12.get<vk::PhysicalDeviceVulkan12Properties>();
+        caps.Vulkan12Properties.pNext = nullptr;
+      }
+
+      if (caps.Properties.apiVersion >= VK_API_VERSION_1_3) {
+        auto features13 = device.getFeatures2<vk::PhysicalDeviceFeatures2, vk::PhysicalDeviceVulkan13Features>();
+        caps.Synchronization2 = features13.get<vk::PhysicalDeviceVulkan13Features>().synchronization2;
+      }
+    }
+    else {
+      caps.Features = device.getFeatures();
+    }
+
+    for (const vk::ExtensionProperties& extension : device.enumerateDeviceExtensionProperties()) {
+      caps.Extensions.insert(extension.extensionName.data());
+    }
+    if (!caps.Synchronization2 && caps.Properties.apiVersion >= VK_API_VERSION_1_1 &&
+      caps.has_extension(VK_KHR_SYNCHRONIZATION_2_EXTENSION_NAME)) {
+      auto features = device.getFeatures2<vk::PhysicalDeviceFeatures2, vk::PhysicalDeviceSynchronization2Features>();
+      caps.Synchronization2 = features.get<vk::PhysicalDeviceSynchronization2Features>().synchronization2;
+    }
+
+    caps.MemoryBudget = caps.Properties.apiVersion >= VK_API_VERSION_1_1 && caps.has_extension(VK_EXT_MEMORY_BUDGET_EXTENSION_NAME);
+
+    if (debug) {
+      std::string supported;
+      for (const std::string& extension : caps.Extensions) {
+        supported += extension + ", ";
+      }
+      LOG_DEBUG("Supported Device Extensions: " << supported);
+    }
+
+    caps.QueueFamilies = device.getQueueFamilyProperties();
+    if (surface) {
+      query_surface_support(caps, surface, debug);
+    }
+    else {
+      caps.Indices = find_queue_families(caps.QueueFamilies, caps.PresentSupport, debug);
+    }
+
+    return caps;
+  }
+}// namespace VkUtils
@@ -0,0 +1,11 @@
+#pragma once
+#include "Headers.h"
+namespace VkUtils {
+  // everything one frame in flight owns, indexed by Application::current_frame_
+  struct FrameData {
+    vk::CommandPool CommandPool;
+    vk::CommandBuffer CommandBuffer;
+    vk::Semaphore ImageAvailable;
+    vk::Fence InFlight;
+  };
+}// namespace VkUtils
@@ -1,48 +1,158 @@
 #pragma once
+#include <map>
+
 namespace VkUtils {
   struct QueueFamilyIndices {
     std::optional<uint32_t> GraphicsFamily;
     std::optional<uint32_t> PresentFamily;
+    // prefers a transfer-only family (a DMA engine), falls back to the graphics family
+    std::optional<uint32_t> TransferFamily;
+    // prefers a compute family without graphics (async compute), falls back to the graphics family
+    std::optional<uint32_t> ComputeFamily;
+    // no surface to present to, PresentFamily stays empty
+    bool Headless = false;
+
+    bool is_complete() const {
+      return GraphicsFamily.has_value() && (Headless || PresentFamily.has_value());
+    }
+
+    bool has_dedicated_transfer() const {
+      return TransferFamily.has_value() && TransferFamily != GraphicsFamily;
+    }
 
-    bool is_complete() {
-      return GraphicsFamily.has_value() && PresentFamily.has_value();
+    bool has_async_compute() const {
+      return ComputeFamily.has_value() && ComputeFamily != GraphicsFamily;
     }
   };
 
-  QueueFamilyIndices find_queue_families(const vk::PhysicalDevice& device, const vk::SurfaceKHR& surface, const bool debug) {
+  // queues opened beyond the graphics queue, priorities are in [0, 1] and only rank queues within a family
+  struct QueueRequest {
+    uint32_t ComputeQueues = 1;
+    float GraphicsPriority = 1.0f;
+    float ComputePriority = 0.5f;
+    float TransferPriority = 0.5f;
+  };
+
+  struct QueueSlot {
+    uint32_t Family = 0;
+    uint32_t Index = 0;
+  };
+
+  // which queue of which family each role gets, and the priority of every queue created per family
+  struct QueuePlan {
+    QueueSlot Graphics;
+    QueueSlot Present;
+    QueueSlot Transfer;
+    // at least one, fewer than requested when the family runs out of queues
+    std::vector<QueueSlot> Compute;
+    std::map<uint32_t, std::vector<float>> Priorities;
+  };
+
+  // present_support holds one entry per family, or nothing when headless
+  QueueFamilyIndices find_queue_families(const std::vector<vk::QueueFamilyProperties>& family_props, const std::vector<bool>& present_support, const bool debug) {
     if (debug) {
-      std::cout << "Finding Queue Families..." << std::endl;
+      LOG_DEBUG("Finding Queue Families...");
     }
     QueueFamilyIndices indices;
+    indices.Headless = present_support.empty();
 
-    std::vector<vk::QueueFamilyProperties> family_props{ device.getQueueFamilyProperties() };
     if (debug) {
-      std::cout << "Device supports " << family_props.size() << " queue families!" << std::endl;
+      LOG_DEBUG("Device supports " << family_props.size() << " queue families!");
     }
 
+    // transfer-only beats transfer+compute, which beats sharing the graphics family
+    int transfer_score{ 0 };
+    // compute without transfer is unusual, prefer the family that also has it
+    int compute_score{ 0 };
     int indice{ 0 };
     for (const vk::QueueFamilyProperties& prop : family_props) {
-      if (prop.queueFlags & vk::QueueFlagBits::eGraphics) {
+      if (!indices.GraphicsFamily && (prop.queueFlags & vk::QueueFlagBits::eGraphics)) {
         indices.GraphicsFamily = indice;
         if (debug) {
-          std::cout << "Queue family " << indice << " is suitable for graphics!" << std::endl;
+          LOG_DEBUG("Queue family " << indice << " is suitable for graphics!");
         }
       }
 
-      if (device.getSurfaceSupportKHR(indice, surface)) {
+      if (!indices.Headless && !indices.PresentFamily && present_support[indice]) {
         indices.PresentFamily = indice;
         if (debug) {
-          std::cout << "Queue family " << indice << " is suitable for presenting!" << std::endl;
+          LOG_DEBUG("Queue family " << indice << " is suitable for presenting!");
         }
       }
 
-      if (indices.is_complete()) {
-        break;
+      if ((prop.queueFlags & vk::QueueFlagBits::eTransfer) && !(prop.queueFlags & vk::QueueFlagBits::eGraphics)) {
+        int score = (prop.queueFlags & vk::QueueFlagBits::eCompute) ? 1 : 2;
+        if (score > transfer_score) {
+          transfer_score = score;
+          indices.TransferFamily = indice;
+          if (debug) {
+            LOG_DEBUG("Queue family " << indice << " is suitable for dedicated transfers!");
+          }
+        }
       }
+
+      if ((prop.queueFlags & vk::QueueFlagBits::eCompute) && !(prop.queueFlags & vk::QueueFlagBits::eGraphics)) {
+        int score = (prop.queueFlags & vk::QueueFlagBits::eTransfer) ? 2 : 1;
+        if (score > compute_score) {
+          compute_score = score;
+          indices.ComputeFamily = indice;
+          if (debug) {
+            LOG_DEBUG("Queue family " << indice << " is suitable for async compute!");
+          }
+        }
+      }
+
       ++indice;
     }
 
+    // graphics queues always support transfers and compute
+    if (!indices.TransferFamily) {
+      indices.TransferFamily = indices.GraphicsFamily;
+    }
+    if (!indices.ComputeFamily) {
+      indices.ComputeFamily = indices.GraphicsFamily;
+    }
+
     return indices;
   }
 
-}// namespace VkUtils
\ No newline at end of file
+  // graphics always gets queue 0 of its family; present and a transfer role in the graphics
+  // family share it, everything else takes the next free queue and shares once none are left
+  QueuePlan plan_queues(const QueueFamilyIndices& indices, const std::vector<vk::QueueFamilyProperties>& family_props,
+    const QueueRequest& request) {
+    QueuePlan plan;
+
+    auto take = [&](uint32_t family, float priority) {
+      std::vector<float>& priorities = plan.Priorities[family];
+      if (priorities.size() < family_props[family].queueCount) {
+        priorities.push_back(priority);
+      }
+      return QueueSlot{ family, static_cast<uint32_t>(priorities.size() - 1) };
+    };
+
+    uint32_t graphics_family = indices.GraphicsFamily.value();
+    plan.Graphics = take(graphics_family, request.GraphicsPriority);
+
+    plan.Present = plan.Graphics;
+    if (!indices.Headless && indices.PresentFamily.value() != graphics_family) {
+      plan.Present = take(indices.PresentFamily.value(), request.GraphicsPriority);
+    }
+
+    plan.Transfer = plan.Graphics;
+    if (indices.has_dedicated_transfer()) {
+      plan.Transfer = take(indices.TransferFamily.value(), request.TransferPriority);
+    }
+
+    uint32_t compute_family = indices.ComputeFamily.value();
+    for (uint32_t i = 0; i < (std::max)(request.ComputeQueues, 1u); ++i) {
+      // a family without spare queues still hands its last queue to the first compute role
+      if (!plan.Compute.empty() && plan.Priorities[compute_family].size() >= family_props[compute_family].queueCount) {
+        break;
+      }
+      plan.Compute.push_back(take(compute_family, request.ComputePriority));
+    }
+
+    return plan;
+  }
+
+}// namespace VkUtils
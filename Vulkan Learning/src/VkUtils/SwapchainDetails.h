@@ -1,5 +1,6 @@
 #pragma once
 #include "Headers.h"
+#include "Memory/MemoryAllocator.h"
 namespace VkUtils {
   struct SwapChainSupportDetails {
     vk::SurfaceCapabilitiesKHR Capabilities;
@@ -13,11 +14,19 @@ namespace VkUtils {
     vk::Extent2D Extent;
   };
 
+  // stands in for the swapchain when running headless
+  struct OffscreenBundle {
+    std::vector<vk::Image> Images;
+    std::vector<MemoryAllocation> Memory;
+    vk::Format Format;
+    vk::Extent2D Extent;
+  };
+
   SwapChainSupportDetails query_swapchain_support(const vk::PhysicalDevice& physical_device, const vk::SurfaceKHR& surface, const bool debug) {
     SwapChainSupportDetails details;
 
     if (debug) {
-      std::cout << "Querying Swapchain Support..." << std::endl;
+      LOG_DEBUG("Querying Swapchain Support...");
     }
 
     details.Capabilities = physical_device.getSurfaceCapabilitiesKHR(surface);
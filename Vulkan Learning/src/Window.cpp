@@ -0,0 +1,24 @@
+#ifdef _WIN32
+#include "WindowsWindow.h"
+#else
+#include "LinuxWindow.h"
+#endif
+
+Window* Window::create(bool debug) {
+#ifdef _WIN32
+  return new WindowsWindow(debug);
+#else
+  return new LinuxWindow(debug);
+#endif
+}
+
+std::vector<const char*> Window::required_instance_extensions(bool debug) {
+  GlfwWindow::init_glfw(debug);
+
+  uint32_t count = 0;
+  const char** extensions = glfwGetRequiredInstanceExtensions(&count);
+  if (!extensions) {
+    return {};
+  }
+  return std::vector<const char*>(extensions, extensions + count);
+}
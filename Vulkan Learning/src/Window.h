@@ -0,0 +1,28 @@
+#pragma once
+#include "Headers.h"
+
+// Platform independent window interface. Application only talks to this,
+// the backend is picked at compile time by Window::create().
+class Window {
+public:
+  virtual ~Window() = default;
+
+  static Window* create(bool debug);
+  // initializes the platform layer and returns the instance extensions a surface needs, so the
+  // instance can be created on another thread while create() runs. Main thread only, like create()
+  static std::vector<const char*> required_instance_extensions(bool debug);
+
+  // processes pending events without blocking
+  virtual void on_update() = 0;
+  // blocks until the next window event, used while minimized
+  virtual void wait_events() = 0;
+  // blocks until an event arrives or timeout_seconds pass, lets an idle app sleep instead of spinning
+  virtual void wait_events_timeout(double timeout_seconds) = 0;
+  virtual bool should_close() = 0;
+  virtual bool is_minimized() = 0;
+  // true once after the framebuffer changed size
+  virtual bool consume_resize() = 0;
+  virtual void create_surface(const vk::Instance& instance, vk::SurfaceKHR& surface, const bool debug) = 0;
+
+  virtual GLFWwindow* get_glfw_window() = 0;
+};
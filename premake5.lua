@@ -27,7 +27,11 @@ project "Vulkan Learning"
 	files
 	{
 		"%{prj.name}/src/**.h",
-		"%{prj.name}/src/**.cpp"
+		"%{prj.name}/src/**.cpp",
+		"%{prj.name}/shaders/**.glsl",
+		"%{prj.name}/shaders/**.comp",
+		"%{prj.name}/shaders/**.vert",
+		"%{prj.name}/shaders/**.frag"
 	}
 
 	includedirs
@@ -40,14 +44,29 @@ project "Vulkan Learning"
 
 	links 
 	{ 
-		"GLFW",
-		"vulkan-1"
+		"GLFW"
 	}
 
+	-- shaders are compiled next to their sources, the app loads them from --shader-dir (default "shaders")
+	filter "files:**.comp or **.vert or **.frag"
+		buildmessage "Compiling %{file.relpath}"
+		-- same options as CompilerOptions in ShaderCompiler.cpp, so offline and runtime SPIR-V match
+		buildcommands { 'glslc --target-env=vulkan1.2 -O "%{file.abspath}" -o "%{file.directory}/%{file.name}.spv"' }
+		buildoutputs { "%{file.directory}/%{file.name}.spv" }
+		buildinputs { "%{prj.location}/shaders/bindless.glsl", "%{prj.location}/shaders/scene.glsl" }
+
 	filter "system:windows"
+		removefiles { "%{prj.name}/src/LinuxWindow.*" }
 		libdirs { 
 			"Vulkan Learning/vendor/vulkan/Lib"
 		}
+		links { "vulkan-1" }
 		cppdialect "C++17"
 		systemversion "latest"
+		symbols "On"
+
+	filter "system:linux"
+		removefiles { "%{prj.name}/src/WindowsWindow.*" }
+		links { "vulkan", "dl", "pthread", "X11" }
+		cppdialect "C++17"
 		symbols "On"
\ No newline at end of file